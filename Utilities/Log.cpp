@@ -7,10 +7,23 @@
 #include "Thread.h"
 #include "rFile.h"
 
+#ifdef _WIN32
+#include <Windows.h>
+#elif __APPLE__
+#include <pthread.h>
+#endif
+
 using namespace Log;
 
 LogManager *gLogManager = nullptr;
 
+std::atomic<u32> Log::g_severity_masks[LOG_TYPE_COUNT] =
+{
+	{ LOG_SEVERITY_ALL }, { LOG_SEVERITY_ALL }, { LOG_SEVERITY_ALL },
+	{ LOG_SEVERITY_ALL }, { LOG_SEVERITY_ALL }, { LOG_SEVERITY_ALL },
+	{ LOG_SEVERITY_ALL }, { LOG_SEVERITY_ALL }, { LOG_SEVERITY_ALL },
+};
+
 u32 LogMessage::size()
 {
 	//1 byte for NULL terminator
@@ -56,8 +69,6 @@ LogChannel::LogChannel() : LogChannel("unknown")
 
 LogChannel::LogChannel(const std::string& name) :
 	  name(name)
-	, mEnabled(true)
-	, mLogLevel(Warning)
 {}
 
 void LogChannel::log(LogMessage msg)
@@ -80,6 +91,12 @@ void LogChannel::removeListener(std::shared_ptr<LogListener> listener)
 	mListeners.erase(listener);
 }
 
+bool LogChannel::hasListeners()
+{
+	std::lock_guard<std::mutex> lock(mListenerLock);
+	return !mListeners.empty();
+}
+
 struct CoutListener : LogListener
 {
 	void log(LogMessage msg)
@@ -113,64 +130,387 @@ struct FileListener : LogListener
 	}
 };
 
-LogManager::LogManager() 
-#ifdef BUFFERED_LOGGING
-	: mExiting(false), mLogConsumer()
+LogBuffer::LogBuffer()
+	: m_data(new u8[capacity])
+	, m_get(0)
+	, m_put(0)
+	, thread(this) // no thread name written yet
+	, orphaned(false)
+{
+}
+
+u8* LogBuffer::reserve(u32 size)
+{
+	u32 put = m_put.load(std::memory_order_relaxed);
+	const u32 pos = put % capacity;
+	const u32 tail = capacity - pos;
+	const u32 need = size > tail ? tail + size : size; // records never wrap around
+
+	while (capacity - (put - m_get.load(std::memory_order_acquire)) < need)
+	{
+		LogManager::getInstance().wakeConsumer();
+		std::this_thread::yield();
+	}
+
+	if (size > tail)
+	{
+		LogRecord& pad = *(LogRecord*)(m_data.get() + pos);
+		pad.size = tail;
+		pad.kind = RecordPadding;
+		m_put.store(put += tail, std::memory_order_release);
+	}
+
+	return m_data.get() + put % capacity;
+}
+
+void LogBuffer::commit(u32 size)
+{
+	m_put.store(m_put.load(std::memory_order_relaxed) + size, std::memory_order_release);
+}
+
+// binary log file (LogManager::setBinaryLog): a header followed by chunks, the formats and the thread names are
+// written once, before the first message that refers to them
+static const char s_binary_magic[8] = { 'R', 'P', 'C', 'S', '3', 'L', 'O', 'G' };
+static const u32 s_binary_version = 1;
+
+enum BinaryChunk : u8
+{
+	ChunkFormat = 1, // u32 id, format string, printf format prefix, argument types (null terminated strings)
+	ChunkThread, // u32 id, thread name
+	ChunkMessage, // u32 format id, u32 thread id, u8 type, u8 severity, u32 size, arguments
+	ChunkText, // u32 thread id, u8 type, u8 severity, u32 size, formatted text (messages logged synchronously)
+};
+
+static void put_binary(std::vector<u8>& out, const void* data, size_t size)
+{
+	out.insert(out.end(), (const u8*)data, (const u8*)data + size);
+}
+
+template<typename T> static void put_binary(std::vector<u8>& out, T value)
+{
+	put_binary(out, &value, sizeof(T));
+}
+
+static void put_binary(std::vector<u8>& out, const char* str)
+{
+	put_binary(out, str, strlen(str) + 1);
+}
+
+static void write_binary_data(rFile* file, std::vector<u8>& data)
+{
+	if (file && data.size())
+	{
+		file->Write(data.data(), data.size());
+	}
+
+	data.clear();
+}
+
+thread_local LogBuffer* g_tls_log_buffer = nullptr;
+thread_local bool g_tls_log_consumer = false;
+thread_local bool g_tls_log_finished = false; // the buffer was released, the thread logs synchronously until it ends
+
+// Owns the buffer of a thread and releases it when the thread finishes, however it was started. The consumer frees the
+// buffer once it's drained.
+struct LogBufferOwner
+{
+	LogBuffer* buffer;
+
+	~LogBufferOwner()
+	{
+		if (buffer)
+		{
+			g_tls_log_buffer = nullptr;
+			g_tls_log_finished = true;
+			buffer->orphaned = true;
+		}
+	}
+};
+
+// thread_local is __declspec(thread) or __thread on Windows and OS X (GNU.h), which don't support destructors,
+// so the owner is deleted by a fiber local storage callback or a pthread key destructor there
+#ifdef _WIN32
+static void WINAPI DeleteLogBufferOwner(void* owner)
+{
+	delete (LogBufferOwner*)owner;
+}
+
+static void SetLogBufferOwner(LogBuffer* buffer)
+{
+	static const DWORD index = FlsAlloc(DeleteLogBufferOwner);
+	FlsSetValue(index, new LogBufferOwner{ buffer });
+}
+#elif __APPLE__
+static void DeleteLogBufferOwner(void* owner)
+{
+	delete (LogBufferOwner*)owner;
+}
+
+static void SetLogBufferOwner(LogBuffer* buffer)
+{
+	static pthread_key_t key;
+	static const int res = pthread_key_create(&key, DeleteLogBufferOwner);
+	pthread_setspecific(key, new LogBufferOwner{ buffer });
+}
+#else
+static thread_local LogBufferOwner g_tls_log_buffer_owner = { nullptr };
+
+static void SetLogBufferOwner(LogBuffer* buffer)
+{
+	g_tls_log_buffer_owner.buffer = buffer;
+}
 #endif
+
+LogManager::LogManager() 
+	: mSeq(0)
+	, mProcessed(0)
+	, mConsumerIdle(false)
+	, mExiting(false)
+	, mLogConsumer()
+	, mFileListener(new FileListener())
+	, mBinaryEnabled(false)
 {
 	auto it = mChannels.begin();
-	std::shared_ptr<LogListener> listener(new FileListener());
 	for (const LogTypeName& name : gTypeNameTable)
 	{
 		it->name = name.mName;
-		it->addListener(listener);
+		it->addListener(mFileListener);
 		it++;
 	}
 	std::shared_ptr<LogListener> TTYListener(new FileListener("TTY",false));
 	getChannel(TTY).addListener(TTYListener);
-#ifdef BUFFERED_LOGGING
 	mLogConsumer = std::thread(&LogManager::consumeLog, this);
-#endif
 }
 
 LogManager::~LogManager()
 {
-#ifdef BUFFERED_LOGGING
 	mExiting = true;
-	mBufferReady.notify_all();
+	wakeConsumer();
 	mLogConsumer.join();
+	setBinaryLog("");
+}
+
+LogBuffer* LogManager::getThreadBuffer()
+{
+	if (g_tls_log_consumer || g_tls_log_finished || mExiting)
+	{
+		return nullptr;
+	}
+
+	LogBuffer* buffer = g_tls_log_buffer;
+	if (!buffer)
+	{
+		std::shared_ptr<LogBuffer> new_buffer(new LogBuffer());
+		{
+			std::lock_guard<std::mutex> lock(mBuffersLock);
+			mBuffers.push_back(new_buffer);
+			SetLogBufferOwner(new_buffer.get());
+		}
+		g_tls_log_buffer = buffer = new_buffer.get();
+	}
+
+	// write the thread name only when it changes
+	NamedThreadBase* thr = GetCurrentNamedThread();
+	if (buffer->thread != thr)
+	{
+		const std::string name = thr ? thr->GetThreadName() : "";
+		const u32 size = AlignAddr((u32)(sizeof(LogRecord) + name.size() + 1), 8);
+
+		LogRecord& rec = *(LogRecord*)buffer->reserve(size);
+		rec.size = size;
+		rec.kind = RecordThreadName;
+		memcpy(&rec + 1, name.c_str(), name.size() + 1);
+		buffer->commit(size);
+
+		buffer->thread = thr;
+	}
+
+	return buffer;
+}
+
+u32 LogManager::getBufferCount()
+{
+	std::lock_guard<std::mutex> lock(mBuffersLock);
+	return (u32)mBuffers.size();
+}
+
+void LogManager::wakeConsumer()
+{
+	if (mConsumerIdle.exchange(false))
+	{
+		std::lock_guard<std::mutex> lock(mStatusMut);
+		mBufferReady.notify_one();
+	}
+}
+
+void LogManager::flush()
+{
+	if (g_tls_log_consumer || !mLogConsumer.joinable())
+	{
+		return;
+	}
+
+	const u64 seq = mSeq;
+
+	while (mProcessed < seq && !mExiting)
+	{
+		mConsumerIdle = true;
+		wakeConsumer();
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
 }
 
 void LogManager::consumeLog()
 {
-	std::unique_lock<std::mutex> lock(mStatusMut);
-	while (!mExiting)
+	g_tls_log_consumer = true;
+
+	while (true)
 	{
-		mBufferReady.wait(lock);
-		mBuffer.lockGet();
-		size_t size = mBuffer.size();
-		std::vector<char> local_messages(size);
-		mBuffer.popN(&local_messages.front(), size);
-		mBuffer.unlockGet();
+		const bool exiting = mExiting;
+
+		if (consume())
+		{
+			continue;
+		}
 
-		u32 cursor = 0;
-		u32 removed = 0;
-		while (cursor < size)
+		if (exiting)
 		{
-			Log::LogMessage msg = Log::LogMessage::deserialize(local_messages.data() + cursor, &removed);
-			cursor += removed;
-			getChannel(msg.mType).log(msg);
+			break;
 		}
+
+		std::unique_lock<std::mutex> lock(mStatusMut);
+		mConsumerIdle = true;
+		mBufferReady.wait_for(lock, std::chrono::milliseconds(10));
 	}
-#endif
+}
+
+u32 LogManager::consume()
+{
+	struct Entry
+	{
+		const LogRecord* rec;
+		const char* name;
+	};
+
+	std::vector<std::shared_ptr<LogBuffer>> buffers;
+	{
+		std::lock_guard<std::mutex> lock(mBuffersLock);
+		buffers = mBuffers;
+	}
+
+	std::vector<Entry> entries;
+	std::vector<u32> ends(buffers.size());
+
+	for (size_t i = 0; i < buffers.size(); i++)
+	{
+		LogBuffer& buffer = *buffers[i];
+		const char* name = buffer.name.c_str();
+		u32 pos = buffer.get();
+		const u32 put = buffer.put();
+
+		while (pos != put)
+		{
+			const LogRecord& rec = *(const LogRecord*)buffer.at(pos);
+
+			switch (rec.kind)
+			{
+			case RecordMessage: entries.push_back({ &rec, name }); break;
+			case RecordThreadName: name = (const char*)(&rec + 1); break;
+			case RecordPadding: break;
+			}
+
+			pos += rec.size;
+		}
+
+		ends[i] = pos;
+	}
+
+	// messages of different threads are written in the order of their calls
+	std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b)
+	{
+		return a.rec->seq < b.rec->seq;
+	});
+
+	for (auto& entry : entries)
+	{
+		const LogRecord& rec = *entry.rec;
+
+		if (mBinaryEnabled)
+		{
+			writeBinary(&rec, nullptr, entry.name);
+		}
+
+		// in binary mode, only the messages of channels with other listeners (like the log window) are formatted
+		if (mChannels[static_cast<u32>(rec.type)].hasListeners())
+		{
+			dispatch({ rec.type, rec.severity, rec.info->format(rec.fmt, (const u8*)(&rec + 1)) }, entry.name);
+		}
+	}
+
+	for (size_t i = 0; i < buffers.size(); i++)
+	{
+		LogBuffer& buffer = *buffers[i];
+
+		// remember the last thread name of the buffer
+		const u32 get = buffer.get();
+		for (u32 pos = get; pos != ends[i];)
+		{
+			const LogRecord& rec = *(const LogRecord*)buffer.at(pos);
+			if (rec.kind == RecordThreadName)
+			{
+				buffer.name = (const char*)(&rec + 1);
+			}
+			pos += rec.size;
+		}
+
+		buffer.release(ends[i]);
+	}
+
+	if (mBinaryEnabled)
+	{
+		std::lock_guard<std::mutex> lock(mBinaryLock);
+		write_binary_data(mBinaryFile.get(), mBinaryData);
+	}
+
+	mProcessed += entries.size();
+
+	// free the buffers of finished threads
+	std::lock_guard<std::mutex> lock(mBuffersLock);
+	for (auto it = mBuffers.begin(); it != mBuffers.end();)
+	{
+		LogBuffer& buffer = **it;
+		if (buffer.orphaned && buffer.get() == buffer.put())
+		{
+			it = mBuffers.erase(it);
+		}
+		else
+		{
+			it++;
+		}
+	}
+
+	return (u32)entries.size();
 }
 
 void LogManager::log(LogMessage msg)
+{
+	NamedThreadBase* thr = GetCurrentNamedThread();
+	const std::string name = thr ? thr->GetThreadName() : "";
+
+	if (mBinaryEnabled)
+	{
+		writeBinary(nullptr, &msg, name.c_str());
+	}
+
+	dispatch(msg, name.c_str());
+}
+
+static void add_prefix(LogMessage& msg, const char* thread_name)
 {
 	//don't do any formatting changes or filtering to the TTY output since we
 	//use the raw output to do diffs with the output of a real PS3 and some
 	//programs write text in single bytes to the console
-	if (msg.mType != TTY)
+	if (msg.mType != Log::TTY)
 	{
 		std::string prefix;
 		switch (msg.mServerity)
@@ -188,22 +528,495 @@ void LogManager::log(LogMessage msg)
 			prefix = "E ";
 			break;
 		}
-		if (NamedThreadBase* thr = GetCurrentNamedThread())
+		if (thread_name[0])
 		{
-			prefix += "{" + thr->GetThreadName() + "} ";
+			prefix += "{" + std::string(thread_name) + "} ";
 		}
 		msg.mText.insert(0, prefix);
 		msg.mText.append(1,'\n');
 	}
-#ifdef BUFFERED_LOGGING
-	size_t size = msg.size();
-	std::vector<char> temp_buffer(size);
-	msg.serialize(temp_buffer.data());
-	mBuffer.pushRange(temp_buffer.begin(), temp_buffer.end());
-	mBufferReady.notify_one();
-#else
+}
+
+void LogManager::dispatch(LogMessage msg, const char* thread_name)
+{
+	add_prefix(msg, thread_name);
 	mChannels[static_cast<u32>(msg.mType)].log(msg);
-#endif
+}
+
+bool LogManager::setBinaryLog(const std::string& path)
+{
+	// the pending records are written with the previous setting
+	flush();
+
+	std::unique_ptr<rFile> file;
+
+	if (path.size())
+	{
+		file.reset(new rFile());
+
+		if (!file->Create(path, true))
+		{
+			LOG_ERROR(GENERAL, "Can't create the binary log file '%s'", path.c_str());
+			return false;
+		}
+
+		std::vector<u8> header;
+		put_binary(header, s_binary_magic, sizeof(s_binary_magic));
+		put_binary(header, s_binary_version);
+		put_binary(header, (u32)sizeof(void*));
+		write_binary_data(file.get(), header);
+	}
+
+	const bool was_enabled = mBinaryEnabled.exchange(file != nullptr);
+
+	{
+		std::lock_guard<std::mutex> lock(mBinaryLock);
+
+		write_binary_data(mBinaryFile.get(), mBinaryData);
+		mBinaryFile = std::move(file);
+		mBinaryFormats.clear();
+		mBinaryThreads.clear();
+	}
+
+	// the text log file isn't written in binary mode, so only the channels with other listeners format the messages
+	// (listeners aren't changed under mBinaryLock, writeBinary() may be called while a channel is locked)
+	if (was_enabled != mBinaryEnabled)
+	{
+		for (auto& channel : mChannels)
+		{
+			mBinaryEnabled ? channel.removeListener(mFileListener) : channel.addListener(mFileListener);
+		}
+	}
+
+	return true;
+}
+
+void LogManager::writeBinary(const LogRecord* rec, const LogMessage* msg, const char* thread_name)
+{
+	std::lock_guard<std::mutex> lock(mBinaryLock);
+
+	if (!mBinaryFile)
+	{
+		return;
+	}
+
+	auto thread = mBinaryThreads.find(thread_name);
+	if (thread == mBinaryThreads.end())
+	{
+		thread = mBinaryThreads.emplace(thread_name, (u32)mBinaryThreads.size()).first;
+		put_binary(mBinaryData, ChunkThread);
+		put_binary(mBinaryData, thread->second);
+		put_binary(mBinaryData, thread_name);
+	}
+
+	if (!rec)
+	{
+		put_binary(mBinaryData, ChunkText);
+		put_binary(mBinaryData, thread->second);
+		put_binary(mBinaryData, (u8)msg->mType);
+		put_binary(mBinaryData, (u8)msg->mServerity);
+		put_binary(mBinaryData, (u32)msg->mText.size());
+		put_binary(mBinaryData, msg->mText.data(), msg->mText.size());
+
+		// not followed by consume()
+		write_binary_data(mBinaryFile.get(), mBinaryData);
+		return;
+	}
+
+	auto format = mBinaryFormats.find(std::make_pair(rec->fmt, rec->info));
+	if (format == mBinaryFormats.end())
+	{
+		format = mBinaryFormats.emplace(std::make_pair(rec->fmt, rec->info), (u32)mBinaryFormats.size()).first;
+		put_binary(mBinaryData, ChunkFormat);
+		put_binary(mBinaryData, format->second);
+		put_binary(mBinaryData, rec->fmt);
+		put_binary(mBinaryData, rec->info->prefix);
+		put_binary(mBinaryData, rec->info->types);
+	}
+
+	const u32 size = rec->size - (u32)sizeof(LogRecord);
+
+	put_binary(mBinaryData, ChunkMessage);
+	put_binary(mBinaryData, format->second);
+	put_binary(mBinaryData, thread->second);
+	put_binary(mBinaryData, (u8)rec->type);
+	put_binary(mBinaryData, (u8)rec->severity);
+	put_binary(mBinaryData, size);
+	put_binary(mBinaryData, rec + 1, size);
+}
+
+// reads the stored arguments of a binary log message
+struct BinaryArgReader
+{
+	const char* types;
+	const u8* data;
+	const u8* end;
+	u32 pointer_size;
+
+	// returns the type of the argument (0 if there are no more arguments or the rest can't be read)
+	char next(u64& value, double& fp, const char*& str)
+	{
+		const char type = *types;
+		u32 size = 0;
+
+		switch (type)
+		{
+		case 'b': case 'B': size = 1; break;
+		case 'h': case 'H': size = 2; break;
+		case 'i': case 'I': case 'f': size = 4; break;
+		case 'q': case 'Q': case 'd': size = 8; break;
+		case 'p': size = pointer_size; break;
+		case 's':
+		{
+			const u8* nul = (const u8*)memchr(data, 0, end - data);
+			if (!nul)
+			{
+				return 0;
+			}
+
+			str = (const char*)data;
+			data = nul + 1;
+			types++;
+			return type;
+		}
+		default: return 0; // unknown size
+		}
+
+		if ((u32)(end - data) < size)
+		{
+			return 0;
+		}
+
+		u64 raw = 0;
+		memcpy(&raw, data, size);
+		data += size;
+		types++;
+
+		if (type == 'f')
+		{
+			float f;
+			memcpy(&f, &raw, sizeof(f));
+			fp = f;
+		}
+		else if (type == 'd')
+		{
+			memcpy(&fp, &raw, sizeof(fp));
+		}
+		else if (type >= 'a' && type != 'p' && size < 8)
+		{
+			// sign extended like a promoted vararg
+			value = (u64)((s64)(raw << (64 - size * 8)) >> (64 - size * 8));
+		}
+		else
+		{
+			value = raw;
+		}
+
+		return type;
+	}
+};
+
+template<typename T> static void append_format(std::string& out, const std::string& spec, T value)
+{
+	const int size = snprintf(nullptr, 0, spec.c_str(), value);
+	if (size > 0)
+	{
+		std::vector<char> buf(size + 1);
+		snprintf(buf.data(), buf.size(), spec.c_str(), value);
+		out.append(buf.data(), size);
+	}
+}
+
+// formats the stored arguments like the snprintf() call of the consumer thread, an argument that doesn't match its
+// conversion is replaced by "(?)"
+static bool format_binary_args(std::string& out, const char* fmt, BinaryArgReader& args)
+{
+	u64 value = 0;
+	double fp = 0;
+	const char* str = nullptr;
+
+	for (const char* p = fmt; *p;)
+	{
+		if (*p != '%')
+		{
+			const char* next = strchr(p, '%');
+			const size_t count = next ? next - p : strlen(p);
+			out.append(p, count);
+			p += count;
+			continue;
+		}
+
+		if (p[1] == '%')
+		{
+			out += '%';
+			p += 2;
+			continue;
+		}
+
+		// %[flags][width][.precision][length]conversion
+		std::string spec = "%";
+		p++;
+
+		while (*p && strchr("-+ #0", *p))
+		{
+			spec += *p++;
+		}
+
+		// width and precision
+		for (bool precision = false;; precision = true)
+		{
+			if (*p == '*')
+			{
+				p++;
+				const char type = args.next(value, fp, str);
+				if (!type || !strchr("bBhHiIqQ", type))
+				{
+					return false;
+				}
+				spec += std::to_string((s32)value);
+			}
+
+			while (*p >= '0' && *p <= '9')
+			{
+				spec += *p++;
+			}
+
+			if (precision || *p != '.')
+			{
+				break;
+			}
+
+			spec += *p++;
+		}
+
+		// the stored integer is truncated to the size the length modifier reads
+		u32 bits = 32;
+
+		if (p[0] == 'h' && p[1] == 'h') { bits = 8; p += 2; }
+		else if (p[0] == 'h') { bits = 16; p++; }
+		else if (p[0] == 'l' && p[1] == 'l') { bits = 64; p += 2; }
+		else if (p[0] == 'l') { bits = sizeof(long) * 8; p++; }
+		else if (p[0] == 'I' && p[1] == '6' && p[2] == '4') { bits = 64; p += 3; }
+		else if (p[0] == 'I' && p[1] == '3' && p[2] == '2') { bits = 32; p += 3; }
+		else if (p[0] && strchr("jztqLI", p[0])) { bits = 64; p++; }
+
+		const char conv = *p;
+		if (!conv)
+		{
+			break;
+		}
+		p++;
+
+		const char type = args.next(value, fp, str);
+		if (!type)
+		{
+			return false;
+		}
+
+		const bool is_int = strchr("bBhHiIqQp", type) != nullptr;
+
+		switch (conv)
+		{
+		case 'd': case 'i': case 'u': case 'o': case 'x': case 'X': case 'c':
+		{
+			if (!is_int)
+			{
+				out += "(?)";
+				break;
+			}
+
+			const u32 shift = 64 - bits;
+
+			if (conv == 'c')
+			{
+				append_format(out, spec + 'c', (int)value);
+			}
+			else if (conv == 'd' || conv == 'i')
+			{
+				append_format(out, spec + "lld", (long long)((s64)(value << shift) >> shift));
+			}
+			else
+			{
+				append_format(out, spec + "ll" + conv, (unsigned long long)((value << shift) >> shift));
+			}
+			break;
+		}
+
+		case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+		{
+			if (type != 'f' && type != 'd')
+			{
+				out += "(?)";
+				break;
+			}
+
+			append_format(out, spec + conv, fp);
+			break;
+		}
+
+		case 's':
+		{
+			if (type != 's')
+			{
+				out += "(?)";
+				break;
+			}
+
+			append_format(out, spec + 's', str);
+			break;
+		}
+
+		case 'p':
+		{
+			if (!is_int)
+			{
+				out += "(?)";
+				break;
+			}
+
+			append_format(out, spec + 'p', (void*)(size_t)value);
+			break;
+		}
+
+		default: return false;
+		}
+	}
+
+	return true;
+}
+
+s64 LogManager::decodeBinaryLog(const std::string& path, std::string& text)
+{
+	rFile file(path, rFile::read);
+	if (!file.IsOpened())
+	{
+		return -1;
+	}
+
+	std::vector<u8> data(file.Length());
+	if (file.Read(data.data(), data.size()) != data.size() || data.size() < sizeof(s_binary_magic) + 8 || memcmp(data.data(), s_binary_magic, sizeof(s_binary_magic)))
+	{
+		return -1;
+	}
+
+	struct Format
+	{
+		std::string fmt;
+		std::string prefix;
+		std::string types;
+	};
+
+	std::vector<Format> formats;
+	std::vector<std::string> threads;
+
+	const u8* pos = data.data() + sizeof(s_binary_magic);
+	const u8* const end = data.data() + data.size();
+
+	auto get_u32 = [&]() -> u32
+	{
+		u32 value = 0;
+		if (end - pos >= 4)
+		{
+			memcpy(&value, pos, 4);
+		}
+		pos += 4;
+		return value;
+	};
+
+	auto get_str = [&]() -> std::string
+	{
+		const u8* nul = (const u8*)memchr(pos, 0, end - pos);
+		const std::string res((const char*)pos, nul ? nul - pos : end - pos);
+		pos = nul ? nul + 1 : end + 1;
+		return res;
+	};
+
+	if (get_u32() != s_binary_version)
+	{
+		return -1;
+	}
+
+	const u32 pointer_size = get_u32();
+	s64 count = 0;
+
+	while (pos < end)
+	{
+		const u8 chunk = *pos++;
+
+		if (chunk == ChunkFormat)
+		{
+			const u32 id = get_u32();
+			Format format;
+			format.fmt = get_str();
+			format.prefix = get_str();
+			format.types = get_str();
+
+			if (id >= formats.size())
+			{
+				formats.resize(id + 1);
+			}
+			formats[id] = format;
+			continue;
+		}
+
+		if (chunk == ChunkThread)
+		{
+			const u32 id = get_u32();
+			if (id >= threads.size())
+			{
+				threads.resize(id + 1);
+			}
+			threads[id] = get_str();
+			continue;
+		}
+
+		if (chunk != ChunkMessage && chunk != ChunkText)
+		{
+			break;
+		}
+
+		const u32 format = chunk == ChunkMessage ? get_u32() : 0;
+		const u32 thread = get_u32();
+
+		if (end - pos < 6)
+		{
+			break;
+		}
+
+		LogMessage msg;
+		msg.mType = (LogType)pos[0];
+		msg.mServerity = (LogSeverity)pos[1];
+		pos += 2;
+
+		const u32 size = get_u32();
+		if ((u32)(end - pos) < size || msg.mType >= LOG_TYPE_COUNT)
+		{
+			break;
+		}
+
+		if (chunk == ChunkText)
+		{
+			msg.mText.assign((const char*)pos, size);
+		}
+		else if (format < formats.size())
+		{
+			const Format& f = formats[format];
+			BinaryArgReader args = { f.types.c_str(), pos, pos + size, pointer_size };
+
+			// an argument of unknown type (and everything after it) can't be formatted
+			if (!format_binary_args(msg.mText, f.prefix.c_str(), args) || !format_binary_args(msg.mText, f.fmt.c_str(), args))
+			{
+				msg.mText += fmt::Format(" [format '%s' with arguments '%s' can't be decoded]", f.fmt.c_str(), f.types.c_str());
+			}
+		}
+
+		pos += size;
+		add_prefix(msg, thread < threads.size() ? threads[thread].c_str() : "");
+		text += gTypeNameTable[msg.mType].mName + msg.mText;
+		count++;
+	}
+
+	return count;
 }
 
 void LogManager::addListener(std::shared_ptr<LogListener> listener)
@@ -226,6 +1039,12 @@ LogManager& LogManager::getInstance()
 	if (!gLogManager)
 	{
 		gLogManager = new LogManager();
+
+		// write the pending messages at exit (the manager itself is never destroyed)
+		atexit([]()
+		{
+			gLogManager->flush();
+		});
 	}
 	return *gLogManager;
 }
@@ -233,3 +1052,52 @@ LogChannel &LogManager::getChannel(LogType type)
 {
 	return mChannels[static_cast<u32>(type)];
 }
+
+void LogManager::setSeverityMask(LogType type, u32 mask)
+{
+	g_severity_masks[type] = mask & LOG_SEVERITY_ALL;
+}
+
+u32 LogManager::getSeverityMask(LogType type)
+{
+	return g_severity_masks[type];
+}
+
+void LogManager::setSeverityMasks(const std::string& list)
+{
+	for (u32 i = 0; i < LOG_TYPE_COUNT; i++)
+	{
+		setSeverityMask(static_cast<LogType>(i), LOG_SEVERITY_ALL);
+	}
+
+	std::istringstream stream(list);
+	std::string entry;
+
+	while (std::getline(stream, entry, ','))
+	{
+		const auto pos = entry.find('=');
+		if (pos == std::string::npos)
+		{
+			continue;
+		}
+
+		const std::string channel = entry.substr(0, pos);
+		const u32 mask = (u32)strtoul(entry.substr(pos + 1).c_str(), nullptr, 0);
+		bool found = false;
+
+		for (const LogTypeName& name : gTypeNameTable)
+		{
+			// table names have a ": " suffix
+			if (name.mName.compare(0, name.mName.size() - 2, channel) == 0)
+			{
+				setSeverityMask(name.mType, mask);
+				found = true;
+			}
+		}
+
+		if (!found)
+		{
+			LOG_ERROR(GENERAL, "Unknown log channel in severity mask list: '%s'", channel.c_str());
+		}
+	}
+}
@@ -1,14 +1,22 @@
 #pragma once
 #include "Utilities/MTRingbuffer.h"
+#include <map>
 
-//#define BUFFERED_LOGGING 1
+class rFile;
+
+//severities that are compiled in (bit mask of Log::LogSeverity),
+//for example -DLOG_SEVERITY_MASK=0xc removes all success and notice messages from the build
+#ifndef LOG_SEVERITY_MASK
+#define LOG_SEVERITY_MASK 0xf
+#endif
 
 //first parameter is of type Log::LogType and text is of type std::string
+//the arguments are only evaluated if the severity is enabled for the channel
 
-#define LOG_SUCCESS(logType, text, ...)           log_message(logType, Log::Success, text, ##__VA_ARGS__)
-#define LOG_NOTICE(logType, text, ...)            log_message(logType, Log::Notice,  text, ##__VA_ARGS__) 
-#define LOG_WARNING(logType, text, ...)           log_message(logType, Log::Warning, text, ##__VA_ARGS__) 
-#define LOG_ERROR(logType, text, ...)             log_message(logType, Log::Error,   text, ##__VA_ARGS__)
+#define LOG_SUCCESS(logType, text, ...)           (!Log::is_enabled<Log::Success>(logType) ? (void)0 : log_message(logType, Log::Success, text, ##__VA_ARGS__))
+#define LOG_NOTICE(logType, text, ...)            (!Log::is_enabled<Log::Notice>(logType)  ? (void)0 : log_message(logType, Log::Notice,  text, ##__VA_ARGS__))
+#define LOG_WARNING(logType, text, ...)           (!Log::is_enabled<Log::Warning>(logType) ? (void)0 : log_message(logType, Log::Warning, text, ##__VA_ARGS__))
+#define LOG_ERROR(logType, text, ...)             (!Log::is_enabled<Log::Error>(logType)   ? (void)0 : log_message(logType, Log::Error,   text, ##__VA_ARGS__))
 
 namespace Log
 {
@@ -56,6 +64,22 @@ namespace Log
 		Error,
 	};
 
+	const u32 LOG_TYPE_COUNT = std::tuple_size<decltype(gTypeNameTable)>::value;
+	const u32 LOG_SEVERITY_ALL = 0xf;
+
+	// runtime masks of enabled severities (one bit per LogSeverity) for each channel
+	extern std::atomic<u32> g_severity_masks[LOG_TYPE_COUNT];
+
+	template<LogSeverity sev> struct LogSeverityCompiled
+	{
+		static const bool value = ((LOG_SEVERITY_MASK >> sev) & 1) != 0;
+	};
+
+	template<LogSeverity sev> __forceinline bool is_enabled(LogType type)
+	{
+		return LogSeverityCompiled<sev>::value && ((g_severity_masks[type].load(std::memory_order_relaxed) >> sev) & 1) != 0;
+	}
+
 	struct LogMessage
 	{
 		using size_type = u32;
@@ -74,6 +98,192 @@ namespace Log
 		virtual void log(LogMessage msg) = 0;
 	};
 
+	// formats the arguments of a deferred log record (called by the log consumer thread)
+	typedef std::string(*LogFormatter)(const char* fmt, const u8* args);
+
+	// type code of a deferred log argument, used by the decoder of binary logs: 's' C string, 'f'/'d' float/double,
+	// 'p' pointer, 'b'/'h'/'i'/'q' signed and 'B'/'H'/'I'/'Q' unsigned (or enum) 8/16/32/64-bit integer, '?' other
+	template<typename T> struct LogArgType
+	{
+		static const char value =
+			std::is_floating_point<T>::value ? (sizeof(T) == 4 ? 'f' : sizeof(T) == 8 ? 'd' : '?') :
+			std::is_pointer<T>::value ? 'p' :
+			!std::is_integral<T>::value && !std::is_enum<T>::value ? '?' :
+			sizeof(T) == 1 ? (std::is_signed<T>::value ? 'b' : 'B') :
+			sizeof(T) == 2 ? (std::is_signed<T>::value ? 'h' : 'H') :
+			sizeof(T) == 4 ? (std::is_signed<T>::value ? 'i' : 'I') :
+			sizeof(T) == 8 ? (std::is_signed<T>::value ? 'q' : 'Q') : '?';
+	};
+
+	template<> struct LogArgType<const char*> { static const char value = 's'; };
+	template<> struct LogArgType<char*> { static const char value = 's'; };
+
+	template<typename... Ts> struct LogArgTypes
+	{
+		static const char value[sizeof...(Ts) + 1];
+	};
+
+	template<typename... Ts> const char LogArgTypes<Ts...>::value[sizeof...(Ts) + 1] = { LogArgType<Ts>::value..., 0 };
+
+	// static description of the arguments of a deferred log record: the consumer thread formats them with format(),
+	// the decoder of binary logs formats the leading arguments with the printf format prefix, the others with the
+	// format string of the record
+	struct LogArgsInfo
+	{
+		LogFormatter format;
+		const char* prefix;
+		const char* types; // LogArgType of every stored argument
+	};
+
+	// argument of a deferred log record: strings are copied, everything else is stored by value
+	template<typename T> struct LogArg
+	{
+		static u32 size(const T& arg)
+		{
+			return sizeof(T);
+		}
+
+		static u8* store(u8* out, const T& arg)
+		{
+			memcpy(out, &arg, sizeof(T));
+			return out + sizeof(T);
+		}
+
+		static T load(const u8*& in)
+		{
+			typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type value;
+			memcpy(&value, in, sizeof(T));
+			in += sizeof(T);
+			return reinterpret_cast<T&>(value);
+		}
+	};
+
+	template<> struct LogArg<const char*>
+	{
+		static u32 size(const char* arg)
+		{
+			return (u32)strlen(arg ? arg : "(null)") + 1;
+		}
+
+		static u8* store(u8* out, const char* arg)
+		{
+			const u32 count = size(arg);
+			memcpy(out, arg ? arg : "(null)", count);
+			return out + count;
+		}
+
+		static const char* load(const u8*& in)
+		{
+			const char* res = (const char*)in;
+			in += strlen(res) + 1;
+			return res;
+		}
+	};
+
+	template<> struct LogArg<char*> : LogArg<const char*>
+	{
+		static char* load(const u8*& in)
+		{
+			return const_cast<char*>(LogArg<const char*>::load(in));
+		}
+	};
+
+	inline u32 log_args_size()
+	{
+		return 0;
+	}
+
+	template<typename T, typename... Ts> inline u32 log_args_size(const T& arg, const Ts&... args)
+	{
+		return LogArg<T>::size(arg) + log_args_size(args...);
+	}
+
+	inline void log_args_store(u8* out)
+	{
+	}
+
+	template<typename T, typename... Ts> inline void log_args_store(u8* out, const T& arg, const Ts&... args)
+	{
+		log_args_store(LogArg<T>::store(out, arg), args...);
+	}
+
+	// restores the argument list stored by log_args_store() and formats it
+	template<typename... Ts> struct LogArgs;
+
+	template<> struct LogArgs<>
+	{
+		template<typename... Args> static std::string format(const char* fmt, const u8* in, Args... args)
+		{
+			return fmt::Format(fmt, args...);
+		}
+	};
+
+	template<typename T, typename... Ts> struct LogArgs<T, Ts...>
+	{
+		template<typename... Args> static std::string format(const char* fmt, const u8* in, Args... args)
+		{
+			const T arg = LogArg<T>::load(in);
+			return LogArgs<Ts...>::format(fmt, in, args..., arg);
+		}
+	};
+
+	template<typename... Ts> std::string format_log_args(const char* fmt, const u8* args)
+	{
+		return LogArgs<Ts...>::format(fmt, args);
+	}
+
+	template<typename... Ts> struct LogMessageArgs
+	{
+		static const LogArgsInfo info;
+	};
+
+	template<typename... Ts> const LogArgsInfo LogMessageArgs<Ts...>::info = { &format_log_args<Ts...>, "", LogArgTypes<Ts...>::value };
+
+	enum LogRecordKind : u32
+	{
+		RecordMessage,
+		RecordThreadName, // followed by the name of the thread that writes the next records
+		RecordPadding, // skip to the beginning of the buffer
+	};
+
+	// header of a record in LogBuffer (followed by the argument data)
+	struct LogRecord
+	{
+		u32 size; // 8-byte aligned, including the header
+		LogRecordKind kind;
+		u64 seq; // global order of messages
+		const LogArgsInfo* info;
+		const char* fmt; // must be a static string
+		LogType type;
+		LogSeverity severity;
+	};
+
+	// single-producer single-consumer queue of log records, one per logging thread
+	class LogBuffer
+	{
+		std::unique_ptr<u8[]> m_data;
+		std::atomic<u32> m_get;
+		std::atomic<u32> m_put;
+
+	public:
+		static const u32 capacity = 256 * 1024;
+
+		const void* thread; // thread whose name was written last (producer only)
+		std::string name; // thread name for the records before m_get (consumer only)
+		std::atomic<bool> orphaned; // the owner thread has finished
+
+		LogBuffer();
+
+		// get space for a record of the given size, waits for the consumer if the buffer is full
+		u8* reserve(u32 size);
+		void commit(u32 size);
+
+		u32 get() const { return m_get.load(std::memory_order_relaxed); }
+		u32 put() const { return m_put.load(std::memory_order_acquire); }
+		void release(u32 get) { m_get.store(get, std::memory_order_release); }
+		const u8* at(u32 pos) const { return m_data.get() + (pos % capacity); }
+	};
+
 	struct LogChannel
 	{
 		LogChannel();
@@ -83,10 +293,9 @@ namespace Log
 		void log(LogMessage msg);
 		void addListener(std::shared_ptr<LogListener> listener);
 		void removeListener(std::shared_ptr<LogListener> listener);
+		bool hasListeners();
 		std::string name;
 	private:
-		bool mEnabled;
-		LogSeverity mLogLevel;
 		std::mutex mListenerLock;
 		std::set<std::shared_ptr<LogListener>> mListeners;
 	};
@@ -100,20 +309,92 @@ namespace Log
 		void log(LogMessage msg);
 		void addListener(std::shared_ptr<LogListener> listener);
 		void removeListener(std::shared_ptr<LogListener> listener);
-#ifdef BUFFERED_LOGGING
-		void consumeLog();
-#endif
+
+		static void setSeverityMask(LogType type, u32 mask);
+		static u32 getSeverityMask(LogType type);
+
+		// parse a list of "<channel>=<mask>" entries separated by commas (for example "HLE=0xc,RSX=0"),
+		// channels that are not listed are reset to LOG_SEVERITY_ALL
+		static void setSeverityMasks(const std::string& list);
+
+		// write a record to the buffer of the current thread, formatting is done by the consumer thread
+		template<typename... Ts> void push(LogType type, LogSeverity severity, const LogArgsInfo& info, const char* fmt, Ts... args)
+		{
+			const u32 size = AlignAddr((u32)sizeof(LogRecord) + log_args_size(args...), 8);
+
+			LogBuffer* buffer = size <= LogBuffer::capacity / 4 ? getThreadBuffer() : nullptr;
+			if (!buffer)
+			{
+				std::vector<u8> data(size);
+				log_args_store(data.data(), args...);
+				log({ type, severity, info.format(fmt, data.data()) });
+				return;
+			}
+
+			LogRecord& rec = *(LogRecord*)buffer->reserve(size);
+			rec.size = size;
+			rec.kind = RecordMessage;
+			rec.seq = mSeq++;
+			rec.info = &info;
+			rec.fmt = fmt;
+			rec.type = type;
+			rec.severity = severity;
+			log_args_store((u8*)(&rec + 1), args...);
+			buffer->commit(size);
+
+			if (mConsumerIdle.load(std::memory_order_relaxed))
+			{
+				wakeConsumer();
+			}
+		}
+
+		void wakeConsumer();
+
+		// wait until all records written before the call are processed
+		void flush();
+
+		// write the messages to a binary log file instead of the text log file (the records are copied as they are,
+		// formatting is left to decodeBinaryLog()), an empty path switches back to the text log file
+		bool setBinaryLog(const std::string& path);
+
+		// convert a binary log to the text of the log file, returns the number of messages or -1 if the file can't
+		// be read or isn't a binary log
+		static s64 decodeBinaryLog(const std::string& path, std::string& text);
+
+		// number of thread buffers (the buffers of finished threads are freed when they are drained)
+		u32 getBufferCount();
+
 	private:
-#ifdef BUFFERED_LOGGING
-		MTRingbuffer<char, MAX_LOG_BUFFER_LENGTH> mBuffer;
-		std::condition_variable mBufferReady;
-		std::mutex mStatusMut;
+		// returns nullptr if the caller must log synchronously
+		LogBuffer* getThreadBuffer();
+		void dispatch(LogMessage msg, const char* thread_name);
+		void writeBinary(const LogRecord* rec, const LogMessage* msg, const char* thread_name);
+		u32 consume();
+		void consumeLog();
+
+		std::mutex mBuffersLock;
+		std::vector<std::shared_ptr<LogBuffer>> mBuffers;
+		std::atomic<u64> mSeq;
+		std::atomic<u64> mProcessed; // number of records processed by the consumer
+		std::atomic<bool> mConsumerIdle;
 		std::atomic<bool> mExiting;
+		std::mutex mStatusMut;
+		std::condition_variable mBufferReady;
 		std::thread mLogConsumer;
-#endif
+
+		std::shared_ptr<LogListener> mFileListener;
+		std::atomic<bool> mBinaryEnabled;
+		std::mutex mBinaryLock;
+		std::unique_ptr<rFile> mBinaryFile;
+		std::vector<u8> mBinaryData; // chunks not written to the file yet
+		std::map<std::pair<const char*, const LogArgsInfo*>, u32> mBinaryFormats; // ids of the formats written
+		std::map<std::string, u32> mBinaryThreads; // ids of the thread names written
+
 		std::array<LogChannel, std::tuple_size<decltype(gTypeNameTable)>::value> mChannels;
 		//std::array<LogChannel,gTypeNameTable.size()> mChannels; //TODO: use this once Microsoft sorts their shit out
 	};
+
+	void RunAllTests();
 }
 
 static struct { inline operator Log::LogType() { return Log::LogType::GENERAL; } } GENERAL;
@@ -128,16 +409,12 @@ static struct { inline operator Log::LogType() { return Log::LogType::TTY; } } T
 
 inline void log_message(Log::LogType type, Log::LogSeverity sev, const char* text)
 {
-	//another msvc bug makes this not work, uncomment this and delete everything else in this function when it's fixed
-	//Log::LogManager::getInstance().log({logType, severity, text})
-
-	Log::LogMessage msg{type, sev, text};
-	Log::LogManager::getInstance().log(msg);
+	// the text isn't a format string
+	Log::LogManager::getInstance().push(type, sev, Log::LogMessageArgs<const char*>::info, "%s", text);
 }
 
 template<typename T, typename ...Ts> 
 inline void log_message(Log::LogType type, Log::LogSeverity sev, const char* text, T arg, Ts... args)
 {
-	Log::LogMessage msg{type, sev, fmt::Format(text, arg, args...)};
-	Log::LogManager::getInstance().log(msg);
+	Log::LogManager::getInstance().push(type, sev, Log::LogMessageArgs<T, Ts...>::info, text, arg, args...);
 }
\ No newline at end of file
@@ -0,0 +1,314 @@
+#include "stdafx.h"
+#include "Log.h"
+#include "rFile.h"
+#include "Emu/SysCalls/LogBase.h"
+
+//#define LOG_UNIT_TESTS 1
+
+#ifdef LOG_UNIT_TESTS
+
+// Caller-side latency and throughput of the deferred logging in text and binary mode (compared with formatting the
+// message on the calling thread), the cost of a disabled log statement, the binary log decoded by decodeBinaryLog()
+// must match the text the listeners got, and the buffers of raw std::threads must be freed when they finish.
+
+namespace
+{
+	const u32 s_threads = 4;
+	const u32 s_messages = 20000; // per thread
+
+	typedef std::chrono::high_resolution_clock test_clock;
+
+	u64 elapsed_ns(const test_clock::time_point& start)
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(test_clock::now() - start).count();
+	}
+
+	struct TestLogBase : LogBase
+	{
+		std::string name;
+
+		TestLogBase() : name("LogTest")
+		{
+		}
+
+		virtual const std::string& GetName() const override
+		{
+			return name;
+		}
+	};
+
+	// collects the messages that contain the marker, with the channel name like the log file
+	struct CaptureListener : Log::LogListener
+	{
+		std::mutex lock;
+		std::string marker;
+		std::vector<std::string> lines;
+
+		void log(Log::LogMessage msg)
+		{
+			if (msg.mText.find(marker) != std::string::npos)
+			{
+				std::lock_guard<std::mutex> guard(lock);
+				lines.push_back(Log::gTypeNameTable[msg.mType].mName + msg.mText);
+			}
+		}
+	};
+
+	// every thread logs s_messages messages, written to the binary log if the path isn't empty
+	u32 run_benchmark(const char* mode, const std::string& binary_path)
+	{
+		auto& manager = Log::LogManager::getInstance();
+
+		if (!manager.setBinaryLog(binary_path))
+		{
+			return 1;
+		}
+
+		std::vector<u64> latency(s_threads * s_messages);
+		std::vector<std::thread> threads;
+
+		const auto start = test_clock::now();
+
+		for (u32 t = 0; t < s_threads; t++)
+		{
+			threads.emplace_back([t, &latency]()
+			{
+				for (u32 i = 0; i < s_messages; i++)
+				{
+					const auto stamp = test_clock::now();
+					LOG_NOTICE(GENERAL, "Log benchmark: thread %d, message %d, value %f, name %s", t, i, i * 0.5, "benchmark");
+					latency[t * s_messages + i] = elapsed_ns(stamp);
+				}
+			});
+		}
+
+		for (auto& thr : threads)
+		{
+			thr.join();
+		}
+
+		const u64 caller_time = elapsed_ns(start);
+		manager.flush();
+		const u64 total_time = elapsed_ns(start);
+
+		// the results are written to the text log
+		if (binary_path.size())
+		{
+			manager.setBinaryLog("");
+			rRemoveFile(binary_path);
+		}
+
+		std::sort(latency.begin(), latency.end());
+
+		LOG_NOTICE(GENERAL, "Log (%s): caller latency median %lld ns, p99 %lld ns, max %lld ns", mode,
+			latency[latency.size() / 2], latency[latency.size() * 99 / 100], latency.back());
+		LOG_NOTICE(GENERAL, "Log (%s): %.0f messages/s logged by %d threads, %.0f messages/s written", mode,
+			latency.size() * 1e9 / caller_time, s_threads, latency.size() * 1e9 / total_time);
+
+		return 0;
+	}
+
+	// a disabled log statement in a tight loop, compared with the loop alone. The severity is masked at runtime, or
+	// compiled out if LOG_SEVERITY_MASK doesn't contain it, and the argument must never be evaluated.
+	u32 run_disabled_benchmark()
+	{
+		const u32 iterations = 10000000;
+		const u32 mask = Log::LogManager::getSeverityMask(Log::GENERAL);
+		volatile u32 sink = 0;
+		u32 evaluated = 0;
+
+		auto argument = [&evaluated](u32 i)
+		{
+			evaluated++;
+			return std::to_string(i);
+		};
+
+		Log::LogManager::setSeverityMask(Log::GENERAL, mask & ~(1 << Log::Success | 1 << Log::Notice));
+
+		auto start = test_clock::now();
+		for (u32 i = 0; i < iterations; i++)
+		{
+			sink = sink + i;
+		}
+		const u64 empty_time = elapsed_ns(start);
+
+		start = test_clock::now();
+		for (u32 i = 0; i < iterations; i++)
+		{
+			sink = sink + i;
+			LOG_NOTICE(GENERAL, "Log benchmark: %s", argument(i).c_str());
+		}
+		const u64 masked_time = elapsed_ns(start);
+
+		start = test_clock::now();
+		for (u32 i = 0; i < iterations; i++)
+		{
+			sink = sink + i;
+			LOG_SUCCESS(GENERAL, "Log benchmark: %s", argument(i).c_str());
+		}
+		const u64 success_time = elapsed_ns(start);
+
+		Log::LogManager::setSeverityMask(Log::GENERAL, mask);
+
+		LOG_NOTICE(GENERAL, "Log (disabled): loop %.2f ns, masked notice %.2f ns, %s success %.2f ns per iteration",
+			(double)empty_time / iterations, (double)masked_time / iterations,
+			Log::LogSeverityCompiled<Log::Success>::value ? "masked" : "compiled out", (double)success_time / iterations);
+
+		if (evaluated)
+		{
+			LOG_ERROR(GENERAL, "Log: the arguments of %d disabled messages were evaluated", evaluated);
+			return 1;
+		}
+
+		return 0;
+	}
+
+	u32 test_round_trip()
+	{
+		const std::string path = "./log_test.blog";
+		const std::string marker = "{log round trip}";
+		auto& manager = Log::LogManager::getInstance();
+
+		std::shared_ptr<CaptureListener> listener(new CaptureListener());
+		listener->marker = marker;
+
+		if (!manager.setBinaryLog(path))
+		{
+			LOG_ERROR(GENERAL, "Log: binary log '%s' can't be created", path.c_str());
+			return 1;
+		}
+
+		manager.addListener(listener);
+
+		TestLogBase base;
+		const char* null_str = nullptr;
+		const std::string long_text(Log::LogBuffer::capacity / 2, 'x'); // logged synchronously
+
+		LOG_NOTICE(GENERAL, "%s no arguments, 100%% literal", marker.c_str());
+		LOG_WARNING(HLE, "%s %d %u %x %08X %o %5d|%-5d| %+d", marker.c_str(), -123, 4000000000u, 0xdeadbeef, 0xabc, 8, 42, 42, 7);
+		LOG_ERROR(MEMORY, "%s %lld %llu %llx 0x%016llx", marker.c_str(), -1234567890123ll, 18446744073709551615ull, 0x123456789abull, 1ull);
+		LOG_SUCCESS(LOADER, "%s %hhd %hd %c %d %d", marker.c_str(), (s8)-5, (s16)-300, 'R', (u8)200, (u16)60000);
+		LOG_NOTICE(RSX, "%s %f %.3f %e %g %10.2f", marker.c_str(), 1.5, 3.14159f, 1e-10, 2.5, -7.125);
+		LOG_NOTICE(PPU, "%s '%s' '%10s' '%-4s|' '%.2s' %s", marker.c_str(), "text", "right", "l", "truncated", null_str);
+		LOG_NOTICE(SPU, "%s %*d|%-*d|%.*f", marker.c_str(), 6, 1, 4, 2, 2, 0.125);
+
+		// written to the binary log directly, after the records of the consumer thread
+		manager.flush();
+		LOG_NOTICE(GENERAL, "%s %s", marker.c_str(), long_text.c_str());
+		base.Error("%s module error %d", marker.c_str(), 5);
+		base.Warning(0x42, "%s module warning with id 0x%x", marker.c_str(), 0x1234);
+
+		std::thread([&]()
+		{
+			LOG_NOTICE(ARMv7, "%s from a raw thread %d", marker.c_str(), 1);
+		}).join();
+
+		manager.setBinaryLog("");
+		manager.removeListener(listener);
+
+		std::string text;
+		const s64 count = Log::LogManager::decodeBinaryLog(path, text);
+		rRemoveFile(path);
+
+		std::vector<std::string> decoded;
+		std::istringstream stream(text);
+
+		for (std::string line; std::getline(stream, line);)
+		{
+			if (line.find(marker) != std::string::npos)
+			{
+				decoded.push_back(line + "\n");
+			}
+		}
+
+		u32 failed = 0;
+
+		// the LOG_SUCCESS message is missing if the severity is compiled out
+		const size_t expected = Log::LogSeverityCompiled<Log::Success>::value ? 11 : 10;
+
+		if (count < 0 || decoded.size() != expected || decoded != listener->lines)
+		{
+			LOG_ERROR(GENERAL, "Log: %d of %d decoded messages match (%lld messages in the binary log)",
+				(u32)decoded.size(), (u32)listener->lines.size(), count);
+			failed++;
+
+			for (size_t i = 0; i < decoded.size() && i < listener->lines.size(); i++)
+			{
+				if (decoded[i] != listener->lines[i] && decoded[i].size() < 1000)
+				{
+					LOG_ERROR(GENERAL, "Log: decoded '%s', logged '%s'", decoded[i].c_str(), listener->lines[i].c_str());
+				}
+			}
+		}
+
+		return failed;
+	}
+
+	// the buffers of threads that aren't started by NamedThreadBase must be freed when they finish
+	u32 test_thread_buffers()
+	{
+		auto& manager = Log::LogManager::getInstance();
+		manager.flush();
+
+		const u32 before = manager.getBufferCount();
+
+		for (u32 i = 0; i < 16; i++)
+		{
+			std::thread([i]()
+			{
+				LOG_NOTICE(GENERAL, "Log: raw thread %d", i);
+			}).join();
+		}
+
+		// the drained buffers are freed after the messages are written
+		for (u32 i = 0; i < 100 && manager.getBufferCount() > before; i++)
+		{
+			manager.flush();
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+
+		if (manager.getBufferCount() > before)
+		{
+			LOG_ERROR(GENERAL, "Log: %d thread buffers before, %d after the threads finished", before, manager.getBufferCount());
+			return 1;
+		}
+
+		return 0;
+	}
+}
+
+void Log::RunAllTests()
+{
+	LOG_NOTICE(GENERAL, "Running log tests");
+
+	u32 num_failed = 0;
+
+	// formatting on the calling thread, like before the messages were deferred
+	{
+		const auto start = test_clock::now();
+		size_t size = 0;
+
+		for (u32 i = 0; i < s_messages; i++)
+		{
+			size += fmt::Format("Log benchmark: thread %d, message %d, value %f, name %s", 0, i, i * 0.5, "benchmark").size();
+		}
+
+		LOG_NOTICE(GENERAL, "Log: %lld ns per message formatted by the caller (%d bytes)", elapsed_ns(start) / s_messages, (u32)size);
+	}
+
+	num_failed += run_benchmark("text", "");
+	num_failed += run_benchmark("binary", "./log_bench.blog");
+	num_failed += run_disabled_benchmark();
+	num_failed += test_round_trip();
+	num_failed += test_thread_buffers();
+
+	LOG_NOTICE(GENERAL, "Unit Tests done (%d failed)", num_failed);
+}
+
+#else
+
+void Log::RunAllTests()
+{
+}
+
+#endif // LOG_UNIT_TESTS
@@ -14,41 +14,71 @@ class MTRingbuffer{
 	std::recursive_mutex mMutGet;
 	std::mutex mMutPut;
 
-	size_t mGet;
-	size_t mPut;
+	//the indices are only written with the matching get/put mutex held, the other side reads them
+	//without locking, so a single consumer and a single (serialized) producer never contend
+	std::atomic<size_t> mGet;
+	std::atomic<size_t> mPut;
+
+	//a side that finds the buffer empty/full parks here until the other side moved its index
+	std::mutex mMutWait;
+	std::condition_variable mCvWait;
+	std::atomic<u32> mWaiters;
+
 	size_t moveGet(size_t by = 1){ return (mGet + by) % MAX_MTRINGBUFFER_BUFFER_SIZE; }
 	size_t movePut(size_t by = 1){ return (mPut + by) % MAX_MTRINGBUFFER_BUFFER_SIZE; }
+
+	template<typename F>
+	void waitUntil(F pred)
+	{
+		if (pred()) return;
+
+		std::unique_lock<std::mutex> lock(mMutWait);
+		mWaiters++;
+		while (!pred())
+		{
+			//the timeout only matters if the other side is gone
+			mCvWait.wait_for(lock, std::chrono::milliseconds(10));
+		}
+		mWaiters--;
+	}
+
+	void wakeWaiters()
+	{
+		if (mWaiters)
+		{
+			std::lock_guard<std::mutex> lock(mMutWait);
+			mCvWait.notify_all();
+		}
+	}
+
 public:
-	MTRingbuffer() : mGet(0), mPut(0){}
+	MTRingbuffer() : mGet(0), mPut(0), mWaiters(0){}
 
 	//blocks until there's something to get, so check "spaceLeft()" if you want to avoid blocking
 	//also lock the get mutex around the spaceLeft() check and the pop if you want to avoid racing
 	T pop()
 	{
 		std::lock_guard<std::recursive_mutex> lock(mMutGet);
-		while (mGet == mPut)
-		{
-			//wait until there's actually something to get
-			//throwing an exception might be better, blocking here is a little awkward
-			std::this_thread::sleep_for(std::chrono::milliseconds(1));
-		}
+		//wait until there's actually something to get
+		//throwing an exception might be better, blocking here is a little awkward
+		waitUntil([this]() { return mGet != mPut; });
 		size_t ret = mGet;
+		T result = mBuffer[ret];
 		mGet = moveGet();
-		return mBuffer[ret];
+		wakeWaiters();
+		return result;
 	}
 
 	//blocks if the buffer is full until there's enough room
 	void push(T &putEle)
 	{
 		std::lock_guard<std::mutex> lock(mMutPut);
-		while (movePut() == mGet)
-		{
-			//if this is reached a lot it's time to increase the buffer size
-			//or implement dynamic re-sizing
-			std::this_thread::sleep_for(std::chrono::milliseconds(1));
-		}
+		//if this is reached a lot it's time to increase the buffer size
+		//or implement dynamic re-sizing
+		waitUntil([this]() { return movePut() != mGet; });
 		mBuffer[mPut] = std::forward(putEle);
 		mPut = movePut();
+		wakeWaiters();
 	}
 
 	bool empty()
@@ -61,13 +91,15 @@ public:
 	//space, so we shouldn't report it as free.
 	size_t spaceLeft() //apparently free() is a macro definition in msvc in some conditions
 	{
-		if (mGet < mPut)
+		const size_t lGet = mGet;
+		const size_t lPut = mPut;
+		if (lGet < lPut)
 		{
-			return mBuffer.size() - (mPut - mGet) - 1;
+			return mBuffer.size() - (lPut - lGet) - 1;
 		}
-		else if (mGet > mPut)
+		else if (lGet > lPut)
 		{
-			return mGet - mPut - 1;
+			return lGet - lPut - 1;
 		}
 		else
 		{
@@ -90,12 +122,9 @@ public:
 
 		//if whatever we're trying to store is greater than the entire buffer the following loop will be infinite
 		assert(mBuffer.size() > length);
-		while (spaceLeft() < length)
-		{
-			//if this is reached a lot it's time to increase the buffer size
-			//or implement dynamic re-sizing
-			std::this_thread::sleep_for(std::chrono::milliseconds(1));
-		}
+		//if this is reached a lot it's time to increase the buffer size
+		//or implement dynamic re-sizing
+		waitUntil([this, length]() { return spaceLeft() >= length; });
 		if (mPut + length <= mBuffer.size())
 		{
 			std::copy(from, until, mBuffer.begin() + mPut);
@@ -107,7 +136,7 @@ public:
 			std::copy(from + tillEnd, until, mBuffer.begin());
 		}
 		mPut = movePut(length);
-
+		wakeWaiters();
 	}
 
 	//takes output iterator to T
@@ -119,6 +148,7 @@ public:
 		assert(n <= size());
 		peekN<IteratorType>(output, n);
 		mGet = moveGet(n);
+		wakeWaiters();
 	}
 
 	//takes output iterator to T
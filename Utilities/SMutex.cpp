@@ -4,6 +4,8 @@
 
 #include "Utilities/SMutex.h"
 
+waiter_map_t g_sm_wm("sm_wm");
+
 bool SM_IsAborted()
 {
 	return Emu.IsStopped();
@@ -1,8 +1,12 @@
 #pragma once
 #include "Emu/Memory/atomic_type.h"
+#include "Utilities/Thread.h"
 
 bool SM_IsAborted();
 
+// threads waiting for SMutexBase ownership changes (signal_id is the address of the owner field)
+extern waiter_map_t g_sm_wm;
+
 enum SMutexResult
 {
 	SMR_OK = 0, // succeeded (lock, trylock, unlock)
@@ -48,6 +52,13 @@ public:
 	void finalize()
 	{
 		owner = GetDeadValue();
+		notify();
+	}
+
+	// wake up threads waiting in lock() or wait_owner()
+	__forceinline void notify()
+	{
+		g_sm_wm.notify((u64)&owner);
 	}
 
 	__forceinline T GetOwner() const
@@ -76,6 +87,7 @@ public:
 			return SMR_FAILED;
 		}
 
+		notify();
 		return SMR_OK;
 	}
 
@@ -101,28 +113,39 @@ public:
 			return SMR_PERMITTED;
 		}
 
+		if (to != tid)
+		{
+			notify();
+		}
+
 		return SMR_OK;
 	}
 
+	// timeout is in microseconds (0 = infinite)
 	SMutexResult lock(T tid, u64 timeout = 0)
 	{
-		u64 counter = 0;
+		SMutexResult res = SMR_FAILED;
 
-		while (true)
+		g_sm_wm.wait_op((u64)&owner, [this, tid, &res]()
 		{
-			switch (SMutexResult res = trylock(tid))
-			{
-				case SMR_FAILED: break;
-				default: return res;
-			}
+			return (res = trylock(tid)) != SMR_FAILED;
+		}, timeout);
 
-			std::this_thread::sleep_for(std::chrono::milliseconds(1));
-
-			if (timeout && counter++ > timeout)
-			{
-				return SMR_TIMEOUT;
-			}
+		if (res == SMR_FAILED)
+		{
+			return SM_IsAborted() ? SMR_ABORT : SMR_TIMEOUT;
 		}
+
+		return res;
+	}
+
+	// wait until the ownership is passed to tid by another thread, timeout is in microseconds (0 = infinite)
+	bool wait_owner(T tid, u64 timeout = 0)
+	{
+		return g_sm_wm.wait_op((u64)&owner, [this, tid]()
+		{
+			return GetOwner() == tid || GetOwner() == GetDeadValue();
+		}, timeout);
 	}
 };
 
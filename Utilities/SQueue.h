@@ -1,113 +1,275 @@
 #pragma once
+#include "Utilities/Thread.h"
 
 static const volatile bool sq_no_wait = true;
 
-template<typename T, u32 SQSize = 666>
-class SQueue
+// Blocking interface shared by bounded lock-free queues (Q must implement TryPush, TryPop and TryPeek).
+// A thread that has to wait for an element or for free space is parked on a waiter map and woken up by
+// the opposite side, so there is no polling. Waiting is aborted if the emulator is stopped or *do_exit is set.
+template<typename Q, typename T>
+class SQueueBase
 {
-	std::mutex m_mutex;
-	u32 m_pos;
-	u32 m_count;
-	T m_data[SQSize];
+	enum : u64
+	{
+		SQ_NOT_EMPTY,
+		SQ_NOT_FULL,
+	};
 
-public:
-	SQueue()
-		: m_pos(0)
-		, m_count(0)
+	waiter_map_t m_wm;
+
+	Q& queue()
 	{
+		return static_cast<Q&>(*this);
 	}
 
-	const u32 GetSize() const
+	static bool is_aborted(const volatile bool* do_exit)
 	{
-		return SQSize;
+		return Emu.IsStopped() || (do_exit && *do_exit);
 	}
 
+protected:
+	SQueueBase()
+		: m_wm("squeue_wm")
+	{
+	}
+
+public:
 	bool Push(const T& data, const volatile bool* do_exit)
 	{
-		while (true)
+		bool pushed = false;
+
+		m_wm.wait_op(SQ_NOT_FULL, [&]()
 		{
-			if (m_count >= SQSize)
-			{
-				if (Emu.IsStopped() || (do_exit && *do_exit))
-				{
-					return false;
-				}
+			return (pushed = queue().TryPush(data)) || is_aborted(do_exit);
+		});
 
-				std::this_thread::sleep_for(std::chrono::milliseconds(1));
-				continue;
-			}
+		if (pushed)
+		{
+			m_wm.notify(SQ_NOT_EMPTY);
+		}
 
-			{
-				std::lock_guard<std::mutex> lock(m_mutex);
+		return pushed;
+	}
 
-				if (m_count >= SQSize) continue;
+	bool Pop(T& data, const volatile bool* do_exit)
+	{
+		bool popped = false;
 
-				m_data[(m_pos + m_count++) % SQSize] = data;
+		m_wm.wait_op(SQ_NOT_EMPTY, [&]()
+		{
+			return (popped = queue().TryPop(data)) || is_aborted(do_exit);
+		});
 
-				return true;
-			}
+		if (popped)
+		{
+			m_wm.notify(SQ_NOT_FULL);
 		}
+
+		return popped;
 	}
 
-	bool Pop(T& data, const volatile bool* do_exit)
+	// only valid if there is a single consumer
+	bool Peek(T& data, const volatile bool* do_exit, u32 pos = 0)
 	{
-		while (true)
+		bool found = false;
+
+		m_wm.wait_op(SQ_NOT_EMPTY, [&]()
 		{
-			if (!m_count)
-			{
-				if (Emu.IsStopped() || (do_exit && *do_exit))
-				{
-					return false;
-				}
+			return (found = queue().TryPeek(data, pos)) || is_aborted(do_exit);
+		});
 
-				std::this_thread::sleep_for(std::chrono::milliseconds(1));
-				continue;
-			}
+		return found;
+	}
 
-			{
-				std::lock_guard<std::mutex> lock(m_mutex);
+	void Clear()
+	{
+		T data;
+		while (queue().TryPop(data))
+		{
+		}
 
-				if (!m_count) continue;
+		m_wm.notify(SQ_NOT_FULL);
+	}
+};
 
-				data = m_data[m_pos];
-				m_pos = (m_pos + 1) % SQSize;
-				m_count--;
+// Bounded lock-free multi-producer multi-consumer queue (D. Vyukov's algorithm)
+template<typename T, u32 SQSize = 666>
+class SQueue : public SQueueBase<SQueue<T, SQSize>, T>
+{
+	struct cell_t
+	{
+		std::atomic<u64> seq; // equals position when free, position + 1 when filled
+		T data;
+	};
 
-				return true;
-			}
+	cell_t m_data[SQSize];
+	std::atomic<u64> m_push_pos;
+	std::atomic<u64> m_pop_pos;
+
+public:
+	SQueue()
+		: m_push_pos(0)
+		, m_pop_pos(0)
+	{
+		for (u32 i = 0; i < SQSize; i++)
+		{
+			m_data[i].seq.store(i, std::memory_order_relaxed);
 		}
 	}
 
-	void Clear()
+	const u32 GetSize() const
 	{
-		std::lock_guard<std::mutex> lock(m_mutex);
-		m_count = 0;
+		return SQSize;
 	}
 
-	bool Peek(T& data, const volatile bool* do_exit, u32 pos = 0)
+	bool TryPush(const T& data)
 	{
+		u64 pos = m_push_pos.load(std::memory_order_relaxed);
+		cell_t* cell;
+
 		while (true)
 		{
-			if (m_count <= pos)
+			cell = &m_data[pos % SQSize];
+			const s64 diff = (s64)cell->seq.load(std::memory_order_acquire) - (s64)pos;
+
+			if (diff == 0)
 			{
-				if (Emu.IsStopped() || (do_exit && *do_exit))
+				if (m_push_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
 				{
-					return false;
+					break;
 				}
-				
-				std::this_thread::sleep_for(std::chrono::milliseconds(1));
-				continue;
 			}
+			else if (diff < 0)
+			{
+				return false; // full
+			}
+			else
+			{
+				pos = m_push_pos.load(std::memory_order_relaxed);
+			}
+		}
+
+		cell->data = data;
+		cell->seq.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool TryPop(T& data)
+	{
+		u64 pos = m_pop_pos.load(std::memory_order_relaxed);
+		cell_t* cell;
+
+		while (true)
+		{
+			cell = &m_data[pos % SQSize];
+			const s64 diff = (s64)cell->seq.load(std::memory_order_acquire) - (s64)(pos + 1);
 
+			if (diff == 0)
 			{
-				std::lock_guard<std::mutex> lock(m_mutex);
-				if (m_count > pos)
+				if (m_pop_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
 				{
 					break;
 				}
 			}
+			else if (diff < 0)
+			{
+				return false; // empty
+			}
+			else
+			{
+				pos = m_pop_pos.load(std::memory_order_relaxed);
+			}
+		}
+
+		data = cell->data;
+		cell->seq.store(pos + SQSize, std::memory_order_release);
+		return true;
+	}
+
+	bool TryPeek(T& data, u32 pos)
+	{
+		if (pos >= SQSize)
+		{
+			return false;
+		}
+
+		const u64 abs_pos = m_pop_pos.load(std::memory_order_relaxed) + pos;
+		const cell_t& cell = m_data[abs_pos % SQSize];
+
+		if (cell.seq.load(std::memory_order_acquire) != abs_pos + 1)
+		{
+			return false;
+		}
+
+		data = cell.data;
+		return true;
+	}
+};
+
+// Bounded lock-free single-producer single-consumer queue
+template<typename T, u32 SQSize>
+class SQueueSPSC : public SQueueBase<SQueueSPSC<T, SQSize>, T>
+{
+	T m_data[SQSize];
+	std::atomic<u64> m_push_pos; // modified by producer only
+	std::atomic<u64> m_pop_pos; // modified by consumer only
+
+public:
+	SQueueSPSC()
+		: m_push_pos(0)
+		, m_pop_pos(0)
+	{
+	}
+
+	const u32 GetSize() const
+	{
+		return SQSize;
+	}
+
+	bool TryPush(const T& data)
+	{
+		const u64 pos = m_push_pos.load(std::memory_order_relaxed);
+
+		if (pos - m_pop_pos.load(std::memory_order_acquire) >= SQSize)
+		{
+			return false; // full
+		}
+
+		m_data[pos % SQSize] = data;
+		m_push_pos.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool TryPop(T& data)
+	{
+		const u64 pos = m_pop_pos.load(std::memory_order_relaxed);
+
+		if (pos == m_push_pos.load(std::memory_order_acquire))
+		{
+			return false; // empty
+		}
+
+		data = m_data[pos % SQSize];
+		m_pop_pos.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool TryPeek(T& data, u32 pos)
+	{
+		const u64 abs_pos = m_pop_pos.load(std::memory_order_relaxed) + pos;
+
+		if (abs_pos >= m_push_pos.load(std::memory_order_acquire))
+		{
+			return false;
 		}
-		data = m_data[(m_pos + pos) % SQSize];
+
+		data = m_data[abs_pos % SQSize];
 		return true;
 	}
 };
+
+namespace squeue
+{
+	// throughput and wake-up latency benchmark of the queues (empty unless enabled in SQueueTests.cpp)
+	void RunAllTests();
+}
@@ -0,0 +1,226 @@
+#include "stdafx.h"
+#include "Log.h"
+#include "Emu/System.h"
+#include "SQueue.h"
+
+//#define SQUEUE_UNIT_TESTS 1
+
+#ifdef SQUEUE_UNIT_TESTS
+
+// Throughput of SQueueSPSC and SQueue (compared with a deque guarded by a mutex and a condition variable) and the time a
+// parked consumer needs to wake up after a push. The values are checked, so lost or duplicated elements are detected.
+// Waits are aborted while the emulator is stopped, so this is called from Emulator::Run() (only the first time).
+
+namespace
+{
+	const u64 s_elements = 1000000;
+	const u32 s_wakeups = 1000;
+
+	typedef std::chrono::high_resolution_clock test_clock;
+
+	// the baseline: a blocking queue like the old SQueue but with a condition variable instead of polling
+	template<typename T, u32 SQSize>
+	class locked_queue
+	{
+		std::mutex m_mutex;
+		std::condition_variable m_cv;
+		std::deque<T> m_data;
+
+	public:
+		bool Push(const T& data, const volatile bool* do_exit)
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_cv.wait(lock, [this]() { return m_data.size() < SQSize; });
+			m_data.push_back(data);
+			m_cv.notify_all();
+			return true;
+		}
+
+		bool Pop(T& data, const volatile bool* do_exit)
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_cv.wait(lock, [this]() { return !m_data.empty(); });
+			data = m_data.front();
+			m_data.pop_front();
+			m_cv.notify_all();
+			return true;
+		}
+	};
+
+	// every producer pushes s_elements / producers values, returns the number of errors
+	template<typename Q> u32 run_throughput(const char* name, u32 producers, u32 consumers)
+	{
+		Q* queue = new Q;
+		const u64 count = s_elements / producers;
+		std::atomic<u64> sum(0), popped(0);
+		std::atomic<u32> errors(0);
+
+		const auto start = test_clock::now();
+		std::vector<std::unique_ptr<thread>> threads;
+
+		for (u32 p = 0; p < producers; p++)
+		{
+			threads.emplace_back(new thread(fmt::Format("SQueue producer %d", p), [queue, count, &errors]()
+			{
+				for (u64 i = 1; i <= count; i++)
+				{
+					if (!queue->Push(i, nullptr))
+					{
+						errors++;
+						return;
+					}
+				}
+			}));
+		}
+
+		for (u32 c = 0; c < consumers; c++)
+		{
+			threads.emplace_back(new thread(fmt::Format("SQueue consumer %d", c), [queue, count, producers, consumers, &sum, &popped, &errors]()
+			{
+				u64 last = 0;
+
+				for (u64 i = 0; i < count * producers / consumers; i++)
+				{
+					u64 value;
+
+					if (!queue->Pop(value, nullptr))
+					{
+						errors++;
+						return;
+					}
+
+					// with a single producer, the values must arrive in order
+					if (producers == 1 && value != last + 1)
+					{
+						errors++;
+					}
+
+					last = value;
+					sum += value;
+					popped++;
+				}
+			}));
+		}
+
+		for (auto& t : threads)
+		{
+			t->join();
+		}
+
+		const double seconds = std::chrono::duration<double>(test_clock::now() - start).count();
+		delete queue;
+
+		if (popped != count * producers || sum != producers * count * (count + 1) / 2)
+		{
+			errors++;
+		}
+
+		LOG_NOTICE(GENERAL, "%s: %d:%d threads: %.2f M elements/s", name, producers, consumers, popped / seconds / 1000000);
+
+		if (errors)
+		{
+			LOG_ERROR(GENERAL, "%s: %d:%d threads: %d errors (%lld of %lld elements popped)", name, producers, consumers, errors.load(), popped.load(), count * producers);
+		}
+
+		return errors;
+	}
+
+	// the producer sleeps before every push, so the consumer is parked on the empty queue, and pushes the current time
+	template<typename Q> u32 run_wakeup(const char* name)
+	{
+		Q* queue = new Q;
+		std::atomic<u32> errors(0);
+		std::vector<u64> latency;
+
+		thread consumer("SQueue consumer", [queue, &latency, &errors]()
+		{
+			for (u32 i = 0; i < s_wakeups; i++)
+			{
+				u64 value;
+
+				if (!queue->Pop(value, nullptr))
+				{
+					errors++;
+					return;
+				}
+
+				const u64 now = std::chrono::duration_cast<std::chrono::nanoseconds>(test_clock::now().time_since_epoch()).count();
+				latency.push_back(now - value);
+			}
+		});
+
+		thread producer("SQueue producer", [queue, &errors]()
+		{
+			for (u32 i = 0; i < s_wakeups; i++)
+			{
+				std::this_thread::sleep_for(std::chrono::microseconds(200));
+
+				if (!queue->Push(std::chrono::duration_cast<std::chrono::nanoseconds>(test_clock::now().time_since_epoch()).count(), nullptr))
+				{
+					errors++;
+					return;
+				}
+			}
+		});
+
+		producer.join();
+		consumer.join();
+		delete queue;
+
+		if (errors || latency.size() != s_wakeups)
+		{
+			LOG_ERROR(GENERAL, "%s: wake-up: %d errors", name, errors.load());
+			return errors ? errors.load() : 1;
+		}
+
+		std::sort(latency.begin(), latency.end());
+
+		LOG_NOTICE(GENERAL, "%s: wake-up latency: median %.1f us, p99 %.1f us, max %.1f us", name,
+			latency[s_wakeups / 2] / 1000.0, latency[s_wakeups * 99 / 100] / 1000.0, latency.back() / 1000.0);
+
+		return 0;
+	}
+}
+
+namespace squeue
+{
+	void RunAllTests()
+	{
+		static bool s_done = false;
+
+		if (s_done)
+		{
+			return;
+		}
+
+		s_done = true;
+
+		LOG_NOTICE(GENERAL, "Running SQueue tests");
+
+		u32 num_failed = 0;
+
+		num_failed += run_throughput<SQueueSPSC<u64, 256>>("SQueueSPSC", 1, 1) != 0;
+		num_failed += run_throughput<SQueue<u64, 256>>("SQueue", 1, 1) != 0;
+		num_failed += run_throughput<SQueue<u64, 256>>("SQueue", 2, 2) != 0;
+		num_failed += run_throughput<SQueue<u64, 256>>("SQueue", 4, 4) != 0;
+		num_failed += run_throughput<locked_queue<u64, 256>>("mutex queue", 1, 1) != 0;
+		num_failed += run_throughput<locked_queue<u64, 256>>("mutex queue", 4, 4) != 0;
+
+		num_failed += run_wakeup<SQueueSPSC<u64, 256>>("SQueueSPSC") != 0;
+		num_failed += run_wakeup<SQueue<u64, 256>>("SQueue") != 0;
+		num_failed += run_wakeup<locked_queue<u64, 256>>("mutex queue") != 0;
+
+		LOG_NOTICE(GENERAL, "Unit Tests done (%d failed)", num_failed);
+	}
+}
+
+#else
+
+namespace squeue
+{
+	void RunAllTests()
+	{
+	}
+}
+
+#endif // SQUEUE_UNIT_TESTS
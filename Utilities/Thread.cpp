@@ -2,6 +2,7 @@
 #include "Emu/System.h"
 #include "Log.h"
 #include "Thread.h"
+#include "Emu/PerfCounters.h"
 
 thread_local NamedThreadBase* g_tls_this_thread = nullptr;
 std::atomic<u32> g_thread_count(0);
@@ -49,11 +50,14 @@ void NamedThreadBase::SetThreadName(const std::string& name)
 void NamedThreadBase::WaitForAnySignal(u64 time) // wait for Notify() signal or sleep
 {
 	std::unique_lock<std::mutex> lock(m_signal_mtx);
-	m_signal_cv.wait_for(lock, std::chrono::milliseconds(time));
+	m_signal_cv.wait_for(lock, std::chrono::milliseconds(time), [this]() { return m_signaled; });
+	m_signaled = false;
 }
 
-void NamedThreadBase::Notify() // wake up waiting thread or nothing
+void NamedThreadBase::Notify() // wake up waiting thread (the signal is kept if it isn't waiting yet)
 {
+	std::lock_guard<std::mutex> lock(m_signal_mtx);
+	m_signaled = true;
 	m_signal_cv.notify_one();
 }
 
@@ -103,6 +107,7 @@ void ThreadBase::Start()
 
 		m_alive = false;
 		SetCurrentNamedThread(nullptr);
+		perf::release_thread();
 		g_thread_count--;
 	});
 }
@@ -190,6 +195,7 @@ void thread::start(std::function<void()> func)
 		}
 
 		SetCurrentNamedThread(nullptr);
+		perf::release_thread();
 		g_thread_count--;
 	});
 }
@@ -219,16 +225,41 @@ bool waiter_map_t::is_stopped(u64 signal_id)
 	return false;
 }
 
+u64 waiter_map_t::get_time()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 void waiter_map_t::waiter_reg_t::init()
 {
 	if (thread) return;
 
 	thread = GetCurrentNamedThread();
 
+	if (!thread) return; // not a named thread, fall back to sleeping in wait()
+
 	std::lock_guard<std::mutex> lock(map.m_mutex);
 
 	// add waiter
 	map.m_waiters.push_back({ signal_id, thread });
+	map.m_count++;
+}
+
+void waiter_map_t::waiter_reg_t::wait(u64 time)
+{
+	if (thread)
+	{
+		const auto start = std::chrono::high_resolution_clock::now();
+
+		thread->WaitForAnySignal(time);
+
+		perf::add(perf::LOCK_WAITS);
+		perf::add(perf::LOCK_WAIT_US, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count());
+	}
+	else
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
 }
 
 waiter_map_t::waiter_reg_t::~waiter_reg_t()
@@ -237,6 +268,8 @@ waiter_map_t::waiter_reg_t::~waiter_reg_t()
 
 	std::lock_guard<std::mutex> lock(map.m_mutex);
 
+	map.m_count--;
+
 	// remove waiter
 	for (s64 i = map.m_waiters.size() - 1; i >= 0; i--)
 	{
@@ -253,7 +286,7 @@ waiter_map_t::waiter_reg_t::~waiter_reg_t()
 
 void waiter_map_t::notify(u64 signal_id)
 {
-	if (!m_waiters.size()) return;
+	if (!m_count) return;
 
 	std::lock_guard<std::mutex> lock(m_mutex);
 
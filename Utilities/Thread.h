@@ -7,15 +7,16 @@ class NamedThreadBase
 	std::string m_name;
 	std::condition_variable m_signal_cv;
 	std::mutex m_signal_mtx;
+	bool m_signaled; // set by Notify(), consumed by WaitForAnySignal()
 
 public:
 	std::atomic<bool> m_tls_assigned;
 
-	NamedThreadBase(const std::string& name) : m_name(name), m_tls_assigned(false)
+	NamedThreadBase(const std::string& name) : m_name(name), m_signaled(false), m_tls_assigned(false)
 	{
 	}
 
-	NamedThreadBase() : m_tls_assigned(false)
+	NamedThreadBase() : m_signaled(false), m_tls_assigned(false)
 	{
 	}
 
@@ -115,8 +116,12 @@ class slw_shared_mutex_t
 
 class waiter_map_t
 {
+	// upper bound (in ms) for a single wait, only matters if a notification was missed
+	static const u64 s_max_wait = 10;
+
 	// TODO: optimize (use custom lightweight readers-writer lock)
 	std::mutex m_mutex;
+	std::atomic<u32> m_count; // registered waiters, checked by notify() without locking
 
 	struct waiter_t
 	{
@@ -144,32 +149,67 @@ class waiter_map_t
 		~waiter_reg_t();
 
 		void init();
+		void wait(u64 time);
 	};
 
 	bool is_stopped(u64 signal_id);
+	static u64 get_time();
 
 public:
 	waiter_map_t(const char* name)
-		: m_name(name)
+		: m_count(0)
+		, m_name(name)
 	{
 	}
 
 	// wait until waiter_func() returns true, signal_id is an arbitrary number
-	template<typename WT> __forceinline void wait_op(u64 signal_id, const WT waiter_func)
+	// timeout is in microseconds (0 = infinite); returns false if timed out or the emulator has been stopped
+	template<typename WT> __forceinline bool wait_op(u64 signal_id, const WT waiter_func, u64 timeout = 0)
 	{
-		// register waiter
+		// fast path, don't register
+		if (waiter_func())
+		{
+			return true;
+		}
+
+		const u64 start_time = timeout ? get_time() : 0;
+
+		// register waiter before checking the condition again, so notify() can't be missed
 		waiter_reg_t waiter(*this, signal_id);
+		waiter.init();
 
 		// check condition or if emulator is stopped
-		while (!waiter_func() && !is_stopped(signal_id))
+		while (!waiter_func())
 		{
-			// initialize waiter (only first time)
-			waiter.init();
-			// wait for 1 ms or until signal arrived
-			waiter.thread->WaitForAnySignal(1);
+			if (is_stopped(signal_id))
+			{
+				return false;
+			}
+
+			u64 wait_time = s_max_wait;
+
+			if (timeout)
+			{
+				const u64 passed = get_time() - start_time;
+
+				if (passed >= timeout)
+				{
+					return false;
+				}
+
+				wait_time = std::min<u64>(wait_time, (timeout - passed + 999) / 1000);
+			}
+
+			// wait until signal arrived (or a short period expired)
+			waiter.wait(wait_time);
 		}
+
+		return true;
 	}
 
 	// signal all threads waiting on waiter_op() with the same signal_id (signaling only hints those threads that corresponding conditions are *probably* met)
 	void notify(u64 signal_id);
+
+	// latency benchmark of SMutex and waiter maps (empty unless enabled in ThreadTests.cpp)
+	static void RunAllTests();
 };
@@ -0,0 +1,177 @@
+#include "stdafx.h"
+#include "Log.h"
+#include "Thread.h"
+#include "SMutex.h"
+
+//#define THREAD_UNIT_TESTS 1
+
+#ifdef THREAD_UNIT_TESTS
+
+// Latency of the waiter maps used by SMutex and the lv2 sync primitives: lock/unlock without and with contention, and
+// the round trip of a post/wait pair between two threads (the handoff of sys_semaphore). Waits are aborted while the
+// emulator is stopped, so this is called from Emulator::Run() (only the first time).
+
+namespace
+{
+	const u32 s_uncontended = 1000000;
+	const u32 s_contended = 100000;
+	const u32 s_round_trips = 20000;
+
+	typedef std::chrono::high_resolution_clock test_clock;
+
+	double elapsed_ns(const test_clock::time_point& start, u32 count)
+	{
+		return std::chrono::duration<double, std::nano>(test_clock::now() - start).count() / count;
+	}
+}
+
+void waiter_map_t::RunAllTests()
+{
+	static bool s_done = false;
+
+	if (s_done)
+	{
+		return;
+	}
+
+	s_done = true;
+
+	LOG_NOTICE(GENERAL, "Running waiter map tests");
+
+	u32 num_failed = 0;
+
+	// uncontended: the lock is always free, nothing is waiting
+	{
+		SMutex mutex;
+		mutex.initialize();
+
+		const auto start = test_clock::now();
+
+		for (u32 i = 0; i < s_uncontended; i++)
+		{
+			if (mutex.lock(1) != SMR_OK || mutex.unlock(1) != SMR_OK)
+			{
+				LOG_ERROR(GENERAL, "SMutex: uncontended lock failed");
+				num_failed++;
+				break;
+			}
+		}
+
+		LOG_NOTICE(GENERAL, "SMutex: %.1f ns per lock/unlock (uncontended)", elapsed_ns(start, s_uncontended));
+
+		std::mutex std_mutex;
+		const auto std_start = test_clock::now();
+
+		for (u32 i = 0; i < s_uncontended; i++)
+		{
+			std_mutex.lock();
+			std_mutex.unlock();
+		}
+
+		LOG_NOTICE(GENERAL, "std::mutex: %.1f ns per lock/unlock (uncontended)", elapsed_ns(std_start, s_uncontended));
+	}
+
+	// contended: two threads increment a counter under the lock
+	{
+		SMutex mutex;
+		mutex.initialize();
+
+		u32 counter = 0;
+		std::atomic<u32> errors(0);
+
+		auto func = [&](u32 tid)
+		{
+			for (u32 i = 0; i < s_contended; i++)
+			{
+				if (mutex.lock(tid) != SMR_OK)
+				{
+					errors++;
+					return;
+				}
+
+				counter++;
+
+				if (mutex.unlock(tid) != SMR_OK)
+				{
+					errors++;
+					return;
+				}
+			}
+		};
+
+		const auto start = test_clock::now();
+
+		thread t1("SMutex test 1", [&]() { func(1); });
+		thread t2("SMutex test 2", [&]() { func(2); });
+		t1.join();
+		t2.join();
+
+		if (errors || counter != 2 * s_contended)
+		{
+			LOG_ERROR(GENERAL, "SMutex: %d errors, counter=%d (expected %d)", errors.load(), counter, 2 * s_contended);
+			num_failed++;
+		}
+
+		LOG_NOTICE(GENERAL, "SMutex: %.1f ns per lock/unlock (2 threads)", elapsed_ns(start, 2 * s_contended));
+	}
+
+	// round trips: each side posts a value and waits for the answer, like sys_semaphore_post() and _wait() do
+	{
+		waiter_map_t wm("test_wm");
+		std::atomic<u32> ping(0), pong(0);
+		std::atomic<u32> errors(0);
+
+		const auto start = test_clock::now();
+
+		thread t1("waiter map test 1", [&]()
+		{
+			for (u32 i = 1; i <= s_round_trips; i++)
+			{
+				ping = i;
+				wm.notify(1);
+
+				if (!wm.wait_op(2, [&]() { return pong == i; }))
+				{
+					errors++;
+					return;
+				}
+			}
+		});
+
+		thread t2("waiter map test 2", [&]()
+		{
+			for (u32 i = 1; i <= s_round_trips; i++)
+			{
+				if (!wm.wait_op(1, [&]() { return ping == i; }))
+				{
+					errors++;
+					return;
+				}
+
+				pong = i;
+				wm.notify(2);
+			}
+		});
+
+		t1.join();
+		t2.join();
+
+		if (errors)
+		{
+			LOG_ERROR(GENERAL, "waiter_map_t: %d waits failed", errors.load());
+			num_failed++;
+		}
+
+		LOG_NOTICE(GENERAL, "waiter_map_t: %.1f us per post/wait round trip", elapsed_ns(start, s_round_trips) / 1000);
+	}
+
+	LOG_NOTICE(GENERAL, "Unit Tests done (%d failed)", num_failed);
+}
+
+#else
+
+void waiter_map_t::RunAllTests()
+{
+}
+
+#endif // THREAD_UNIT_TESTS
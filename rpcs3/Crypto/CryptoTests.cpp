@@ -0,0 +1,848 @@
+#include "stdafx.h"
+#include "Utilities/Log.h"
+#include "Utilities/rFile.h"
+#include "aes.h"
+#include "aesni.h"
+#include "sha1.h"
+#include "unedat.h"
+#include "unself.h"
+#include "Emu/FS/vfsLocalFile.h"
+#include "Emu/FS/vfsMemoryFile.h"
+
+//#define CRYPTO_UNIT_TESTS 1
+
+#ifdef CRYPTO_UNIT_TESTS
+#include <random>
+
+// Known-answer tests (FIPS-197, SP 800-38A, RFC 4493, FIPS 180) of the portable code and, if the CPU supports them, of
+// the AES-NI and SHA-NI paths. The accelerated paths are also compared with the portable code on random data (lengths,
+// in-place buffers, CTR chunks and counter wrap, chunked SHA-1 updates). The benchmark reports MB/s of both.
+// Synthetic EDAT data is decrypted by decrypt_data() on the calling thread and on all cores, the results must match the
+// plain data (and a damaged block must be detected). The EDAT benchmark compares both.
+// A synthetic SELF is decrypted by DecryptSelf() into memory and into an ELF file which is read back (how the ELF was
+// loaded before), both must give the ELF image. The SELF benchmark compares the time of both (the boot time of the SELF).
+
+namespace crypto
+{
+	static const u32 s_random_tests = 1000;
+	static const u32 s_bench_size = 16 * 1024 * 1024;
+	static const u32 s_edat_bench_size = 64 * 1024 * 1024;
+	static const std::string s_edat_path = "./edat_test.edat";
+	static const std::string s_dec_path = "./edat_test.dec";
+	static const u32 s_self_bench_size = 32 * 1024 * 1024;
+	static const u32 s_self_bench_runs = 5;
+	static const std::string s_self_path = "./self_test.self";
+	static const std::string s_elf_path = "./self_test.elf";
+
+	static std::vector<u8> hex(const char* str)
+	{
+		std::vector<u8> res;
+
+		for (; str[0] && str[1]; str += 2)
+		{
+			res.push_back((u8)std::stoul(std::string(str, 2), nullptr, 16));
+		}
+
+		return res;
+	}
+
+	static std::string to_hex(const u8* data, size_t size)
+	{
+		std::string res;
+
+		for (size_t i = 0; i < size; i++)
+		{
+			res += fmt::Format("%02x", data[i]);
+		}
+
+		return res;
+	}
+
+	static bool check(const char* name, const char* path, const u8* data, const std::vector<u8>& expected)
+	{
+		if (memcmp(data, expected.data(), expected.size()) != 0)
+		{
+			LOG_ERROR(GENERAL, "[UT crypto] %s (%s): %s, expected %s", name, path, to_hex(data, expected.size()).c_str(), to_hex(expected.data(), expected.size()).c_str());
+			return false;
+		}
+
+		return true;
+	}
+
+	static const char* const s_sp800_key = "2b7e151628aed2a6abf7158809cf4f3c";
+	static const char* const s_sp800_plain =
+		"6bc1bee22e409f96e93d7e117393172a" "ae2d8a571e03ac9c9eb76fac45af8e51" "30c81c46a35ce411e5fbc1191a0a52ef" "f69f2445df4f9b17ad2b417be66c3710";
+
+	static u32 run_known_answers(const char* path)
+	{
+		u32 failed = 0;
+
+		// FIPS-197 appendix C
+		static const struct { const char* key; const char* cipher; } ecb[] =
+		{
+			{ "000102030405060708090a0b0c0d0e0f", "69c4e0d86a7b0430d8cdb78070b4c55a" },
+			{ "000102030405060708090a0b0c0d0e0f1011121314151617", "dda97ca4864cdfe06eaf70a0ec0d7191" },
+			{ "000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f", "8ea2b7ca516745bfeafc49904b496089" },
+		};
+
+		for (auto& v : ecb)
+		{
+			const auto key = hex(v.key);
+			const auto plain = hex("00112233445566778899aabbccddeeff");
+			u8 out[16], back[16];
+			aes_context ctx;
+
+			aes_setkey_enc(&ctx, key.data(), (u32)key.size() * 8);
+			aes_crypt_ecb(&ctx, AES_ENCRYPT, plain.data(), out);
+			failed += !check("aes_crypt_ecb(encrypt)", path, out, hex(v.cipher));
+
+			aes_setkey_dec(&ctx, key.data(), (u32)key.size() * 8);
+			aes_crypt_ecb(&ctx, AES_DECRYPT, out, back);
+			failed += !check("aes_crypt_ecb(decrypt)", path, back, plain);
+		}
+
+		// SP 800-38A F.2.2 (CBC-AES128.Decrypt)
+		{
+			const auto key = hex(s_sp800_key);
+			auto data = hex("7649abac8119b246cee98e9b12e9197d" "5086cb9b507219ee95db113a917678b2" "73bed6b8e3c1743b7116e69e22229516" "3ff1caa1681fac09120eca307586e1a7");
+			auto iv = hex("000102030405060708090a0b0c0d0e0f");
+			aes_context ctx;
+
+			aes_setkey_dec(&ctx, key.data(), 128);
+			aes_crypt_cbc(&ctx, AES_DECRYPT, data.size(), iv.data(), data.data(), data.data());
+			failed += !check("aes_crypt_cbc(decrypt)", path, data.data(), hex(s_sp800_plain));
+			failed += !check("aes_crypt_cbc(iv)", path, iv.data(), hex("3ff1caa1681fac09120eca307586e1a7"));
+		}
+
+		// SP 800-38A F.5.1 (CTR-AES128.Encrypt), in two chunks which split a block
+		{
+			const auto key = hex(s_sp800_key);
+			const auto plain = hex(s_sp800_plain);
+			auto counter = hex("f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff");
+			std::vector<u8> out(plain.size());
+			u8 stream[16];
+			size_t off = 0;
+			aes_context ctx;
+
+			aes_setkey_enc(&ctx, key.data(), 128);
+			aes_crypt_ctr(&ctx, 20, &off, counter.data(), stream, plain.data(), out.data());
+			aes_crypt_ctr(&ctx, plain.size() - 20, &off, counter.data(), stream, plain.data() + 20, out.data() + 20);
+			failed += !check("aes_crypt_ctr", path, out.data(),
+				hex("874d6191b620e3261bef6864990db6ce" "9806f66b7970fdff8617187bb9fffdff" "5ae4df3edbd5d35e5b4f09020db03eab" "1e031dda2fbe03d1792170a0f3009cee"));
+		}
+
+		// RFC 4493 (AES-CMAC)
+		{
+			const auto key = hex(s_sp800_key);
+			auto plain = hex(s_sp800_plain);
+			u8 out[16];
+			aes_context ctx;
+
+			aes_setkey_enc(&ctx, key.data(), 128);
+			aes_cmac(&ctx, 16, plain.data(), out);
+			failed += !check("aes_cmac(16)", path, out, hex("070a16b46b4d4144f79bdd9dd04a287c"));
+			aes_cmac(&ctx, 64, plain.data(), out);
+			failed += !check("aes_cmac(64)", path, out, hex("51f0bebf7e3b9d92fc49741779363cfe"));
+		}
+
+		// FIPS 180-2 appendix A
+		{
+			u8 out[20];
+			const std::string abc = "abc";
+			const std::string abc56 = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+			const std::string million(1000000, 'a');
+
+			sha1((const u8*)abc.data(), abc.size(), out);
+			failed += !check("sha1(abc)", path, out, hex("a9993e364706816aba3e25717850c26c9cd0d89d"));
+			sha1((const u8*)abc56.data(), abc56.size(), out);
+			failed += !check("sha1(abc...nopq)", path, out, hex("84983e441c3bd26ebaae4aa1f95129e5e54670f1"));
+			sha1((const u8*)million.data(), million.size(), out);
+			failed += !check("sha1(a * 1000000)", path, out, hex("34aa973cd4c4daa4f61eeb2bdbad27316534016f"));
+		}
+
+		return failed;
+	}
+
+	static void set_portable(bool portable)
+	{
+		aesni_force_portable(portable);
+		sha1_force_portable(portable);
+	}
+
+	// every random case is computed with both implementations
+	template<typename F> static bool compare(const char* name, u32 n, F func)
+	{
+		set_portable(true);
+		const std::vector<u8> ref = func();
+		set_portable(false);
+		const std::vector<u8> res = func();
+
+		if (res != ref)
+		{
+			LOG_ERROR(GENERAL, "[UT crypto] %s: the accelerated result differs (case %d)", name, n);
+			return false;
+		}
+
+		return true;
+	}
+
+	static u32 run_random_tests()
+	{
+		std::mt19937 rng(0x5eed);
+		u32 failed = 0;
+
+		auto random_bytes = [&rng](size_t size)
+		{
+			std::vector<u8> res(size);
+			for (auto& v : res) v = (u8)rng();
+			return res;
+		};
+
+		for (u32 n = 0; n < s_random_tests; n++)
+		{
+			const u32 keybits = 128 + 64 * (rng() % 3);
+			const auto key = random_bytes(keybits / 8);
+			const auto iv = random_bytes(16);
+			const auto data = random_bytes(16 * (rng() % 64 + 1));
+			const bool in_place = rng() % 2 != 0;
+
+			failed += !compare("aes_crypt_ecb", n, [&]()
+			{
+				aes_context ctx;
+				std::vector<u8> res(32);
+				aes_setkey_enc(&ctx, key.data(), keybits);
+				aes_crypt_ecb(&ctx, AES_ENCRYPT, data.data(), res.data());
+				aes_setkey_dec(&ctx, key.data(), keybits);
+				aes_crypt_ecb(&ctx, AES_DECRYPT, data.data(), res.data() + 16);
+				return res;
+			});
+
+			failed += !compare("aes_crypt_cbc", n, [&]()
+			{
+				aes_context ctx;
+				std::vector<u8> res = data, tmp_iv = iv;
+				std::vector<u8> out(data.size());
+				aes_setkey_dec(&ctx, key.data(), keybits);
+				aes_crypt_cbc(&ctx, AES_DECRYPT, res.size(), tmp_iv.data(), res.data(), in_place ? res.data() : out.data());
+				if (!in_place) res = out;
+				res.insert(res.end(), tmp_iv.begin(), tmp_iv.end());
+				return res;
+			});
+
+			// counters close to the wrap of all 128 bits, random chunks continue with the saved stream block
+			auto counter = iv;
+			if (rng() % 2) memset(counter.data(), 0xff, 15);
+			std::vector<u32> chunks;
+			for (size_t left = data.size(); left;)
+			{
+				const u32 size = std::min<u32>((u32)left, rng() % 100);
+				chunks.push_back(size);
+				left -= size;
+			}
+
+			failed += !compare("aes_crypt_ctr", n, [&]()
+			{
+				aes_context ctx;
+				std::vector<u8> res = data, tmp_counter = counter;
+				u8 stream[16] = {};
+				size_t off = 0, pos = 0;
+				aes_setkey_enc(&ctx, key.data(), keybits);
+				for (u32 size : chunks)
+				{
+					aes_crypt_ctr(&ctx, size, &off, tmp_counter.data(), stream, res.data() + pos, res.data() + pos);
+					pos += size;
+				}
+				res.insert(res.end(), tmp_counter.begin(), tmp_counter.end());
+				res.push_back((u8)off);
+				return res;
+			});
+
+			const int cmac_size = (int)(data.size() - rng() % 16);
+
+			failed += !compare("aes_cmac", n, [&]()
+			{
+				aes_context ctx;
+				std::vector<u8> res(16), tmp = data;
+				aes_setkey_enc(&ctx, key.data(), keybits);
+				aes_cmac(&ctx, cmac_size, tmp.data(), res.data());
+				return res;
+			});
+
+			// random lengths (not only whole blocks), updated in random chunks
+			const auto text = random_bytes(rng() % 2048);
+
+			failed += !compare("sha1_update", n, [&]()
+			{
+				std::mt19937 chunk_rng(n);
+				sha1_context ctx;
+				std::vector<u8> res(20);
+				sha1_starts(&ctx);
+				for (size_t pos = 0; pos < text.size();)
+				{
+					const size_t size = std::min<size_t>(text.size() - pos, chunk_rng() % 300);
+					sha1_update(&ctx, text.data() + pos, size);
+					pos += size;
+				}
+				sha1_finish(&ctx, res.data());
+				return res;
+			});
+
+			failed += !compare("sha1_hmac", n, [&]()
+			{
+				std::vector<u8> res(20);
+				sha1_hmac(key.data(), key.size(), text.data(), text.size(), res.data());
+				return res;
+			});
+
+			// a failing case is reported once
+			if (failed)
+			{
+				break;
+			}
+		}
+
+		return failed;
+	}
+
+	template<typename F> static double megabytes_per_second(F func)
+	{
+		const auto start = std::chrono::high_resolution_clock::now();
+		func();
+		return s_bench_size / std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count() / (1024 * 1024);
+	}
+
+	static void benchmark(const char* path)
+	{
+		std::vector<u8> data(s_bench_size), out(s_bench_size);
+		u8 key[16] = {}, iv[16] = {}, stream[16], digest[20];
+		size_t off = 0;
+		aes_context enc, dec;
+
+		aes_setkey_enc(&enc, key, 128);
+		aes_setkey_dec(&dec, key, 128);
+
+		const double ecb = megabytes_per_second([&]()
+		{
+			for (u32 i = 0; i < s_bench_size; i += 16) aes_crypt_ecb(&enc, AES_ENCRYPT, data.data() + i, out.data() + i);
+		});
+
+		const double cbc = megabytes_per_second([&]() { aes_crypt_cbc(&dec, AES_DECRYPT, s_bench_size, iv, data.data(), out.data()); });
+		const double ctr = megabytes_per_second([&]() { aes_crypt_ctr(&enc, s_bench_size, &off, iv, stream, data.data(), out.data()); });
+		const double sha = megabytes_per_second([&]() { sha1(data.data(), s_bench_size, digest); });
+
+		LOG_NOTICE(GENERAL, "crypto (%s): AES-128 ECB %.0f MB/s, CBC decrypt %.0f MB/s, CTR %.0f MB/s, SHA-1 %.0f MB/s", path, ecb, cbc, ctr, sha);
+	}
+
+	// metadata and data of an EDAT (NPD version 3, not compressed) encrypted with the block keys of decrypt_data()
+	static std::vector<u8> build_edat(const EDAT_HEADER& edat, NPD_HEADER& npd, u8* crypt_key, const std::vector<u8>& plain, int damaged_block, std::mt19937& rng)
+	{
+		const int block_num = (int)((edat.file_size + edat.block_size - 1) / edat.block_size);
+		const bool interleaved = (edat.flags & EDAT_FLAG_0x20) != 0;
+		std::vector<u8> file(0x100 + (size_t)block_num * ((interleaved ? 0x20 : 0x10) + edat.block_size));
+
+		for (int i = 0; i < block_num; i++)
+		{
+			const int length = (int)std::min<u64>(edat.block_size, edat.file_size - (u64)i * edat.block_size);
+			const int padded_length = (length + 0xf) & ~0xf;
+			std::vector<u8> data(padded_length), enc(padded_length);
+			memcpy(data.data(), &plain[(size_t)i * edat.block_size], length);
+
+			u8 key[0x10], hash[0x10], iv[0x10], hash_result[0x14];
+			unsigned char *b_key = get_block_key(i, &npd);
+			aesecb128_encrypt(crypt_key, b_key, key);
+			delete[] b_key;
+
+			if (edat.flags & EDAT_FLAG_0x10)
+				aesecb128_encrypt(crypt_key, key, hash);
+			else
+				memcpy(hash, key, 0x10);
+
+			memcpy(iv, npd.digest, 0x10);
+			aescbc128_encrypt(key, iv, data.data(), enc.data(), padded_length);
+
+			if (edat.flags & EDAT_FLAG_0x10)
+				hmac_hash_forge(hash, 0x10, enc.data(), padded_length, hash_result);
+			else
+				cmac_hash_forge(hash, 0x10, enc.data(), padded_length, hash_result);
+
+			if (i == damaged_block)
+			{
+				enc[3] ^= 1;
+			}
+
+			if (interleaved)
+			{
+				// the metadata precedes the block, the hash is xored with its second half (which holds the last 4 bytes)
+				u8* meta = &file[0x100 + (size_t)i * (0x20 + edat.block_size)];
+				for (int j = 0x10; j < 0x20; j++) meta[j] = (u8)rng();
+				memcpy(meta + 0x10, hash_result + 0x10, 4);
+				for (int j = 0; j < 0x10; j++) meta[j] = hash_result[j] ^ meta[j + 0x10];
+				memcpy(meta + 0x20, enc.data(), padded_length);
+			}
+			else
+			{
+				memcpy(&file[0x100 + (size_t)i * 0x10], hash_result, 0x10);
+				memcpy(&file[0x100 + (size_t)block_num * 0x10 + (size_t)i * edat.block_size], enc.data(), padded_length);
+			}
+		}
+
+		return file;
+	}
+
+	// returns the result of decrypt_data() (-1 if the files could not be written or read)
+	static int run_decrypt_data(const std::vector<u8>& file, EDAT_HEADER edat, NPD_HEADER npd, u8* crypt_key, bool sequential, std::vector<u8>& result, double& seconds)
+	{
+		int res = -1;
+
+		{
+			rFile f;
+
+			if (!f.Create(s_edat_path, true) || f.Write(file.data(), file.size()) != file.size())
+			{
+				return -1;
+			}
+		}
+
+		{
+			rFile in(s_edat_path, rFile::read);
+			rFile out;
+
+			if (in.IsOpened() && out.Create(s_dec_path, true))
+			{
+				edat_force_sequential(sequential);
+				const auto start = std::chrono::high_resolution_clock::now();
+				res = decrypt_data(&in, &out, &edat, &npd, crypt_key, false);
+				seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+				edat_force_sequential(false);
+			}
+		}
+
+		{
+			rFile f(s_dec_path, rFile::read);
+			result.resize(f.IsOpened() ? f.Length() : 0);
+
+			if (f.IsOpened() && f.Read(result.data(), result.size()) != result.size())
+			{
+				res = -1;
+			}
+		}
+
+		rRemoveFile(s_edat_path);
+		rRemoveFile(s_dec_path);
+		return res;
+	}
+
+	static u32 run_edat_tests()
+	{
+		std::mt19937 rng(0xeda7);
+		u32 failed = 0;
+
+		// AES-CMAC with a partial last block, 0x10 SHA1-HMAC over several batches, 0x14 SHA1-HMAC with the metadata before each block
+		static const struct { const char* name; int flags; int block_size; u64 file_size; } cases[] =
+		{
+			{ "AES-CMAC", 0, 0x4000, 0x4000 * 5 + 0x123 },
+			{ "FLAG 0x10", EDAT_FLAG_0x10, 0x1000, 9 * 1024 * 1024 + 0x10 },
+			{ "FLAG 0x10 | 0x20", EDAT_FLAG_0x10 | EDAT_FLAG_0x20, 0x4000, 0x4000 * 300 + 0x4 },
+		};
+
+		for (auto& c : cases)
+		{
+			NPD_HEADER npd = {};
+			npd.version = 3;
+			for (auto& v : npd.digest) v = (u8)rng();
+			for (auto& v : npd.dev_hash) v = (u8)rng();
+
+			EDAT_HEADER edat = {};
+			edat.flags = c.flags;
+			edat.block_size = c.block_size;
+			edat.file_size = c.file_size;
+
+			u8 crypt_key[0x10];
+			for (auto& v : crypt_key) v = (u8)rng();
+
+			std::vector<u8> plain((size_t)c.file_size), result;
+			for (auto& v : plain) v = (u8)rng();
+
+			const std::vector<u8> file = build_edat(edat, npd, crypt_key, plain, -1, rng);
+			const std::vector<u8> damaged = build_edat(edat, npd, crypt_key, plain, 1, rng);
+
+			for (bool sequential : { true, false })
+			{
+				const char* mode = sequential ? "sequential" : "parallel";
+				double seconds;
+
+				if (run_decrypt_data(file, edat, npd, crypt_key, sequential, result, seconds) != 0 || result != plain)
+				{
+					LOG_ERROR(GENERAL, "[UT crypto] decrypt_data(%s, %s): wrong result", c.name, mode);
+					failed++;
+				}
+
+				if (run_decrypt_data(damaged, edat, npd, crypt_key, sequential, result, seconds) != 1)
+				{
+					LOG_ERROR(GENERAL, "[UT crypto] decrypt_data(%s, %s): the damaged block was not detected", c.name, mode);
+					failed++;
+				}
+			}
+		}
+
+		return failed;
+	}
+
+	static void edat_benchmark()
+	{
+		std::mt19937 rng(0xbe4c);
+		NPD_HEADER npd = {};
+		npd.version = 3;
+
+		EDAT_HEADER edat = {};
+		edat.flags = EDAT_FLAG_0x10;
+		edat.block_size = 0x4000;
+		edat.file_size = s_edat_bench_size;
+
+		u8 crypt_key[0x10] = {};
+		std::vector<u8> plain(s_edat_bench_size), result;
+		const std::vector<u8> file = build_edat(edat, npd, crypt_key, plain, -1, rng);
+
+		double sequential = 0, parallel = 0;
+
+		if (run_decrypt_data(file, edat, npd, crypt_key, true, result, sequential) != 0 || run_decrypt_data(file, edat, npd, crypt_key, false, result, parallel) != 0)
+		{
+			LOG_ERROR(GENERAL, "[UT crypto] EDAT benchmark: decrypt_data() failed");
+			return;
+		}
+
+		LOG_NOTICE(GENERAL, "crypto: EDAT (%d MB, FLAG 0x10) sequential %.0f MB/s, parallel (%d threads) %.0f MB/s", s_edat_bench_size >> 20,
+			s_edat_bench_size / sequential / (1024 * 1024), std::max<u32>(1, std::thread::hardware_concurrency()), s_edat_bench_size / parallel / (1024 * 1024));
+	}
+
+	// 64-bit ELF (one program header per segment) and a SELF (APP, key revision 0) with the segments as encrypted sections
+	static std::vector<u8> build_self(const std::vector<std::vector<u8>>& segments, std::vector<u8>& elf, std::mt19937& rng)
+	{
+		const u32 count = (u32)segments.size();
+
+		Elf64_Ehdr ehdr = {};
+		ehdr.e_magic = 0x7F454C46;
+		ehdr.e_class = 2;
+		ehdr.e_data = 2;
+		ehdr.e_curver = 1;
+		ehdr.e_type = 2;
+		ehdr.e_machine = 0x15;
+		ehdr.e_version = 1;
+		ehdr.e_entry = 0x10200;
+		ehdr.e_phoff = 0x40;
+		ehdr.e_ehsize = 0x40;
+		ehdr.e_phentsize = 0x38;
+		ehdr.e_phnum = count;
+
+		std::vector<Elf64_Phdr> phdrs(count);
+		u64 elf_offset = (0x40 + count * 0x38 + 0xff) & ~0xff;
+
+		for (u32 i = 0; i < count; i++)
+		{
+			phdrs[i] = {};
+			phdrs[i].p_type = 1;
+			phdrs[i].p_flags = 5;
+			phdrs[i].p_offset = elf_offset;
+			phdrs[i].p_vaddr = phdrs[i].p_paddr = 0x10000 + elf_offset;
+			phdrs[i].p_filesz = phdrs[i].p_memsz = segments[i].size();
+			phdrs[i].p_align = 0x100;
+			elf_offset = (elf_offset + segments[i].size() + 0xff) & ~0xff;
+		}
+
+		vfsMemoryFile e;
+		e.Open("elf");
+		WriteEhdr(e, ehdr);
+		for (auto& p : phdrs) WritePhdr(e, p);
+		for (u32 i = 0; i < count; i++)
+		{
+			e.Seek(phdrs[i].p_offset);
+			e.Write(segments[i].data(), segments[i].size());
+		}
+		elf = e.GetData();
+
+		// SCE header, SELF header, APP info, ELF header and program headers, section info, SCE version info, metadata
+		const u64 elf_off = 0x90, phdr_off = elf_off + 0x40, secinfo_off = phdr_off + count * 0x38, scever_off = secinfo_off + count * 0x20;
+		const u64 meta_off = (scever_off + 0x10 + 0xf) & ~0xf;
+		const u64 header_size = meta_off + 0x40 + 0x20 + count * 0x30 + count * 2 * 0x10;
+
+		std::vector<u64> data_offsets;
+		u64 data_offset = (header_size + 0xf) & ~0xf;
+
+		for (auto& s : segments)
+		{
+			data_offsets.push_back(data_offset);
+			data_offset = (data_offset + s.size() + 0xf) & ~0xf;
+		}
+
+		u8 meta_key[0x10], meta_iv[0x10];
+		std::vector<u8> data_keys(count * 2 * 0x10);
+		for (auto& v : meta_key) v = (u8)rng();
+		for (auto& v : meta_iv) v = (u8)rng();
+		for (auto& v : data_keys) v = (u8)rng();
+
+		vfsMemoryFile s;
+		s.Open("self");
+		Write32(s, 0x53434500);
+		Write32(s, 2);
+		Write16(s, 0);
+		Write16(s, 1);
+		Write32(s, (u32)(meta_off - 0x20));
+		Write64(s, header_size);
+		Write64(s, elf.size());
+
+		Write64(s, 3);
+		Write64(s, 0x70);
+		Write64(s, elf_off);
+		Write64(s, phdr_off);
+		Write64(s, 0);
+		Write64(s, secinfo_off);
+		Write64(s, scever_off);
+		Write64(s, scever_off + 0x10);
+		Write64(s, 0);
+		Write64(s, 0);
+
+		Write64(s, 0x1010000001000003);
+		Write32(s, 0x01000002);
+		Write32(s, KEY_APP);
+		Write64(s, 0x0001000000000000);
+		Write64(s, 0);
+
+		WriteEhdr(s, ehdr);
+		for (auto& p : phdrs) WritePhdr(s, p);
+
+		for (u32 i = 0; i < count; i++)
+		{
+			Write64(s, data_offsets[i]);
+			Write64(s, segments[i].size());
+			Write32(s, 1);
+			Write32(s, 0);
+			Write32(s, 0);
+			Write32(s, 1);
+		}
+
+		Write32(s, 1);
+		Write32(s, 1);
+		Write32(s, 0x10);
+		Write32(s, 0);
+
+		// metadata info (key and iv of the metadata headers), metadata header, section headers, data keys and ivs
+		s.Seek(meta_off);
+		s.Write(meta_key, 0x10);
+		for (u32 i = 0; i < 0x10; i++) Write8(s, 0);
+		s.Write(meta_iv, 0x10);
+		for (u32 i = 0; i < 0x10; i++) Write8(s, 0);
+
+		Write64(s, meta_off);
+		Write32(s, 1);
+		Write32(s, count);
+		Write32(s, count * 2);
+		Write32(s, 0);
+		Write32(s, 0);
+		Write32(s, 0);
+
+		for (u32 i = 0; i < count; i++)
+		{
+			Write64(s, data_offsets[i]);
+			Write64(s, segments[i].size());
+			Write32(s, 2);
+			Write32(s, i);
+			Write32(s, 2);
+			Write32(s, 0);
+			Write32(s, 3);
+			Write32(s, i * 2);
+			Write32(s, i * 2 + 1);
+			Write32(s, 1);
+		}
+
+		s.Write(data_keys.data(), data_keys.size());
+
+		for (u32 i = 0; i < count; i++)
+		{
+			s.Seek(data_offsets[i]);
+			s.Write(segments[i].data(), segments[i].size());
+		}
+
+		std::vector<u8> self = s.GetData();
+		aes_context aes;
+
+		for (u32 i = 0; i < count; i++)
+		{
+			size_t nc_off = 0;
+			u8 stream_block[0x10] = {}, iv[0x10];
+			memcpy(iv, &data_keys[(i * 2 + 1) * 0x10], 0x10);
+			aes_setkey_enc(&aes, &data_keys[i * 2 * 0x10], 128);
+			aes_crypt_ctr(&aes, segments[i].size(), &nc_off, iv, stream_block, &self[data_offsets[i]], &self[data_offsets[i]]);
+		}
+
+		size_t nc_off = 0;
+		u8 stream_block[0x10];
+		aes_setkey_enc(&aes, meta_key, 128);
+		aes_crypt_ctr(&aes, header_size - meta_off - 0x40, &nc_off, meta_iv, stream_block, &self[meta_off + 0x40], &self[meta_off + 0x40]);
+
+		SELF_KEY keyset = KeyVault().FindSelfKey(KEY_APP, 0, 0);
+		aes_setkey_enc(&aes, keyset.erk, 256);
+		aes_crypt_cbc(&aes, AES_ENCRYPT, 0x40, keyset.riv, &self[meta_off], &self[meta_off]);
+
+		return self;
+	}
+
+	// decrypts the SELF into memory (like Emulator::Load) or into an ELF file which is read back (like before)
+	static bool run_decrypt_self(const std::vector<u8>& self, bool in_memory, std::vector<u8>& result, double& seconds)
+	{
+		{
+			rFile f;
+
+			if (!f.Create(s_self_path, true) || f.Write(self.data(), self.size()) != self.size())
+			{
+				return false;
+			}
+		}
+
+		bool res = false;
+		const auto start = std::chrono::high_resolution_clock::now();
+
+		if (in_memory)
+		{
+			vfsMemoryFile elf;
+			elf.Open(s_self_path);
+			res = DecryptSelf(elf, s_self_path);
+			result.resize((size_t)elf.GetSize());
+			elf.Read(result.data(), result.size());
+		}
+		else
+		{
+			rRemoveFile(s_elf_path);
+
+			{
+				vfsLocalFile elf(nullptr);
+				res = elf.Open(s_elf_path, vfsWrite) && DecryptSelf(elf, s_self_path);
+			}
+
+			vfsLocalFile elf(nullptr);
+			res = elf.Open(s_elf_path) && res;
+			result.resize(elf.IsOpened() ? (size_t)elf.GetSize() : 0);
+			elf.Read(result.data(), result.size());
+		}
+
+		seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+		rRemoveFile(s_self_path);
+		rRemoveFile(s_elf_path);
+		return res;
+	}
+
+	static u32 run_self_tests()
+	{
+		std::mt19937 rng(0x5e1f);
+		u32 failed = 0;
+
+		// segments of any size (the sections are decrypted in parallel)
+		std::vector<std::vector<u8>> segments(6);
+		for (auto& s : segments)
+		{
+			s.resize(rng() % 0x40000 + 1);
+			for (auto& v : s) v = (u8)rng();
+		}
+
+		std::vector<u8> elf, result;
+		std::vector<u8> self = build_self(segments, elf, rng);
+		double seconds;
+
+		for (bool in_memory : { true, false })
+		{
+			if (!run_decrypt_self(self, in_memory, result, seconds) || result != elf)
+			{
+				LOG_ERROR(GENERAL, "[UT crypto] DecryptSelf(%s): wrong ELF image", in_memory ? "memory" : "file");
+				failed++;
+			}
+		}
+
+		// a damaged metadata info (the first block is xored with the key padding by AES-CBC) must be detected
+		const u32 meta_off = 0x20 + (self[0xc] << 24 | self[0xd] << 16 | self[0xe] << 8 | self[0xf]);
+		self[meta_off] ^= 1;
+
+		if (run_decrypt_self(self, true, result, seconds))
+		{
+			LOG_ERROR(GENERAL, "[UT crypto] DecryptSelf: the damaged metadata was not detected");
+			failed++;
+		}
+
+		return failed;
+	}
+
+	static void self_benchmark()
+	{
+		std::mt19937 rng(0xbe4c);
+
+		// a big executable: code, read-only data, data
+		std::vector<std::vector<u8>> segments(3);
+		segments[0].resize(s_self_bench_size / 2);
+		segments[1].resize(s_self_bench_size / 4);
+		segments[2].resize(s_self_bench_size / 4);
+
+		std::vector<u8> elf, result;
+		const std::vector<u8> self = build_self(segments, elf, rng);
+		double in_memory = 1e9, file = 1e9;
+
+		for (u32 i = 0; i < s_self_bench_runs; i++)
+		{
+			double seconds;
+
+			if (!run_decrypt_self(self, true, result, seconds) || result != elf)
+			{
+				LOG_ERROR(GENERAL, "[UT crypto] SELF benchmark: DecryptSelf() failed");
+				return;
+			}
+
+			in_memory = std::min(in_memory, seconds);
+
+			if (!run_decrypt_self(self, false, result, seconds) || result != elf)
+			{
+				LOG_ERROR(GENERAL, "[UT crypto] SELF benchmark: DecryptSelf() failed");
+				return;
+			}
+
+			file = std::min(file, seconds);
+		}
+
+		LOG_NOTICE(GENERAL, "crypto: SELF (%d MB, %d sections, %d threads) decrypted into memory in %.1f ms, through an ELF file in %.1f ms", s_self_bench_size >> 20,
+			(u32)segments.size(), std::max<u32>(1, std::thread::hardware_concurrency()), in_memory * 1000, file * 1000);
+	}
+
+	void RunAllTests()
+	{
+		const bool has_aesni = aesni_supports(POLARSSL_AESNI_AES) != 0;
+
+		LOG_NOTICE(GENERAL, "Running crypto tests (AES-NI %s)", has_aesni ? "enabled" : "disabled");
+
+		u32 num_failed = 0;
+
+		set_portable(true);
+		num_failed += run_known_answers("portable");
+		benchmark("portable");
+
+		set_portable(false);
+		num_failed += run_known_answers("accelerated");
+		num_failed += run_random_tests();
+		benchmark("accelerated");
+
+		num_failed += run_edat_tests();
+		edat_benchmark();
+
+		num_failed += run_self_tests();
+		self_benchmark();
+
+		LOG_NOTICE(GENERAL, "Unit Tests done (%d failed)", num_failed);
+	}
+}
+
+#else
+
+namespace crypto
+{
+	void RunAllTests()
+	{
+	}
+}
+
+#endif // CRYPTO_UNIT_TESTS
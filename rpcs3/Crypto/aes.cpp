@@ -31,6 +31,7 @@
 
 #include "stdafx.h"
 #include "aes.h"
+#include "aesni.h"
 
 /*
  * 32-bit integer manipulation macros (little endian)
@@ -644,6 +645,9 @@ int aes_crypt_ecb( aes_context *ctx,
     int i;
     uint32_t *RK, X0, X1, X2, X3, Y0, Y1, Y2, Y3;
 
+    if( aesni_supports( POLARSSL_AESNI_AES ) )
+        return( aesni_crypt_ecb( ctx, mode, input, output ) );
+
     RK = ctx->rk;
 
     GET_UINT32_LE( X0, input,  0 ); X0 ^= *RK++;
@@ -744,6 +748,12 @@ int aes_crypt_cbc( aes_context *ctx,
     if( length % 16 )
         return( POLARSSL_ERR_AES_INVALID_INPUT_LENGTH );
 
+    if( mode == AES_DECRYPT && aesni_supports( POLARSSL_AESNI_AES ) )
+    {
+        aesni_crypt_cbc_dec( ctx, length, iv, input, output );
+        return( 0 );
+    }
+
     if( mode == AES_DECRYPT )
     {
         while( length > 0 )
@@ -840,6 +850,22 @@ int aes_crypt_ctr( aes_context *ctx,
     int c, i;
     size_t n = *nc_off;
 
+    if( aesni_supports( POLARSSL_AESNI_AES ) )
+    {
+        // use the rest of the saved stream block, then process whole blocks in parallel
+        while( n != 0 && length > 0 )
+        {
+            *output++ = (unsigned char)( *input++ ^ stream_block[n] );
+            n = (n + 1) & 0x0F;
+            length--;
+        }
+
+        aesni_crypt_ctr( ctx, length / 16, nonce_counter, input, output );
+        input  += length & ~(size_t)0x0F;
+        output += length & ~(size_t)0x0F;
+        length &= 0x0F;
+    }
+
     while( length-- )
     {
         if( n == 0 ) {
@@ -0,0 +1,228 @@
+/*
+ *  AES-NI support functions
+ *
+ *  The round key layout of aes.cpp (PolarSSL) matches the byte order expected by
+ *  the AES-NI instructions, and the table-based decryption key schedule is equal
+ *  to AESIMC applied to the encryption round keys, so no separate setup is needed.
+ *
+ *  [AES-WP] http://software.intel.com/en-us/articles/intel-advanced-encryption-standard-aes-instructions-set
+ */
+
+#include "stdafx.h"
+#include "aesni.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#define AESNI_TARGET
+#else
+#include <cpuid.h>
+#define AESNI_TARGET __attribute__((target("aes")))
+#endif
+#include <wmmintrin.h>
+
+static int aesni_disabled = 0;
+
+void aesni_force_portable( int disable )
+{
+    aesni_disabled = disable;
+}
+
+/*
+ * AES-NI support detection routine
+ */
+int aesni_supports( unsigned int what )
+{
+    static int done = 0;
+    static unsigned int c = 0;
+
+    if( aesni_disabled )
+        return( 0 );
+
+    if( !done )
+    {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid( info, 1 );
+        c = (unsigned int)info[2];
+#else
+        unsigned int a, b, d;
+        if( !__get_cpuid( 1, &a, &b, &c, &d ) )
+            c = 0;
+#endif
+        done = 1;
+    }
+
+    return( ( c & what ) != 0 );
+}
+
+static __forceinline void load_round_keys( const aes_context *ctx, __m128i rk[15] )
+{
+    for( int i = 0; i <= ctx->nr; i++ )
+        rk[i] = _mm_loadu_si128( (const __m128i *) ctx->rk + i );
+}
+
+static AESNI_TARGET __forceinline __m128i aesni_enc( __m128i b, const __m128i rk[15], int nr )
+{
+    b = _mm_xor_si128( b, rk[0] );
+    for( int i = 1; i < nr; i++ )
+        b = _mm_aesenc_si128( b, rk[i] );
+    return _mm_aesenclast_si128( b, rk[nr] );
+}
+
+static AESNI_TARGET __forceinline __m128i aesni_dec( __m128i b, const __m128i rk[15], int nr )
+{
+    b = _mm_xor_si128( b, rk[0] );
+    for( int i = 1; i < nr; i++ )
+        b = _mm_aesdec_si128( b, rk[i] );
+    return _mm_aesdeclast_si128( b, rk[nr] );
+}
+
+/*
+ * AES-NI AES-ECB block en(de)cryption
+ */
+AESNI_TARGET int aesni_crypt_ecb( aes_context *ctx,
+                                  int mode,
+                                  const unsigned char input[16],
+                                  unsigned char output[16] )
+{
+    __m128i rk[15];
+    load_round_keys( ctx, rk );
+
+    const __m128i b = _mm_loadu_si128( (const __m128i *) input );
+
+    _mm_storeu_si128( (__m128i *) output, mode == AES_DECRYPT ? aesni_dec( b, rk, ctx->nr ) : aesni_enc( b, rk, ctx->nr ) );
+
+    return( 0 );
+}
+
+/*
+ * AES-NI AES-CBC decryption (independent blocks are interleaved to hide AESDEC latency)
+ */
+AESNI_TARGET void aesni_crypt_cbc_dec( aes_context *ctx,
+                                       size_t length,
+                                       unsigned char iv[16],
+                                       const unsigned char *input,
+                                       unsigned char *output )
+{
+    __m128i rk[15];
+    load_round_keys( ctx, rk );
+
+    const int nr = ctx->nr;
+    __m128i prev = _mm_loadu_si128( (const __m128i *) iv );
+
+    while( length >= 64 )
+    {
+        const __m128i c0 = _mm_loadu_si128( (const __m128i *) input + 0 );
+        const __m128i c1 = _mm_loadu_si128( (const __m128i *) input + 1 );
+        const __m128i c2 = _mm_loadu_si128( (const __m128i *) input + 2 );
+        const __m128i c3 = _mm_loadu_si128( (const __m128i *) input + 3 );
+
+        __m128i b0 = _mm_xor_si128( c0, rk[0] );
+        __m128i b1 = _mm_xor_si128( c1, rk[0] );
+        __m128i b2 = _mm_xor_si128( c2, rk[0] );
+        __m128i b3 = _mm_xor_si128( c3, rk[0] );
+
+        for( int i = 1; i < nr; i++ )
+        {
+            b0 = _mm_aesdec_si128( b0, rk[i] );
+            b1 = _mm_aesdec_si128( b1, rk[i] );
+            b2 = _mm_aesdec_si128( b2, rk[i] );
+            b3 = _mm_aesdec_si128( b3, rk[i] );
+        }
+
+        b0 = _mm_aesdeclast_si128( b0, rk[nr] );
+        b1 = _mm_aesdeclast_si128( b1, rk[nr] );
+        b2 = _mm_aesdeclast_si128( b2, rk[nr] );
+        b3 = _mm_aesdeclast_si128( b3, rk[nr] );
+
+        _mm_storeu_si128( (__m128i *) output + 0, _mm_xor_si128( b0, prev ) );
+        _mm_storeu_si128( (__m128i *) output + 1, _mm_xor_si128( b1, c0 ) );
+        _mm_storeu_si128( (__m128i *) output + 2, _mm_xor_si128( b2, c1 ) );
+        _mm_storeu_si128( (__m128i *) output + 3, _mm_xor_si128( b3, c2 ) );
+        prev = c3;
+
+        input  += 64;
+        output += 64;
+        length -= 64;
+    }
+
+    while( length >= 16 )
+    {
+        const __m128i c = _mm_loadu_si128( (const __m128i *) input );
+
+        _mm_storeu_si128( (__m128i *) output, _mm_xor_si128( aesni_dec( c, rk, nr ), prev ) );
+        prev = c;
+
+        input  += 16;
+        output += 16;
+        length -= 16;
+    }
+
+    _mm_storeu_si128( (__m128i *) iv, prev );
+}
+
+static __forceinline __m128i ctr_next( unsigned char nonce_counter[16] )
+{
+    const __m128i b = _mm_loadu_si128( (const __m128i *) nonce_counter );
+
+    for( int i = 16; i > 0; i-- )
+        if( ++nonce_counter[i - 1] != 0 )
+            break;
+
+    return b;
+}
+
+/*
+ * AES-NI AES-CTR for whole blocks
+ */
+AESNI_TARGET void aesni_crypt_ctr( aes_context *ctx,
+                                   size_t blocks,
+                                   unsigned char nonce_counter[16],
+                                   const unsigned char *input,
+                                   unsigned char *output )
+{
+    __m128i rk[15];
+    load_round_keys( ctx, rk );
+
+    const int nr = ctx->nr;
+
+    while( blocks >= 4 )
+    {
+        __m128i b0 = _mm_xor_si128( ctr_next( nonce_counter ), rk[0] );
+        __m128i b1 = _mm_xor_si128( ctr_next( nonce_counter ), rk[0] );
+        __m128i b2 = _mm_xor_si128( ctr_next( nonce_counter ), rk[0] );
+        __m128i b3 = _mm_xor_si128( ctr_next( nonce_counter ), rk[0] );
+
+        for( int i = 1; i < nr; i++ )
+        {
+            b0 = _mm_aesenc_si128( b0, rk[i] );
+            b1 = _mm_aesenc_si128( b1, rk[i] );
+            b2 = _mm_aesenc_si128( b2, rk[i] );
+            b3 = _mm_aesenc_si128( b3, rk[i] );
+        }
+
+        b0 = _mm_aesenclast_si128( b0, rk[nr] );
+        b1 = _mm_aesenclast_si128( b1, rk[nr] );
+        b2 = _mm_aesenclast_si128( b2, rk[nr] );
+        b3 = _mm_aesenclast_si128( b3, rk[nr] );
+
+        _mm_storeu_si128( (__m128i *) output + 0, _mm_xor_si128( b0, _mm_loadu_si128( (const __m128i *) input + 0 ) ) );
+        _mm_storeu_si128( (__m128i *) output + 1, _mm_xor_si128( b1, _mm_loadu_si128( (const __m128i *) input + 1 ) ) );
+        _mm_storeu_si128( (__m128i *) output + 2, _mm_xor_si128( b2, _mm_loadu_si128( (const __m128i *) input + 2 ) ) );
+        _mm_storeu_si128( (__m128i *) output + 3, _mm_xor_si128( b3, _mm_loadu_si128( (const __m128i *) input + 3 ) ) );
+
+        input  += 64;
+        output += 64;
+        blocks -= 4;
+    }
+
+    while( blocks-- )
+    {
+        const __m128i k = aesni_enc( ctr_next( nonce_counter ), rk, nr );
+
+        _mm_storeu_si128( (__m128i *) output, _mm_xor_si128( k, _mm_loadu_si128( (const __m128i *) input ) ) );
+
+        input  += 16;
+        output += 16;
+    }
+}
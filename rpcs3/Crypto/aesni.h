@@ -0,0 +1,88 @@
+#pragma once
+
+/**
+ * \file aesni.h
+ *
+ * \brief AES-NI accelerated AES (runtime dispatched from aes.cpp)
+ *
+ * Uses the same round key layout as the table-based implementation,
+ * so contexts set up by aes_setkey_enc/aes_setkey_dec work with both.
+ */
+#include "aes.h"
+
+#define POLARSSL_AESNI_AES      0x02000000u
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief          AES-NI features detection routine
+ *
+ * \param what     The feature to detect (POLARSSL_AESNI_AES)
+ *
+ * \return         1 if CPU has support for the feature, 0 otherwise
+ */
+int aesni_supports( unsigned int what );
+
+/**
+ * \brief          Ignore AES-NI (used by the tests to compare with the table-based code)
+ *
+ * \param disable  1 to report no support, 0 to detect it again
+ */
+void aesni_force_portable( int disable );
+
+/**
+ * \brief          AES-NI AES-ECB block en(de)cryption
+ *
+ * \param ctx      AES context
+ * \param mode     AES_ENCRYPT or AES_DECRYPT
+ * \param input    16-byte input block
+ * \param output   16-byte output block
+ *
+ * \return         0 on success (cannot fail)
+ */
+int aesni_crypt_ecb( aes_context *ctx,
+                     int mode,
+                     const unsigned char input[16],
+                     unsigned char output[16] );
+
+/**
+ * \brief          AES-NI AES-CBC decryption, 4 blocks are processed in parallel
+ *
+ * \param ctx      AES context (decryption key schedule)
+ * \param length   length of the input data (multiple of 16)
+ * \param iv       initialization vector (updated after use)
+ * \param input    buffer holding the input data
+ * \param output   buffer holding the output data
+ */
+void aesni_crypt_cbc_dec( aes_context *ctx,
+                          size_t length,
+                          unsigned char iv[16],
+                          const unsigned char *input,
+                          unsigned char *output );
+
+/**
+ * \brief          AES-NI AES-CTR for whole blocks, 4 blocks are processed in parallel
+ *
+ * \param ctx           AES context (encryption key schedule)
+ * \param blocks        number of 16-byte blocks
+ * \param nonce_counter The 128-bit big-endian nonce and counter (updated after use)
+ * \param input         The input data stream
+ * \param output        The output data stream
+ */
+void aesni_crypt_ctr( aes_context *ctx,
+                      size_t blocks,
+                      unsigned char nonce_counter[16],
+                      const unsigned char *input,
+                      unsigned char *output );
+
+#ifdef __cplusplus
+}
+
+namespace crypto
+{
+	// known-answer tests and a benchmark of the AES-NI, SHA-NI and portable code (empty unless enabled in CryptoTests.cpp)
+	void RunAllTests();
+}
+#endif
@@ -69,10 +69,126 @@ void sha1_starts( sha1_context *ctx )
     ctx->state[4] = 0xC3D2E1F0;
 }
 
+static int sha1_portable_forced = 0;
+
+void sha1_force_portable( int disable )
+{
+    sha1_portable_forced = disable;
+}
+
+/*
+ * SHA-NI implementation (Intel SHA extensions), selected at runtime
+ */
+#if defined(_MSC_VER) ? _MSC_VER >= 1900 : (defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define SHA1_SHANI
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#define SHANI_TARGET
+#else
+#include <cpuid.h>
+#define SHANI_TARGET __attribute__((target("sha,ssse3")))
+#endif
+#include <immintrin.h>
+
+static int sha1_shani_supported()
+{
+    static int result = -1;
+
+    if( result < 0 )
+    {
+        unsigned int ecx1 = 0, ebx7 = 0;
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid( info, 0 );
+        const unsigned int max_leaf = (unsigned int)info[0];
+        __cpuid( info, 1 );
+        ecx1 = (unsigned int)info[2];
+        if( max_leaf >= 7 )
+        {
+            __cpuidex( info, 7, 0 );
+            ebx7 = (unsigned int)info[1];
+        }
+#else
+        unsigned int a, b, c, d;
+        if( __get_cpuid( 1, &a, &b, &c, &d ) )
+            ecx1 = c;
+        if( __get_cpuid_max( 0, nullptr ) >= 7 )
+        {
+            __cpuid_count( 7, 0, a, b, c, d );
+            ebx7 = b;
+        }
+#endif
+        result = ( ecx1 & ( 1 << 9 ) ) && ( ebx7 & ( 1 << 29 ) ); // SSSE3 and SHA
+    }
+
+    return result && !sha1_portable_forced;
+}
+
+/*
+ * Four rounds (k = 0..19): E0 and E1 alternate as the E input of SHA1RNDS4,
+ * the message schedule for the following rounds is computed in M[] meanwhile
+ */
+#define SHA1_QROUND(k, E_cur, E_next)                                   \
+{                                                                       \
+    E_cur = (k) ? _mm_sha1nexte_epu32( E_cur, M[(k) & 3] )              \
+                : _mm_add_epi32( E_cur, M[0] );                         \
+    E_next = ABCD;                                                      \
+    if( (k) >= 3 && (k) <= 18 )                                         \
+        M[((k) + 1) & 3] = _mm_sha1msg2_epu32( M[((k) + 1) & 3], M[(k) & 3] ); \
+    ABCD = _mm_sha1rnds4_epu32( ABCD, E_cur, (k) / 5 );                 \
+    if( (k) >= 1 && (k) <= 16 )                                         \
+        M[((k) + 3) & 3] = _mm_sha1msg1_epu32( M[((k) + 3) & 3], M[(k) & 3] ); \
+    if( (k) >= 2 && (k) <= 17 )                                         \
+        M[((k) + 2) & 3] = _mm_xor_si128( M[((k) + 2) & 3], M[(k) & 3] ); \
+}
+
+static SHANI_TARGET void sha1_process_shani( uint32_t state[5], const unsigned char *data, size_t blocks )
+{
+    const __m128i MASK = _mm_set_epi8( 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 );
+
+    __m128i ABCD = _mm_shuffle_epi32( _mm_loadu_si128( (const __m128i *) state ), 0x1B );
+    __m128i E0 = _mm_set_epi32( state[4], 0, 0, 0 );
+    __m128i E1;
+    __m128i M[4];
+
+    for( ; blocks; blocks--, data += 64 )
+    {
+        const __m128i ABCD_SAVE = ABCD;
+        const __m128i E0_SAVE = E0;
+
+        for( int i = 0; i < 4; i++ )
+            M[i] = _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i *) data + i ), MASK );
+
+        SHA1_QROUND(  0, E0, E1 ); SHA1_QROUND(  1, E1, E0 ); SHA1_QROUND(  2, E0, E1 ); SHA1_QROUND(  3, E1, E0 );
+        SHA1_QROUND(  4, E0, E1 ); SHA1_QROUND(  5, E1, E0 ); SHA1_QROUND(  6, E0, E1 ); SHA1_QROUND(  7, E1, E0 );
+        SHA1_QROUND(  8, E0, E1 ); SHA1_QROUND(  9, E1, E0 ); SHA1_QROUND( 10, E0, E1 ); SHA1_QROUND( 11, E1, E0 );
+        SHA1_QROUND( 12, E0, E1 ); SHA1_QROUND( 13, E1, E0 ); SHA1_QROUND( 14, E0, E1 ); SHA1_QROUND( 15, E1, E0 );
+        SHA1_QROUND( 16, E0, E1 ); SHA1_QROUND( 17, E1, E0 ); SHA1_QROUND( 18, E0, E1 ); SHA1_QROUND( 19, E1, E0 );
+
+        E0 = _mm_sha1nexte_epu32( E0, E0_SAVE );
+        ABCD = _mm_add_epi32( ABCD, ABCD_SAVE );
+    }
+
+    _mm_storeu_si128( (__m128i *) state, _mm_shuffle_epi32( ABCD, 0x1B ) );
+    state[4] = (uint32_t) _mm_cvtsi128_si32( _mm_srli_si128( E0, 12 ) );
+}
+
+#undef SHA1_QROUND
+#endif
+
 void sha1_process( sha1_context *ctx, const unsigned char data[64] )
 {
     uint32_t temp, W[16], A, B, C, D, E;
 
+#ifdef SHA1_SHANI
+    if( sha1_shani_supported() )
+    {
+        sha1_process_shani( ctx->state, data, 1 );
+        return;
+    }
+#endif
+
     GET_UINT32_BE( W[ 0], data,  0 );
     GET_UINT32_BE( W[ 1], data,  4 );
     GET_UINT32_BE( W[ 2], data,  8 );
@@ -254,6 +370,15 @@ void sha1_update( sha1_context *ctx, const unsigned char *input, size_t ilen )
         left = 0;
     }
 
+#ifdef SHA1_SHANI
+    if( ilen >= 64 && sha1_shani_supported() )
+    {
+        sha1_process_shani( ctx->state, input, ilen / 64 );
+        input += ilen & ~(size_t)0x3F;
+        ilen  &= 0x3F;
+    }
+#endif
+
     while( ilen >= 64 )
     {
         sha1_process( ctx, input );
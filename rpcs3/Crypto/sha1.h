@@ -85,6 +85,13 @@ void sha1_finish( sha1_context *ctx, unsigned char output[20] );
 /* Internal use */
 void sha1_process( sha1_context *ctx, const unsigned char data[64] );
 
+/**
+ * \brief          Ignore the SHA extensions (used by the tests to compare with the portable code)
+ *
+ * \param disable  1 to use the portable code only, 0 to use SHA-NI again if supported
+ */
+void sha1_force_portable( int disable );
+
 #ifdef __cplusplus
 }
 #endif
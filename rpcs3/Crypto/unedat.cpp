@@ -135,83 +135,114 @@ unsigned char* get_block_key(int block, NPD_HEADER *npd)
 	return dest_key;
 }
 
+// Block descriptor used by decrypt_data.
+struct EDAT_BLOCK
+{
+	u64 offset;               // file offset of the block data
+	u64 read_offset;          // file offset of the block data (or of its metadata if it precedes the data)
+	int read_length;          // bytes to read at read_offset
+	int length;               // padded length
+	int pad_length;           // real length
+	int compression_end;
+	size_t pos;               // position of the read data in the batch buffer
+	bool valid;
+	unsigned char key_result[0x10];
+	unsigned char hash[0x10];
+	unsigned char hash_result[0x14];
+};
+
+// Batches are read and decrypted at once, then written back in block order.
+static const size_t EDAT_BATCH_SIZE = 4 * 1024 * 1024;
+
+static bool s_edat_sequential = false;
+
+void edat_force_sequential(bool sequential)
+{
+	s_edat_sequential = sequential;
+}
+
 // EDAT/SDAT decryption.
 int decrypt_data(rFile *in, rFile *out, EDAT_HEADER *edat, NPD_HEADER *npd, unsigned char* crypt_key, bool verbose)
 {
 	// Get metadata info and setup buffers.
-	int block_num = (int)((edat->file_size + edat->block_size - 1) / edat->block_size);
-	int metadata_section_size = ((edat->flags & EDAT_COMPRESSED_FLAG) != 0 || (edat->flags & EDAT_FLAG_0x20) != 0) ? 0x20 : 0x10;
-	int metadata_offset = 0x100;
+	const int block_num = (int)((edat->file_size + edat->block_size - 1) / edat->block_size);
+	const int metadata_section_size = ((edat->flags & EDAT_COMPRESSED_FLAG) != 0 || (edat->flags & EDAT_FLAG_0x20) != 0) ? 0x20 : 0x10;
+	const int metadata_offset = 0x100;
+	const int padded_block_size = (int)((edat->block_size + 0xF) & 0xFFFFFFF0);
+
+	// Setup the crypto and hashing mode based on the extra flags.
+	int crypto_mode = ((edat->flags & EDAT_FLAG_0x02) == 0) ? 0x2 : 0x1;
+	int hash_mode;
+
+	if ((edat->flags & EDAT_FLAG_0x10) == 0)
+		hash_mode = 0x02;
+	else if ((edat->flags & EDAT_FLAG_0x20) == 0)
+		hash_mode = 0x04;
+	else
+		hash_mode = 0x01;
 
-	unsigned char *enc_data;
-	unsigned char *dec_data;
-	unsigned char *b_key;
-	unsigned char *iv;
+	if ((edat->flags & EDAT_ENCRYPTED_KEY_FLAG) != 0)
+	{
+		crypto_mode |= 0x10000000;
+		hash_mode |= 0x10000000;
+	}
 
-	unsigned char hash[0x10];
-	unsigned char key_result[0x10];
-	unsigned char hash_result[0x14];
-	memset(hash, 0, 0x10);
-	memset(key_result, 0, 0x10);
-	memset(hash_result, 0, 0x14);
-
-	unsigned long long offset = 0;
-	unsigned long long metadata_sec_offset = 0;
-	int length = 0;
-	int compression_end = 0;
+	if ((edat->flags & EDAT_DEBUG_DATA_FLAG) != 0)
+	{
+		// Reset the flags.
+		crypto_mode |= 0x01000000;
+		hash_mode |= 0x01000000;
+	}
+
+	// IV is null if NPD version is 1 or 0.
 	unsigned char empty_iv[0x10] = {};
+	unsigned char *iv = (npd->version <= 1) ? empty_iv : npd->digest;
+
+	// Read the whole metadata table at once (FLAG 0x20 metadata is read together with each data block).
+	std::vector<unsigned char> metadata;
+	if ((edat->flags & EDAT_FLAG_0x20) == 0 || (edat->flags & EDAT_COMPRESSED_FLAG) != 0)
+	{
+		metadata.resize((size_t)block_num * metadata_section_size);
+		in->Seek(metadata_offset);
+		in->Read(metadata.data(), metadata.size());
+	}
 
-	// Decrypt the metadata.
-	int i;
-	for (i = 0; i < block_num; i++)
+	// Decrypt the metadata and derive the block keys.
+	std::vector<EDAT_BLOCK> blocks(block_num);
+	for (int i = 0; i < block_num; i++)
 	{
-		memset(hash_result, 0, 0x14);
+		EDAT_BLOCK& b = blocks[i];
+		memset(&b, 0, sizeof(EDAT_BLOCK));
+
+		int length;
 
 		if ((edat->flags & EDAT_COMPRESSED_FLAG) != 0)
 		{
-			metadata_sec_offset = metadata_offset + (unsigned long long) i * metadata_section_size;
-			in->Seek(metadata_sec_offset);
-
-			unsigned char metadata[0x20];
-			memset(metadata, 0, 0x20);
-			in->Read(metadata, 0x20);
+			unsigned char *section = &metadata[(size_t)i * metadata_section_size];
 
 			// If the data is compressed, decrypt the metadata.
 			// NOTE: For NPD version 1 the metadata is not encrypted.
 			if (npd->version <= 1)
 			{
-				offset = swap64(*(unsigned long long*)&metadata[0x10]);
-				length = swap32(*(int*)&metadata[0x18]);
-				compression_end = swap32(*(int*)&metadata[0x1C]);
+				b.offset = swap64(*(unsigned long long*)&section[0x10]);
+				length = swap32(*(int*)&section[0x18]);
+				b.compression_end = swap32(*(int*)&section[0x1C]);
 			}
 			else
 			{
-				unsigned char *result = dec_section(metadata);
-				offset = swap64(*(unsigned long long*)&result[0]);
+				unsigned char *result = dec_section(section);
+				b.offset = swap64(*(unsigned long long*)&result[0]);
 				length = swap32(*(int*)&result[8]);
-				compression_end = swap32(*(int*)&result[12]);
+				b.compression_end = swap32(*(int*)&result[12]);
 				delete[] result;
 			}
-			
-			memcpy(hash_result, metadata, 0x10);
+
+			memcpy(b.hash_result, section, 0x10);
 		}
 		else if ((edat->flags & EDAT_FLAG_0x20) != 0)
 		{
-			// If FLAG 0x20, the metadata precedes each data block.
-			metadata_sec_offset = metadata_offset + (unsigned long long) i * (metadata_section_size + length);
-			in->Seek(metadata_sec_offset);
-
-			unsigned char metadata[0x20];
-			memset(metadata, 0, 0x20);
-			in->Read(metadata, 0x20);
-			memcpy(hash_result, metadata, 0x14);
-
-			// If FLAG 0x20 is set, apply custom xor.
-			int j;
-			for (j = 0; j < 0x10; j++)
-				hash_result[j] = (unsigned char)(metadata[j] ^ metadata[j + 0x10]);
-
-			offset = metadata_sec_offset + 0x20;
+			// If FLAG 0x20, the metadata precedes each data block (hash_result is set after reading it).
+			b.offset = metadata_offset + (unsigned long long) i * (metadata_section_size + padded_block_size) + 0x20;
 			length = edat->block_size;
 
 			if ((i == (block_num - 1)) && (edat->file_size % edat->block_size))
@@ -219,11 +250,8 @@ int decrypt_data(rFile *in, rFile *out, EDAT_HEADER *edat, NPD_HEADER *npd, unsi
 		}
 		else
 		{
-			metadata_sec_offset = metadata_offset + (unsigned long long) i * metadata_section_size;
-			in->Seek(metadata_sec_offset);
-
-			in->Read(hash_result, 0x10);
-			offset = metadata_offset + (unsigned long long) i * edat->block_size + (unsigned long long) block_num * metadata_section_size;
+			memcpy(b.hash_result, &metadata[(size_t)i * metadata_section_size], 0x10);
+			b.offset = metadata_offset + (unsigned long long) i * edat->block_size + (unsigned long long) block_num * metadata_section_size;
 			length = edat->block_size;
 
 			if ((i == (block_num - 1)) && (edat->file_size % edat->block_size))
@@ -231,110 +259,171 @@ int decrypt_data(rFile *in, rFile *out, EDAT_HEADER *edat, NPD_HEADER *npd, unsi
 		}
 
 		// Locate the real data.
-		int pad_length = length;
-		length = (int)((pad_length + 0xF) & 0xFFFFFFF0);
-
-		// Setup buffers for decryption and read the data.
-		enc_data = new unsigned char[length];
-		dec_data = new unsigned char[length];
-		memset(enc_data, 0, length);
-		memset(dec_data, 0, length);
-		memset(hash, 0, 0x10);
-		memset(key_result, 0, 0x10);
+		b.pad_length = length;
+		b.length = (int)((length + 0xF) & 0xFFFFFFF0);
+		b.read_offset = b.offset;
+		b.read_length = b.length;
 
-		in->Seek(offset);
-		in->Read(enc_data, length);
+		if ((edat->flags & EDAT_FLAG_0x20) != 0 && (edat->flags & EDAT_COMPRESSED_FLAG) == 0)
+		{
+			b.read_offset -= 0x20;
+			b.read_length += 0x20;
+		}
 
 		// Generate a key for the current block.
-		b_key = get_block_key(i, npd);
+		unsigned char *b_key = get_block_key(i, npd);
 
 		// Encrypt the block key with the crypto key.
-		aesecb128_encrypt(crypt_key, b_key, key_result);
+		aesecb128_encrypt(crypt_key, b_key, b.key_result);
 		if ((edat->flags & EDAT_FLAG_0x10) != 0)
-			aesecb128_encrypt(crypt_key, key_result, hash);  // If FLAG 0x10 is set, encrypt again to get the final hash.
+			aesecb128_encrypt(crypt_key, b.key_result, b.hash);  // If FLAG 0x10 is set, encrypt again to get the final hash.
 		else
-			memcpy(hash, key_result, 0x10);
+			memcpy(b.hash, b.key_result, 0x10);
+
+		delete[] b_key;
+	}
 
-		// Setup the crypto and hashing mode based on the extra flags.
-		int crypto_mode = ((edat->flags & EDAT_FLAG_0x02) == 0) ? 0x2 : 0x1;
-		int hash_mode;
+	metadata.clear();
 
-		if ((edat->flags  & EDAT_FLAG_0x10) == 0)
-			hash_mode = 0x02;
-		else if ((edat->flags & EDAT_FLAG_0x20) == 0)
-			hash_mode = 0x04;
-		else
-			hash_mode = 0x01;
+	std::vector<unsigned char> enc_data;
+	std::vector<unsigned char> dec_data;
+	std::vector<unsigned char> decomp_data;
 
-		if ((edat->flags  & EDAT_ENCRYPTED_KEY_FLAG) != 0)
+	for (int first = 0; first < block_num;)
+	{
+		// Collect the next batch and read its data, contiguous blocks are read with a single call.
+		int last = first;
+		size_t batch_size = 0;
+
+		while (last < block_num && (last == first || batch_size + blocks[last].read_length <= EDAT_BATCH_SIZE))
 		{
-			crypto_mode |= 0x10000000;
-			hash_mode |= 0x10000000;
+			blocks[last].pos = batch_size;
+			batch_size += blocks[last].read_length;
+			last++;
 		}
 
-		if ((edat->flags  & EDAT_DEBUG_DATA_FLAG) != 0)
+		enc_data.resize(batch_size);
+		dec_data.resize(batch_size);
+
+		for (int i = first; i < last;)
 		{
-			// Reset the flags.
-			crypto_mode |= 0x01000000;
-			hash_mode |= 0x01000000;
-			// Simply copy the data without the header or the footer.
-			memcpy(dec_data, enc_data, length);
+			int j = i + 1;
+			size_t size = blocks[i].read_length;
+
+			while (j < last && blocks[j].read_offset == blocks[j - 1].read_offset + blocks[j - 1].read_length)
+			{
+				size += blocks[j++].read_length;
+			}
+
+			in->Seek(blocks[i].read_offset);
+			in->Read(&enc_data[blocks[i].pos], size);
+			i = j;
 		}
-		else
+
+		// Decrypt the batch, blocks are independent and distributed between all available cores.
+		std::atomic<int> next(first);
+
+		auto decrypt_blocks = [&]()
 		{
-			// IV is null if NPD version is 1 or 0.
-			iv = (npd->version <= 1) ? empty_iv : npd->digest;
-			// Call main crypto routine on this data block.
-			if (!decrypt(hash_mode, crypto_mode, (npd->version == 4), enc_data, dec_data, length, key_result, iv, hash, hash_result))
+			for (int i; (i = next++) < last;)
 			{
-				if (verbose)
-					LOG_WARNING(LOADER, "EDAT: Block at offset 0x%llx has invalid hash!", offset);
-					
-				return 1;
+				EDAT_BLOCK& b = blocks[i];
+				unsigned char *enc = &enc_data[b.pos];
+				unsigned char *dec = &dec_data[b.pos];
+
+				if (b.read_offset != b.offset)
+				{
+					// If FLAG 0x20 is set, apply custom xor.
+					memcpy(b.hash_result, enc, 0x14);
+					for (int j = 0; j < 0x10; j++)
+						b.hash_result[j] = (unsigned char)(enc[j] ^ enc[j + 0x10]);
+
+					enc += 0x20;
+					dec += 0x20;
+				}
+
+				if ((edat->flags & EDAT_DEBUG_DATA_FLAG) != 0)
+				{
+					// Simply copy the data without the header or the footer.
+					memcpy(dec, enc, b.length);
+					b.valid = true;
+				}
+				else
+				{
+					// Call main crypto routine on this data block.
+					b.valid = decrypt(hash_mode, crypto_mode, (npd->version == 4), enc, dec, b.length, b.key_result, iv, b.hash, b.hash_result);
+				}
 			}
-		}
+		};
+
+		const int threads = s_edat_sequential ? 1 : std::max<int>(1, std::min<int>(std::thread::hardware_concurrency(), last - first));
 
-		// Apply additional compression if needed and write the decrypted data.
-		if (((edat->flags & EDAT_COMPRESSED_FLAG) != 0) && compression_end)
+		std::vector<std::thread> workers;
+
+		for (int t = 1; t < threads; t++)
 		{
-			int decomp_size = (int)edat->file_size;
-			unsigned char *decomp_data = new unsigned char[decomp_size];
-			memset(decomp_data, 0, decomp_size);
+			workers.emplace_back(decrypt_blocks);
+		}
 
-			if (verbose)
-				LOG_NOTICE(LOADER, "EDAT: Decompressing data...");
+		decrypt_blocks();
 
-			int res = decompress(decomp_data, dec_data, decomp_size);
-			out->Write(decomp_data, res);
+		for (auto& t : workers)
+		{
+			t.join();
+		}
 
-			if (verbose)
+		// Write the decrypted data in block order.
+		for (int i = first; i < last; i++)
+		{
+			const EDAT_BLOCK& b = blocks[i];
+			unsigned char *dec = &dec_data[b.pos + (b.read_length - b.length)];
+
+			if (!b.valid)
 			{
-				LOG_NOTICE(LOADER, "EDAT: Compressed block size: %d", pad_length);
-				LOG_NOTICE(LOADER, "EDAT: Decompressed block size: %d", res);
-			}
+				if (verbose)
+					LOG_WARNING(LOADER, "EDAT: Block at offset 0x%llx has invalid hash!", b.offset);
 
-			edat->file_size -= res;
+				return 1;
+			}
 
-			if (edat->file_size == 0)
+			// Apply additional compression if needed and write the decrypted data.
+			if (((edat->flags & EDAT_COMPRESSED_FLAG) != 0) && b.compression_end)
 			{
-				if (res < 0)
+				int decomp_size = (int)edat->file_size;
+				decomp_data.assign(decomp_size, 0);
+
+				if (verbose)
+					LOG_NOTICE(LOADER, "EDAT: Decompressing data...");
+
+				int res = decompress(decomp_data.data(), dec, decomp_size);
+				out->Write(decomp_data.data(), res);
+
+				if (verbose)
 				{
-					LOG_ERROR(LOADER, "EDAT: Decompression failed!");
-					return 1;
+					LOG_NOTICE(LOADER, "EDAT: Compressed block size: %d", b.pad_length);
+					LOG_NOTICE(LOADER, "EDAT: Decompressed block size: %d", res);
 				}
-				else
-					LOG_NOTICE(LOADER, "EDAT: Successfully decompressed!");
-			}
 
-			delete[] decomp_data;
-		}
-		else
-		{
-			out->Write(dec_data, pad_length);
+				edat->file_size -= res;
+
+				if (edat->file_size == 0)
+				{
+					if (res < 0)
+					{
+						LOG_ERROR(LOADER, "EDAT: Decompression failed!");
+						return 1;
+					}
+					else
+						LOG_NOTICE(LOADER, "EDAT: Successfully decompressed!");
+				}
+			}
+			else
+			{
+				out->Write(dec, b.pad_length);
+			}
 		}
 
-		delete[] enc_data;
-		delete[] dec_data;
+		first = last;
 	}
 
 	return 0;
@@ -898,4 +987,4 @@ int DecryptEDAT(const std::string& input_file_name, const std::string& output_fi
 	input.Close();
 	output.Close();
 	return 0;
-}
\ No newline at end of file
+}
\ No newline at end of file
@@ -33,4 +33,12 @@ typedef struct
 	unsigned long long file_size;
 } EDAT_HEADER;
 
+class rFile;
+
+int decrypt_data(rFile *in, rFile *out, EDAT_HEADER *edat, NPD_HEADER *npd, unsigned char* crypt_key, bool verbose);
+unsigned char* get_block_key(int block, NPD_HEADER *npd);
+
+// Decrypt the blocks on the calling thread only (used by the benchmark in CryptoTests.cpp).
+void edat_force_sequential(bool sequential);
+
 int DecryptEDAT(const std::string& input_file_name, const std::string& output_file_name, int mode, const std::string& rap_file_name, unsigned char *custom_klic, bool verbose);
\ No newline at end of file
@@ -10,6 +10,7 @@
 
 #include "Utilities/Log.h"
 #include "Utilities/rFile.h"
+#include <future>
 
 // Decryption.
 bool CheckHeader(rFile& pkg_f, PKGHeader* m_header)
@@ -70,85 +71,108 @@ bool LoadHeader(rFile& pkg_f, PKGHeader* m_header)
 	return true;
 }
 
-int Decrypt(rFile& pkg_f, rFile& dec_pkg_f, PKGHeader* m_header)
+// Every 16-byte block of the data area has its own keystream block, so any range of blocks
+// can be decrypted independently of the others given the index of its first block.
+static void DecryptBlocks(const PKGHeader& header, aes_context& c, u64 block, u8* data, size_t size)
 {
-	if (!LoadHeader(pkg_f, m_header))
-		return -1;
-
-	aes_context c;
-	u8 iv[HASH_LEN];
-	u8 buf[BUF_SIZE];
-	u8 ctr[BUF_SIZE];
-	
-	// Debug key
-	u8 key[0x40];
-	memset(key, 0, 0x40);
-	memcpy(key+0x00, &m_header->qa_digest[0], 8); // &data[0x60]
-	memcpy(key+0x08, &m_header->qa_digest[0], 8); // &data[0x60]
-	memcpy(key+0x10, &m_header->qa_digest[8], 8); // &data[0x68]
-	memcpy(key+0x18, &m_header->qa_digest[8], 8); // &data[0x68]
-
-	pkg_f.Seek(m_header->data_offset);
-	u32 parts = (m_header->data_size + BUF_SIZE - 1) / BUF_SIZE;
-
-	wxProgressDialog pdlg("PKG Decrypter / Installer", "Please wait, decrypting...", parts, 0, wxPD_AUTO_HIDE | wxPD_APP_MODAL);
-
-	memcpy(iv, m_header->klicensee, sizeof(iv));
-	aes_setkey_enc(&c, PKG_AES_KEY, 128);
-	
-	for (u32 i=0; i<parts; i++)
+	if (header.pkg_type == PKG_RELEASE_TYPE_DEBUG)
 	{
-		memset(buf, 0, sizeof(buf));
-		u32 length = pkg_f.Read(buf, BUF_SIZE);
-		u32 bits = (length + HASH_LEN - 1) / HASH_LEN;
-		
-		if (m_header->pkg_type == PKG_RELEASE_TYPE_DEBUG)
+		// Debug key
+		u8 key[0x40];
+		memset(key, 0, 0x40);
+		memcpy(key+0x00, &header.qa_digest[0], 8); // &data[0x60]
+		memcpy(key+0x08, &header.qa_digest[0], 8); // &data[0x60]
+		memcpy(key+0x10, &header.qa_digest[8], 8); // &data[0x68]
+		memcpy(key+0x18, &header.qa_digest[8], 8); // &data[0x68]
+		*(be_t<u64>*)&key[0x38] = block;
+
+		for (size_t i = 0; i < size; i += HASH_LEN)
 		{
-			for (u32 j=0; j<bits; j++)
+			u8 hash[0x14];
+			sha1(key, 0x40, hash);
+
+			for (size_t j = 0; j < HASH_LEN && i + j < size; j++)
 			{
-				u8 hash[0x14];
-				sha1(key, 0x40, hash);
-				*(u64*)&buf[j*HASH_LEN + 0] ^= *(u64*)&hash[0];
-				*(u64*)&buf[j*HASH_LEN + 8] ^= *(u64*)&hash[8];
-				*(be_t<u64>*)&key[0x38] += 1;
+				data[i + j] ^= hash[j];
 			}
+
+			*(be_t<u64>*)&key[0x38] += 1;
 		}
+	}
+	else
+	{
+		// AES-CTR, the counter is klicensee + block index (128-bit big endian)
+		u8 iv[HASH_LEN];
+		u8 stream[HASH_LEN];
+		size_t nc_off = 0;
 
-		if (m_header->pkg_type == PKG_RELEASE_TYPE_RELEASE)
-		{
-			for (u32 j=0; j<bits; j++)
-			{
-				aes_crypt_ecb(&c, AES_ENCRYPT, iv, ctr+j*HASH_LEN);
+		const u64 lo = *(be_t<u64>*)&header.klicensee[8];
+		*(be_t<u64>*)&iv[0] = *(be_t<u64>*)&header.klicensee[0] + (lo + block < lo ? 1 : 0);
+		*(be_t<u64>*)&iv[8] = lo + block;
 
-				be_t<u64> hi = *(be_t<u64>*)&iv[0];
-				be_t<u64> lo = *(be_t<u64>*)&iv[8];
-				lo++;
+		aes_crypt_ctr(&c, size, &nc_off, iv, stream, data, data);
+	}
+}
 
-				if (lo == 0)
-					hi += 1;
+// Decrypt data located at the given offset of the data area (must be a multiple of HASH_LEN),
+// large ranges are split between all available cores
+static void DecryptData(const PKGHeader& header, aes_context& c, u64 offset, u8* data, size_t size)
+{
+	const size_t min_part = 256 * 1024;
+	const size_t threads = std::max<size_t>(1, std::min<size_t>(std::thread::hardware_concurrency(), size / min_part));
+	const size_t part = (size / threads + HASH_LEN - 1) & ~(size_t)(HASH_LEN - 1);
 
-				*(be_t<u64>*)&iv[0] = hi;
-				*(be_t<u64>*)&iv[8] = lo;
-			}
-		
-			for (u32 j=0; j<length; j++) {
-				buf[j] ^= ctr[j];
-			}
-		}		
-		dec_pkg_f.Write(buf, length);
-		pdlg.Update(i);
+	std::vector<std::thread> workers;
+
+	for (size_t start = part; start < size; start += part)
+	{
+		workers.emplace_back(DecryptBlocks, std::cref(header), std::ref(c), (offset + start) / HASH_LEN, data + start, std::min(part, size - start));
 	}
-	pdlg.Update(parts);
-	return 0;
+
+	DecryptBlocks(header, c, offset / HASH_LEN, data, std::min(part, size));
+
+	for (auto& t : workers)
+	{
+		t.join();
+	}
+}
+
+// Read and decrypt size bytes at the given offset of the data area (buf must have HASH_LEN bytes of extra space)
+static bool ReadData(rFile& pkg_f, const PKGHeader& header, aes_context& c, u64 offset, u8* buf, size_t size)
+{
+	const u64 aligned = offset & ~(u64)(HASH_LEN - 1);
+	const size_t skip = (size_t)(offset - aligned);
+
+	pkg_f.Seek(header.data_offset + aligned);
+
+	if (pkg_f.Read(buf, size + skip) != size + skip)
+	{
+		LOG_ERROR(LOADER, "PKG: Unexpected end of file!");
+		return false;
+	}
+
+	DecryptData(header, c, aligned, buf, size + skip);
+
+	if (skip)
+	{
+		memmove(buf, buf + skip, size);
+	}
+
+	return true;
 }
 
 // Unpacking.
-bool LoadEntries(rFile& dec_pkg_f, PKGHeader* m_header, PKGEntry *m_entries)
+bool LoadEntries(rFile& pkg_f, const PKGHeader& header, aes_context& c, std::vector<PKGEntry>& entries)
 {
-	dec_pkg_f.Seek(0);
-	dec_pkg_f.Read(m_entries, sizeof(PKGEntry) * m_header->file_count);
-	
-	if (m_entries->name_offset / sizeof(PKGEntry) != m_header->file_count) {
+	std::vector<u8> buf(sizeof(PKGEntry) * header.file_count + HASH_LEN);
+
+	if (!header.file_count || !ReadData(pkg_f, header, c, 0, buf.data(), sizeof(PKGEntry) * header.file_count))
+		return false;
+
+	entries.resize(header.file_count);
+	memcpy(entries.data(), buf.data(), sizeof(PKGEntry) * header.file_count);
+
+	if (entries[0].name_offset / sizeof(PKGEntry) != header.file_count) {
 		LOG_ERROR(LOADER, "PKG: Entries are damaged!");
 		return false;
 	}
@@ -156,14 +180,16 @@ bool LoadEntries(rFile& dec_pkg_f, PKGHeader* m_header, PKGEntry *m_entries)
 	return true;
 }
 
-bool UnpackEntry(rFile& dec_pkg_f, const PKGEntry& entry, std::string dir)
+// Decrypt the entry straight into the destination file: the next chunk is read and decrypted while the previous one is written
+bool UnpackEntry(rFile& pkg_f, const PKGHeader& header, aes_context& c, const PKGEntry& entry, std::string dir, u8* buf[2], std::function<void(u64)> progress)
 {
-	u8 buf[BUF_SIZE];
+	std::vector<u8> name_buf(entry.name_size + HASH_LEN);
+
+	if (!ReadData(pkg_f, header, c, entry.name_offset, name_buf.data(), entry.name_size))
+		return false;
+
+	const std::string name(reinterpret_cast<char *>(name_buf.data()), entry.name_size);
 
-	dec_pkg_f.Seek(entry.name_offset);
-	dec_pkg_f.Read(buf, entry.name_size);
-	buf[entry.name_size] = 0;
-	
 	switch (entry.type & (0xff))
 	{
 		case PKG_FILE_ENTRY_NPDRM:
@@ -172,22 +198,41 @@ bool UnpackEntry(rFile& dec_pkg_f, const PKGEntry& entry, std::string dir)
 		case PKG_FILE_ENTRY_REGULAR:
 		{
 			rFile out;
-			out.Create(dir + std::string(reinterpret_cast<char *>(buf), entry.name_size));
-			dec_pkg_f.Seek(entry.file_offset);
-
-			for (u64 size = 0; size < entry.file_size; ) {
-				size += dec_pkg_f.Read(buf, BUF_SIZE);
-				if (size > entry.file_size)
-					out.Write(buf, BUF_SIZE - (size - entry.file_size));
-				else
-					out.Write(buf, BUF_SIZE);
+			if (!out.Create(dir + name, true)) {
+				LOG_ERROR(LOADER, "PKG: Could not create file '%s'", (dir + name).c_str());
+				return false;
+			}
+
+			std::future<bool> write;
+			u32 cur = 0;
+
+			for (u64 pos = 0; pos < entry.file_size; pos += PKG_BUF_SIZE, cur ^= 1) {
+				const size_t size = (size_t)std::min<u64>(PKG_BUF_SIZE, entry.file_size - pos);
+
+				if (!ReadData(pkg_f, header, c, entry.file_offset + pos, buf[cur], size))
+					return false;
+
+				if (write.valid() && !write.get()) {
+					LOG_ERROR(LOADER, "PKG: Could not write file '%s'", (dir + name).c_str());
+					return false;
+				}
+
+				u8* data = buf[cur];
+				write = std::async(std::launch::async, [&out, data, size]() { return out.Write(data, size) == size; });
+				progress(size);
+			}
+
+			if (write.valid() && !write.get()) {
+				LOG_ERROR(LOADER, "PKG: Could not write file '%s'", (dir + name).c_str());
+				return false;
 			}
+
 			out.Close();
 		}
 		break;
 			
 		case PKG_FILE_ENTRY_FOLDER:
-			rMkdir(dir + std::string(reinterpret_cast<char *>(buf), entry.name_size));
+			rMkdir(dir + name);
 		break;
 	}
 	return true;
@@ -195,39 +240,58 @@ bool UnpackEntry(rFile& dec_pkg_f, const PKGEntry& entry, std::string dir)
 
 int Unpack(rFile& pkg_f, std::string src, std::string dst)
 {
-	PKGHeader* m_header = (PKGHeader*) malloc (sizeof(PKGHeader));
-
-	rFile dec_pkg_f;
-	// TODO: This shouldn't use current dir
-	std::string decryptedFile = "./dev_hdd1/" + src + ".dec";
+	PKGHeader header;
 
-	dec_pkg_f.Create(decryptedFile, true);
-	
-	if (Decrypt(pkg_f, dec_pkg_f, m_header) < 0)
+	if (!LoadHeader(pkg_f, &header))
 		return -1;
-	
-	dec_pkg_f.Close();
 
-	rFile n_dec_pkg_f(decryptedFile, rFile::read);
+	aes_context c;
+	aes_setkey_enc(&c, PKG_AES_KEY, 128);
 
 	std::vector<PKGEntry> m_entries;
-	m_entries.resize(m_header->file_count);
-
-	PKGEntry *m_entries_ptr = &m_entries[0];
-	if (!LoadEntries(n_dec_pkg_f, m_header, m_entries_ptr))
+	if (!LoadEntries(pkg_f, header, c, m_entries))
 		return -1;
 
-	wxProgressDialog pdlg("PKG Decrypter / Installer", "Please wait, unpacking...", m_entries.size(), 0, wxPD_AUTO_HIDE | wxPD_APP_MODAL);
+	u64 total = 0;
+	for (const PKGEntry& entry : m_entries)
+	{
+		if ((entry.type & 0xff) != PKG_FILE_ENTRY_FOLDER)
+			total += entry.file_size;
+	}
+
+	// two buffers (double buffering), aligned for faster unbuffered I/O and SIMD decryption
+	std::unique_ptr<u8, void(*)(void*)> buf0((u8*)_aligned_malloc(PKG_BUF_SIZE + HASH_LEN, 4096), _aligned_free);
+	std::unique_ptr<u8, void(*)(void*)> buf1((u8*)_aligned_malloc(PKG_BUF_SIZE + HASH_LEN, 4096), _aligned_free);
+	u8* buf[2] = { buf0.get(), buf1.get() };
+
+	wxProgressDialog pdlg("PKG Decrypter / Installer", "Please wait, installing...", 1000, 0, wxPD_AUTO_HIDE | wxPD_APP_MODAL);
+
+	u64 done = 0;
+	const auto progress = [&](u64 size)
+	{
+		done += size;
+		pdlg.Update((int)(done * 1000 / std::max<u64>(total, 1)));
+	};
 
+	const auto start = std::chrono::steady_clock::now();
+	u32 failed = 0;
+
+	// a damaged entry doesn't stop the installation, the other files are still unpacked
 	for (const PKGEntry& entry : m_entries)
 	{
-		UnpackEntry(n_dec_pkg_f, entry, dst + src + "/");
-		pdlg.Update(pdlg.GetValue() + 1);
+		if (!UnpackEntry(pkg_f, header, c, entry, dst + src + "/", buf, progress))
+			failed++;
+	}
+	pdlg.Update(1000);
+
+	if (failed)
+	{
+		LOG_ERROR(LOADER, "PKG: %d of %d entries could not be unpacked", failed, (u32)m_entries.size());
 	}
-	pdlg.Update(m_entries.size());
 
-	n_dec_pkg_f.Close();
-	wxRemoveFile(decryptedFile);
+	const double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	LOG_NOTICE(LOADER, "PKG: %d entries, %lld MB unpacked in %.2f s (%.1f MB/s)",
+		(u32)m_entries.size(), total / (1024 * 1024), time, time > 0 ? total / time / (1024 * 1024) : 0.0);
 
 	return 0;
 }
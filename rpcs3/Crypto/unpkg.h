@@ -15,7 +15,7 @@
 #define PKG_FILE_ENTRY_OVERWRITE  0x80000000
 
 #define HASH_LEN 16
-#define BUF_SIZE 4096
+#define PKG_BUF_SIZE (8 * 1024 * 1024) // installer I/O buffer size
 
 // Structs
 struct PKGHeader
@@ -47,4 +47,10 @@ struct PKGEntry
 
 class rFile;
 
-extern int Unpack(rFile& dec_pkg_f, std::string src, std::string dst);
\ No newline at end of file
+extern int Unpack(rFile& pkg_f, std::string src, std::string dst);
+
+namespace unpkg
+{
+	// installs synthetic packages and compares the installed trees (empty unless enabled in unpkgTests.cpp)
+	void RunAllTests();
+}
\ No newline at end of file
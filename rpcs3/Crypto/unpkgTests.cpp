@@ -0,0 +1,288 @@
+#include "stdafx.h"
+#include "Utilities/Log.h"
+#include "Utilities/rFile.h"
+#include "aes.h"
+#include "sha1.h"
+#include "key_vault.h"
+#include "unpkg.h"
+
+//#define UNPKG_UNIT_TESTS 1
+
+#ifdef UNPKG_UNIT_TESTS
+#include <random>
+
+// Synthetic release and debug packages are encrypted with the serial keystream of the old installer (which decrypted
+// the whole data area to a temporary file first) and installed with Unpack(). The installed tree must contain exactly
+// the expected folders and files. The entries are packed without alignment, the file data spans several installer
+// buffers, the release counter carries into its upper half and one entry is damaged (the following entries must still
+// be installed).
+
+namespace unpkg
+{
+	struct test_entry
+	{
+		std::string name;
+		u32 type;
+		std::vector<u8> data;
+		bool damaged;
+	};
+
+	static const std::string s_dir = "./unpkg_test/";
+	static const std::string s_title = "UNPKGTEST";
+
+	// the keystream of the old Decrypt() loop, XOR is its own inverse so it encrypts as well
+	static void ref_crypt(const PKGHeader& header, u8* data, size_t size)
+	{
+		aes_context c;
+		aes_setkey_enc(&c, PKG_AES_KEY, 128);
+
+		u8 iv[HASH_LEN];
+		memcpy(iv, header.klicensee, sizeof(iv));
+
+		u8 key[0x40];
+		memset(key, 0, 0x40);
+		memcpy(key + 0x00, &header.qa_digest[0], 8);
+		memcpy(key + 0x08, &header.qa_digest[0], 8);
+		memcpy(key + 0x10, &header.qa_digest[8], 8);
+		memcpy(key + 0x18, &header.qa_digest[8], 8);
+
+		for (size_t pos = 0; pos < size; pos += HASH_LEN)
+		{
+			u8 stream[0x14];
+
+			if (header.pkg_type == PKG_RELEASE_TYPE_DEBUG)
+			{
+				sha1(key, 0x40, stream);
+				*(be_t<u64>*)&key[0x38] += 1;
+			}
+			else
+			{
+				aes_crypt_ecb(&c, AES_ENCRYPT, iv, stream);
+
+				be_t<u64> hi = *(be_t<u64>*)&iv[0];
+				be_t<u64> lo = *(be_t<u64>*)&iv[8];
+				lo++;
+
+				if (lo == 0)
+					hi += 1;
+
+				*(be_t<u64>*)&iv[0] = hi;
+				*(be_t<u64>*)&iv[8] = lo;
+			}
+
+			for (size_t j = 0; j < HASH_LEN && pos + j < size; j++)
+			{
+				data[pos + j] ^= stream[j];
+			}
+		}
+	}
+
+	// header, entry table, names and file data (packed without padding), and the 0x60 bytes after the data area
+	static std::vector<u8> build_package(u16 type, const std::vector<test_entry>& entries, std::mt19937& rng)
+	{
+		const u64 data_offset = PKG_HEADER_SIZE;
+
+		std::vector<u8> data(sizeof(PKGEntry) * entries.size());
+
+		for (size_t i = 0; i < entries.size(); i++)
+		{
+			PKGEntry& entry = ((PKGEntry*)data.data())[i];
+			memset(&entry, 0, sizeof(entry));
+			entry.name_offset = (u32)data.size();
+			entry.name_size = (u32)entries[i].name.size();
+			entry.type = entries[i].type;
+			data.insert(data.end(), entries[i].name.begin(), entries[i].name.end());
+		}
+
+		for (size_t i = 0; i < entries.size(); i++)
+		{
+			PKGEntry& entry = ((PKGEntry*)data.data())[i];
+			entry.file_offset = data.size();
+			entry.file_size = entries[i].data.size();
+
+			if (entries[i].damaged)
+			{
+				// points past the end of the package
+				entry.file_offset = 0x100000000ull;
+				entry.file_size = 0x1000;
+			}
+
+			data.insert(data.end(), entries[i].data.begin(), entries[i].data.end());
+		}
+
+		PKGHeader header;
+		memset(&header, 0, sizeof(header));
+		header.pkg_magic = 0x7F504B47;
+		header.pkg_type = type;
+		header.pkg_platform = PKG_PLATFORM_TYPE_PS3;
+		header.header_size = PKG_HEADER_SIZE;
+		header.file_count = (u32)entries.size();
+		header.data_offset = data_offset;
+		header.data_size = data.size();
+		header.pkg_size = data_offset + data.size() + 0x60;
+		for (auto& v : header.qa_digest) v = (u8)rng();
+
+		// the low half of the counter overflows within the data area
+		for (auto& v : header.klicensee) v = (u8)rng();
+		*(be_t<u64>*)&header.klicensee[8] = 0xffffffffffffffffull - 1000;
+
+		ref_crypt(header, data.data(), data.size());
+
+		std::vector<u8> res(data_offset);
+		memcpy(res.data(), &header, sizeof(header));
+		res.insert(res.end(), data.begin(), data.end());
+		res.resize(res.size() + 0x60);
+		return res;
+	}
+
+	// relative paths of all folders and files under the directory
+	static void list_tree(const std::string& root, const std::string& path, std::set<std::string>& result)
+	{
+		rDir dir(root + path);
+		std::string name;
+
+		for (bool found = dir.GetFirst(&name); found; found = dir.GetNext(&name))
+		{
+			result.insert(path + name);
+
+			if (rIsDir(root + path + name))
+			{
+				list_tree(root, path + name + "/", result);
+			}
+		}
+	}
+
+	static bool read_file(const std::string& path, std::vector<u8>& data)
+	{
+		rFile f(path, rFile::read);
+
+		if (!f.IsOpened())
+		{
+			return false;
+		}
+
+		data.resize(f.Length());
+		return f.Read(data.data(), data.size()) == data.size();
+	}
+
+	static void remove_tree(const std::string& path)
+	{
+		std::set<std::string> tree;
+		list_tree(path, "", tree);
+
+		// deepest paths first
+		for (auto it = tree.rbegin(); it != tree.rend(); it++)
+		{
+			rIsDir(path + *it) ? rRmdir(path + *it) : rRemoveFile(path + *it);
+		}
+
+		rRmdir(path);
+	}
+
+	static u32 run_install(const char* name, u16 type, const std::vector<test_entry>& entries, std::mt19937& rng)
+	{
+		const std::string pkg_path = s_dir + "test.pkg";
+		const std::string dst = s_dir + "dev_hdd0/";
+
+		remove_tree(s_dir);
+		rMkpath(dst + s_title);
+
+		{
+			const std::vector<u8> pkg = build_package(type, entries, rng);
+			rFile f;
+
+			if (!f.Create(pkg_path, true) || f.Write(pkg.data(), pkg.size()) != pkg.size())
+			{
+				LOG_ERROR(GENERAL, "[UT unpkg] %s: could not write '%s'", name, pkg_path.c_str());
+				return 1;
+			}
+		}
+
+		rFile pkg_f(pkg_path, rFile::read);
+
+		if (Unpack(pkg_f, s_title, dst) < 0)
+		{
+			LOG_ERROR(GENERAL, "[UT unpkg] %s: Unpack() failed", name);
+			return 1;
+		}
+
+		pkg_f.Close();
+
+		const std::string root = dst + s_title + "/";
+		std::set<std::string> expected, installed;
+		u32 failed = 0;
+
+		list_tree(root, "", installed);
+
+		for (auto& entry : entries)
+		{
+			expected.insert(entry.name);
+
+			if (entry.type == PKG_FILE_ENTRY_FOLDER || entry.damaged)
+			{
+				continue;
+			}
+
+			std::vector<u8> data;
+
+			if (!read_file(root + entry.name, data) || data != entry.data)
+			{
+				LOG_ERROR(GENERAL, "[UT unpkg] %s: '%s' differs (%d bytes, expected %d)", name, entry.name.c_str(), (u32)data.size(), (u32)entry.data.size());
+				failed++;
+			}
+		}
+
+		if (installed != expected)
+		{
+			LOG_ERROR(GENERAL, "[UT unpkg] %s: %d paths installed, %d expected", name, (u32)installed.size(), (u32)expected.size());
+			failed++;
+		}
+
+		remove_tree(s_dir);
+		return failed;
+	}
+
+	void RunAllTests()
+	{
+		LOG_NOTICE(GENERAL, "Running unpkg tests");
+
+		std::mt19937 rng(0x5eed);
+
+		auto random_data = [&rng](size_t size)
+		{
+			std::vector<u8> res(size);
+			for (auto& v : res) v = (u8)rng();
+			return res;
+		};
+
+		const std::vector<test_entry> entries =
+		{
+			{ "USRDIR", PKG_FILE_ENTRY_FOLDER, {}, false },
+			{ "PARAM.SFO", PKG_FILE_ENTRY_REGULAR | PKG_FILE_ENTRY_OVERWRITE, random_data(1001), false },
+			{ "ICON0.PNG", PKG_FILE_ENTRY_REGULAR, {}, false },
+			{ "USRDIR/EBOOT.BIN", PKG_FILE_ENTRY_NPDRM, random_data(2 * PKG_BUF_SIZE + 12345), false },
+			{ "USRDIR/DAMAGED.DAT", PKG_FILE_ENTRY_REGULAR, {}, true },
+			{ "USRDIR/A", PKG_FILE_ENTRY_REGULAR, random_data(17), false },
+			{ "USRDIR/DATA", PKG_FILE_ENTRY_FOLDER, {}, false },
+			{ "USRDIR/DATA/LEVEL1.DAT", PKG_FILE_ENTRY_SDAT, random_data(4099), false },
+		};
+
+		u32 num_failed = 0;
+
+		num_failed += run_install("release", PKG_RELEASE_TYPE_RELEASE, entries, rng);
+		num_failed += run_install("debug", PKG_RELEASE_TYPE_DEBUG, entries, rng);
+
+		LOG_NOTICE(GENERAL, "Unit Tests done (%d failed)", num_failed);
+	}
+}
+
+#else
+
+namespace unpkg
+{
+	void RunAllTests()
+	{
+	}
+}
+
+#endif // UNPKG_UNIT_TESTS
@@ -314,10 +314,16 @@ void SelfSection::Load(vfsStream& f)
 }
 
 SELFDecrypter::SELFDecrypter(vfsStream& s)
-	: self_f(s), key_v(), data_buf_length(0)
+	: self_f(s), key_v(), data_keys(nullptr), data_keys_length(0), data_buf(nullptr), data_buf_length(0)
 {
 }
 
+SELFDecrypter::~SELFDecrypter()
+{
+	free(data_keys);
+	free(data_buf);
+}
+
 bool SELFDecrypter::LoadHeaders(bool isElf32)
 {
 	// Read SCE header.
@@ -631,81 +637,89 @@ bool SELFDecrypter::LoadMetadata()
 
 bool SELFDecrypter::DecryptData()
 {
-	aes_context aes;
+	// Calculate the total data size and the offset of every encrypted section in the data buffer.
+	std::vector<u32> sections;
+	std::vector<u32> data_buf_offsets;
 
-	// Calculate the total data size.
 	for (unsigned int i = 0; i < meta_hdr.section_count; i++)
 	{
+		// Check if this is an encrypted section and make sure the key and iv are not out of boundaries.
 		if (meta_shdr[i].encrypted == 3)
 		{
 			if ((meta_shdr[i].key_idx <= meta_hdr.key_count - 1) && (meta_shdr[i].iv_idx <= meta_hdr.key_count))
+			{
+				sections.push_back(i);
+				data_buf_offsets.push_back(data_buf_length);
 				data_buf_length += meta_shdr[i].data_size;
+			}
 		}
 	}
 
 	// Allocate a buffer to store decrypted data.
 	data_buf = (u8*)malloc(data_buf_length);
 
-	// Set initial offset.
-	u32 data_buf_offset = 0;
-
-	// Parse the metadata section headers to find the offsets of encrypted data.
-	for (unsigned int i = 0; i < meta_hdr.section_count; i++)
+	// Read the encrypted data of all sections (the SELF stream can't be shared between threads).
+	for (size_t s = 0; s < sections.size(); s++)
 	{
-		size_t ctr_nc_off = 0;
-		u8 ctr_stream_block[0x10];
-		u8 data_key[0x10];
-		u8 data_iv[0x10];
+		const u32 i = sections[s];
 
-		// Check if this is an encrypted section.
-		if (meta_shdr[i].encrypted == 3)
+		self_f.Seek(meta_shdr[i].data_offset);
+		if (self_f.Read(data_buf + data_buf_offsets[s], meta_shdr[i].data_size) != meta_shdr[i].data_size)
 		{
-			// Make sure the key and iv are not out of boundaries.
-			if((meta_shdr[i].key_idx <= meta_hdr.key_count - 1) && (meta_shdr[i].iv_idx <= meta_hdr.key_count))
-			{
-				// Get the key and iv from the previously stored key buffer.
-				memcpy(data_key, data_keys + meta_shdr[i].key_idx * 0x10, 0x10);
-				memcpy(data_iv, data_keys + meta_shdr[i].iv_idx * 0x10, 0x10);
-
-				// Allocate a buffer to hold the data.
-				u8 *buf = (u8 *)malloc(meta_shdr[i].data_size);
+			LOG_ERROR(LOADER, "SELF: Failed to read section %d!", i);
+			return false;
+		}
+	}
 
-				// Seek to the section data offset and read the encrypted data.
-				self_f.Seek(meta_shdr[i].data_offset);
-				self_f.Read(buf, meta_shdr[i].data_size);
+	// Sections have their own keys and are decrypted in place, in parallel.
+	std::atomic<size_t> next(0);
 
-				// Zero out our ctr nonce.
-				memset(ctr_stream_block, 0, sizeof(ctr_stream_block));
+	auto decrypt_sections = [&]()
+	{
+		for (size_t s; (s = next++) < sections.size();)
+		{
+			const u32 i = sections[s];
 
-				// Perform AES-CTR encryption on the data blocks.
-				aes_setkey_enc(&aes, data_key, 128);
-				aes_crypt_ctr(&aes, meta_shdr[i].data_size, &ctr_nc_off, data_iv, ctr_stream_block, buf, buf);
+			aes_context aes;
+			size_t ctr_nc_off = 0;
+			u8 ctr_stream_block[0x10];
+			u8 data_key[0x10];
+			u8 data_iv[0x10];
 
-				// Copy the decrypted data.
-				memcpy(data_buf + data_buf_offset, buf, meta_shdr[i].data_size);
+			// Get the key and iv from the previously stored key buffer.
+			memcpy(data_key, data_keys + meta_shdr[i].key_idx * 0x10, 0x10);
+			memcpy(data_iv, data_keys + meta_shdr[i].iv_idx * 0x10, 0x10);
 
-				// Advance the buffer's offset.
-				data_buf_offset += meta_shdr[i].data_size;
+			// Zero out our ctr nonce.
+			memset(ctr_stream_block, 0, sizeof(ctr_stream_block));
 
-				// Release the temporary buffer.
-				free(buf);
-			}
+			// Perform AES-CTR encryption on the data blocks.
+			aes_setkey_enc(&aes, data_key, 128);
+			aes_crypt_ctr(&aes, meta_shdr[i].data_size, &ctr_nc_off, data_iv, ctr_stream_block, data_buf + data_buf_offsets[s], data_buf + data_buf_offsets[s]);
 		}
+	};
+
+	const size_t threads = std::max<size_t>(1, std::min<size_t>(std::thread::hardware_concurrency(), sections.size()));
+
+	std::vector<std::thread> workers;
+
+	for (size_t t = 1; t < threads; t++)
+	{
+		workers.emplace_back(decrypt_sections);
 	}
 
-	return true;
-}
+	decrypt_sections();
 
-bool SELFDecrypter::MakeElf(const std::string& elf, bool isElf32)
-{
-	// Create a new ELF file.
-	rFile e(elf.c_str(), rFile::write);
-	if(!e.IsOpened())
+	for (auto& t : workers)
 	{
-		LOG_ERROR(LOADER, "Could not create ELF file! (%s)", elf.c_str());
-		return false;
+		t.join();
 	}
 
+	return true;
+}
+
+bool SELFDecrypter::MakeElf(vfsStream& e, bool isElf32)
+{
 	// Set initial offset.
 	u32 data_buf_offset = 0;
 
@@ -803,7 +817,6 @@ bool SELFDecrypter::MakeElf(const std::string& elf, bool isElf32)
 		}
 	}
 
-	e.Close();
 	return true;
 }
 
@@ -877,7 +890,7 @@ bool IsSelfElf32(const std::string& path)
 	return (elf_class[4] == 1);
 }
 
-bool CheckDebugSelf(const std::string& self, const std::string& elf)
+bool CheckDebugSelf(const std::string& self, vfsStream& elf)
 {
 	// Open the SELF file.
 	rFile s(self);
@@ -907,20 +920,11 @@ bool CheckDebugSelf(const std::string& self, const std::string& elf)
 		elf_offset = swap64(elf_offset);
 		s.Seek(elf_offset);
 
-		// Write the real ELF file back.
-		rFile e(elf, rFile::write);
-		if(!e.IsOpened())
-		{
-			LOG_ERROR(LOADER, "Could not create ELF file! (%s)", elf.c_str());
-			return false;
-		}
+		// Copy the real ELF file.
+		std::vector<u8> buf((size_t)(s.Length() - elf_offset));
+		s.Read(buf.data(), buf.size());
+		elf.Write(buf.data(), buf.size());
 
-		// Copy the data.
-		char buf[2048];
-		while (ssize_t size = s.Read(buf, 2048))
-			e.Write(buf, size);
-
-		e.Close();
 		return true;
 	}
 	else
@@ -931,7 +935,7 @@ bool CheckDebugSelf(const std::string& self, const std::string& elf)
 	}
 }
 
-bool DecryptSelf(const std::string& elf, const std::string& self)
+bool DecryptSelf(vfsStream& elf, const std::string& self)
 {
 	// Check for a debug SELF first.
 	if (!CheckDebugSelf(self, elf))
@@ -977,5 +981,8 @@ bool DecryptSelf(const std::string& elf, const std::string& self)
 		}
 	}
 
+	// Rewind the ELF stream for the loader.
+	elf.Seek(0);
+
 	return true;
 }
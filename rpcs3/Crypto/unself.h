@@ -224,7 +224,8 @@ class SELFDecrypter
 
 public:
 	SELFDecrypter(vfsStream& s);
-	bool MakeElf(const std::string& elf, bool isElf32);
+	~SELFDecrypter();
+	bool MakeElf(vfsStream& e, bool isElf32);
 	bool LoadHeaders(bool isElf32);
 	void ShowHeaders(bool isElf32);
 	bool LoadMetadata();
@@ -235,5 +236,5 @@ public:
 
 extern bool IsSelf(const std::string& path);
 extern bool IsSelfElf32(const std::string& path);
-extern bool CheckDebugSelf(const std::string& self, const std::string& elf);
-extern bool DecryptSelf(const std::string& elf, const std::string& self);
+extern bool CheckDebugSelf(const std::string& self, vfsStream& elf);
+extern bool DecryptSelf(vfsStream& elf, const std::string& self);
@@ -0,0 +1,92 @@
+#include "stdafx.h"
+#include "Emu/Memory/Memory.h"
+#include "Emu/System.h"
+#include "Emu/SysCalls/lv2/sys_time.h"
+#include "AudioClock.h"
+
+AudioClock g_audio_clock;
+
+AudioClock::AudioClock()
+	: m_start_time(0)
+	, m_stopped(true)
+{
+	memset(&m_stats, 0, sizeof(m_stats));
+}
+
+void AudioClock::Start(u64 start_time)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_start_time = start_time;
+	m_stopped = false;
+	memset(&m_stats, 0, sizeof(m_stats));
+}
+
+void AudioClock::Stop()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_stopped = true;
+	m_cond.notify_all();
+}
+
+bool AudioClock::WaitDeadline(u64 block)
+{
+	const u64 deadline = GetDeadline(block);
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	while (true)
+	{
+		if (m_stopped || Emu.IsStopped())
+		{
+			return false;
+		}
+
+		const u64 now = get_system_time();
+
+		if (now >= deadline)
+		{
+			const u64 lateness = now - deadline;
+
+			m_stats.blocks++;
+			m_stats.total_lateness += lateness;
+
+			if (lateness > m_stats.max_lateness)
+			{
+				m_stats.max_lateness = lateness;
+			}
+
+			if (lateness >= GetDeadline(1) - m_start_time)
+			{
+				m_stats.late_blocks++;
+			}
+
+			return true;
+		}
+
+		// don't sleep too long to notice emulation stop
+		m_cond.wait_for(lock, std::chrono::microseconds(std::min<u64>(deadline - now, 10000)));
+	}
+}
+
+void AudioClock::Tick()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_cond.notify_all();
+}
+
+void AudioClock::ReportUnderrun()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_stats.underruns++;
+}
+
+AudioClockStats AudioClock::GetStats()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	return m_stats;
+}
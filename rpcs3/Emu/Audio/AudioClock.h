@@ -0,0 +1,69 @@
+#pragma once
+
+struct AudioClockStats
+{
+	u64 blocks; // blocks emitted
+	u64 late_blocks; // blocks started more than one block period after their deadline
+	u64 underruns; // blocks which were not filled in time by their producer
+	u64 max_lateness; // us
+	u64 total_lateness; // us
+};
+
+// Shared timeline of 256-sample blocks (48 kHz) for the cellAudio thread and its producers (libmixer).
+// The audio thread sleeps until the deadline of each block and publishes it with Tick(), producers wait
+// for published blocks instead of polling.
+class AudioClock
+{
+	std::mutex m_mutex;
+	std::condition_variable m_cond;
+	u64 m_start_time;
+	bool m_stopped;
+	AudioClockStats m_stats;
+
+public:
+	static const u64 block_samples = 256;
+	static const u64 sample_rate = 48000;
+
+	AudioClock();
+
+	void Start(u64 start_time);
+	void Stop();
+
+	u64 GetStartTime() const { return m_start_time; }
+
+	// time when the block should be mixed (us, get_system_time() base)
+	u64 GetDeadline(u64 block) const
+	{
+		return m_start_time + block * block_samples * 1000000 / sample_rate;
+	}
+
+	// sleep until the deadline of the block, returns false if the clock or emulation has been stopped
+	bool WaitDeadline(u64 block);
+
+	// called after a block has been published, wakes up waiting producers
+	void Tick();
+
+	// wait until pred() is true, it's evaluated again after every Tick()
+	template<typename T> bool WaitTick(const T pred)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		while (!pred())
+		{
+			if (m_stopped || Emu.IsStopped())
+			{
+				return false;
+			}
+
+			m_cond.wait_for(lock, std::chrono::milliseconds(10));
+		}
+
+		return true;
+	}
+
+	void ReportUnderrun();
+
+	AudioClockStats GetStats();
+};
+
+extern AudioClock g_audio_clock;
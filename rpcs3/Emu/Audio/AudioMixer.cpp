@@ -0,0 +1,240 @@
+#include "stdafx.h"
+#include "AudioMixer.h"
+
+static __forceinline __m128i bswap32(__m128i v)
+{
+	// swap bytes in 16-bit words, then swap words in 32-bit elements
+	v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+	return _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0xb1), 0xb1);
+}
+
+static __forceinline __m128 load_be(const be_t<float>* ptr)
+{
+	return _mm_castsi128_ps(bswap32(_mm_loadu_si128((const __m128i*)ptr)));
+}
+
+static __forceinline void store_be(be_t<float>* ptr, __m128 v)
+{
+	_mm_storeu_si128((__m128i*)ptr, bswap32(_mm_castps_si128(v)));
+}
+
+// Accumulating into unused channels with -0.0f leaves them unchanged (including -0.0f values),
+// storing the first mix pads them with 0.0f like the scalar code did
+template<bool first> static __forceinline __m128 pad_value()
+{
+	return first ? _mm_setzero_ps() : _mm_set1_ps(-0.0f);
+}
+
+template<bool first> static __forceinline void put(float* dst, __m128 v)
+{
+	_mm_storeu_ps(dst, first ? v : _mm_add_ps(_mm_loadu_ps(dst), v));
+}
+
+template<bool first> static void mix_port_2ch(float* buf2ch, float* buf8ch, const be_t<float>* src, __m128 level, u32 frames)
+{
+	const __m128 pad = pad_value<first>();
+
+	for (u32 i = 0; i < frames; i += 2)
+	{
+		const __m128 v = _mm_mul_ps(load_be(src + i * 2), level); // L0 R0 L1 R1
+
+		put<first>(buf2ch + i * 2, v);
+
+		put<first>(buf8ch + i * 8 + 0, _mm_movelh_ps(v, pad));
+		put<first>(buf8ch + i * 8 + 8, _mm_movehl_ps(pad, v));
+
+		if (first)
+		{
+			_mm_storeu_ps(buf8ch + i * 8 + 4, pad);
+			_mm_storeu_ps(buf8ch + i * 8 + 12, pad);
+		}
+	}
+}
+
+template<bool first> static void mix_port_6ch(float* buf2ch, float* buf8ch, const be_t<float>* src, __m128 level, u32 frames)
+{
+	const __m128 pad = pad_value<first>();
+	const __m128 k_mid = _mm_set1_ps(0.708f);
+
+	for (u32 i = 0; i < frames; i += 2)
+	{
+		const __m128 a0 = _mm_mul_ps(load_be(src + i * 6 + 0), level); // L0 R0 C0 LFE0
+		const __m128 a1 = _mm_mul_ps(load_be(src + i * 6 + 4), level); // RL0 RR0 L1 R1
+		const __m128 a2 = _mm_mul_ps(load_be(src + i * 6 + 8), level); // C1 LFE1 RL1 RR1
+
+		const __m128 front = _mm_shuffle_ps(a0, a1, _MM_SHUFFLE(3, 2, 1, 0)); // L0 R0 L1 R1
+		const __m128 rear = _mm_shuffle_ps(a1, a2, _MM_SHUFFLE(3, 2, 1, 0)); // RL0 RR0 RL1 RR1
+		const __m128 cf = _mm_shuffle_ps(a0, a2, _MM_SHUFFLE(1, 0, 3, 2)); // C0 LFE0 C1 LFE1
+		const __m128 mid = _mm_mul_ps(_mm_add_ps(cf, _mm_shuffle_ps(cf, cf, _MM_SHUFFLE(2, 3, 0, 1))), k_mid);
+
+		put<first>(buf2ch + i * 2, _mm_add_ps(_mm_add_ps(front, rear), mid));
+
+		put<first>(buf8ch + i * 8 + 0, a0);
+		put<first>(buf8ch + i * 8 + 4, _mm_movelh_ps(a1, pad));
+		put<first>(buf8ch + i * 8 + 8, _mm_shuffle_ps(a1, a2, _MM_SHUFFLE(1, 0, 3, 2)));
+		put<first>(buf8ch + i * 8 + 12, _mm_movehl_ps(pad, a2));
+	}
+}
+
+template<bool first> static void mix_port_8ch(float* buf2ch, float* buf8ch, const be_t<float>* src, __m128 level, u32 frames)
+{
+	const __m128 k_mid = _mm_set1_ps(0.708f);
+
+	for (u32 i = 0; i < frames; i += 2)
+	{
+		const __m128 a0 = _mm_mul_ps(load_be(src + i * 8 + 0), level); // L0 R0 C0 LFE0
+		const __m128 a1 = _mm_mul_ps(load_be(src + i * 8 + 4), level); // RL0 RR0 SL0 SR0
+		const __m128 b0 = _mm_mul_ps(load_be(src + i * 8 + 8), level); // L1 R1 C1 LFE1
+		const __m128 b1 = _mm_mul_ps(load_be(src + i * 8 + 12), level); // RL1 RR1 SL1 SR1
+
+		const __m128 front = _mm_movelh_ps(a0, b0);
+		const __m128 cf = _mm_movehl_ps(b0, a0);
+		const __m128 rear = _mm_movelh_ps(a1, b1);
+		const __m128 side = _mm_movehl_ps(b1, a1);
+		const __m128 mid = _mm_mul_ps(_mm_add_ps(cf, _mm_shuffle_ps(cf, cf, _MM_SHUFFLE(2, 3, 0, 1))), k_mid);
+
+		put<first>(buf2ch + i * 2, _mm_add_ps(_mm_add_ps(_mm_add_ps(front, rear), side), mid));
+
+		put<first>(buf8ch + i * 8 + 0, a0);
+		put<first>(buf8ch + i * 8 + 4, a1);
+		put<first>(buf8ch + i * 8 + 8, b0);
+		put<first>(buf8ch + i * 8 + 12, b1);
+	}
+}
+
+void audio_mix_port(float* buf2ch, float* buf8ch, const be_t<float>* src, u32 channels, float level, u32 frames, bool first)
+{
+	assert(frames % 2 == 0);
+
+	const __m128 lv = _mm_set1_ps(level);
+
+	switch (channels)
+	{
+	case 2: first ? mix_port_2ch<true>(buf2ch, buf8ch, src, lv, frames) : mix_port_2ch<false>(buf2ch, buf8ch, src, lv, frames); break;
+	case 6: first ? mix_port_6ch<true>(buf2ch, buf8ch, src, lv, frames) : mix_port_6ch<false>(buf2ch, buf8ch, src, lv, frames); break;
+	case 8: first ? mix_port_8ch<true>(buf2ch, buf8ch, src, lv, frames) : mix_port_8ch<false>(buf2ch, buf8ch, src, lv, frames); break;
+	default: assert(!"audio_mix_port(): unsupported channel count");
+	}
+}
+
+static __forceinline void add_lo(float* dst, __m128 v)
+{
+	// dst[0..1] += v[0..1]
+	const __m128 d = _mm_loadl_pi(_mm_setzero_ps(), (const __m64*)dst);
+	_mm_storel_pi((__m64*)dst, _mm_add_ps(d, v));
+}
+
+void audio_upmix_be(float* dst8ch, const be_t<float>* src, u32 channels, u32 frames)
+{
+	assert(frames % 4 == 0);
+
+	switch (channels)
+	{
+	case 1:
+	{
+		for (u32 i = 0; i < frames; i += 4)
+		{
+			const __m128 v = load_be(src + i); // C0 C1 C2 C3
+			const __m128 lo = _mm_unpacklo_ps(v, v);
+			const __m128 hi = _mm_unpackhi_ps(v, v);
+			add_lo(dst8ch + i * 8 + 0, lo);
+			add_lo(dst8ch + i * 8 + 8, _mm_movehl_ps(lo, lo));
+			add_lo(dst8ch + i * 8 + 16, hi);
+			add_lo(dst8ch + i * 8 + 24, _mm_movehl_ps(hi, hi));
+		}
+		break;
+	}
+
+	case 2:
+	{
+		for (u32 i = 0; i < frames; i += 2)
+		{
+			const __m128 v = load_be(src + i * 2); // L0 R0 L1 R1
+			add_lo(dst8ch + i * 8 + 0, v);
+			add_lo(dst8ch + i * 8 + 8, _mm_movehl_ps(v, v));
+		}
+		break;
+	}
+
+	case 6:
+	{
+		for (u32 i = 0; i < frames; i += 2)
+		{
+			const __m128 a0 = load_be(src + i * 6 + 0); // L0 R0 C0 LFE0
+			const __m128 a1 = load_be(src + i * 6 + 4); // RL0 RR0 L1 R1
+			const __m128 a2 = load_be(src + i * 6 + 8); // C1 LFE1 RL1 RR1
+			put<false>(dst8ch + i * 8 + 0, a0);
+			add_lo(dst8ch + i * 8 + 4, a1);
+			put<false>(dst8ch + i * 8 + 8, _mm_shuffle_ps(a1, a2, _MM_SHUFFLE(1, 0, 3, 2)));
+			add_lo(dst8ch + i * 8 + 12, _mm_movehl_ps(a2, a2));
+		}
+		break;
+	}
+
+	case 8:
+	{
+		for (u32 i = 0; i < frames * 8; i += 4)
+		{
+			put<false>(dst8ch + i, load_be(src + i));
+		}
+		break;
+	}
+
+	default: assert(!"audio_upmix_be(): unsupported channel count");
+	}
+}
+
+void audio_mix_s16_voice(float* dst8ch, const s16* src, u32 channels, float level, u32 frames)
+{
+	assert(frames % 4 == 0);
+
+	const __m128 scale = _mm_set1_ps(1.0f / 0x8000); // exact, same as dividing by 0x8000
+	const __m128 lv = _mm_set1_ps(level);
+
+	if (channels == 1)
+	{
+		for (u32 i = 0; i < frames; i += 4)
+		{
+			const __m128i s = _mm_loadl_epi64((const __m128i*)(src + i)); // C0 C1 C2 C3
+			const __m128 v = _mm_mul_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16)), scale), lv);
+			const __m128 lo = _mm_unpacklo_ps(v, v);
+			const __m128 hi = _mm_unpackhi_ps(v, v);
+			add_lo(dst8ch + i * 8 + 0, lo);
+			add_lo(dst8ch + i * 8 + 8, _mm_movehl_ps(lo, lo));
+			add_lo(dst8ch + i * 8 + 16, hi);
+			add_lo(dst8ch + i * 8 + 24, _mm_movehl_ps(hi, hi));
+		}
+	}
+	else if (channels == 2)
+	{
+		for (u32 i = 0; i < frames; i += 4)
+		{
+			const __m128i s = _mm_loadu_si128((const __m128i*)(src + i * 2)); // L0 R0 L1 R1 L2 R2 L3 R3
+			const __m128 lo = _mm_mul_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16)), scale), lv);
+			const __m128 hi = _mm_mul_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16)), scale), lv);
+			add_lo(dst8ch + i * 8 + 0, lo);
+			add_lo(dst8ch + i * 8 + 8, _mm_movehl_ps(lo, lo));
+			add_lo(dst8ch + i * 8 + 16, hi);
+			add_lo(dst8ch + i * 8 + 24, _mm_movehl_ps(hi, hi));
+		}
+	}
+	else
+	{
+		assert(!"audio_mix_s16_voice(): unsupported channel count");
+	}
+}
+
+void audio_store_be(be_t<float>* dst, const float* src, u32 count)
+{
+	u32 i = 0;
+
+	for (; i + 4 <= count; i += 4)
+	{
+		store_be(dst + i, _mm_loadu_ps(src + i));
+	}
+
+	for (; i < count; i++)
+	{
+		dst[i] = src[i];
+	}
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+// SSE2 mixing kernels used by cellAudio and libmixer.
+// Every kernel performs the same float operations in the same order as the scalar loops it replaces,
+// so the output is bit-exact. Frame counts must be even (cellAudio and libmixer always use 256).
+
+// Mix one block of a big-endian audio port (2, 6 or 8 channels) scaled by level into the intermediate
+// 2ch (downmixed) and 8ch buffers. If first is set, destination buffers are overwritten, otherwise accumulated.
+void audio_mix_port(float* buf2ch, float* buf8ch, const be_t<float>* src, u32 channels, float level, u32 frames, bool first);
+
+// Add big-endian 1, 2, 6 or 8 channel data to the corresponding channels of an 8ch buffer
+void audio_upmix_be(float* dst8ch, const be_t<float>* src, u32 channels, u32 frames);
+
+// Add a little-endian s16 mono or stereo voice (scaled by level / 0x8000) to channels 0-1 of an 8ch buffer
+void audio_mix_s16_voice(float* dst8ch, const s16* src, u32 channels, float level, u32 frames);
+
+// Store floats in big-endian byte order
+void audio_store_be(be_t<float>* dst, const float* src, u32 count);
+
+namespace audio_mixer
+{
+	// bit-exactness tests against the scalar loops and a benchmark (empty unless enabled in AudioMixerTests.cpp)
+	void RunAllTests();
+}
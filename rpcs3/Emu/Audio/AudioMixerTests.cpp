@@ -0,0 +1,488 @@
+#include "stdafx.h"
+#include "Utilities/Log.h"
+#include "AudioMixer.h"
+
+//#define AUDIO_MIXER_UNIT_TESTS 1
+
+#ifdef AUDIO_MIXER_UNIT_TESTS
+#include <random>
+
+// Every kernel is compared bit for bit with the scalar loop which cellAudio or libmixer used before (the references
+// below), for all channel counts, with random samples, levels and edge values (zeros, denormals, infinities).
+// NaNs are left out: the compiler may swap the operands of a scalar addition, which changes the propagated NaN.
+// The benchmark reports mixed frames per second of the kernels and the references.
+
+namespace audio_mixer
+{
+	static const u32 s_frames = 256;
+	static const u32 s_iterations = 100;
+	static const u32 s_bench_blocks = 20000;
+
+	static void ref_mix_port(float* buf2ch, float* buf8ch, const be_t<float>* buf, u32 channels, float level, u32 frames, bool first_mix)
+	{
+		static const float k = 1.0f;
+		const float m = level;
+
+		if (channels == 2)
+		{
+			for (u32 i = 0; i < frames * 2; i += 2)
+			{
+				const float left = buf[i + 0] * m;
+				const float right = buf[i + 1] * m;
+
+				if (first_mix)
+				{
+					buf2ch[i + 0] = left;
+					buf2ch[i + 1] = right;
+
+					buf8ch[i * 4 + 0] = left;
+					buf8ch[i * 4 + 1] = right;
+					buf8ch[i * 4 + 2] = 0.0f;
+					buf8ch[i * 4 + 3] = 0.0f;
+					buf8ch[i * 4 + 4] = 0.0f;
+					buf8ch[i * 4 + 5] = 0.0f;
+					buf8ch[i * 4 + 6] = 0.0f;
+					buf8ch[i * 4 + 7] = 0.0f;
+				}
+				else
+				{
+					buf2ch[i + 0] += left;
+					buf2ch[i + 1] += right;
+
+					buf8ch[i * 4 + 0] += left;
+					buf8ch[i * 4 + 1] += right;
+				}
+			}
+		}
+		else if (channels == 6)
+		{
+			for (u32 i = 0; i < frames * 2; i += 2)
+			{
+				const float left = buf[i * 3 + 0] * m;
+				const float right = buf[i * 3 + 1] * m;
+				const float center = buf[i * 3 + 2] * m;
+				const float low_freq = buf[i * 3 + 3] * m;
+				const float rear_left = buf[i * 3 + 4] * m;
+				const float rear_right = buf[i * 3 + 5] * m;
+
+				const float mid = (center + low_freq) * 0.708f;
+
+				if (first_mix)
+				{
+					buf2ch[i + 0] = (left + rear_left + mid) * k;
+					buf2ch[i + 1] = (right + rear_right + mid) * k;
+
+					buf8ch[i * 4 + 0] = left;
+					buf8ch[i * 4 + 1] = right;
+					buf8ch[i * 4 + 2] = center;
+					buf8ch[i * 4 + 3] = low_freq;
+					buf8ch[i * 4 + 4] = rear_left;
+					buf8ch[i * 4 + 5] = rear_right;
+					buf8ch[i * 4 + 6] = 0.0f;
+					buf8ch[i * 4 + 7] = 0.0f;
+				}
+				else
+				{
+					buf2ch[i + 0] += (left + rear_left + mid) * k;
+					buf2ch[i + 1] += (right + rear_right + mid) * k;
+
+					buf8ch[i * 4 + 0] += left;
+					buf8ch[i * 4 + 1] += right;
+					buf8ch[i * 4 + 2] += center;
+					buf8ch[i * 4 + 3] += low_freq;
+					buf8ch[i * 4 + 4] += rear_left;
+					buf8ch[i * 4 + 5] += rear_right;
+				}
+			}
+		}
+		else if (channels == 8)
+		{
+			for (u32 i = 0; i < frames * 2; i += 2)
+			{
+				const float left = buf[i * 4 + 0] * m;
+				const float right = buf[i * 4 + 1] * m;
+				const float center = buf[i * 4 + 2] * m;
+				const float low_freq = buf[i * 4 + 3] * m;
+				const float rear_left = buf[i * 4 + 4] * m;
+				const float rear_right = buf[i * 4 + 5] * m;
+				const float side_left = buf[i * 4 + 6] * m;
+				const float side_right = buf[i * 4 + 7] * m;
+
+				const float mid = (center + low_freq) * 0.708f;
+
+				if (first_mix)
+				{
+					buf2ch[i + 0] = (left + rear_left + side_left + mid) * k;
+					buf2ch[i + 1] = (right + rear_right + side_right + mid) * k;
+
+					buf8ch[i * 4 + 0] = left;
+					buf8ch[i * 4 + 1] = right;
+					buf8ch[i * 4 + 2] = center;
+					buf8ch[i * 4 + 3] = low_freq;
+					buf8ch[i * 4 + 4] = rear_left;
+					buf8ch[i * 4 + 5] = rear_right;
+					buf8ch[i * 4 + 6] = side_left;
+					buf8ch[i * 4 + 7] = side_right;
+				}
+				else
+				{
+					buf2ch[i + 0] += (left + rear_left + side_left + mid) * k;
+					buf2ch[i + 1] += (right + rear_right + side_right + mid) * k;
+
+					buf8ch[i * 4 + 0] += left;
+					buf8ch[i * 4 + 1] += right;
+					buf8ch[i * 4 + 2] += center;
+					buf8ch[i * 4 + 3] += low_freq;
+					buf8ch[i * 4 + 4] += rear_left;
+					buf8ch[i * 4 + 5] += rear_right;
+					buf8ch[i * 4 + 6] += side_left;
+					buf8ch[i * 4 + 7] += side_right;
+				}
+			}
+		}
+	}
+
+	static void ref_upmix_be(float* mixdata, const be_t<float>* addr, u32 channels, u32 samples)
+	{
+		if (channels == 1)
+		{
+			for (u32 i = 0; i < samples; i++)
+			{
+				const float center = addr[i];
+				mixdata[i * 8 + 0] += center;
+				mixdata[i * 8 + 1] += center;
+			}
+		}
+		else if (channels == 2)
+		{
+			for (u32 i = 0; i < samples; i++)
+			{
+				const float left = addr[i * 2 + 0];
+				const float right = addr[i * 2 + 1];
+				mixdata[i * 8 + 0] += left;
+				mixdata[i * 8 + 1] += right;
+			}
+		}
+		else if (channels == 6)
+		{
+			for (u32 i = 0; i < samples; i++)
+			{
+				const float left = addr[i * 6 + 0];
+				const float right = addr[i * 6 + 1];
+				const float center = addr[i * 6 + 2];
+				const float low_freq = addr[i * 6 + 3];
+				const float rear_left = addr[i * 6 + 4];
+				const float rear_right = addr[i * 6 + 5];
+				mixdata[i * 8 + 0] += left;
+				mixdata[i * 8 + 1] += right;
+				mixdata[i * 8 + 2] += center;
+				mixdata[i * 8 + 3] += low_freq;
+				mixdata[i * 8 + 4] += rear_left;
+				mixdata[i * 8 + 5] += rear_right;
+			}
+		}
+		else if (channels == 8)
+		{
+			for (u32 i = 0; i < samples * 8; i++)
+			{
+				mixdata[i] += addr[i];
+			}
+		}
+	}
+
+	static void ref_mix_s16_voice(float* mixdata, const s16* v, u32 channels, float level, u32 frames)
+	{
+		for (u32 i = 0; i < frames; i++)
+		{
+			float left, right;
+
+			if (channels == 1)
+			{
+				left = right = (float)v[i] / 0x8000 * level;
+			}
+			else
+			{
+				left = (float)v[i * 2 + 0] / 0x8000 * level;
+				right = (float)v[i * 2 + 1] / 0x8000 * level;
+			}
+
+			mixdata[i * 8 + 0] += left;
+			mixdata[i * 8 + 1] += right;
+		}
+	}
+
+	static void ref_store_be(be_t<float>* buf, const float* mixdata, u32 count)
+	{
+		for (u32 i = 0; i < count; i++)
+		{
+			buf[i] = mixdata[i];
+		}
+	}
+
+	class test_data
+	{
+		std::mt19937 m_rng;
+
+	public:
+		test_data()
+			: m_rng(0x5eed)
+		{
+		}
+
+		// mostly normal samples, some edge values and random exponents (without NaNs)
+		float sample()
+		{
+			static const u32 edge[] = { 0x00000000, 0x80000000, 0x00000001, 0x807fffff, 0x00800000, 0x3f800000, 0xbf800000, 0x7f7fffff, 0xff7fffff, 0x7f800000, 0xff800000 };
+
+			u32 bits;
+			const u32 kind = m_rng() % 16;
+
+			if (kind == 0)
+			{
+				bits = edge[m_rng() % (sizeof(edge) / sizeof(edge[0]))];
+			}
+			else if (kind == 1)
+			{
+				do bits = m_rng(); while ((bits & 0x7f800000) == 0x7f800000 && (bits & 0x7fffff));
+			}
+			else
+			{
+				return normal();
+			}
+
+			return (float&)bits;
+		}
+
+		float normal()
+		{
+			return std::uniform_real_distribution<float>(-1.0f, 1.0f)(m_rng);
+		}
+
+		float level()
+		{
+			static const float levels[] = { 0.0f, 1.0f, 0.5f, 0.708f };
+			const u32 i = m_rng() % 8;
+			return i < 4 ? levels[i] : std::uniform_real_distribution<float>(0.0f, 1.0f)(m_rng);
+		}
+
+		s16 s16_sample()
+		{
+			static const s16 edge[] = { 0, 1, -1, 0x7fff, -0x8000 };
+			return m_rng() % 8 ? (s16)m_rng() : edge[m_rng() % 5];
+		}
+
+		template<typename T> void fill(std::vector<T>& data)
+		{
+			for (auto& v : data) v = sample();
+		}
+
+		void fill(std::vector<s16>& data)
+		{
+			for (auto& v : data) v = s16_sample();
+		}
+	};
+
+	static bool equal(const std::vector<float>& a, const std::vector<float>& b)
+	{
+		return a.size() == b.size() && memcmp(a.data(), b.data(), a.size() * sizeof(float)) == 0;
+	}
+
+	static u32 test_mix_port(test_data& data)
+	{
+		u32 failed = 0;
+
+		for (u32 channels : { 2, 6, 8 })
+		{
+			for (bool first : { true, false })
+			{
+				for (u32 n = 0; n < s_iterations; n++)
+				{
+					std::vector<be_t<float>> src(s_frames * channels);
+					std::vector<float> buf2ch(s_frames * 2), buf8ch(s_frames * 8);
+					data.fill(src);
+					data.fill(buf2ch);
+					data.fill(buf8ch);
+					const float level = data.level();
+
+					std::vector<float> ref2ch = buf2ch, ref8ch = buf8ch;
+					ref_mix_port(ref2ch.data(), ref8ch.data(), src.data(), channels, level, s_frames, first);
+					audio_mix_port(buf2ch.data(), buf8ch.data(), src.data(), channels, level, s_frames, first);
+
+					if (!equal(buf2ch, ref2ch) || !equal(buf8ch, ref8ch))
+					{
+						LOG_ERROR(GENERAL, "[UT audio_mixer] audio_mix_port(channels=%d, first=%d, level=%f) differs", channels, first, level);
+						failed++;
+						break;
+					}
+				}
+			}
+		}
+
+		return failed;
+	}
+
+	static u32 test_upmix_be(test_data& data)
+	{
+		u32 failed = 0;
+
+		for (u32 channels : { 1, 2, 6, 8 })
+		{
+			for (u32 n = 0; n < s_iterations; n++)
+			{
+				std::vector<be_t<float>> src(s_frames * channels);
+				std::vector<float> dst(s_frames * 8);
+				data.fill(src);
+				data.fill(dst);
+
+				std::vector<float> ref = dst;
+				ref_upmix_be(ref.data(), src.data(), channels, s_frames);
+				audio_upmix_be(dst.data(), src.data(), channels, s_frames);
+
+				if (!equal(dst, ref))
+				{
+					LOG_ERROR(GENERAL, "[UT audio_mixer] audio_upmix_be(channels=%d) differs", channels);
+					failed++;
+					break;
+				}
+			}
+		}
+
+		return failed;
+	}
+
+	static u32 test_mix_s16_voice(test_data& data)
+	{
+		u32 failed = 0;
+
+		for (u32 channels : { 1, 2 })
+		{
+			for (u32 n = 0; n < s_iterations; n++)
+			{
+				std::vector<s16> src(s_frames * channels);
+				std::vector<float> dst(s_frames * 8);
+				data.fill(src);
+				data.fill(dst);
+				const float level = data.level();
+
+				std::vector<float> ref = dst;
+				ref_mix_s16_voice(ref.data(), src.data(), channels, level, s_frames);
+				audio_mix_s16_voice(dst.data(), src.data(), channels, level, s_frames);
+
+				if (!equal(dst, ref))
+				{
+					LOG_ERROR(GENERAL, "[UT audio_mixer] audio_mix_s16_voice(channels=%d, level=%f) differs", channels, level);
+					failed++;
+					break;
+				}
+			}
+		}
+
+		return failed;
+	}
+
+	static u32 test_store_be(test_data& data)
+	{
+		// also odd counts for the scalar tail
+		for (u32 count : { s_frames * 8, 1u, 3u, 5u, 13u })
+		{
+			std::vector<float> src(count);
+			data.fill(src);
+
+			std::vector<be_t<float>> dst(count), ref(count);
+			ref_store_be(ref.data(), src.data(), count);
+			audio_store_be(dst.data(), src.data(), count);
+
+			if (memcmp(dst.data(), ref.data(), count * sizeof(float)) != 0)
+			{
+				LOG_ERROR(GENERAL, "[UT audio_mixer] audio_store_be(count=%d) differs", count);
+				return 1;
+			}
+		}
+
+		return 0;
+	}
+
+	// mixed frames per second of func (which mixes s_frames frames)
+	template<typename F> static double frames_per_second(F func)
+	{
+		const auto start = std::chrono::high_resolution_clock::now();
+
+		for (u32 i = 0; i < s_bench_blocks; i++)
+		{
+			func();
+		}
+
+		return s_bench_blocks * s_frames / std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	static void benchmark()
+	{
+		test_data data;
+		std::vector<be_t<float>> src(s_frames * 8);
+		std::vector<s16> src16(s_frames * 2);
+		std::vector<float> buf2ch(s_frames * 2), buf8ch(s_frames * 8);
+		std::vector<be_t<float>> out(s_frames * 8);
+
+		// ordinary samples, denormals would measure something else
+		for (auto& v : src) v = data.normal();
+		for (auto& v : src16) v = data.s16_sample();
+
+		for (u32 channels : { 2, 6, 8 })
+		{
+			const double ref = frames_per_second([&]() { ref_mix_port(buf2ch.data(), buf8ch.data(), src.data(), channels, 0.5f, s_frames, false); });
+			const double sse = frames_per_second([&]() { audio_mix_port(buf2ch.data(), buf8ch.data(), src.data(), channels, 0.5f, s_frames, false); });
+			LOG_NOTICE(GENERAL, "audio_mix_port(%dch): %.1f M frames/s (scalar: %.1f M frames/s)", channels, sse / 1000000, ref / 1000000);
+		}
+
+		for (u32 channels : { 1, 2, 6, 8 })
+		{
+			const double ref = frames_per_second([&]() { ref_upmix_be(buf8ch.data(), src.data(), channels, s_frames); });
+			const double sse = frames_per_second([&]() { audio_upmix_be(buf8ch.data(), src.data(), channels, s_frames); });
+			LOG_NOTICE(GENERAL, "audio_upmix_be(%dch): %.1f M frames/s (scalar: %.1f M frames/s)", channels, sse / 1000000, ref / 1000000);
+
+			// keep the accumulated values small
+			memset(buf8ch.data(), 0, buf8ch.size() * sizeof(float));
+		}
+
+		for (u32 channels : { 1, 2 })
+		{
+			const double ref = frames_per_second([&]() { ref_mix_s16_voice(buf8ch.data(), src16.data(), channels, 0.5f, s_frames); });
+			const double sse = frames_per_second([&]() { audio_mix_s16_voice(buf8ch.data(), src16.data(), channels, 0.5f, s_frames); });
+			LOG_NOTICE(GENERAL, "audio_mix_s16_voice(%dch): %.1f M frames/s (scalar: %.1f M frames/s)", channels, sse / 1000000, ref / 1000000);
+		}
+
+		{
+			const double ref = frames_per_second([&]() { ref_store_be(out.data(), buf8ch.data(), s_frames * 8); });
+			const double sse = frames_per_second([&]() { audio_store_be(out.data(), buf8ch.data(), s_frames * 8); });
+			LOG_NOTICE(GENERAL, "audio_store_be(8ch): %.1f M frames/s (scalar: %.1f M frames/s)", sse / 1000000, ref / 1000000);
+		}
+	}
+
+	void RunAllTests()
+	{
+		LOG_NOTICE(GENERAL, "Running audio mixer tests");
+
+		test_data data;
+		u32 num_failed = 0;
+
+		num_failed += test_mix_port(data);
+		num_failed += test_upmix_be(data);
+		num_failed += test_mix_s16_voice(data);
+		num_failed += test_store_be(data);
+
+		benchmark();
+
+		LOG_NOTICE(GENERAL, "Unit Tests done (%d failed)", num_failed);
+	}
+}
+
+#else
+
+namespace audio_mixer
+{
+	void RunAllTests()
+	{
+	}
+}
+
+#endif // AUDIO_MIXER_UNIT_TESTS
@@ -5,6 +5,7 @@
 #include "Emu/Memory/Memory.h"
 #include "Emu/System.h"
 #include "Emu/DbgCommand.h"
+#include "Emu/PerfCounters.h"
 
 #include "CPUDecoder.h"
 #include "CPUThread.h"
@@ -29,6 +30,7 @@ CPUThread::CPUThread(CPUThreadType type)
 	, m_status(Stopped)
 	, m_last_syscall(0)
 	, m_trace_enabled(false)
+	, m_prof_state(0)
 {
 }
 
@@ -314,6 +316,13 @@ void CPUThread::Task()
 
 	std::vector<u32> trace;
 
+	// executed steps are added to the thread counters in batches
+	u64 steps = 0;
+
+	// the state of the caller is restored for the nested calls (callbacks of HLE functions)
+	const u64 prof_state = m_prof_state.load(std::memory_order_relaxed);
+	SetProfState(CPU_EXEC_INTERPRETER, 0);
+
 #ifdef _WIN32
 	auto old_se_translator = _set_se_translator(_se_translator);
 #else
@@ -341,6 +350,12 @@ void CPUThread::Task()
 			//if (m_trace_enabled) trace.push_back(PC);
 			NextPc(m_dec->DecodeMemory(PC + m_offset));
 
+			if (++steps == 0x1000)
+			{
+				perf::add(perf::CPU_STEPS, steps);
+				steps = 0;
+			}
+
 			if (status == CPUThread_Step)
 			{
 				m_is_step = false;
@@ -374,6 +389,9 @@ void CPUThread::Task()
 	// TODO: linux version
 #endif
 
+	perf::add(perf::CPU_STEPS, steps);
+	m_prof_state.store(prof_state, std::memory_order_relaxed);
+
 	if (trace.size())
 	{
 		LOG_NOTICE(GENERAL, "Trace begin (%d elements)", trace.size());
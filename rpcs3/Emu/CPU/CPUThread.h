@@ -10,6 +10,18 @@ enum CPUThreadType :unsigned char
 	CPU_THREAD_ARMv7,
 };
 
+// what a thread executes, sampled by the profiler (Emu/Profiler.h)
+enum CPUExecMode : u32
+{
+	CPU_EXEC_INTERPRETER, // at the PC
+	CPU_EXEC_RECOMPILED,  // the compiled block at the address
+	CPU_EXEC_HLE,         // the HLE function with the id
+	CPU_EXEC_SYSCALL,     // the lv2 syscall with the number
+	CPU_EXEC_NATIVE,      // host code that isn't called by the guest (custom thread tasks)
+
+	CPU_EXEC_MODE_COUNT
+};
+
 enum CPUThreadStatus
 {
 	CPUThread_Ready,
@@ -126,6 +138,15 @@ public:
 	u64 m_interrupt_arg;
 	u64 m_last_syscall;
 
+	// the execution mode in the high word and the address or the function id in the low word (the address isn't set
+	// in the interpreter mode, the PC is used), only written by the thread itself
+	std::atomic<u64> m_prof_state;
+
+	void SetProfState(CPUExecMode mode, u32 value)
+	{
+		m_prof_state.store((u64)mode << 32 | value, std::memory_order_relaxed);
+	}
+
 protected:
 	CPUThread(CPUThreadType type);
 
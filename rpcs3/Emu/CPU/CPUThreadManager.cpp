@@ -127,7 +127,7 @@ RawSPUThread* CPUThreadManager::GetRawSPUThread(u32 num)
 {
 	if (num < sizeof(Memory.RawSPUMem) / sizeof(Memory.RawSPUMem[0]))
 	{
-		return (RawSPUThread*)Memory.RawSPUMem[num];
+		return (RawSPUThread*)Memory.RawSPUMem[num].block.load();
 	}
 	else
 	{
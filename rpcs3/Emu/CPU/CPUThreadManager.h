@@ -19,6 +19,15 @@ public:
 	void RemoveThread(const u32 id);
 
 	std::vector<CPUThread*>& GetThreads() { return m_threads; }
+
+	// the threads can't be removed while func is called
+	template<typename T> void ForEachThread(T func)
+	{
+		std::lock_guard<std::mutex> lock(m_mtx_thread);
+
+		for (auto thr : m_threads) func(*thr);
+	}
+
 	s32 GetThreadNumById(CPUThreadType type, u32 id);
 	CPUThread* GetThread(u32 id);
 	RawSPUThread* GetRawSPUThread(u32 num);
@@ -8,6 +8,7 @@
 #include "Emu/SysCalls/Modules.h"
 #include "Emu/Memory/Memory.h"
 #include "Emu/SysCalls/lv2/sys_time.h"
+#include "Emu/Cell/VectorOps.h"
 
 #include <stdint.h>
 #ifdef _MSC_VER
@@ -118,6 +119,13 @@ private:
 		return v;
 	}
 
+	// CR6 of the vector compare instructions with Rc = 1: all elements true (0x8) or none (0x2)
+	void UpdateCR6(const __m128i mask)
+	{
+		const int bits = _mm_movemask_epi8(mask);
+		CPU.CR.cr6 = (bits == 0xffff ? 0x8 : 0) | (bits == 0 ? 0x2 : 0);
+	}
+
 	bool CheckCondition(u32 bo, u32 bi)
 	{
 		const u8 bo0 = (bo & 0x10) ? 1 : 0;
@@ -189,215 +197,99 @@ private:
 	}
 	void VADDCUW(u32 vd, u32 va, u32 vb) //nf
 	{
-		for (uint w = 0; w < 4; w++)
-		{
-			CPU.VPR[vd]._u32[w] = ~CPU.VPR[va]._u32[w] < CPU.VPR[vb]._u32[w];
-		}
+		CPU.VPR[vd].vi = simd::carry_u32(CPU.VPR[va].vi, CPU.VPR[vb].vi);
 	}
 	void VADDFP(u32 vd, u32 va, u32 vb)
 	{
-		for (uint w = 0; w < 4; w++)
-		{
-			CPU.VPR[vd]._f[w] = CPU.VPR[va]._f[w] + CPU.VPR[vb]._f[w];
-		}
+		CPU.VPR[vd].vf = _mm_add_ps(CPU.VPR[va].vf, CPU.VPR[vb].vf);
 	}
 	void VADDSBS(u32 vd, u32 va, u32 vb) //nf
 	{
-		for(u32 b=0; b<16; ++b)
-		{
-			s16 result = (s16)CPU.VPR[va]._s8[b] + (s16)CPU.VPR[vb]._s8[b];
-
-			if (result > 0x7f)
-			{
-				CPU.VPR[vd]._s8[b] = 0x7f;
-				CPU.VSCR.SAT = 1;
-			}
-			else if (result < -0x80)
-			{
-				CPU.VPR[vd]._s8[b] = -0x80;
-				CPU.VSCR.SAT = 1;
-			}
-			else
-				CPU.VPR[vd]._s8[b] = (s8)result;
-		}
+		bool sat = false;
+		CPU.VPR[vd].vi = simd::adds_s8(CPU.VPR[va].vi, CPU.VPR[vb].vi, sat);
+		if (sat) CPU.VSCR.SAT = 1;
 	}
 	void VADDSHS(u32 vd, u32 va, u32 vb)
 	{
-		for (uint h = 0; h < 8; h++)
-		{
-			s32 result = (s32)CPU.VPR[va]._s16[h] + (s32)CPU.VPR[vb]._s16[h];
-
-			if (result > 0x7fff)
-			{
-				CPU.VPR[vd]._s16[h] = 0x7fff;
-				CPU.VSCR.SAT = 1;
-			}
-			else if (result < -0x8000)
-			{
-				CPU.VPR[vd]._s16[h] = -0x8000;
-				CPU.VSCR.SAT = 1;
-			}
-			else
-				CPU.VPR[vd]._s16[h] = result;
-		}
+		bool sat = false;
+		CPU.VPR[vd].vi = simd::adds_s16(CPU.VPR[va].vi, CPU.VPR[vb].vi, sat);
+		if (sat) CPU.VSCR.SAT = 1;
 	}
 	void VADDSWS(u32 vd, u32 va, u32 vb) //nf
 	{
-		for (uint w = 0; w < 4; w++)
-		{
-			s64 result = (s64)CPU.VPR[va]._s32[w] + (s64)CPU.VPR[vb]._s32[w];
-
-			if (result > 0x7fffffff)
-			{
-				CPU.VPR[vd]._s32[w] = 0x7fffffff;
-				CPU.VSCR.SAT = 1;
-			}
-			else if (result < (s32)0x80000000)
-			{
-				CPU.VPR[vd]._s32[w] = 0x80000000;
-				CPU.VSCR.SAT = 1;
-			}
-			else
-				CPU.VPR[vd]._s32[w] = (s32)result;
-		}
+		bool sat = false;
+		CPU.VPR[vd].vi = simd::adds_s32(CPU.VPR[va].vi, CPU.VPR[vb].vi, sat);
+		if (sat) CPU.VSCR.SAT = 1;
 	}
 	void VADDUBM(u32 vd, u32 va, u32 vb)
 	{
-		for (uint b = 0; b < 16; b++)
-		{
-			CPU.VPR[vd]._u8[b] = CPU.VPR[va]._u8[b] + CPU.VPR[vb]._u8[b];
-		}
+		CPU.VPR[vd].vi = _mm_add_epi8(CPU.VPR[va].vi, CPU.VPR[vb].vi);
 	}
 	void VADDUBS(u32 vd, u32 va, u32 vb)
 	{
-		for (uint b = 0; b < 16; b++)
-		{
-			u16 result = (u16)CPU.VPR[va]._u8[b] + (u16)CPU.VPR[vb]._u8[b];
-
-			if (result > 0xff)
-			{
-				CPU.VPR[vd]._u8[b] = 0xff;
-				CPU.VSCR.SAT = 1;
-			}
-			else
-				CPU.VPR[vd]._u8[b] = (u8)result;
-		}
+		bool sat = false;
+		CPU.VPR[vd].vi = simd::adds_u8(CPU.VPR[va].vi, CPU.VPR[vb].vi, sat);
+		if (sat) CPU.VSCR.SAT = 1;
 	}
 	void VADDUHM(u32 vd, u32 va, u32 vb)
 	{
-		for (uint h = 0; h < 8; h++)
-		{
-			CPU.VPR[vd]._u16[h] = CPU.VPR[va]._u16[h] + CPU.VPR[vb]._u16[h];
-		}
+		CPU.VPR[vd].vi = _mm_add_epi16(CPU.VPR[va].vi, CPU.VPR[vb].vi);
 	}
 	void VADDUHS(u32 vd, u32 va, u32 vb)
 	{
-		for (uint h = 0; h < 8; h++)
-		{
-			u32 result = (u32)CPU.VPR[va]._u16[h] + (u32)CPU.VPR[vb]._u16[h];
-
-			if (result > 0xffff)
-			{
-				CPU.VPR[vd]._u16[h] = 0xffff;
-				CPU.VSCR.SAT = 1;
-			}
-			else
-				CPU.VPR[vd]._u16[h] = result;
-		}
+		bool sat = false;
+		CPU.VPR[vd].vi = simd::adds_u16(CPU.VPR[va].vi, CPU.VPR[vb].vi, sat);
+		if (sat) CPU.VSCR.SAT = 1;
 	}
 	void VADDUWM(u32 vd, u32 va, u32 vb)
 	{
-		for (uint w = 0; w < 4; w++)
-		{
-			CPU.VPR[vd]._u32[w] = CPU.VPR[va]._u32[w] + CPU.VPR[vb]._u32[w];
-		}
+		CPU.VPR[vd].vi = _mm_add_epi32(CPU.VPR[va].vi, CPU.VPR[vb].vi);
 	}
 	void VADDUWS(u32 vd, u32 va, u32 vb)
 	{
-		for (uint w = 0; w < 4; w++)
-		{
-			u64 result = (u64)CPU.VPR[va]._u32[w] + (u64)CPU.VPR[vb]._u32[w];
-
-			if (result > 0xffffffff)
-			{
-				CPU.VPR[vd]._u32[w] = 0xffffffff;
-				CPU.VSCR.SAT = 1;
-			}
-			else
-				CPU.VPR[vd]._u32[w] = (u32)result;
-		}
+		bool sat = false;
+		CPU.VPR[vd].vi = simd::adds_u32(CPU.VPR[va].vi, CPU.VPR[vb].vi, sat);
+		if (sat) CPU.VSCR.SAT = 1;
 	}
 	void VAND(u32 vd, u32 va, u32 vb)
 	{
-		for (uint w = 0; w < 4; w++)
-		{
-			CPU.VPR[vd]._u32[w] = CPU.VPR[va]._u32[w] & CPU.VPR[vb]._u32[w];
-		}
+		CPU.VPR[vd].vi = _mm_and_si128(CPU.VPR[va].vi, CPU.VPR[vb].vi);
 	}
 	void VANDC(u32 vd, u32 va, u32 vb)
 	{
-		for (uint w = 0; w < 4; w++)
-		{
-			CPU.VPR[vd]._u32[w] = CPU.VPR[va]._u32[w] & (~CPU.VPR[vb]._u32[w]);
-		}
+		CPU.VPR[vd].vi = _mm_andnot_si128(CPU.VPR[vb].vi, CPU.VPR[va].vi);
 	}
 	void VAVGSB(u32 vd, u32 va, u32 vb) //nf
 	{
-		for (uint b = 0; b < 16; b++)
-		{
-			CPU.VPR[vd]._s8[b] = (CPU.VPR[va]._s8[b] + CPU.VPR[vb]._s8[b] + 1) >> 1;
-		}
+		CPU.VPR[vd].vi = simd::avg_s8(CPU.VPR[va].vi, CPU.VPR[vb].vi);
 	}
 	void VAVGSH(u32 vd, u32 va, u32 vb) //nf
 	{
-		for (uint h = 0; h < 8; h++)
-		{
-			CPU.VPR[vd]._s16[h] = (CPU.VPR[va]._s16[h] + CPU.VPR[vb]._s16[h] + 1) >> 1;
-		}
+		CPU.VPR[vd].vi = simd::avg_s16(CPU.VPR[va].vi, CPU.VPR[vb].vi);
 	}
 	void VAVGSW(u32 vd, u32 va, u32 vb) //nf
 	{
-		for (uint w = 0; w < 4; w++)
-		{
-			CPU.VPR[vd]._s32[w] = ((s64)CPU.VPR[va]._s32[w] + (s64)CPU.VPR[vb]._s32[w] + 1) >> 1;
-		}
+		CPU.VPR[vd].vi = simd::avg_s32(CPU.VPR[va].vi, CPU.VPR[vb].vi);
 	}
 	void VAVGUB(u32 vd, u32 va, u32 vb)
 	{
-		for (uint b = 0; b < 16; b++)
-			CPU.VPR[vd]._u8[b] = (CPU.VPR[va]._u8[b] + CPU.VPR[vb]._u8[b] + 1) >> 1;
+		CPU.VPR[vd].vi = _mm_avg_epu8(CPU.VPR[va].vi, CPU.VPR[vb].vi);
 	}
 	void VAVGUH(u32 vd, u32 va, u32 vb) //nf
 	{
-		for (uint h = 0; h < 8; h++)
-		{
-			CPU.VPR[vd]._u16[h] = (CPU.VPR[va]._u16[h] + CPU.VPR[vb]._u16[h] + 1) >> 1;
-		}
+		CPU.VPR[vd].vi = _mm_avg_epu16(CPU.VPR[va].vi, CPU.VPR[vb].vi);
 	}
 	void VAVGUW(u32 vd, u32 va, u32 vb) //nf
 	{
-		for (uint w = 0; w < 4; w++)
-		{
-			CPU.VPR[vd]._u32[w] = ((u64)CPU.VPR[va]._u32[w] + (u64)CPU.VPR[vb]._u32[w] + 1) >> 1;
-		}
+		CPU.VPR[vd].vi = simd::avg_u32(CPU.VPR[va].vi, CPU.VPR[vb].vi);
 	}
 	void VCFSX(u32 vd, u32 uimm5, u32 vb)
 	{
-		u32 scale = 1 << uimm5;
-			
-		for (uint w = 0; w < 4; w++)
-		{
-			CPU.VPR[vd]._f[w] = ((float)CPU.VPR[vb]._s32[w]) / scale;
-		}
+		CPU.VPR[vd].vf = _mm_div_ps(_mm_cvtepi32_ps(CPU.VPR[vb].vi), _mm_set1_ps((float)(1u << uimm5)));
 	}
 	void VCFUX(u32 vd, u32 uimm5, u32 vb)
 	{
-		u32 scale = 1 << uimm5;
-			
-		for (uint w = 0; w < 4; w++)
-		{
-			CPU.VPR[vd]._f[w] = ((float)CPU.VPR[vb]._u32[w]) / scale;
-		}
+		CPU.VPR[vd].vf = _mm_div_ps(simd::cvt_u32_f(CPU.VPR[vb].vi), _mm_set1_ps((float)(1u << uimm5)));
 	}
 	void VCMPBFP(u32 vd, u32 va, u32 vb)
 	{
@@ -440,372 +332,119 @@ private:
 	}
 	void VCMPEQFP(u32 vd, u32 va, u32 vb)
 	{
-		for (uint w = 0; w < 4; w++)
-		{
-			CPU.VPR[vd]._u32[w] = CPU.VPR[va]._f[w] == CPU.VPR[vb]._f[w] ? 0xffffffff : 0;
-		}
+		CPU.VPR[vd].vi = _mm_castps_si128(_mm_cmpeq_ps(CPU.VPR[va].vf, CPU.VPR[vb].vf));
 	}
 	void VCMPEQFP_(u32 vd, u32 va, u32 vb)
 	{
-		int all_equal = 0x8;
-		int none_equal = 0x2;
-
-		for (uint w = 0; w < 4; w++)
-		{
-			if (CPU.VPR[va]._f[w] == CPU.VPR[vb]._f[w])
-			{
-				CPU.VPR[vd]._u32[w] = 0xffffffff;
-				none_equal = 0;
-			}
-			else
-			{
-				CPU.VPR[vd]._u32[w] = 0;
-				all_equal = 0;
-			}
-		}
-
-		CPU.CR.cr6 = all_equal | none_equal;
+		CPU.VPR[vd].vi = _mm_castps_si128(_mm_cmpeq_ps(CPU.VPR[va].vf, CPU.VPR[vb].vf));
+		UpdateCR6(CPU.VPR[vd].vi);
 	}
 	void VCMPEQUB(u32 vd, u32 va, u32 vb)
 	{
-		for (uint b = 0; b < 16; b++)
-		{
-			CPU.VPR[vd]._u8[b] = CPU.VPR[va]._u8[b] == CPU.VPR[vb]._u8[b] ? 0xff : 0;
-		}
+		CPU.VPR[vd].vi = _mm_cmpeq_epi8(CPU.VPR[va].vi, CPU.VPR[vb].vi);
 	}
 	void VCMPEQUB_(u32 vd, u32 va, u32 vb)
 	{
-		int all_equal = 0x8;
-		int none_equal = 0x2;
-			
-		for (uint b = 0; b < 16; b++)
-		{
-			if (CPU.VPR[va]._u8[b] == CPU.VPR[vb]._u8[b])
-			{
-				CPU.VPR[vd]._u8[b] = 0xff;
-				none_equal = 0;
-			}
-			else
-			{
-				CPU.VPR[vd]._u8[b] = 0;
-				all_equal = 0;
-			}
-		}
-
-		CPU.CR.cr6 = all_equal | none_equal;
+		CPU.VPR[vd].vi = _mm_cmpeq_epi8(CPU.VPR[va].vi, CPU.VPR[vb].vi);
+		UpdateCR6(CPU.VPR[vd].vi);
 	}
 	void VCMPEQUH(u32 vd, u32 va, u32 vb) //nf
 	{
-		for (uint h = 0; h < 8; h++)
-		{
-			CPU.VPR[vd]._u16[h] = CPU.VPR[va]._u16[h] == CPU.VPR[vb]._u16[h] ? 0xffff : 0;
-		}
+		CPU.VPR[vd].vi = _mm_cmpeq_epi16(CPU.VPR[va].vi, CPU.VPR[vb].vi);
 	}
 	void VCMPEQUH_(u32 vd, u32 va, u32 vb) //nf
 	{
-		int all_equal = 0x8;
-		int none_equal = 0x2;
-			
-		for (uint h = 0; h < 8; h++)
-		{
-			if (CPU.VPR[va]._u16[h] == CPU.VPR[vb]._u16[h])
-			{
-				CPU.VPR[vd]._u16[h] = 0xffff;
-				none_equal = 0;
-			}
-			else
-			{
-				CPU.VPR[vd]._u16[h] = 0;
-				all_equal = 0;
-			}
-		}
-			
-		CPU.CR.cr6 = all_equal | none_equal;
+		CPU.VPR[vd].vi = _mm_cmpeq_epi16(CPU.VPR[va].vi, CPU.VPR[vb].vi);
+		UpdateCR6(CPU.VPR[vd].vi);
 	}
 	void VCMPEQUW(u32 vd, u32 va, u32 vb)
 	{
-		for (uint w = 0; w < 4; w++)
-		{
-			CPU.VPR[vd]._u32[w] = CPU.VPR[va]._u32[w] == CPU.VPR[vb]._u32[w] ? 0xffffffff : 0;
-		}
+		CPU.VPR[vd].vi = _mm_cmpeq_epi32(CPU.VPR[va].vi, CPU.VPR[vb].vi);
 	}
 	void VCMPEQUW_(u32 vd, u32 va, u32 vb)
 	{
-		int all_equal = 0x8;
-		int none_equal = 0x2;
-			
-		for (uint w = 0; w < 4; w++)
-		{
-			if (CPU.VPR[va]._u32[w] == CPU.VPR[vb]._u32[w])
-			{
-				CPU.VPR[vd]._u32[w] = 0xffffffff;
-				none_equal = 0;
-			}
-			else
-			{
-				CPU.VPR[vd]._u32[w] = 0;
-				all_equal = 0;
-			}
-		}
-
-		CPU.CR.cr6 = all_equal | none_equal;
+		CPU.VPR[vd].vi = _mm_cmpeq_epi32(CPU.VPR[va].vi, CPU.VPR[vb].vi);
+		UpdateCR6(CPU.VPR[vd].vi);
 	}
 	void VCMPGEFP(u32 vd, u32 va, u32 vb)
 	{
-		for (uint w = 0; w < 4; w++)
-		{
-			CPU.VPR[vd]._u32[w] = CPU.VPR[va]._f[w] >= CPU.VPR[vb]._f[w] ? 0xffffffff : 0;
-		}
+		CPU.VPR[vd].vi = _mm_castps_si128(_mm_cmpge_ps(CPU.VPR[va].vf, CPU.VPR[vb].vf));
 	}
 	void VCMPGEFP_(u32 vd, u32 va, u32 vb)
 	{
-		int all_ge = 0x8;
-		int none_ge = 0x2;
-			
-		for (uint w = 0; w < 4; w++)
-		{
-			if (CPU.VPR[va]._f[w] >= CPU.VPR[vb]._f[w])
-			{
-				CPU.VPR[vd]._u32[w] = 0xffffffff;
-				none_ge = 0;
-			}
-			else
-			{
-				CPU.VPR[vd]._u32[w] = 0;
-				all_ge = 0;
-			}
-		}
-
-		CPU.CR.cr6 = all_ge | none_ge;
+		CPU.VPR[vd].vi = _mm_castps_si128(_mm_cmpge_ps(CPU.VPR[va].vf, CPU.VPR[vb].vf));
+		UpdateCR6(CPU.VPR[vd].vi);
 	}
 	void VCMPGTFP(u32 vd, u32 va, u32 vb)
 	{
-		for (uint w = 0; w < 4; w++)
-		{
-			CPU.VPR[vd]._u32[w] = CPU.VPR[va]._f[w] > CPU.VPR[vb]._f[w] ? 0xffffffff : 0;
-		}
+		CPU.VPR[vd].vi = _mm_castps_si128(_mm_cmpgt_ps(CPU.VPR[va].vf, CPU.VPR[vb].vf));
 	}
 	void VCMPGTFP_(u32 vd, u32 va, u32 vb)
 	{
-		int all_ge = 0x8;
-		int none_ge = 0x2;
-			
-		for (uint w = 0; w < 4; w++)
-		{
-			if (CPU.VPR[va]._f[w] > CPU.VPR[vb]._f[w])
-			{
-				CPU.VPR[vd]._u32[w] = 0xffffffff;
-				none_ge = 0;
-			}
-			else
-			{
-				CPU.VPR[vd]._u32[w] = 0;
-				all_ge = 0;
-			}
-		}
-
-		CPU.CR.cr6 = all_ge | none_ge;
+		CPU.VPR[vd].vi = _mm_castps_si128(_mm_cmpgt_ps(CPU.VPR[va].vf, CPU.VPR[vb].vf));
+		UpdateCR6(CPU.VPR[vd].vi);
 	}
 	void VCMPGTSB(u32 vd, u32 va, u32 vb) //nf
 	{
-		for (uint b = 0; b < 16; b++)
-		{
-			CPU.VPR[vd]._u8[b] = CPU.VPR[va]._s8[b] > CPU.VPR[vb]._s8[b] ? 0xff : 0;
-		}
+		CPU.VPR[vd].vi = _mm_cmpgt_epi8(CPU.VPR[va].vi, CPU.VPR[vb].vi);
 	}
 	void VCMPGTSB_(u32 vd, u32 va, u32 vb)
 	{
-		int all_gt = 0x8;
-		int none_gt = 0x2;
-			
-		for (uint b = 0; b < 16; b++)
-		{
-			if (CPU.VPR[va]._s8[b] > CPU.VPR[vb]._s8[b])
-			{
-				CPU.VPR[vd]._u8[b] = 0xff;
-				none_gt = 0;
-			}
-			else
-			{
-				CPU.VPR[vd]._u8[b] = 0;
-				all_gt = 0;
-			}
-		}
-
-		CPU.CR.cr6 = all_gt | none_gt;
+		CPU.VPR[vd].vi = _mm_cmpgt_epi8(CPU.VPR[va].vi, CPU.VPR[vb].vi);
+		UpdateCR6(CPU.VPR[vd].vi);
 	}
 	void VCMPGTSH(u32 vd, u32 va, u32 vb)
 	{
-		for (uint h = 0; h < 8; h++)
-		{
-			CPU.VPR[vd]._u16[h] = CPU.VPR[va]._s16[h] > CPU.VPR[vb]._s16[h] ? 0xffff : 0;
-		}
+		CPU.VPR[vd].vi = _mm_cmpgt_epi16(CPU.VPR[va].vi, CPU.VPR[vb].vi);
 	}
 	void VCMPGTSH_(u32 vd, u32 va, u32 vb)
 	{
-		int all_gt = 0x8;
-		int none_gt = 0x2;
-			
-		for (uint h = 0; h < 8; h++)
-		{
-			if (CPU.VPR[va]._s16[h] > CPU.VPR[vb]._s16[h])
-			{
-				CPU.VPR[vd]._u16[h] = 0xffff;
-				none_gt = 0;
-			}
-			else
-			{
-				CPU.VPR[vd]._u16[h] = 0;
-				all_gt = 0;
-			}
-		}
-
-		CPU.CR.cr6 = all_gt | none_gt;
+		CPU.VPR[vd].vi = _mm_cmpgt_epi16(CPU.VPR[va].vi, CPU.VPR[vb].vi);
+		UpdateCR6(CPU.VPR[vd].vi);
 	}
 	void VCMPGTSW(u32 vd, u32 va, u32 vb)
 	{
-		for (uint w = 0; w < 4; w++)
-		{
-			CPU.VPR[vd]._u32[w] = CPU.VPR[va]._s32[w] > CPU.VPR[vb]._s32[w] ? 0xffffffff : 0;
-		}
+		CPU.VPR[vd].vi = _mm_cmpgt_epi32(CPU.VPR[va].vi, CPU.VPR[vb].vi);
 	}
 	void VCMPGTSW_(u32 vd, u32 va, u32 vb)
 	{
-		int all_gt = 0x8;
-		int none_gt = 0x2;
-			
-		for (uint w = 0; w < 4; w++)
-		{
-			if (CPU.VPR[va]._s32[w] > CPU.VPR[vb]._s32[w])
-			{
-				CPU.VPR[vd]._u32[w] = 0xffffffff;
-				none_gt = 0;
-			}
-			else
-			{
-				CPU.VPR[vd]._u32[w] = 0;
-				all_gt = 0;
-			}
-		}
-
-		CPU.CR.cr6 = all_gt | none_gt;
+		CPU.VPR[vd].vi = _mm_cmpgt_epi32(CPU.VPR[va].vi, CPU.VPR[vb].vi);
+		UpdateCR6(CPU.VPR[vd].vi);
 	}
 	void VCMPGTUB(u32 vd, u32 va, u32 vb)
 	{
-		for (uint b = 0; b < 16; b++)
-		{
-			CPU.VPR[vd]._u8[b] = CPU.VPR[va]._u8[b] > CPU.VPR[vb]._u8[b] ? 0xff : 0;
-		}
+		CPU.VPR[vd].vi = _mm_cmpgt_epu8(CPU.VPR[va].vi, CPU.VPR[vb].vi);
 	}
 	void VCMPGTUB_(u32 vd, u32 va, u32 vb)
 	{
-		int all_gt = 0x8;
-		int none_gt = 0x2;
-
-		for (uint b = 0; b < 16; b++)
-		{
-			if (CPU.VPR[va]._u8[b] > CPU.VPR[vb]._u8[b])
-			{
-				CPU.VPR[vd]._u8[b] = 0xff;
-				none_gt = 0;
-			}
-			else
-			{
-				CPU.VPR[vd]._u8[b] = 0;
-				all_gt = 0;
-			}
-		}
-
-		CPU.CR.cr6 = all_gt | none_gt;
+		CPU.VPR[vd].vi = _mm_cmpgt_epu8(CPU.VPR[va].vi, CPU.VPR[vb].vi);
+		UpdateCR6(CPU.VPR[vd].vi);
 	}
 	void VCMPGTUH(u32 vd, u32 va, u32 vb)
 	{
-		for (uint h = 0; h < 8; h++)
-		{
-			CPU.VPR[vd]._u16[h] = CPU.VPR[va]._u16[h] > CPU.VPR[vb]._u16[h] ? 0xffff : 0;
-		}
+		CPU.VPR[vd].vi = simd::cmpgt_u16(CPU.VPR[va].vi, CPU.VPR[vb].vi);
 	}
 	void VCMPGTUH_(u32 vd, u32 va, u32 vb)
 	{
-		int all_gt = 0x8;
-		int none_gt = 0x2;
-			
-		for (uint h = 0; h < 8; h++)
-		{
-			if (CPU.VPR[va]._u16[h] > CPU.VPR[vb]._u16[h])
-			{
-				CPU.VPR[vd]._u16[h] = 0xffff;
-				none_gt = 0;
-			}
-			else
-			{
-				CPU.VPR[vd]._u16[h] = 0;
-				all_gt = 0;
-			}
-		}
-
-		CPU.CR.cr6 = all_gt | none_gt;
+		CPU.VPR[vd].vi = simd::cmpgt_u16(CPU.VPR[va].vi, CPU.VPR[vb].vi);
+		UpdateCR6(CPU.VPR[vd].vi);
 	}
 	void VCMPGTUW(u32 vd, u32 va, u32 vb)
 	{
-		for (uint w = 0; w < 4; w++)
-		{
-			CPU.VPR[vd]._u32[w] = CPU.VPR[va]._u32[w] > CPU.VPR[vb]._u32[w] ? 0xffffffff : 0;
-		}
+		CPU.VPR[vd].vi = simd::cmpgt_u32(CPU.VPR[va].vi, CPU.VPR[vb].vi);
 	}
 	void VCMPGTUW_(u32 vd, u32 va, u32 vb)
 	{
-		int all_gt = 0x8;
-		int none_gt = 0x2;
-			
-		for (uint w = 0; w < 4; w++)
-		{
-			if (CPU.VPR[va]._u32[w] > CPU.VPR[vb]._u32[w])
-			{
-				CPU.VPR[vd]._u32[w] = 0xffffffff;
-				none_gt = 0;
-			}
-			else
-			{
-				CPU.VPR[vd]._u32[w] = 0;
-				all_gt = 0;
-			}
-		}
-
-		CPU.CR.cr6 = all_gt | none_gt;
+		CPU.VPR[vd].vi = simd::cmpgt_u32(CPU.VPR[va].vi, CPU.VPR[vb].vi);
+		UpdateCR6(CPU.VPR[vd].vi);
 	}
 	void VCTSXS(u32 vd, u32 uimm5, u32 vb)
 	{
-		int nScale = 1 << uimm5;
-			
-		for (uint w = 0; w < 4; w++)
-		{		
-			float result = CPU.VPR[vb]._f[w] * nScale;
-
-			if (result > 0x7fffffff)
-				CPU.VPR[vd]._s32[w] = (int)0x7fffffff;
-			else if (result < -pow(2, 31))
-				CPU.VPR[vd]._s32[w] = (int)0x80000000;
-			else // C rounding = Round towards 0
-				CPU.VPR[vd]._s32[w] = (int)result;
-		}
+		CPU.VPR[vd].vi = simd::cvt_f_s32_sat(CPU.VPR[vb].vf, (float)(s32)(1u << uimm5));
 	}
 	void VCTUXS(u32 vd, u32 uimm5, u32 vb)
 	{
-		int nScale = 1 << uimm5;
-
-		for (uint w = 0; w < 4; w++)
-		{
-			// C rounding = Round towards 0
-			s64 result = (s64)(CPU.VPR[vb]._f[w] * nScale);
-
-			if (result > 0xffffffffu)
-				CPU.VPR[vd]._u32[w] = 0xffffffffu;
-			else if (result < 0)
-				CPU.VPR[vd]._u32[w] = 0;
-			else
-				CPU.VPR[vd]._u32[w] = (u32)result;
-		}
+		CPU.VPR[vd].vi = simd::cvt_f_u32_sat(CPU.VPR[vb].vf, (float)(s32)(1u << uimm5));
 	}
 	void VEXPTEFP(u32 vd, u32 vb)
 	{
@@ -828,55 +467,35 @@ private:
 	}
 	void VMADDFP(u32 vd, u32 va, u32 vc, u32 vb)
 	{
-		for (uint w = 0; w < 4; w++)
-		{
-			CPU.VPR[vd]._f[w] = CPU.VPR[va]._f[w] * CPU.VPR[vc]._f[w] + CPU.VPR[vb]._f[w];
-		}
+		CPU.VPR[vd].vf = _mm_add_ps(_mm_mul_ps(CPU.VPR[va].vf, CPU.VPR[vc].vf), CPU.VPR[vb].vf);
 	}
 	void VMAXFP(u32 vd, u32 va, u32 vb)
 	{
-		for (uint w = 0; w < 4; w++)
-		{
-			CPU.VPR[vd]._f[w] = std::max(CPU.VPR[va]._f[w], CPU.VPR[vb]._f[w]);
-		}
+		CPU.VPR[vd].vf = _mm_max_ps(CPU.VPR[vb].vf, CPU.VPR[va].vf);
 	}
 	void VMAXSB(u32 vd, u32 va, u32 vb) //nf
 	{
-		for (uint b = 0; b < 16; b++)
-			CPU.VPR[vd]._s8[b] = std::max(CPU.VPR[va]._s8[b], CPU.VPR[vb]._s8[b]);
+		CPU.VPR[vd].vi = simd::max_s8(CPU.VPR[va].vi, CPU.VPR[vb].vi);
 	}
 	void VMAXSH(u32 vd, u32 va, u32 vb)
 	{
-		for (uint h = 0; h < 8; h++)
-		{
-			CPU.VPR[vd]._s16[h] = std::max(CPU.VPR[va]._s16[h], CPU.VPR[vb]._s16[h]);
-		}
+		CPU.VPR[vd].vi = _mm_max_epi16(CPU.VPR[va].vi, CPU.VPR[vb].vi);
 	}
 	void VMAXSW(u32 vd, u32 va, u32 vb)
 	{
-		for (uint w = 0; w < 4; w++)
-		{
-			CPU.VPR[vd]._s32[w] = std::max(CPU.VPR[va]._s32[w], CPU.VPR[vb]._s32[w]);
-		}
+		CPU.VPR[vd].vi = simd::max_s32(CPU.VPR[va].vi, CPU.VPR[vb].vi);
 	}
 	void VMAXUB(u32 vd, u32 va, u32 vb)
 	{
-		for (uint b = 0; b < 16; b++)
-			CPU.VPR[vd]._u8[b] = std::max(CPU.VPR[va]._u8[b], CPU.VPR[vb]._u8[b]);
+		CPU.VPR[vd].vi = _mm_max_epu8(CPU.VPR[va].vi, CPU.VPR[vb].vi);
 	}
 	void VMAXUH(u32 vd, u32 va, u32 vb)
 	{
-		for (uint h = 0; h < 8; h++)
-		{
-			CPU.VPR[vd]._u16[h] = std::max(CPU.VPR[va]._u16[h], CPU.VPR[vb]._u16[h]);
-		}
+		CPU.VPR[vd].vi = simd::max_u16(CPU.VPR[va].vi, CPU.VPR[vb].vi);
 	}
 	void VMAXUW(u32 vd, u32 va, u32 vb)
 	{
-		for (uint w = 0; w < 4; w++)
-		{
-			CPU.VPR[vd]._u32[w] = std::max(CPU.VPR[va]._u32[w], CPU.VPR[vb]._u32[w]);
-		}
+		CPU.VPR[vd].vi = simd::max_u32(CPU.VPR[va].vi, CPU.VPR[vb].vi);
 	}
 	void VMHADDSHS(u32 vd, u32 va, u32 vb, u32 vc)
 	{
@@ -920,52 +539,31 @@ private:
 	}
 	void VMINFP(u32 vd, u32 va, u32 vb)
 	{
-		for (uint w = 0; w < 4; w++)
-		{
-			CPU.VPR[vd]._f[w] = std::min(CPU.VPR[va]._f[w], CPU.VPR[vb]._f[w]);
-		}
+		CPU.VPR[vd].vf = _mm_min_ps(CPU.VPR[vb].vf, CPU.VPR[va].vf);
 	}
 	void VMINSB(u32 vd, u32 va, u32 vb) //nf
 	{
-		for (uint b = 0; b < 16; b++)
-		{
-			CPU.VPR[vd]._s8[b] = std::min(CPU.VPR[va]._s8[b], CPU.VPR[vb]._s8[b]);
-		}
+		CPU.VPR[vd].vi = simd::min_s8(CPU.VPR[va].vi, CPU.VPR[vb].vi);
 	}
 	void VMINSH(u32 vd, u32 va, u32 vb)
 	{
-		for (uint h = 0; h < 8; h++)
-		{
-			CPU.VPR[vd]._s16[h] = std::min(CPU.VPR[va]._s16[h], CPU.VPR[vb]._s16[h]);
-		}
+		CPU.VPR[vd].vi = _mm_min_epi16(CPU.VPR[va].vi, CPU.VPR[vb].vi);
 	}
 	void VMINSW(u32 vd, u32 va, u32 vb)
 	{
-		for (uint w = 0; w < 4; w++)
-		{
-			CPU.VPR[vd]._s32[w] = std::min(CPU.VPR[va]._s32[w], CPU.VPR[vb]._s32[w]);
-		}
+		CPU.VPR[vd].vi = simd::min_s32(CPU.VPR[va].vi, CPU.VPR[vb].vi);
 	}
 	void VMINUB(u32 vd, u32 va, u32 vb)
 	{
-		for (uint b = 0; b < 16; b++)
-		{
-			CPU.VPR[vd]._u8[b] = std::min(CPU.VPR[va]._u8[b], CPU.VPR[vb]._u8[b]);
-		}
+		CPU.VPR[vd].vi = _mm_min_epu8(CPU.VPR[va].vi, CPU.VPR[vb].vi);
 	}
 	void VMINUH(u32 vd, u32 va, u32 vb)
 	{
-		for (uint h = 0; h < 8; h++)
-		{
-			CPU.VPR[vd]._u16[h] = std::min(CPU.VPR[va]._u16[h], CPU.VPR[vb]._u16[h]);
-		}
+		CPU.VPR[vd].vi = simd::min_u16(CPU.VPR[va].vi, CPU.VPR[vb].vi);
 	}
 	void VMINUW(u32 vd, u32 va, u32 vb)
 	{
-		for (uint w = 0; w < 4; w++)
-		{
-			CPU.VPR[vd]._u32[w] = std::min(CPU.VPR[va]._u32[w], CPU.VPR[vb]._u32[w]);
-		}
+		CPU.VPR[vd].vi = simd::min_u32(CPU.VPR[va].vi, CPU.VPR[vb].vi);
 	}
 	void VMLADDUHM(u32 vd, u32 va, u32 vb, u32 vc)
 	{
@@ -1145,93 +743,51 @@ private:
 	}
 	void VMULESB(u32 vd, u32 va, u32 vb) //nf
 	{
-		for (uint h = 0; h < 8; h++)
-		{
-			CPU.VPR[vd]._s16[h] = (s16)CPU.VPR[va]._s8[h*2+1] * (s16)CPU.VPR[vb]._s8[h*2+1];
-		}
+		CPU.VPR[vd].vi = simd::mul_hi_s8(CPU.VPR[va].vi, CPU.VPR[vb].vi);
 	}
 	void VMULESH(u32 vd, u32 va, u32 vb)
 	{
-		for (uint w = 0; w < 4; w++)
-		{
-			CPU.VPR[vd]._s32[w] = (s32)CPU.VPR[va]._s16[w*2+1] * (s32)CPU.VPR[vb]._s16[w*2+1];
-		}
+		CPU.VPR[vd].vi = simd::mul_hi_s16(CPU.VPR[va].vi, CPU.VPR[vb].vi);
 	}
 	void VMULEUB(u32 vd, u32 va, u32 vb)
 	{
-		for (uint h = 0; h < 8; h++)
-		{
-			CPU.VPR[vd]._u16[h] = (u16)CPU.VPR[va]._u8[h*2+1] * (u16)CPU.VPR[vb]._u8[h*2+1];
-		}
+		CPU.VPR[vd].vi = simd::mul_hi_u8(CPU.VPR[va].vi, CPU.VPR[vb].vi);
 	}
 	void VMULEUH(u32 vd, u32 va, u32 vb)
 	{
-		for (uint w = 0; w < 4; w++)
-		{
-			CPU.VPR[vd]._u32[w] = (u32)CPU.VPR[va]._u16[w*2+1] * (u32)CPU.VPR[vb]._u16[w*2+1];
-		}
+		CPU.VPR[vd].vi = simd::mul_hi_u16(CPU.VPR[va].vi, CPU.VPR[vb].vi);
 	}
 	void VMULOSB(u32 vd, u32 va, u32 vb) //nf
 	{
-		for (uint h = 0; h < 8; h++)
-		{
-			CPU.VPR[vd]._s16[h] = (s16)CPU.VPR[va]._s8[h*2] * (s16)CPU.VPR[vb]._s8[h*2];
-		}
+		CPU.VPR[vd].vi = simd::mul_lo_s8(CPU.VPR[va].vi, CPU.VPR[vb].vi);
 	}
 	void VMULOSH(u32 vd, u32 va, u32 vb)
 	{
-		for (uint w = 0; w < 4; w++)
-		{
-			CPU.VPR[vd]._s32[w] = (s32)CPU.VPR[va]._s16[w*2] * (s32)CPU.VPR[vb]._s16[w*2];
-		}
+		CPU.VPR[vd].vi = simd::mul_lo_s16(CPU.VPR[va].vi, CPU.VPR[vb].vi);
 	}
 	void VMULOUB(u32 vd, u32 va, u32 vb)
 	{
-		for (uint h = 0; h < 8; h++)
-		{
-			CPU.VPR[vd]._u16[h] = (u16)CPU.VPR[va]._u8[h*2] * (u16)CPU.VPR[vb]._u8[h*2];
-		}
+		CPU.VPR[vd].vi = simd::mul_lo_u8(CPU.VPR[va].vi, CPU.VPR[vb].vi);
 	}
 	void VMULOUH(u32 vd, u32 va, u32 vb)
 	{
-		for (uint w = 0; w < 4; w++)
-		{
-			CPU.VPR[vd]._u32[w] = (u32)CPU.VPR[va]._u16[w*2] * (u32)CPU.VPR[vb]._u16[w*2];
-		}
+		CPU.VPR[vd].vi = simd::mul_lo_u16(CPU.VPR[va].vi, CPU.VPR[vb].vi);
 	}
 	void VNMSUBFP(u32 vd, u32 va, u32 vc, u32 vb)
 	{
-		for (uint w = 0; w < 4; w++)
-		{
-			CPU.VPR[vd]._f[w] = -(CPU.VPR[va]._f[w] * CPU.VPR[vc]._f[w] - CPU.VPR[vb]._f[w]);
-		}
+		CPU.VPR[vd].vf = _mm_xor_ps(_mm_sub_ps(_mm_mul_ps(CPU.VPR[va].vf, CPU.VPR[vc].vf), CPU.VPR[vb].vf), _mm_set1_ps(-0.0f));
 	}
 	void VNOR(u32 vd, u32 va, u32 vb)
 	{
-		for (uint w = 0; w < 4; w++)
-		{
-			CPU.VPR[vd]._u32[w] = ~(CPU.VPR[va]._u32[w] | CPU.VPR[vb]._u32[w]);
-		}
+		CPU.VPR[vd].vi = _mm_xor_si128(_mm_or_si128(CPU.VPR[va].vi, CPU.VPR[vb].vi), _mm_set1_epi32(-1));
 	}
 	void VOR(u32 vd, u32 va, u32 vb)
 	{
-		for (uint w = 0; w < 4; w++)
-		{
-			CPU.VPR[vd]._u32[w] = CPU.VPR[va]._u32[w] | CPU.VPR[vb]._u32[w];
-		}
+		CPU.VPR[vd].vi = _mm_or_si128(CPU.VPR[va].vi, CPU.VPR[vb].vi);
 	}
 	void VPERM(u32 vd, u32 va, u32 vb, u32 vc)
 	{
-		u8 tmpSRC[32];
-		memcpy(tmpSRC, CPU.VPR[vb]._u8, 16);
-		memcpy(tmpSRC + 16, CPU.VPR[va]._u8, 16);
-
-		for (uint b = 0; b < 16; b++)
-		{
-			u8 index = CPU.VPR[vc]._u8[b] & 0x1f;
-				
-			CPU.VPR[vd]._u8[b] = tmpSRC[0x1f - index];
-		}
+		CPU.VPR[vd].vi = simd::vperm(CPU.VPR[va].vi, CPU.VPR[vb].vi, CPU.VPR[vc].vi);
 	}
 	void VPKPX(u32 vd, u32 va, u32 vb)
 	{
@@ -1252,143 +808,27 @@ private:
 	}
 	void VPKSHSS(u32 vd, u32 va, u32 vb) //nf
 	{
-		for (uint b = 0; b < 8; b++)
-		{
-			s16 result = CPU.VPR[va]._s16[b];
-
-			if (result > INT8_MAX)
-			{
-				result = INT8_MAX;
-				CPU.VSCR.SAT = 1;
-			}
-			else if (result < INT8_MIN)
-			{
-				result = INT8_MIN;
-				CPU.VSCR.SAT = 1;
-			}
-				
-			CPU.VPR[vd]._s8[b+8] = (s8)result;
-
-			result = CPU.VPR[vb]._s16[b];
-
-			if (result > INT8_MAX)
-			{
-				result = INT8_MAX;
-				CPU.VSCR.SAT = 1;
-			}
-			else if (result < INT8_MIN)
-			{
-				result = INT8_MIN;
-				CPU.VSCR.SAT = 1;
-			}
-
-			CPU.VPR[vd]._s8[b] = (s8)result;
-		}
+		bool sat = false;
+		CPU.VPR[vd].vi = simd::packs_s16(CPU.VPR[vb].vi, CPU.VPR[va].vi, sat);
+		if (sat) CPU.VSCR.SAT = 1;
 	}
 	void VPKSHUS(u32 vd, u32 va, u32 vb)
 	{
-		for (uint b = 0; b < 8; b++)
-		{
-			s16 result = CPU.VPR[va]._s16[b];
-
-			if (result > UINT8_MAX)
-			{
-				result = UINT8_MAX;
-				CPU.VSCR.SAT = 1;
-			}
-			else if (result < 0)
-			{
-				result = 0;
-				CPU.VSCR.SAT = 1;
-			}
-				
-			CPU.VPR[vd]._u8[b+8] = (u8)result;
-
-			result = CPU.VPR[vb]._s16[b];
-
-			if (result > UINT8_MAX)
-			{
-				result = UINT8_MAX;
-				CPU.VSCR.SAT = 1;
-			}
-			else if (result < 0)
-			{
-				result = 0;
-				CPU.VSCR.SAT = 1;
-			}
-				
-			CPU.VPR[vd]._u8[b] = (u8)result;
-		}
+		bool sat = false;
+		CPU.VPR[vd].vi = simd::packus_s16(CPU.VPR[vb].vi, CPU.VPR[va].vi, sat);
+		if (sat) CPU.VSCR.SAT = 1;
 	}
 	void VPKSWSS(u32 vd, u32 va, u32 vb)
 	{
-		for (uint h = 0; h < 4; h++)
-		{
-			s32 result = CPU.VPR[va]._s32[h];
-
-			if (result > INT16_MAX)
-			{
-				result = INT16_MAX;
-				CPU.VSCR.SAT = 1;
-			}
-			else if (result < INT16_MIN)
-			{
-				result = INT16_MIN;
-				CPU.VSCR.SAT = 1;
-			}
-				
-			CPU.VPR[vd]._s16[h+4] = result;
-
-			result = CPU.VPR[vb]._s32[h];
-
-			if (result > INT16_MAX)
-			{
-				result = INT16_MAX;
-				CPU.VSCR.SAT = 1;
-			}
-			else if (result < INT16_MIN)
-			{
-				result = INT16_MIN;
-				CPU.VSCR.SAT = 1;
-			}
-				
-			CPU.VPR[vd]._s16[h] = result;
-		}
+		bool sat = false;
+		CPU.VPR[vd].vi = simd::packs_s32(CPU.VPR[vb].vi, CPU.VPR[va].vi, sat);
+		if (sat) CPU.VSCR.SAT = 1;
 	}
 	void VPKSWUS(u32 vd, u32 va, u32 vb) //nf
 	{
-		for (uint h = 0; h < 4; h++)
-		{
-			s32 result = CPU.VPR[va]._s32[h];
-
-			if (result > UINT16_MAX)
-			{
-				result = UINT16_MAX;
-				CPU.VSCR.SAT = 1;
-			}
-			else if (result < 0)
-			{
-				result = 0;
-				CPU.VSCR.SAT = 1;
-			}
-				
-			CPU.VPR[vd]._u16[h+4] = result;
-
-			result = CPU.VPR[vb]._s32[h];
-
-			if (result > UINT16_MAX)
-			{
-				result = UINT16_MAX;
-				CPU.VSCR.SAT = 1;
-			}
-			else if (result < 0)
-			{
-				result = 0;
-				CPU.VSCR.SAT = 1;
-			}
-				
-			CPU.VPR[vd]._u16[h] = result;
-		}
+		bool sat = false;
+		CPU.VPR[vd].vi = simd::packus_s32(CPU.VPR[vb].vi, CPU.VPR[va].vi, sat);
+		if (sat) CPU.VSCR.SAT = 1;
 	}
 	void VPKUHUM(u32 vd, u32 va, u32 vb) //nf
 	{
@@ -1400,28 +840,9 @@ private:
 	}
 	void VPKUHUS(u32 vd, u32 va, u32 vb)
 	{
-		for (uint b = 0; b < 8; b++)
-		{
-			u16 result = CPU.VPR[va]._u16[b];
-
-			if (result > UINT8_MAX)
-			{
-				result = UINT8_MAX;
-				CPU.VSCR.SAT = 1;
-			}
-				
-			CPU.VPR[vd]._u8[b+8] = (u8)result;
-
-			result = CPU.VPR[vb]._u16[b];
-
-			if (result > UINT8_MAX)
-			{
-				result = UINT8_MAX;
-				CPU.VSCR.SAT = 1;
-			}
-				
-			CPU.VPR[vd]._u8[b] = (u8)result;
-		}
+		bool sat = false;
+		CPU.VPR[vd].vi = simd::packus_u16(CPU.VPR[vb].vi, CPU.VPR[va].vi, sat);
+		if (sat) CPU.VSCR.SAT = 1;
 	}
 	void VPKUWUM(u32 vd, u32 va, u32 vb)
 	{
@@ -1433,28 +854,9 @@ private:
 	}
 	void VPKUWUS(u32 vd, u32 va, u32 vb) //nf
 	{
-		for (uint h = 0; h < 4; h++)
-		{
-			u32 result = CPU.VPR[va]._u32[h];
-
-			if (result > UINT16_MAX)
-			{
-				result = UINT16_MAX;
-				CPU.VSCR.SAT = 1;
-			}
-				
-			CPU.VPR[vd]._u16[h+4] = result;
-
-			result = CPU.VPR[vb]._u32[h];
-
-			if (result > UINT16_MAX)
-			{
-				result = UINT16_MAX;
-				CPU.VSCR.SAT = 1;
-			}
-				
-			CPU.VPR[vd]._u16[h] = result;
-		}
+		bool sat = false;
+		CPU.VPR[vd].vi = simd::packus_u32(CPU.VPR[vb].vi, CPU.VPR[va].vi, sat);
+		if (sat) CPU.VSCR.SAT = 1;
 	}
 	void VREFP(u32 vd, u32 vb)
 	{
@@ -1526,10 +928,7 @@ private:
 	}
 	void VSEL(u32 vd, u32 va, u32 vb, u32 vc)
 	{
-		for (uint b = 0; b < 16; b++)
-		{
-			CPU.VPR[vd]._u8[b] = (CPU.VPR[vb]._u8[b] & CPU.VPR[vc]._u8[b]) | (CPU.VPR[va]._u8[b] & (~CPU.VPR[vc]._u8[b]));
-		}
+		CPU.VPR[vd].vi = simd::sel(CPU.VPR[vc].vi, CPU.VPR[vb].vi, CPU.VPR[va].vi);
 	}
 	void VSL(u32 vd, u32 va, u32 vb) //nf
 	{
@@ -1701,143 +1100,59 @@ private:
 	}
 	void VSUBCUW(u32 vd, u32 va, u32 vb) //nf
 	{
-		for (uint w = 0; w < 4; w++)
-		{
-			CPU.VPR[vd]._u32[w] = CPU.VPR[va]._u32[w] < CPU.VPR[vb]._u32[w] ? 0 : 1;
-		}
+		CPU.VPR[vd].vi = simd::no_borrow_u32(CPU.VPR[va].vi, CPU.VPR[vb].vi);
 	}
 	void VSUBFP(u32 vd, u32 va, u32 vb)
 	{
-		for (uint w = 0; w < 4; w++)
-		{
-			CPU.VPR[vd]._f[w] = CPU.VPR[va]._f[w] - CPU.VPR[vb]._f[w];
-		}
+		CPU.VPR[vd].vf = _mm_sub_ps(CPU.VPR[va].vf, CPU.VPR[vb].vf);
 	}
 	void VSUBSBS(u32 vd, u32 va, u32 vb) //nf
 	{
-		for (uint b = 0; b < 16; b++)
-		{
-			s16 result = (s16)CPU.VPR[va]._s8[b] - (s16)CPU.VPR[vb]._s8[b];
-
-			if (result < INT8_MIN)
-			{
-				CPU.VPR[vd]._s8[b] = INT8_MIN;
-				CPU.VSCR.SAT = 1;
-			}
-			else if (result > INT8_MAX)
-			{
-				CPU.VPR[vd]._s8[b] = INT8_MAX;
-				CPU.VSCR.SAT = 1;
-			}
-			else
-				CPU.VPR[vd]._s8[b] = (s8)result;
-		}
+		bool sat = false;
+		CPU.VPR[vd].vi = simd::subs_s8(CPU.VPR[va].vi, CPU.VPR[vb].vi, sat);
+		if (sat) CPU.VSCR.SAT = 1;
 	}
 	void VSUBSHS(u32 vd, u32 va, u32 vb)
 	{
-		for (uint h = 0; h < 8; h++)
-		{
-			s32 result = (s32)CPU.VPR[va]._s16[h] - (s32)CPU.VPR[vb]._s16[h];
-
-			if (result < INT16_MIN)
-			{
-				CPU.VPR[vd]._s16[h] = (s16)INT16_MIN;
-				CPU.VSCR.SAT = 1;
-			}
-			else if (result > INT16_MAX)
-			{
-				CPU.VPR[vd]._s16[h] = (s16)INT16_MAX;
-				CPU.VSCR.SAT = 1;
-			}
-			else
-				CPU.VPR[vd]._s16[h] = (s16)result;
-		}
+		bool sat = false;
+		CPU.VPR[vd].vi = simd::subs_s16(CPU.VPR[va].vi, CPU.VPR[vb].vi, sat);
+		if (sat) CPU.VSCR.SAT = 1;
 	}
 	void VSUBSWS(u32 vd, u32 va, u32 vb)
 	{
-		for (uint w = 0; w < 4; w++)
-		{
-			s64 result = (s64)CPU.VPR[va]._s32[w] - (s64)CPU.VPR[vb]._s32[w];
-
-			if (result < INT32_MIN)
-			{
-				CPU.VPR[vd]._s32[w] = (s32)INT32_MIN;
-				CPU.VSCR.SAT = 1;
-			}
-			else if (result > INT32_MAX)
-			{
-				CPU.VPR[vd]._s32[w] = (s32)INT32_MAX;
-				CPU.VSCR.SAT = 1;
-			}
-			else
-				CPU.VPR[vd]._s32[w] = (s32)result;
-		}
+		bool sat = false;
+		CPU.VPR[vd].vi = simd::subs_s32(CPU.VPR[va].vi, CPU.VPR[vb].vi, sat);
+		if (sat) CPU.VSCR.SAT = 1;
 	}
 	void VSUBUBM(u32 vd, u32 va, u32 vb)
 	{
-		for (uint b = 0; b < 16; b++)
-		{
-			CPU.VPR[vd]._u8[b] = (u8)((CPU.VPR[va]._u8[b] - CPU.VPR[vb]._u8[b]) & 0xff);
-		}
+		CPU.VPR[vd].vi = _mm_sub_epi8(CPU.VPR[va].vi, CPU.VPR[vb].vi);
 	}
 	void VSUBUBS(u32 vd, u32 va, u32 vb)
 	{
-		for (uint b = 0; b < 16; b++)
-		{
-				s16 result = (s16)CPU.VPR[va]._u8[b] - (s16)CPU.VPR[vb]._u8[b];
-
-				if (result < 0)
-				{
-				CPU.VPR[vd]._u8[b] = 0;
-				CPU.VSCR.SAT = 1;
-				}
-				else
-					CPU.VPR[vd]._u8[b] = (u8)result;
-		}
+		bool sat = false;
+		CPU.VPR[vd].vi = simd::subs_u8(CPU.VPR[va].vi, CPU.VPR[vb].vi, sat);
+		if (sat) CPU.VSCR.SAT = 1;
 	}
 	void VSUBUHM(u32 vd, u32 va, u32 vb)
 	{
-		for (uint h = 0; h < 8; h++)
-		{
-			CPU.VPR[vd]._u16[h] = CPU.VPR[va]._u16[h] - CPU.VPR[vb]._u16[h];
-		}
+		CPU.VPR[vd].vi = _mm_sub_epi16(CPU.VPR[va].vi, CPU.VPR[vb].vi);
 	}
 	void VSUBUHS(u32 vd, u32 va, u32 vb) //nf
 	{
-		for (uint h = 0; h < 8; h++)
-		{
-			s32 result = (s32)CPU.VPR[va]._u16[h] - (s32)CPU.VPR[vb]._u16[h];
-
-			if (result < 0)
-			{
-				CPU.VPR[vd]._u16[h] = 0;
-				CPU.VSCR.SAT = 1;
-			}
-			else
-				CPU.VPR[vd]._u16[h] = (u16)result;
-		}
+		bool sat = false;
+		CPU.VPR[vd].vi = simd::subs_u16(CPU.VPR[va].vi, CPU.VPR[vb].vi, sat);
+		if (sat) CPU.VSCR.SAT = 1;
 	}
 	void VSUBUWM(u32 vd, u32 va, u32 vb)
 	{
-		for (uint w = 0; w < 4; w++)
-		{
-			CPU.VPR[vd]._u32[w] = CPU.VPR[va]._u32[w] - CPU.VPR[vb]._u32[w];
-		}
+		CPU.VPR[vd].vi = _mm_sub_epi32(CPU.VPR[va].vi, CPU.VPR[vb].vi);
 	}
 	void VSUBUWS(u32 vd, u32 va, u32 vb)
 	{
-		for (uint w = 0; w < 4; w++)
-		{
-			s64 result = (s64)CPU.VPR[va]._u32[w] - (s64)CPU.VPR[vb]._u32[w];
-
-			if (result < 0)
-			{
-				CPU.VPR[vd]._u32[w] = 0;
-				CPU.VSCR.SAT = 1;
-			}
-			else
-				CPU.VPR[vd]._u32[w] = (u32)result;
-		}
+		bool sat = false;
+		CPU.VPR[vd].vi = simd::subs_u32(CPU.VPR[va].vi, CPU.VPR[vb].vi, sat);
+		if (sat) CPU.VSCR.SAT = 1;
 	}
 	void VSUMSWS(u32 vd, u32 va, u32 vb)
 	{
@@ -2005,10 +1320,7 @@ private:
 	}
 	void VXOR(u32 vd, u32 va, u32 vb)
 	{
-		CPU.VPR[vd]._u32[0] = CPU.VPR[va]._u32[0] ^ CPU.VPR[vb]._u32[0];
-		CPU.VPR[vd]._u32[1] = CPU.VPR[va]._u32[1] ^ CPU.VPR[vb]._u32[1];
-		CPU.VPR[vd]._u32[2] = CPU.VPR[va]._u32[2] ^ CPU.VPR[vb]._u32[2];
-		CPU.VPR[vd]._u32[3] = CPU.VPR[va]._u32[3] ^ CPU.VPR[vb]._u32[3];
+		CPU.VPR[vd].vi = _mm_xor_si128(CPU.VPR[va].vi, CPU.VPR[vb].vi);
 	}
 	void MULLI(u32 rd, u32 ra, s32 simm16)
 	{
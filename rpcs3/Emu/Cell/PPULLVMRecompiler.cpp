@@ -1,7 +1,9 @@
 #include "stdafx.h"
+#include "rpcs3/Ini.h"
 #include "Utilities/Log.h"
 #include "Emu/Cell/PPULLVMRecompiler.h"
 #include "Emu/Memory/Memory.h"
+#include "Emu/PerfCounters.h"
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/Support/Host.h"
 #include "llvm/Support/ManagedStatic.h"
@@ -20,14 +22,40 @@
 #include "llvm/Transforms/Vectorize.h"
 #include "llvm/MC/MCDisassembler.h"
 
+#ifdef _WIN32
+#include <Windows.h>
+#include <io.h>
+#else
+#include <signal.h>
+#include <ucontext.h>
+#include <unistd.h>
+#endif
+
 using namespace llvm;
 
 u64  PPULLVMRecompiler::s_rotate_mask[64][64];
 bool PPULLVMRecompiler::s_rotate_mask_inited = false;
 
+std::mutex                                               PPULLVMRecompiler::s_fastmem_lock;
+PPULLVMRecompiler::ExecutableRange                       PPULLVMRecompiler::s_executable_ranges[PPULLVMRecompiler::s_max_executable_ranges];
+std::atomic<u32>                                         PPULLVMRecompiler::s_num_executable_ranges(0);
+u32                                                      PPULLVMRecompiler::s_num_used_executable_ranges = 0;
+std::atomic<bool>                                        PPULLVMRecompiler::s_mmio_fault_pending(false);
+
 PPULLVMRecompiler::PPULLVMRecompiler()
     : ThreadBase("PPULLVMRecompiler")
-    , m_revision(0) {
+    , m_revision(0)
+    , m_current_function_mmio_checks(true) {
+#if defined(_WIN32) || defined(__linux__)
+    m_fastmem = Ini.CPUFastmem.GetValue();
+#else
+    m_fastmem = false;
+#endif
+
+    if (m_fastmem) {
+        InstallFaultHandler();
+    }
+
     InitializeNativeTarget();
     InitializeNativeTargetAsmPrinter();
     InitializeNativeTargetDisassembler();
@@ -73,6 +101,17 @@ PPULLVMRecompiler::PPULLVMRecompiler()
 PPULLVMRecompiler::~PPULLVMRecompiler() {
     Stop();
 
+    {
+        std::lock_guard<std::mutex> lock(s_fastmem_lock);
+        for (u32 i = 0; i < s_num_executable_ranges; i++) {
+            auto & range = s_executable_ranges[i];
+            if (range.end && range.recompiler == this) {
+                range.end.store(0, std::memory_order_release);
+                s_num_used_executable_ranges--;
+            }
+        }
+    }
+
     delete m_execution_engine;
     delete m_fpm;
     delete m_ir_builder;
@@ -127,6 +166,8 @@ void PPULLVMRecompiler::Task() {
         auto idling_end = std::chrono::high_resolution_clock::now();
         m_idling_time += std::chrono::duration_cast<std::chrono::nanoseconds>(idling_end - idling_start);
 
+        QueueMMIOSections();
+
         // Update the set of blocks that have been hit with the set of blocks that have been requested for compilation.
         {
             std::lock_guard<std::mutex> lock(m_uncompiled_shared_lock);
@@ -4144,6 +4185,9 @@ void PPULLVMRecompiler::Compile(u32 address) {
     arg_i->setName("ppu_state");
     (++arg_i)->setName("interpreter");
 
+    // With fastmem, MMIO accesses are checked inline only in sections where an access has already faulted
+    m_current_function_mmio_checks = !m_fastmem || IsMMIOSection(address) || !HasFreeExecutableRange();
+
     // Add an entry block that branches to the first instruction
     m_ir_builder->SetInsertPoint(BasicBlock::Create(m_ir_builder->getContext(), "entry", m_current_function));
     m_ir_builder->CreateBr(GetBlockInFunction(address, m_current_function, true));
@@ -4201,8 +4245,13 @@ void PPULLVMRecompiler::Compile(u32 address) {
     executable_info.num_instructions               = m_num_instructions;
     executable_info.unhit_blocks_list              = std::move(m_current_function_unhit_blocks_list);
     executable_info.llvm_function                  = m_current_function;
+    executable_info.mmio_checks                    = m_current_function_mmio_checks;
     m_compiled[std::make_pair(address, ~revision)] = executable_info;
 
+    if (!m_current_function_mmio_checks) {
+        AddExecutableRange(executable_info.executable, executable_info.size, address);
+    }
+
     {
         std::lock_guard<std::mutex> lock(m_compiled_shared_lock);
         m_compiled_shared[std::make_pair(address, ~revision)] = std::make_pair(executable_info.executable, 0);
@@ -4214,6 +4263,7 @@ void PPULLVMRecompiler::Compile(u32 address) {
 
     auto compilation_end  = std::chrono::high_resolution_clock::now();
     m_compilation_time   += std::chrono::duration_cast<std::chrono::nanoseconds>(compilation_end - compilation_start);
+    perf::add(perf::JIT_COMPILE_US, std::chrono::duration_cast<std::chrono::microseconds>(compilation_end - compilation_start).count());
 }
 
 void PPULLVMRecompiler::RemoveUnusedOldVersions() {
@@ -4236,6 +4286,10 @@ void PPULLVMRecompiler::RemoveUnusedOldVersions() {
             if (erase_this_entry) {
                 auto tmp = i;
                 i--;
+                if (!tmp->second.mmio_checks) {
+                    RemoveExecutableRange(tmp->second.executable, tmp->second.size);
+                }
+
                 m_execution_engine->freeMachineCodeForFunction(tmp->second.llvm_function);
                 tmp->second.llvm_function->eraseFromParent();
                 m_compiled.erase(tmp);
@@ -4254,6 +4308,11 @@ void PPULLVMRecompiler::RemoveUnusedOldVersions() {
 bool PPULLVMRecompiler::NeedsCompiling(u32 address) {
     auto i = m_compiled.lower_bound(std::make_pair(address, 0));
     if (i != m_compiled.end() && i->first.first == address) {
+        if (!i->second.mmio_checks && IsMMIOSection(address)) {
+            // An MMIO access has faulted in this section. Recompile it with inline checks.
+            return true;
+        }
+
         if (i->second.num_instructions >= 300) {
             // This section has reached its limit. Don't allow further expansion.
             return false;
@@ -4273,6 +4332,107 @@ bool PPULLVMRecompiler::NeedsCompiling(u32 address) {
     }
 }
 
+bool PPULLVMRecompiler::IsMMIOSection(u32 address) {
+    std::lock_guard<std::mutex> lock(s_fastmem_lock);
+    return m_mmio_sections.find(address) != m_mmio_sections.end();
+}
+
+void PPULLVMRecompiler::AddExecutableRange(Executable executable, size_t size, u32 address) {
+    std::lock_guard<std::mutex> lock(s_fastmem_lock);
+
+    const u32 count = s_num_executable_ranges;
+    u32       i     = 0;
+    while (i < count && s_executable_ranges[i].end) {
+        i++;
+    }
+
+    if (i == s_max_executable_ranges) {
+        // Prevented by HasFreeExecutableRange()
+        assert(0);
+        return;
+    }
+
+    auto & range = s_executable_ranges[i];
+    range.start      = (u64)executable;
+    range.address    = address;
+    range.recompiler = this;
+    range.mmio_fault = false;
+    range.end.store((u64)executable + size, std::memory_order_release);
+
+    if (i == count) {
+        s_num_executable_ranges.store(count + 1, std::memory_order_release);
+    }
+
+    s_num_used_executable_ranges++;
+}
+
+void PPULLVMRecompiler::RemoveExecutableRange(Executable executable, size_t size) {
+    std::lock_guard<std::mutex> lock(s_fastmem_lock);
+
+    for (u32 i = 0; i < s_num_executable_ranges; i++) {
+        auto & range = s_executable_ranges[i];
+        if (range.end == (u64)executable + size && range.start == (u64)executable) {
+            range.end.store(0, std::memory_order_release);
+            s_num_used_executable_ranges--;
+            return;
+        }
+    }
+}
+
+bool PPULLVMRecompiler::HasFreeExecutableRange() {
+    std::lock_guard<std::mutex> lock(s_fastmem_lock);
+    return s_num_used_executable_ranges < s_max_executable_ranges;
+}
+
+PPULLVMRecompiler::ExecutableRange * PPULLVMRecompiler::FindExecutableRange(u64 rip) {
+    const u32 count = s_num_executable_ranges.load(std::memory_order_acquire);
+    for (u32 i = 0; i < count; i++) {
+        auto & range = s_executable_ranges[i];
+        if (rip < range.end.load(std::memory_order_acquire) && rip >= range.start.load(std::memory_order_relaxed)) {
+            return &range;
+        }
+    }
+
+    return nullptr;
+}
+
+void PPULLVMRecompiler::QueueMMIOSections() {
+    if (!s_mmio_fault_pending.exchange(false)) {
+        return;
+    }
+
+    std::vector<u32> sections;
+
+    {
+        std::lock_guard<std::mutex> lock(s_fastmem_lock);
+        for (u32 i = 0; i < s_num_executable_ranges; i++) {
+            auto & range = s_executable_ranges[i];
+            if (!range.end || !range.mmio_fault) {
+                continue;
+            }
+
+            if (range.recompiler != this) {
+                // Left to the owner of the executable
+                s_mmio_fault_pending = true;
+                continue;
+            }
+
+            range.mmio_fault = false;
+            if (range.address && m_mmio_sections.insert(range.address).second) {
+                sections.push_back(range.address);
+            }
+        }
+    }
+
+    for (auto section : sections) {
+        LOG_NOTICE(PPU, "PPULLVMRecompiler: MMIO access in section 0x%x, recompiling it with inline checks", section);
+    }
+
+    // Compiled by the loop of Task()
+    std::lock_guard<std::mutex> lock(m_uncompiled_shared_lock);
+    m_uncompiled_shared.insert(m_uncompiled_shared.end(), sections.begin(), sections.end());
+}
+
 Value * PPULLVMRecompiler::GetPPUState() {
     return m_current_function->arg_begin();
 }
@@ -4735,10 +4895,12 @@ void PPULLVMRecompiler::CreateBranch(llvm::Value * cmp_i1, llvm::Value * target_
 }
 
 Value * PPULLVMRecompiler::ReadMemory(Value * addr_i64, u32 bits, u32 alignment, bool bswap, bool could_be_mmio) {
-    if (bits != 32 || could_be_mmio == false) {
+    if (bits != 32 || could_be_mmio == false || m_current_function_mmio_checks == false) {
+        // An MMIO access made without inline checks faults and is emulated by HandleMemoryFault. It is volatile so that
+        // it is not merged with other accesses or vectorized, which the fault handler couldn't decode.
         auto eaddr_i64    = m_ir_builder->CreateAdd(addr_i64, m_ir_builder->getInt64((u64)vm::get_ptr<u8>(0)));
         auto eaddr_ix_ptr = m_ir_builder->CreateIntToPtr(eaddr_i64, m_ir_builder->getIntNTy(bits)->getPointerTo());
-        auto val_ix       = (Value *)m_ir_builder->CreateLoad(eaddr_ix_ptr, alignment);
+        auto val_ix       = (Value *)m_ir_builder->CreateAlignedLoad(eaddr_ix_ptr, alignment, bits == 32 && could_be_mmio);
         if (bits > 8 && bswap) {
             val_ix = m_ir_builder->CreateCall(Intrinsic::getDeclaration(m_module, Intrinsic::bswap, m_ir_builder->getIntNTy(bits)), val_ix);
         }
@@ -4790,14 +4952,15 @@ Value * PPULLVMRecompiler::ReadMemory(Value * addr_i64, u32 bits, u32 alignment,
 
 void PPULLVMRecompiler::WriteMemory(Value * addr_i64, Value * val_ix, u32 alignment, bool bswap, bool could_be_mmio) {
     addr_i64 = m_ir_builder->CreateAnd(addr_i64, 0xFFFFFFFF);
-    if (val_ix->getType()->getIntegerBitWidth() != 32 || could_be_mmio == false) {
+    if (val_ix->getType()->getIntegerBitWidth() != 32 || could_be_mmio == false || m_current_function_mmio_checks == false) {
         if (val_ix->getType()->getIntegerBitWidth() > 8 && bswap) {
             val_ix = m_ir_builder->CreateCall(Intrinsic::getDeclaration(m_module, Intrinsic::bswap, val_ix->getType()), val_ix);
         }
 
+        // Volatile if it could be an MMIO access, like in ReadMemory
         auto eaddr_i64    = m_ir_builder->CreateAdd(addr_i64, m_ir_builder->getInt64((u64)vm::get_ptr<u8>(0)));
         auto eaddr_ix_ptr = m_ir_builder->CreateIntToPtr(eaddr_i64, val_ix->getType()->getPointerTo());
-        m_ir_builder->CreateAlignedStore(val_ix, eaddr_ix_ptr, alignment);
+        m_ir_builder->CreateAlignedStore(val_ix, eaddr_ix_ptr, alignment, val_ix->getType()->getIntegerBitWidth() == 32 && could_be_mmio);
     } else {
         BasicBlock * next_block = nullptr;
         for (auto i = m_current_function->begin(); i != m_current_function->end(); i++) {
@@ -4902,9 +5065,298 @@ void PPULLVMRecompiler::InitRotateMask() {
     }
 }
 
-u32                 PPULLVMEmulator::s_num_instances    = 0;
-std::mutex          PPULLVMEmulator::s_recompiler_mutex;
-PPULLVMRecompiler * PPULLVMEmulator::s_recompiler       = nullptr;
+/// Operation of an x86-64 instruction accessing memory
+enum X86MemoryOp {
+    X86_LOAD,
+    X86_STORE,
+
+    // Operations reading the memory operand, in the order of their x86 opcodes
+    X86_ADD,
+    X86_OR,
+    X86_ADC,
+    X86_SBB,
+    X86_AND,
+    X86_SUB,
+    X86_XOR,
+    X86_CMP,
+    X86_TEST,
+};
+
+/// A 32 bit memory access made by an x86-64 instruction
+struct X86MemoryAccess {
+    /// Length of the instruction
+    u32 length;
+
+    /// Operation
+    X86MemoryOp op;
+
+    /// Register operand (x86 encoding)
+    u32 reg;
+
+    /// Immediate operand
+    u32 imm;
+
+    /// Set if the other operand is imm instead of reg
+    bool has_imm;
+
+    /// Set if the memory operand is the first operand (cmp m32, r32 / cmp m32, imm)
+    bool mem_first;
+
+    /// Set for MOVBE (the value is byte swapped by the instruction)
+    bool movbe;
+};
+
+/// Decode the instructions LLVM emits for 32 bit loads and stores: MOV r32, m32 / MOV m32, r32 / MOV m32, imm32 / MOVBE.
+/// A volatile load can still be folded into the instruction using the value, so the ALU instructions that read a 32 bit
+/// memory operand without writing it are decoded as well.
+static bool DecodeX86MemoryAccess(const u8 * code, X86MemoryAccess & access) {
+    const u8 * p   = code;
+    u8         rex = 0;
+
+    if ((*p & 0xF0) == 0x40) {
+        rex = *p++;
+    }
+
+    if (rex & 0x08) {
+        // REX.W: 64 bit operand
+        return false;
+    }
+
+    access.movbe     = false;
+    access.has_imm   = false;
+    access.mem_first = false;
+    u32 imm_size     = 0;
+
+    const u8 opcode = *p++;
+    switch (opcode) {
+    case 0x8B: access.op = X86_LOAD; break;
+    case 0x89: access.op = X86_STORE; break;
+    case 0xC7: access.op = X86_STORE; imm_size = 4; break;
+    case 0x03: case 0x0B: case 0x13: case 0x1B: case 0x23: case 0x2B: case 0x33: case 0x3B:
+        // ADD/OR/ADC/SBB/AND/SUB/XOR/CMP r32, m32
+        access.op = (X86MemoryOp)(X86_ADD + (opcode >> 3));
+        break;
+    case 0x39: access.op = X86_CMP; access.mem_first = true; break;
+    case 0x85: access.op = X86_TEST; access.mem_first = true; break;
+    case 0x81: access.op = X86_CMP; access.mem_first = true; imm_size = 4; break;
+    case 0x83: access.op = X86_CMP; access.mem_first = true; imm_size = 1; break;
+    case 0xF7: access.op = X86_TEST; access.mem_first = true; imm_size = 4; break;
+    case 0x0F:
+        if (p[0] != 0x38 || (p[1] != 0xF0 && p[1] != 0xF1)) {
+            return false;
+        }
+
+        access.op    = p[1] == 0xF1 ? X86_STORE : X86_LOAD;
+        access.movbe = true;
+        p += 2;
+        break;
+    default:
+        return false;
+    }
+
+    const u8  modrm = *p++;
+    const u32 mod   = modrm >> 6;
+    const u32 rm    = modrm & 7;
+    if (mod == 3) {
+        return false;
+    }
+
+    access.reg = ((modrm >> 3) & 7) | ((rex & 0x04) << 1);
+
+    // The reg field of the immediate forms selects the operation: MOV /0, CMP /7, TEST /0. The others write the memory operand.
+    if ((opcode == 0xC7 && (modrm >> 3 & 7) != 0) || ((opcode == 0x81 || opcode == 0x83) && (modrm >> 3 & 7) != 7) || (opcode == 0xF7 && (modrm >> 3 & 7) != 0)) {
+        return false;
+    }
+
+    if (rm == 4) {
+        const u8 sib = *p++;
+        if (mod == 0 && (sib & 7) == 5) {
+            p += 4;
+        }
+    } else if (mod == 0 && rm == 5) {
+        // RIP relative
+        p += 4;
+    }
+
+    if (mod == 1) {
+        p += 1;
+    } else if (mod == 2) {
+        p += 4;
+    }
+
+    if (imm_size) {
+        access.has_imm = true;
+        access.imm     = imm_size == 1 ? (u32)(s32)*(s8 *)p : *(u32 *)p;
+        p += imm_size;
+    }
+
+    access.length = (u32)(p - code);
+    return true;
+}
+
+/// Compute the result of an ALU operation and update the arithmetic flags (CF, PF, AF, ZF, SF, OF) like the x86 instruction
+static u32 EmulateX86Alu(X86MemoryOp op, u32 a, u32 b, u32 & eflags) {
+    const u32 carry_in = eflags & 1;
+    u32       result   = 0;
+    bool      cf       = false;
+    bool      of       = false;
+
+    switch (op) {
+    case X86_ADD:
+    case X86_ADC: {
+        const u64 sum = (u64)a + b + (op == X86_ADC ? carry_in : 0);
+        result = (u32)sum;
+        cf     = (sum >> 32) != 0;
+        of     = (((a ^ result) & (b ^ result)) >> 31) != 0;
+        break;
+    }
+    case X86_SUB:
+    case X86_SBB:
+    case X86_CMP: {
+        const u64 sub = (u64)b + (op == X86_SBB ? carry_in : 0);
+        result = (u32)(a - sub);
+        cf     = a < sub;
+        of     = (((a ^ b) & (a ^ result)) >> 31) != 0;
+        break;
+    }
+    case X86_AND:
+    case X86_TEST: result = a & b; break;
+    case X86_OR:   result = a | b; break;
+    case X86_XOR:  result = a ^ b; break;
+    default: break;
+    }
+
+    u32 parity = result & 0xFF;
+    parity ^= parity >> 4;
+    parity ^= parity >> 2;
+    parity ^= parity >> 1;
+
+    eflags &= ~0x8D5;
+    eflags |= cf ? 0x1 : 0;
+    eflags |= (parity & 1) ? 0 : 0x4;
+    eflags |= (a ^ b ^ result) & 0x10;
+    eflags |= result == 0 ? 0x40 : 0;
+    eflags |= (result >> 31) ? 0x80 : 0;
+    eflags |= of ? 0x800 : 0;
+    return result;
+}
+
+#ifdef _WIN32
+static u64 & GetX86Rip(void * context) {
+    return (u64 &)((PCONTEXT)context)->Rip;
+}
+
+static u32 & GetX86Flags(void * context) {
+    return (u32 &)((PCONTEXT)context)->EFlags;
+}
+
+static u64 & GetX86Gpr(void * context, u32 reg) {
+    // Rax, Rcx, Rdx, Rbx, Rsp, Rbp, Rsi, Rdi and R8-R15 are stored in the x86 encoding order
+    return (u64 &)(&((PCONTEXT)context)->Rax)[reg];
+}
+#elif defined(__linux__)
+static u64 & GetX86Rip(void * context) {
+    return (u64 &)((ucontext_t *)context)->uc_mcontext.gregs[REG_RIP];
+}
+
+static u32 & GetX86Flags(void * context) {
+    return (u32 &)((ucontext_t *)context)->uc_mcontext.gregs[REG_EFL];
+}
+
+static u64 & GetX86Gpr(void * context, u32 reg) {
+    static const int gregs[16] = {
+        REG_RAX, REG_RCX, REG_RDX, REG_RBX, REG_RSP, REG_RBP, REG_RSI, REG_RDI,
+        REG_R8,  REG_R9,  REG_R10, REG_R11, REG_R12, REG_R13, REG_R14, REG_R15,
+    };
+
+    return (u64 &)((ucontext_t *)context)->uc_mcontext.gregs[gregs[reg]];
+}
+#endif
+
+/// Report an MMIO access that the fault handler can't emulate. The fault is not handled and ends the process before
+/// the log is written, so the message is written to stderr directly.
+static void ReportUnsupportedMMIOAccess(u32 addr, u64 rip) {
+    char msg[] = "PPULLVMRecompiler: unsupported instruction accessing MMIO (addr=0x00000000, rip=0x0000000000000000)\n";
+
+    char * p = strstr(msg, "addr=0x") + 7;
+    for (u32 i = 0; i < 8; i++) {
+        p[i] = "0123456789abcdef"[(addr >> (28 - i * 4)) & 0xF];
+    }
+
+    p = strstr(msg, "rip=0x") + 6;
+    for (u32 i = 0; i < 16; i++) {
+        p[i] = "0123456789abcdef"[(rip >> (60 - i * 4)) & 0xF];
+    }
+
+#ifdef _WIN32
+    _write(2, msg, sizeof(msg) - 1);
+#else
+    write(2, msg, sizeof(msg) - 1);
+#endif
+}
+
+void PPULLVMRecompiler::InstallFaultHandler() {
+    vm::add_fault_handler(HandleMemoryFault);
+}
+
+bool PPULLVMRecompiler::HandleMemoryFault(u32 addr, void * context) {
+#if defined(_WIN32) || defined(__linux__)
+    if (addr < RAW_SPU_BASE_ADDR || (addr % RAW_SPU_OFFSET) < RAW_SPU_PROB_OFFSET) {
+        return false;
+    }
+
+    // Only accesses made by executables compiled without inline MMIO checks are emulated
+    u64 & rip   = GetX86Rip(context);
+    auto  range = FindExecutableRange(rip);
+    if (!range) {
+        return false;
+    }
+
+    X86MemoryAccess access;
+    if (!DecodeX86MemoryAccess((const u8 *)rip, access)) {
+        ReportUnsupportedMMIOAccess(addr, rip);
+        return false;
+    }
+
+    // A plain MOV transfers the big endian memory contents as is, MOVBE swaps them. The executable holds no locks, so
+    // the MMIO handlers can be called from the signal handler like from the interpreter.
+    if (access.op == X86_STORE) {
+        const u32 value = access.has_imm ? access.imm : (u32)GetX86Gpr(context, access.reg);
+        Memory.WriteMMIO32(addr, access.movbe ? value : re32(value));
+    } else {
+        const u32 value = Memory.ReadMMIO32(addr);
+        const u32 mem   = access.movbe ? value : re32(value);
+
+        if (access.op == X86_LOAD) {
+            GetX86Gpr(context, access.reg) = mem;
+        } else {
+            const u32 other  = access.has_imm ? access.imm : (u32)GetX86Gpr(context, access.reg);
+            const u32 result = access.mem_first ? EmulateX86Alu(access.op, mem, other, GetX86Flags(context))
+                                                : EmulateX86Alu(access.op, other, mem, GetX86Flags(context));
+
+            // CMP and TEST only set the flags, 32 bit results clear the upper half of the register
+            if (access.op != X86_CMP && access.op != X86_TEST) {
+                GetX86Gpr(context, access.reg) = result;
+            }
+        }
+    }
+
+    rip += access.length;
+
+    // The section is recompiled with inline checks by the recompiler thread, so that its following MMIO accesses don't fault
+    if (!range->mmio_fault.exchange(true)) {
+        s_mmio_fault_pending = true;
+    }
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+u32                  PPULLVMEmulator::s_num_instances    = 0;
+std::recursive_mutex PPULLVMEmulator::s_recompiler_mutex;
+PPULLVMRecompiler *  PPULLVMEmulator::s_recompiler       = nullptr;
 
 PPULLVMEmulator::PPULLVMEmulator(PPUThread & ppu)
     : m_ppu(ppu)
@@ -4912,8 +5364,11 @@ PPULLVMEmulator::PPULLVMEmulator(PPUThread & ppu)
     , m_decoder(m_interpreter)
     , m_last_instr_was_branch(true)
     , m_last_cache_clear_time(std::chrono::high_resolution_clock::now())
-    , m_recompiler_revision(0) {
-    std::lock_guard<std::mutex> lock(s_recompiler_mutex);
+    , m_recompiler_revision(0)
+    , m_cache_check_countdown(s_cache_check_interval) {
+    memset(m_lookup_table, 0, sizeof(m_lookup_table));
+
+    std::lock_guard<std::recursive_mutex> lock(s_recompiler_mutex);
 
     s_num_instances++;
     if (!s_recompiler) {
@@ -4927,7 +5382,7 @@ PPULLVMEmulator::~PPULLVMEmulator() {
         s_recompiler->ReleaseExecutable(iter->first, iter->second.revision);
     }
 
-    std::lock_guard<std::mutex> lock(s_recompiler_mutex);
+    std::lock_guard<std::recursive_mutex> lock(s_recompiler_mutex);
 
     s_num_instances--;
     if (s_recompiler && s_num_instances == 0) {
@@ -4936,67 +5391,125 @@ PPULLVMEmulator::~PPULLVMEmulator() {
     }
 }
 
-u8 PPULLVMEmulator::DecodeMemory(const u32 address) {
+void PPULLVMEmulator::AgeCache() {
+    m_cache_check_countdown = s_cache_check_interval;
+
     auto now = std::chrono::high_resolution_clock::now();
+    if (std::chrono::duration_cast<std::chrono::milliseconds>(now - m_last_cache_clear_time).count() <= 1000) {
+        return;
+    }
 
-    if (std::chrono::duration_cast<std::chrono::milliseconds>(now - m_last_cache_clear_time).count() > 1000) {
-        bool clear_all  = false;
+    bool clear_all  = false;
 
-        u32 revision = s_recompiler->GetCurrentRevision();
-        if (m_recompiler_revision != revision) {
-            m_recompiler_revision = revision;
-            clear_all = true;
-        }
+    u32 revision = s_recompiler->GetCurrentRevision();
+    if (m_recompiler_revision != revision) {
+        m_recompiler_revision = revision;
+        clear_all = true;
+    }
 
-        for (auto iter = m_address_to_executable.begin(); iter != m_address_to_executable.end();) {
-            auto tmp = iter;
-            iter++;
-            if (tmp->second.num_hits == 0 || clear_all) {
-                m_address_to_executable.erase(tmp);
-                s_recompiler->ReleaseExecutable(tmp->first, tmp->second.revision);
-            } else {
-                tmp->second.num_hits = 0;
-            }
+    for (auto iter = m_address_to_executable.begin(); iter != m_address_to_executable.end();) {
+        auto tmp = iter;
+        iter++;
+        if (tmp->second.num_hits == 0 || clear_all) {
+            s_recompiler->ReleaseExecutable(tmp->first, tmp->second.revision);
+            m_address_to_executable.erase(tmp);
+        } else {
+            tmp->second.num_hits = 0;
         }
+    }
 
-        m_last_cache_clear_time = now;
+    // The lookup table may point to erased elements
+    memset(m_lookup_table, 0, sizeof(m_lookup_table));
+
+    m_last_cache_clear_time = now;
+}
+
+std::pair<const u32, PPULLVMEmulator::ExecutableInfo> * PPULLVMEmulator::GetExecutable(u32 address, bool query_recompiler) {
+    auto & lookup_table_entry = m_lookup_table[(address >> 2) & (s_lookup_table_size - 1)];
+    if (lookup_table_entry && lookup_table_entry->first == address) {
+        return lookup_table_entry;
     }
 
     auto address_to_executable_iter = m_address_to_executable.find(address);
     if (address_to_executable_iter == m_address_to_executable.end()) {
+        if (!query_recompiler) {
+            return nullptr;
+        }
+
         auto executable_and_revision = s_recompiler->GetExecutable(address);
-        if (executable_and_revision.first) {
-            ExecutableInfo executable_info;
-            executable_info.executable = executable_and_revision.first;
-            executable_info.revision   = executable_and_revision.second;
-            executable_info.num_hits   = 0;
-
-            address_to_executable_iter = m_address_to_executable.insert(m_address_to_executable.end(), std::make_pair(address, executable_info));
-            m_uncompiled.erase(address);
-        } else {
-            if (m_last_instr_was_branch) {
-                auto uncompiled_iter = m_uncompiled.find(address);
-                if (uncompiled_iter != m_uncompiled.end()) {
-                    uncompiled_iter->second++;
-                    if ((uncompiled_iter->second % 1000) == 0) {
-                        s_recompiler->RequestCompilation(address);
-                    }
-                } else {
-                    m_uncompiled[address] = 0;
-                }
-            }
+        if (!executable_and_revision.first) {
+            return nullptr;
         }
+
+        ExecutableInfo executable_info;
+        executable_info.executable = executable_and_revision.first;
+        executable_info.revision   = executable_and_revision.second;
+        executable_info.num_hits   = 0;
+
+        address_to_executable_iter = m_address_to_executable.insert(m_address_to_executable.end(), std::make_pair(address, executable_info));
+        m_uncompiled.erase(address);
     }
 
-    u8 ret = 0;
-    if (address_to_executable_iter != m_address_to_executable.end()) {
-        address_to_executable_iter->second.executable(&m_ppu, m_interpreter);
-        address_to_executable_iter->second.num_hits++;
+    return lookup_table_entry = &(*address_to_executable_iter);
+}
+
+u8 PPULLVMEmulator::DecodeMemory(const u32 address) {
+    if (--m_cache_check_countdown == 0) {
+        AgeCache();
+    }
+
+    auto executable = GetExecutable(address, true);
+    if (executable) {
+        // Run the executable and keep running the executables of the following sections for as long as they have been
+        // compiled, so that loops spanning several sections don't go back to CPUThread::Task. Breakpoints are checked
+        // by CPUThread::Task only, so sections are not chained if there are any.
+        const bool chain = Emu.GetBreakPoints().empty();
+        u32 num_chained  = 0;
+
+        while (true) {
+            m_ppu.SetProfState(CPU_EXEC_RECOMPILED, executable->first);
+            executable->second.executable(&m_ppu, m_interpreter);
+            executable->second.num_hits++;
+
+            // A pending branch set by an interpreter fallback is resolved by CPUThread::NextPc
+            if (!chain || m_ppu.m_is_branch || m_ppu.ThreadStatus() != CPUThread_Running) {
+                break;
+            }
+
+            if (--m_cache_check_countdown == 0) {
+                AgeCache();
+            }
+
+            executable = GetExecutable(m_ppu.PC, false);
+            if (!executable) {
+                break;
+            }
+
+            num_chained++;
+        }
+
+        if (num_chained) {
+            perf::add(perf::CPU_STEPS, num_chained);
+        }
+
+        m_ppu.SetProfState(CPU_EXEC_INTERPRETER, 0);
         m_last_instr_was_branch = true;
-    } else {
-        ret                     = m_decoder.DecodeMemory(address);
-        m_last_instr_was_branch = m_ppu.m_is_branch;
+        return 0;
+    }
+
+    if (m_last_instr_was_branch) {
+        auto uncompiled_iter = m_uncompiled.find(address);
+        if (uncompiled_iter != m_uncompiled.end()) {
+            uncompiled_iter->second++;
+            if ((uncompiled_iter->second % 1000) == 0) {
+                s_recompiler->RequestCompilation(address);
+            }
+        } else {
+            m_uncompiled[address] = 0;
+        }
     }
 
+    u8 ret                  = m_decoder.DecodeMemory(address);
+    m_last_instr_was_branch = m_ppu.m_is_branch;
     return ret;
 }
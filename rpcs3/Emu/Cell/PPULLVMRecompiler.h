@@ -46,6 +46,13 @@ public:
     /// Execute all tests
     void RunAllTests(PPUThread * ppu_state, PPUInterpreter * interpreter);
 
+    /// Emulate a 32 bit MMIO access made by an executable that faulted at the guest address addr. context is the thread
+    /// context of the fault (PCONTEXT on Windows, ucontext_t * elsewhere). Returns false if the fault was not caused by such an access.
+    /// The accesses are emulated like the interpreter does (the MMIO handlers may lock and log), which is safe because the
+    /// executables hold no locks. Other faults are declined before anything is locked. The recompilation of the section
+    /// is left to Task().
+    static bool HandleMemoryFault(u32 addr, void * context);
+
     void Task() override;
 
 protected:
@@ -467,8 +474,58 @@ private:
 
         /// LLVM function corresponding to the executable
         llvm::Function * llvm_function;
+
+        /// Set if MMIO accesses are checked inline. Otherwise they fault and are emulated by HandleMemoryFault.
+        bool mmio_checks;
+    };
+
+    /// Machine code range of an executable. The fault handler reads the ranges without locking, so end is cleared
+    /// before the other fields of an entry are changed and set after them.
+    struct ExecutableRange {
+        /// End of the machine code. 0 if the entry is free.
+        std::atomic<u64> end;
+
+        /// Start of the machine code
+        std::atomic<u64> start;
+
+        /// Starting address of the section (0 for unit tests)
+        std::atomic<u32> address;
+
+        /// Recompiler that owns the executable
+        std::atomic<PPULLVMRecompiler *> recompiler;
+
+        /// Set by the fault handler when an MMIO access of the executable has faulted
+        std::atomic<bool> mmio_fault;
     };
 
+    /// Maximum number of executables compiled without inline MMIO checks. When they are all in use, sections are
+    /// compiled with inline checks.
+    static const u32 s_max_executable_ranges = 16384;
+
+    /// Lock for changing s_executable_ranges and for accessing m_mmio_sections (not used by the fault handler)
+    static std::mutex s_fastmem_lock;
+
+    /// Machine code ranges of the executables compiled without inline MMIO checks
+    static ExecutableRange s_executable_ranges[s_max_executable_ranges];
+
+    /// Number of entries of s_executable_ranges that have been used. Freed entries below it are reused.
+    static std::atomic<u32> s_num_executable_ranges;
+
+    /// Number of entries of s_executable_ranges in use
+    static u32 s_num_used_executable_ranges;
+
+    /// Set by the fault handler when it sets the mmio_fault flag of a range
+    static std::atomic<bool> s_mmio_fault_pending;
+
+    /// Sections in which an MMIO access has faulted. They are recompiled with inline MMIO checks.
+    std::set<u32> m_mmio_sections;
+
+    /// Set if MMIO accesses are left to fault instead of being checked inline (Ini.CPUFastmem)
+    bool m_fastmem;
+
+    /// Set if the function being compiled checks MMIO accesses inline
+    bool m_current_function_mmio_checks;
+
     /// Lock for accessing m_compiled_shared
     // TODO: Use a RW lock
     std::mutex m_compiled_shared_lock;
@@ -560,6 +617,25 @@ private:
     /// Test whether the blocks needs to be compiled
     bool NeedsCompiling(u32 address);
 
+    /// Test whether an MMIO access has faulted in the section starting at address
+    bool IsMMIOSection(u32 address);
+
+    /// Add or remove the machine code range of an executable compiled without inline MMIO checks
+    void AddExecutableRange(Executable executable, size_t size, u32 address);
+    void RemoveExecutableRange(Executable executable, size_t size);
+
+    /// Test whether another executable can be compiled without inline MMIO checks
+    static bool HasFreeExecutableRange();
+
+    /// Find the range of the executable containing the machine code address rip (called by the fault handler)
+    static ExecutableRange * FindExecutableRange(u64 rip);
+
+    /// Queue the sections whose executables have faulted on an MMIO access for recompilation with inline checks
+    void QueueMMIOSections();
+
+    /// Install the memory fault handler used to emulate MMIO accesses
+    static void InstallFaultHandler();
+
     /// Get PPU state pointer
     llvm::Value * GetPPUState();
 
@@ -714,8 +790,8 @@ private:
     template <class PPULLVMRecompilerFn, class PPUInterpreterFn, class... Args>
     void VerifyInstructionAgainstInterpreter(const char * name, PPULLVMRecompilerFn recomp_fn, PPUInterpreterFn interp_fn, PPUState & input_state, Args... args);
 
-    /// Excute a test
-    void RunTest(const char * name, std::function<void()> test_case, std::function<void()> input, std::function<bool(std::string & msg)> check_result);
+    /// Excute a test. If benchmark_runs is not 0, the function is also timed over that many runs after the check.
+    void RunTest(const char * name, std::function<void()> test_case, std::function<void()> input, std::function<bool(std::string & msg)> check_result, u32 benchmark_runs = 0);
 
     /// A mask used in rotate instructions
     static u64 s_rotate_mask[64][64];
@@ -779,14 +855,34 @@ private:
     /// Sections that have not been compiled yet. Key is starting address of the section.
     std::unordered_map<u32, u64> m_uncompiled;
 
+    /// Number of entries in m_lookup_table. Must be a power of 2.
+    static const u32 s_lookup_table_size = 4096;
+
+    /// Number of DecodeMemory calls and chained executions after which the m_address_to_executable cache is aged
+    static const u32 s_cache_check_interval = 0x10000;
+
+    /// Direct mapped table in front of m_address_to_executable. Index is (address >> 2) % s_lookup_table_size.
+    /// Entries point into m_address_to_executable and are cleared whenever elements are erased from it.
+    std::pair<const u32, ExecutableInfo> * m_lookup_table[s_lookup_table_size];
+
+    /// Number of DecodeMemory calls and chained executions left before the cache is aged
+    u32 m_cache_check_countdown;
+
     /// Number of instances of this class
     static u32 s_num_instances;
 
-    /// Mutex used prevent multiple instances of the recompiler from being created
-    static std::mutex s_recompiler_mutex;
+    /// Mutex used prevent multiple instances of the recompiler from being created. It is recursive because the tests,
+    /// which run while it is locked, create an emulator to measure the dispatcher.
+    static std::recursive_mutex s_recompiler_mutex;
 
     /// PPU to LLVM recompiler
     static PPULLVMRecompiler * s_recompiler;
+
+    /// Get the executable for the code starting at address. The recompiler is queried only if query_recompiler is true.
+    std::pair<const u32, ExecutableInfo> * GetExecutable(u32 address, bool query_recompiler);
+
+    /// Release executables that have not been hit since the last check (or all of them if the recompiler revision has changed)
+    void AgeCache();
 };
 
 #endif // LLVM_AVAILABLE
@@ -1,6 +1,9 @@
 #include "stdafx.h"
 #include "Utilities/Log.h"
 #include "Emu/Cell/PPULLVMRecompiler.h"
+#include "Emu/Cell/RawSPUThread.h"
+#include "Emu/System.h"
+#include "Emu/CPU/CPUThreadManager.h"
 #include "llvm/Support/Host.h"
 #include "llvm/IR/Verifier.h"
 #include "llvm/CodeGen/MachineCodeInfo.h"
@@ -232,7 +235,7 @@ void PPULLVMRecompiler::VerifyInstructionAgainstInterpreter(const char * name, P
 #endif // PPU_LLVM_RECOMPILER_UNIT_TESTS
 }
 
-void PPULLVMRecompiler::RunTest(const char * name, std::function<void()> test_case, std::function<void()> input, std::function<bool(std::string & msg)> check_result) {
+void PPULLVMRecompiler::RunTest(const char * name, std::function<void()> test_case, std::function<void()> input, std::function<bool(std::string & msg)> check_result, u32 benchmark_runs) {
 #ifdef PPU_LLVM_RECOMPILER_UNIT_TESTS
     // Create the unit test function
     m_current_function = (Function *)m_module->getOrInsertFunction(name, m_ir_builder->getVoidTy(),
@@ -277,6 +280,11 @@ void PPULLVMRecompiler::RunTest(const char * name, std::function<void()> test_ca
     MachineCodeInfo mci;
     m_execution_engine->runJITOnFunction(m_current_function, &mci);
 
+    // MMIO accesses of a function compiled without inline checks are emulated by the fault handler
+    if (!m_current_function_mmio_checks) {
+        AddExecutableRange((Executable)mci.address(), mci.size(), 0);
+    }
+
     // Disassemble the generated function
     auto disassembler = LLVMCreateDisasm(sys::getProcessTriple().c_str(), nullptr, 0, nullptr, nullptr);
 
@@ -307,6 +315,23 @@ void PPULLVMRecompiler::RunTest(const char * name, std::function<void()> test_ca
         LOG_ERROR(PPU, "[UT %s] Test failed. %s", name, msg.c_str());
     }
 
+    // Called like the executables of the emulator, the state left by the previous run is the input of the next one
+    if (benchmark_runs) {
+        auto       executable = (Executable)mci.address();
+        const auto start      = std::chrono::high_resolution_clock::now();
+
+        for (u32 i = 0; i < benchmark_runs; i++) {
+            executable(s_ppu_state, s_interpreter);
+        }
+
+        const auto time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start);
+        LOG_NOTICE(PPU, "[UT %s] Benchmark: %.1f ns per run (%u runs)", name, (double)time.count() / benchmark_runs, benchmark_runs);
+    }
+
+    if (!m_current_function_mmio_checks) {
+        RemoveExecutableRange((Executable)mci.address(), mci.size());
+    }
+
     m_execution_engine->freeMachineCodeForFunction(m_current_function);
 #endif // PPU_LLVM_RECOMPILER_UNIT_TESTS
 }
@@ -766,6 +791,177 @@ void PPULLVMRecompiler::RunAllTests(PPUThread * ppu_state, PPUInterpreter * inte
     VERIFY_INSTRUCTION_AGAINST_INTERPRETER(DCBZ, 0, input, 0, 23);
     VERIFY_INSTRUCTION_AGAINST_INTERPRETER(DCBZ, 1, input, 14, 23);
 
+    // MMIO accesses, with inline checks and through the fastmem fault handler
+    auto & raw_spu = (RawSPUThread &)Emu.GetCPU().AddThread(CPU_THREAD_RAW_SPU);
+    InstallFaultHandler();
+
+    for (u32 mmio_checks = 0; mmio_checks < 2; mmio_checks++) {
+        m_current_function_mmio_checks = mmio_checks != 0;
+
+        input.GPR[14] = GetRawSPURegAddrByNum(raw_spu.GetIndex(), 0);
+        VERIFY_INSTRUCTION_AGAINST_INTERPRETER(LWZ, 2 + mmio_checks, input, 5, 14, SPU_MBox_Status_offs);
+
+        // Without inline checks, LLVM may fold the load into the compare instruction
+        auto load_compare = [&]() {
+            LWZ(5, 14, SPU_MBox_Status_offs);
+            CMPLI(1, 0, 5, 0x101);
+        };
+        auto load_input = [&]() {
+            input.Store(*s_ppu_state);
+        };
+        auto check_compare = [&](std::string & msg) {
+            const u32 status   = Memory.ReadMMIO32((u32)input.GPR[14] + SPU_MBox_Status_offs);
+            const u32 expected = status < 0x101 ? 8 : status > 0x101 ? 4 : 2;
+            const u32 cr1      = (s_ppu_state->CR.CR >> 24) & 0xE;
+
+            msg = fmt::Format("status = 0x%x, GPR[5] = 0x%llx, CR1 = 0x%x", status, s_ppu_state->GPR[5], cr1);
+            return s_ppu_state->GPR[5] == status && cr1 == expected;
+        };
+        RunTest(fmt::Format("LWZ_CMPLI_MMIO.%d", mmio_checks).c_str(), load_compare, load_input, check_compare);
+
+        auto test_case = [&]() {
+            STW(3, 14, SPU_In_MBox_offs);
+        };
+        auto store_input = [&]() {
+            input.Store(*s_ppu_state);
+        };
+        auto check_result = [&](std::string & msg) {
+            u32 value;
+            if (!raw_spu.SPU.In_MBox.Pop(value)) {
+                msg = "In_MBox is empty";
+                return false;
+            }
+
+            msg = fmt::Format("In_MBox = 0x%x, GPR[3] = 0x%llx", value, input.GPR[3]);
+            return value == (u32)input.GPR[3];
+        };
+        RunTest(fmt::Format("STW_MMIO.%d", mmio_checks).c_str(), test_case, store_input, check_result);
+
+        // Cost of a load from memory and from MMIO, with inline checks and through the fault handler
+        for (u32 mmio = 0; mmio < 2; mmio++) {
+            const u32 addr = mmio ? GetRawSPURegAddrByNum(raw_spu.GetIndex(), SPU_MBox_Status_offs) : 0x10000;
+
+            auto load_case = [&]() {
+                LWZ(5, 14, 0);
+                CMPLI(1, 0, 5, 0x101);
+            };
+            auto addr_input = [&]() {
+                input.GPR[14] = addr;
+                input.Store(*s_ppu_state);
+            };
+            auto check_load = [&](std::string & msg) {
+                const u32 value = mmio ? Memory.ReadMMIO32(addr) : vm::read32(addr);
+
+                msg = fmt::Format("value = 0x%x, GPR[5] = 0x%llx", value, s_ppu_state->GPR[5]);
+                return s_ppu_state->GPR[5] == value;
+            };
+            RunTest(fmt::Format("LWZ_BENCH.%s.%d", mmio ? "mmio" : "memory", mmio_checks).c_str(), load_case, addr_input, check_load, mmio ? 100000 : 10000000);
+        }
+    }
+
+    m_current_function_mmio_checks = true;
+    Emu.GetCPU().RemoveThread(raw_spu.GetId());
+
+    // Dispatcher throughput on a ring of sections that end with an indirect branch, so that each section is compiled
+    // into an executable of its own. The last one branches to code that is not compiled, which ends DecodeMemory.
+    const u32 num_sections = 64;
+    const u32 num_rounds   = 100000;
+    const u32 ring         = (u32)Memory.Alloc(num_sections * 20 + 4, 0x1000);
+    const u32 ring_end     = ring + num_sections * 20;
+    const u32 saved_pc     = ppu_state->PC;
+
+    for (u32 i = 0; i < num_sections; i++) {
+        const u32 section = ring + i * 20;
+        const u32 next    = section + 20;
+
+        vm::write32(section, 0x38840001);                       // addi r4, r4, 1
+        vm::write32(section + 4, 0x3CA00000 | (next >> 16));    // lis r5, next@h
+        vm::write32(section + 8, 0x60A50000 | (next & 0xFFFF)); // ori r5, r5, next@l
+        vm::write32(section + 12, 0x7CA903A6);                  // mtctr r5
+        vm::write32(section + 16, 0x4E800420);                  // bctr
+    }
+    vm::write32(ring_end, 0x60000000); // nop
+
+    std::vector<Executable> sections;
+    for (u32 i = 0; i < num_sections; i++) {
+        Compile(ring + i * 20);
+        sections.push_back(m_compiled.lower_bound(std::make_pair(ring + i * 20, 0))->second.executable);
+    }
+
+    auto elapsed_ns = [](std::chrono::high_resolution_clock::time_point start) {
+        return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start).count();
+    };
+
+    ppu_state->GPR[4] = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (u32 round = 0; round < num_rounds; round++) {
+        for (auto executable : sections) {
+            executable(ppu_state, interpreter);
+        }
+    }
+    const double body_ns = elapsed_ns(start) / (num_rounds * num_sections);
+    LOG_NOTICE(PPU, "[UT Dispatcher] Section bodies only: %.1f M blocks/s, %.1f ns per block", 1000.0 / body_ns, body_ns);
+
+    // Dispatched like CPUThread::Task does. Setting a breakpoint disables the chaining of the sections, which also
+    // stops whenever the thread is not running.
+    if (ppu_state->ThreadStatus() != CPUThread_Running) {
+        LOG_WARNING(PPU, "[UT Dispatcher] The thread is not running, the sections are not chained");
+    }
+
+    {
+        PPULLVMEmulator emulator(*ppu_state);
+
+        for (u32 chain = 0; chain < 2; chain++) {
+            if (!chain) {
+                Emu.GetBreakPoints().push_back(ring_end);
+            }
+
+            start = std::chrono::high_resolution_clock::now();
+            for (u32 round = 0; round < num_rounds; round++) {
+                ppu_state->PC = ring;
+                while (ppu_state->PC != ring_end) {
+                    emulator.DecodeMemory(ppu_state->PC);
+                }
+            }
+            const double block_ns = elapsed_ns(start) / (num_rounds * num_sections);
+
+            if (!chain) {
+                Emu.GetBreakPoints().pop_back();
+            }
+
+            LOG_NOTICE(PPU, "[UT Dispatcher] DecodeMemory %s: %.1f M blocks/s, %.1f ns per block, %.1f ns dispatcher overhead",
+                chain ? "with chaining" : "without chaining", 1000.0 / block_ns, block_ns, block_ns - body_ns);
+        }
+    }
+
+    if (ppu_state->GPR[4] != 3ull * num_rounds * num_sections) {
+        LOG_ERROR(PPU, "[UT Dispatcher] Test failed. %llu blocks executed, expected %llu", ppu_state->GPR[4], 3ull * num_rounds * num_sections);
+    }
+
+    // The sections are removed, so that code loaded at these addresses later isn't replaced by them
+    for (auto i = m_compiled.begin(); i != m_compiled.end();) {
+        if (i->first.first < ring || i->first.first >= ring_end) {
+            i++;
+            continue;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_compiled_shared_lock);
+            m_compiled_shared.erase(i->first);
+        }
+
+        if (!i->second.mmio_checks) {
+            RemoveExecutableRange(i->second.executable, i->second.size);
+        }
+
+        m_execution_engine->freeMachineCodeForFunction(i->second.llvm_function);
+        i->second.llvm_function->eraseFromParent();
+        i = m_compiled.erase(i);
+    }
+
+    Memory.Free(ring);
+    ppu_state->PC = saved_pc;
+
     initial_state.Store(*ppu_state);
 #endif // PPU_LLVM_RECOMPILER_UNIT_TESTS
 }
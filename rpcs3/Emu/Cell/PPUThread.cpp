@@ -219,6 +219,7 @@ void PPUThread::Task()
 {
 	if (m_custom_task)
 	{
+		SetProfState(CPU_EXEC_NATIVE, 0);
 		m_custom_task(*this);
 	}
 	else
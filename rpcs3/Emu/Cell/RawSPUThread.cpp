@@ -38,8 +38,12 @@ bool RawSPUThread::Read32(const u64 addr, u32* value)
 
 	case SPU_Out_MBox_offs:
 	{
-		// if Out_MBox is empty, the result is undefined
-		SPU.Out_MBox.PopUncond(*value);
+		// if Out_MBox is empty, the result is undefined (atomic exchange, two readers can't get the same message)
+		if (!SPU.Out_MBox.Pop_XCHG(*value))
+		{
+			*value = 0;
+		}
+		NotifyChannel();
 		break;
 	}
 
@@ -98,6 +102,7 @@ bool RawSPUThread::Write32(const u64 addr, const u32 value)
 
 	case MFC_CMDStatus_offs:
 	{
+		std::lock_guard<std::mutex> lock(m_mmio_lock);
 		MFC2.CMDStatus.SetValue(value);
 		EnqMfcCmd(MFC2);
 		break;
@@ -129,7 +134,11 @@ bool RawSPUThread::Write32(const u64 addr, const u32 value)
 	case SPU_In_MBox_offs:
 	{
 		// if In_MBox is already full, the last message is overwritten  
-		SPU.In_MBox.PushUncond(value); 
+		{
+			std::lock_guard<std::mutex> lock(m_mmio_lock);
+			SPU.In_MBox.PushUncond(value);
+		}
+		NotifyChannel();
 		break;
 	}
 
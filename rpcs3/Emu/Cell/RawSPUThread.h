@@ -12,6 +12,10 @@ class RawSPUThread
 {
 	u32 m_index;
 
+	// MMIO is accessed without the lv2 lock; register reads and writes are atomic,
+	// but queue pushes and MFC proxy commands from several PPU threads must be serialized
+	std::mutex m_mmio_lock;
+
 public:
 	RawSPUThread(CPUThreadType type = CPU_THREAD_RAW_SPU);
 	virtual ~RawSPUThread();
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "Emu/Cell/VectorOps.h"
+
 #define UNIMPLEMENTED() UNK(__FUNCTION__)
 
 #define MEM_AND_REG_HASH() \
@@ -60,41 +62,27 @@ private:
 	}
 	void SF(u32 rt, u32 ra, u32 rb)
 	{
-		CPU.GPR[rt]._u32[0] = CPU.GPR[rb]._u32[0] - CPU.GPR[ra]._u32[0];
-		CPU.GPR[rt]._u32[1] = CPU.GPR[rb]._u32[1] - CPU.GPR[ra]._u32[1];
-		CPU.GPR[rt]._u32[2] = CPU.GPR[rb]._u32[2] - CPU.GPR[ra]._u32[2];
-		CPU.GPR[rt]._u32[3] = CPU.GPR[rb]._u32[3] - CPU.GPR[ra]._u32[3];
+		CPU.GPR[rt].vi = _mm_sub_epi32(CPU.GPR[rb].vi, CPU.GPR[ra].vi);
 	}
 	void OR(u32 rt, u32 ra, u32 rb)
 	{
-		CPU.GPR[rt]._u32[0] = CPU.GPR[ra]._u32[0] | CPU.GPR[rb]._u32[0];
-		CPU.GPR[rt]._u32[1] = CPU.GPR[ra]._u32[1] | CPU.GPR[rb]._u32[1];
-		CPU.GPR[rt]._u32[2] = CPU.GPR[ra]._u32[2] | CPU.GPR[rb]._u32[2];
-		CPU.GPR[rt]._u32[3] = CPU.GPR[ra]._u32[3] | CPU.GPR[rb]._u32[3];
+		CPU.GPR[rt].vi = _mm_or_si128(CPU.GPR[ra].vi, CPU.GPR[rb].vi);
 	}
 	void BG(u32 rt, u32 ra, u32 rb)
 	{
-		CPU.GPR[rt]._u32[0] = CPU.GPR[ra]._u32[0] > CPU.GPR[rb]._u32[0] ? 0 : 1;
-		CPU.GPR[rt]._u32[1] = CPU.GPR[ra]._u32[1] > CPU.GPR[rb]._u32[1] ? 0 : 1;
-		CPU.GPR[rt]._u32[2] = CPU.GPR[ra]._u32[2] > CPU.GPR[rb]._u32[2] ? 0 : 1;
-		CPU.GPR[rt]._u32[3] = CPU.GPR[ra]._u32[3] > CPU.GPR[rb]._u32[3] ? 0 : 1;
+		CPU.GPR[rt].vi = simd::no_borrow_u32(CPU.GPR[rb].vi, CPU.GPR[ra].vi);
 	}
 	void SFH(u32 rt, u32 ra, u32 rb)
 	{
-		for (int h = 0; h < 8; h++)
-			CPU.GPR[rt]._u16[h] = CPU.GPR[rb]._u16[h] - CPU.GPR[ra]._u16[h];
+		CPU.GPR[rt].vi = _mm_sub_epi16(CPU.GPR[rb].vi, CPU.GPR[ra].vi);
 	}
 	void NOR(u32 rt, u32 ra, u32 rb)
 	{
-		CPU.GPR[rt]._u32[0] = ~(CPU.GPR[ra]._u32[0] | CPU.GPR[rb]._u32[0]);
-		CPU.GPR[rt]._u32[1] = ~(CPU.GPR[ra]._u32[1] | CPU.GPR[rb]._u32[1]);
-		CPU.GPR[rt]._u32[2] = ~(CPU.GPR[ra]._u32[2] | CPU.GPR[rb]._u32[2]);
-		CPU.GPR[rt]._u32[3] = ~(CPU.GPR[ra]._u32[3] | CPU.GPR[rb]._u32[3]);
+		CPU.GPR[rt].vi = _mm_xor_si128(_mm_or_si128(CPU.GPR[ra].vi, CPU.GPR[rb].vi), _mm_set1_epi32(-1));
 	}
 	void ABSDB(u32 rt, u32 ra, u32 rb)
 	{
-		for (int b = 0; b < 16; b++)
-			CPU.GPR[rt]._u8[b] = CPU.GPR[rb]._u8[b] > CPU.GPR[ra]._u8[b] ? CPU.GPR[rb]._u8[b] - CPU.GPR[ra]._u8[b] : CPU.GPR[ra]._u8[b] - CPU.GPR[rb]._u8[b];
+		CPU.GPR[rt].vi = simd::absdiff_u8(CPU.GPR[ra].vi, CPU.GPR[rb].vi);
 	}
 	void ROT(u32 rt, u32 ra, u32 rb)
 	{
@@ -205,41 +193,27 @@ private:
 	}
 	void A(u32 rt, u32 ra, u32 rb)
 	{
-		CPU.GPR[rt]._u32[0] = CPU.GPR[ra]._u32[0] + CPU.GPR[rb]._u32[0];
-		CPU.GPR[rt]._u32[1] = CPU.GPR[ra]._u32[1] + CPU.GPR[rb]._u32[1];
-		CPU.GPR[rt]._u32[2] = CPU.GPR[ra]._u32[2] + CPU.GPR[rb]._u32[2];
-		CPU.GPR[rt]._u32[3] = CPU.GPR[ra]._u32[3] + CPU.GPR[rb]._u32[3];
+		CPU.GPR[rt].vi = _mm_add_epi32(CPU.GPR[ra].vi, CPU.GPR[rb].vi);
 	}
 	void AND(u32 rt, u32 ra, u32 rb)
 	{
-		CPU.GPR[rt]._u32[0] = CPU.GPR[ra]._u32[0] & CPU.GPR[rb]._u32[0];
-		CPU.GPR[rt]._u32[1] = CPU.GPR[ra]._u32[1] & CPU.GPR[rb]._u32[1];
-		CPU.GPR[rt]._u32[2] = CPU.GPR[ra]._u32[2] & CPU.GPR[rb]._u32[2];
-		CPU.GPR[rt]._u32[3] = CPU.GPR[ra]._u32[3] & CPU.GPR[rb]._u32[3];
+		CPU.GPR[rt].vi = _mm_and_si128(CPU.GPR[ra].vi, CPU.GPR[rb].vi);
 	}
 	void CG(u32 rt, u32 ra, u32 rb)
 	{
-		CPU.GPR[rt]._u32[0] = ((CPU.GPR[ra]._u32[0] + CPU.GPR[rb]._u32[0]) < CPU.GPR[ra]._u32[0]) ? 1 : 0;
-		CPU.GPR[rt]._u32[1] = ((CPU.GPR[ra]._u32[1] + CPU.GPR[rb]._u32[1]) < CPU.GPR[ra]._u32[1]) ? 1 : 0;
-		CPU.GPR[rt]._u32[2] = ((CPU.GPR[ra]._u32[2] + CPU.GPR[rb]._u32[2]) < CPU.GPR[ra]._u32[2]) ? 1 : 0;
-		CPU.GPR[rt]._u32[3] = ((CPU.GPR[ra]._u32[3] + CPU.GPR[rb]._u32[3]) < CPU.GPR[ra]._u32[3]) ? 1 : 0;
+		CPU.GPR[rt].vi = simd::carry_u32(CPU.GPR[ra].vi, CPU.GPR[rb].vi);
 	}
 	void AH(u32 rt, u32 ra, u32 rb)
 	{
-		for (int h = 0; h < 8; h++)
-			CPU.GPR[rt]._u16[h] = CPU.GPR[ra]._u16[h] + CPU.GPR[rb]._u16[h];
+		CPU.GPR[rt].vi = _mm_add_epi16(CPU.GPR[ra].vi, CPU.GPR[rb].vi);
 	}
 	void NAND(u32 rt, u32 ra, u32 rb)
 	{
-		CPU.GPR[rt]._u32[0] = ~(CPU.GPR[ra]._u32[0] & CPU.GPR[rb]._u32[0]);
-		CPU.GPR[rt]._u32[1] = ~(CPU.GPR[ra]._u32[1] & CPU.GPR[rb]._u32[1]);
-		CPU.GPR[rt]._u32[2] = ~(CPU.GPR[ra]._u32[2] & CPU.GPR[rb]._u32[2]);
-		CPU.GPR[rt]._u32[3] = ~(CPU.GPR[ra]._u32[3] & CPU.GPR[rb]._u32[3]);
+		CPU.GPR[rt].vi = _mm_xor_si128(_mm_and_si128(CPU.GPR[ra].vi, CPU.GPR[rb].vi), _mm_set1_epi32(-1));
 	}
 	void AVGB(u32 rt, u32 ra, u32 rb)
 	{
-		for (int b = 0; b < 16; b++)
-			CPU.GPR[rt]._u8[b] = (CPU.GPR[ra]._u8[b] + CPU.GPR[rb]._u8[b] + 1) >> 1;
+		CPU.GPR[rt].vi = _mm_avg_epu8(CPU.GPR[ra].vi, CPU.GPR[rb].vi);
 	}
 	void MTSPR(u32 rt, u32 sa)
 	{
@@ -736,28 +710,23 @@ private:
 	}
 	void CGT(u32 rt, u32 ra, u32 rb)
 	{
-		for (int w = 0; w < 4; w++)
-			CPU.GPR[rt]._u32[w] = CPU.GPR[ra]._s32[w] > CPU.GPR[rb]._s32[w] ? 0xffffffff : 0;
+		CPU.GPR[rt].vi = _mm_cmpgt_epi32(CPU.GPR[ra].vi, CPU.GPR[rb].vi);
 	}
 	void XOR(u32 rt, u32 ra, u32 rb)
 	{
-		for (int w = 0; w < 4; w++)
-			CPU.GPR[rt]._u32[w] = CPU.GPR[ra]._u32[w] ^ CPU.GPR[rb]._u32[w];
+		CPU.GPR[rt].vi = _mm_xor_si128(CPU.GPR[ra].vi, CPU.GPR[rb].vi);
 	}
 	void CGTH(u32 rt, u32 ra, u32 rb)
 	{
-		for (int h = 0; h < 8; h++)
-			CPU.GPR[rt]._u16[h] = CPU.GPR[ra]._s16[h] > CPU.GPR[rb]._s16[h] ? 0xffff : 0;
+		CPU.GPR[rt].vi = _mm_cmpgt_epi16(CPU.GPR[ra].vi, CPU.GPR[rb].vi);
 	}
 	void EQV(u32 rt, u32 ra, u32 rb)
 	{
-		for (int w = 0; w < 4; w++)
-			CPU.GPR[rt]._u32[w] = CPU.GPR[ra]._u32[w] ^ (~CPU.GPR[rb]._u32[w]);
+		CPU.GPR[rt].vi = _mm_xor_si128(_mm_xor_si128(CPU.GPR[ra].vi, CPU.GPR[rb].vi), _mm_set1_epi32(-1));
 	}
 	void CGTB(u32 rt, u32 ra, u32 rb)
 	{
-		for (int b = 0; b < 16; b++)
-			CPU.GPR[rt]._u8[b] = CPU.GPR[ra]._s8[b] > CPU.GPR[rb]._s8[b] ? 0xff : 0;
+		CPU.GPR[rt].vi = _mm_cmpgt_epi8(CPU.GPR[ra].vi, CPU.GPR[rb].vi);
 	}
 	void SUMB(u32 rt, u32 ra, u32 rb)
 	{
@@ -816,22 +785,15 @@ private:
 	}
 	void CLGT(u32 rt, u32 ra, u32 rb)
 	{
-		for(u32 i = 0; i < 4; ++i)
-		{
-			CPU.GPR[rt]._u32[i] = (CPU.GPR[ra]._u32[i] > CPU.GPR[rb]._u32[i]) ? 0xffffffff : 0x00000000;
-		}
+		CPU.GPR[rt].vi = simd::cmpgt_u32(CPU.GPR[ra].vi, CPU.GPR[rb].vi);
 	}
 	void ANDC(u32 rt, u32 ra, u32 rb)
 	{
-		for (int w = 0; w < 4; w++)
-			CPU.GPR[rt]._u32[w] = CPU.GPR[ra]._u32[w] & (~CPU.GPR[rb]._u32[w]);
+		CPU.GPR[rt].vi = _mm_andnot_si128(CPU.GPR[rb].vi, CPU.GPR[ra].vi);
 	}
 	void FCGT(u32 rt, u32 ra, u32 rb)
 	{
-		CPU.GPR[rt]._u32[0] = CPU.GPR[ra]._f[0] > CPU.GPR[rb]._f[0] ? 0xffffffff : 0;
-		CPU.GPR[rt]._u32[1] = CPU.GPR[ra]._f[1] > CPU.GPR[rb]._f[1] ? 0xffffffff : 0;
-		CPU.GPR[rt]._u32[2] = CPU.GPR[ra]._f[2] > CPU.GPR[rb]._f[2] ? 0xffffffff : 0;
-		CPU.GPR[rt]._u32[3] = CPU.GPR[ra]._f[3] > CPU.GPR[rb]._f[3] ? 0xffffffff : 0;
+		CPU.GPR[rt].vf = _mm_cmpgt_ps(CPU.GPR[ra].vf, CPU.GPR[rb].vf);
 	}
 	void DFCGT(u32 rt, u32 ra, u32 rb)
 	{
@@ -839,44 +801,27 @@ private:
 	}
 	void FA(u32 rt, u32 ra, u32 rb)
 	{
-		for (int w = 0; w < 4; w++)
-		{
-			CPU.GPR[rt]._f[w] = CPU.GPR[ra]._f[w] + CPU.GPR[rb]._f[w];
-			//if (CPU.GPR[rt]._f[w] == -0.0f) CPU.GPR[rt]._f[w] = 0.0f;
-		}
+		CPU.GPR[rt].vf = _mm_add_ps(CPU.GPR[ra].vf, CPU.GPR[rb].vf);
 	}
 	void FS(u32 rt, u32 ra, u32 rb)
 	{
-		for (int w = 0; w < 4; w++)
-		{
-			CPU.GPR[rt]._f[w] = CPU.GPR[ra]._f[w] - CPU.GPR[rb]._f[w];
-			//if (CPU.GPR[rt]._f[w] == -0.0f) CPU.GPR[rt]._f[w] = 0.0f;
-		}
+		CPU.GPR[rt].vf = _mm_sub_ps(CPU.GPR[ra].vf, CPU.GPR[rb].vf);
 	}
 	void FM(u32 rt, u32 ra, u32 rb)
 	{
-		for (int w = 0; w < 4; w++)
-		{
-			CPU.GPR[rt]._f[w] = CPU.GPR[ra]._f[w] * CPU.GPR[rb]._f[w];
-			//if (CPU.GPR[rt]._f[w] == -0.0f) CPU.GPR[rt]._f[w] = 0.0f;
-		}
+		CPU.GPR[rt].vf = _mm_mul_ps(CPU.GPR[ra].vf, CPU.GPR[rb].vf);
 	}
 	void CLGTH(u32 rt, u32 ra, u32 rb)
 	{
-		for (int h = 0; h < 8; h++)
-			CPU.GPR[rt]._u16[h] = CPU.GPR[ra]._u16[h] > CPU.GPR[rb]._u16[h] ? 0xffff : 0;
+		CPU.GPR[rt].vi = simd::cmpgt_u16(CPU.GPR[ra].vi, CPU.GPR[rb].vi);
 	}
 	void ORC(u32 rt, u32 ra, u32 rb)
 	{
-		for (int w = 0; w < 4; w++)
-			CPU.GPR[rt]._u32[w] = CPU.GPR[ra]._u32[w] | (~CPU.GPR[rb]._u32[w]);
+		CPU.GPR[rt].vi = _mm_or_si128(CPU.GPR[ra].vi, _mm_xor_si128(CPU.GPR[rb].vi, _mm_set1_epi32(-1)));
 	}
 	void FCMGT(u32 rt, u32 ra, u32 rb)
 	{
-		CPU.GPR[rt]._u32[0] = fabs(CPU.GPR[ra]._f[0]) > fabs(CPU.GPR[rb]._f[0]) ? 0xffffffff : 0;
-		CPU.GPR[rt]._u32[1] = fabs(CPU.GPR[ra]._f[1]) > fabs(CPU.GPR[rb]._f[1]) ? 0xffffffff : 0;
-		CPU.GPR[rt]._u32[2] = fabs(CPU.GPR[ra]._f[2]) > fabs(CPU.GPR[rb]._f[2]) ? 0xffffffff : 0;
-		CPU.GPR[rt]._u32[3] = fabs(CPU.GPR[ra]._f[3]) > fabs(CPU.GPR[rb]._f[3]) ? 0xffffffff : 0;
+		CPU.GPR[rt].vf = _mm_cmpgt_ps(simd::abs_f(CPU.GPR[ra].vf), simd::abs_f(CPU.GPR[rb].vf));
 	}
 	void DFCMGT(u32 rt, u32 ra, u32 rb)
 	{
@@ -899,8 +844,7 @@ private:
 	}
 	void CLGTB(u32 rt, u32 ra, u32 rb)
 	{
-		for (int b = 0; b < 16; b++)
-			CPU.GPR[rt]._u8[b] = CPU.GPR[ra]._u8[b] > CPU.GPR[rb]._u8[b] ? 0xff : 0;
+		CPU.GPR[rt].vi = _mm_cmpgt_epu8(CPU.GPR[ra].vi, CPU.GPR[rb].vi);
 	}
 	void HLGT(u32 rt, u32 ra, u32 rb)
 	{
@@ -932,13 +876,11 @@ private:
 	}
 	void CEQ(u32 rt, u32 ra, u32 rb)
 	{
-		for (int w = 0; w < 4; w++)
-			CPU.GPR[rt]._u32[w] = CPU.GPR[ra]._s32[w] == CPU.GPR[rb]._s32[w] ? 0xffffffff : 0;
+		CPU.GPR[rt].vi = _mm_cmpeq_epi32(CPU.GPR[ra].vi, CPU.GPR[rb].vi);
 	}
 	void MPYHHU(u32 rt, u32 ra, u32 rb)
 	{
-		for (int w = 0; w < 4; w++)
-			CPU.GPR[rt]._u32[w] = CPU.GPR[ra]._u16[w*2+1] * CPU.GPR[rb]._u16[w*2+1];
+		CPU.GPR[rt].vi = simd::mul_hi_u16(CPU.GPR[ra].vi, CPU.GPR[rb].vi);
 	}
 	void ADDX(u32 rt, u32 ra, u32 rb)
 	{
@@ -969,13 +911,11 @@ private:
 	}
 	void MPYHHA(u32 rt, u32 ra, u32 rb)
 	{
-		for (int w = 0; w < 4; w++)
-			CPU.GPR[rt]._s32[w] += CPU.GPR[ra]._s16[w*2+1] * CPU.GPR[rb]._s16[w*2+1];
+		CPU.GPR[rt].vi = _mm_add_epi32(CPU.GPR[rt].vi, simd::mul_hi_s16(CPU.GPR[ra].vi, CPU.GPR[rb].vi));
 	}
 	void MPYHHAU(u32 rt, u32 ra, u32 rb)
 	{
-		for (int w = 0; w < 4; w++)
-			CPU.GPR[rt]._u32[w] += CPU.GPR[ra]._u16[w*2+1] * CPU.GPR[rb]._u16[w*2+1];
+		CPU.GPR[rt].vi = _mm_add_epi32(CPU.GPR[rt].vi, simd::mul_hi_u16(CPU.GPR[ra].vi, CPU.GPR[rb].vi));
 	}
 	//Forced bits to 0, hence the shift:
 	
@@ -1011,10 +951,7 @@ private:
 	}
 	void FCEQ(u32 rt, u32 ra, u32 rb)
 	{
-		CPU.GPR[rt]._u32[0] = CPU.GPR[ra]._f[0] == CPU.GPR[rb]._f[0] ? 0xffffffff : 0;
-		CPU.GPR[rt]._u32[1] = CPU.GPR[ra]._f[1] == CPU.GPR[rb]._f[1] ? 0xffffffff : 0;
-		CPU.GPR[rt]._u32[2] = CPU.GPR[ra]._f[2] == CPU.GPR[rb]._f[2] ? 0xffffffff : 0;
-		CPU.GPR[rt]._u32[3] = CPU.GPR[ra]._f[3] == CPU.GPR[rb]._f[3] ? 0xffffffff : 0;
+		CPU.GPR[rt].vf = _mm_cmpeq_ps(CPU.GPR[ra].vf, CPU.GPR[rb].vf);
 	}
 	void DFCEQ(u32 rt, u32 ra, u32 rb)
 	{
@@ -1022,35 +959,27 @@ private:
 	}
 	void MPY(u32 rt, u32 ra, u32 rb)
 	{
-		for (int w = 0; w < 4; w++)
-			CPU.GPR[rt]._s32[w] = CPU.GPR[ra]._s16[w*2] * CPU.GPR[rb]._s16[w*2];
+		CPU.GPR[rt].vi = simd::mul_lo_s16(CPU.GPR[ra].vi, CPU.GPR[rb].vi);
 	}
 	void MPYH(u32 rt, u32 ra, u32 rb)
 	{
-		for (int w = 0; w < 4; w++)
-			CPU.GPR[rt]._s32[w] = (CPU.GPR[ra]._s16[w*2+1] * CPU.GPR[rb]._s16[w*2]) << 16;
+		CPU.GPR[rt].vi = _mm_slli_epi32(_mm_mullo_epi16(_mm_srli_epi32(CPU.GPR[ra].vi, 16), CPU.GPR[rb].vi), 16);
 	}
 	void MPYHH(u32 rt, u32 ra, u32 rb)
 	{
-		for (int w = 0; w < 4; w++)
-			CPU.GPR[rt]._s32[w] = CPU.GPR[ra]._s16[w*2+1] * CPU.GPR[rb]._s16[w*2+1];
+		CPU.GPR[rt].vi = simd::mul_hi_s16(CPU.GPR[ra].vi, CPU.GPR[rb].vi);
 	}
 	void MPYS(u32 rt, u32 ra, u32 rb)
 	{
-		for (int w = 0; w < 4; w++)
-			CPU.GPR[rt]._s32[w] = (CPU.GPR[ra]._s16[w*2] * CPU.GPR[rb]._s16[w*2]) >> 16;
+		CPU.GPR[rt].vi = _mm_srai_epi32(simd::mul_lo_s16(CPU.GPR[ra].vi, CPU.GPR[rb].vi), 16);
 	}
 	void CEQH(u32 rt, u32 ra, u32 rb)
 	{
-		for (int h = 0; h < 8; h++)
-			CPU.GPR[rt]._u16[h] = CPU.GPR[ra]._u16[h] == CPU.GPR[rb]._u16[h] ? 0xffff : 0;
+		CPU.GPR[rt].vi = _mm_cmpeq_epi16(CPU.GPR[ra].vi, CPU.GPR[rb].vi);
 	}
 	void FCMEQ(u32 rt, u32 ra, u32 rb)
 	{
-		CPU.GPR[rt]._u32[0] = fabs(CPU.GPR[ra]._f[0]) == fabs(CPU.GPR[rb]._f[0]) ? 0xffffffff : 0;
-		CPU.GPR[rt]._u32[1] = fabs(CPU.GPR[ra]._f[1]) == fabs(CPU.GPR[rb]._f[1]) ? 0xffffffff : 0;
-		CPU.GPR[rt]._u32[2] = fabs(CPU.GPR[ra]._f[2]) == fabs(CPU.GPR[rb]._f[2]) ? 0xffffffff : 0;
-		CPU.GPR[rt]._u32[3] = fabs(CPU.GPR[ra]._f[3]) == fabs(CPU.GPR[rb]._f[3]) ? 0xffffffff : 0;
+		CPU.GPR[rt].vf = _mm_cmpeq_ps(simd::abs_f(CPU.GPR[ra].vf), simd::abs_f(CPU.GPR[rb].vf));
 	}
 	void DFCMEQ(u32 rt, u32 ra, u32 rb)
 	{
@@ -1058,13 +987,11 @@ private:
 	}
 	void MPYU(u32 rt, u32 ra, u32 rb)
 	{
-		for (int w = 0; w < 4; w++)
-			CPU.GPR[rt]._u32[w] = CPU.GPR[ra]._u16[w*2] * CPU.GPR[rb]._u16[w*2];
+		CPU.GPR[rt].vi = simd::mul_lo_u16(CPU.GPR[ra].vi, CPU.GPR[rb].vi);
 	}
 	void CEQB(u32 rt, u32 ra, u32 rb)
 	{
-		for (int b = 0; b < 16; b++)
-			CPU.GPR[rt]._u8[b] = CPU.GPR[ra]._u8[b] == CPU.GPR[rb]._u8[b] ? 0xff : 0;
+		CPU.GPR[rt].vi = _mm_cmpeq_epi8(CPU.GPR[ra].vi, CPU.GPR[rb].vi);
 	}
 	void FI(u32 rt, u32 ra, u32 rb)
 	{
@@ -1084,76 +1011,19 @@ private:
 	//0 - 9
 	void CFLTS(u32 rt, u32 ra, s32 i8)
 	{
-		const u32 scale = 173 - (i8 & 0xff); //unsigned immediate
-		for (int i = 0; i < 4; i++)
-		{
-			u32 exp = ((CPU.GPR[ra]._u32[i] >> 23) & 0xff) + scale;
-
-			if (exp > 255) 
-				exp = 255;
-
-			CPU.GPR[rt]._u32[i] = (CPU.GPR[ra]._u32[i] & 0x807fffff) | (exp << 23);
-
-			if (CPU.GPR[rt]._f[i] > 0x7fffffff)
-				CPU.GPR[rt]._u32[i] = 0x7fffffff;
-			else if (CPU.GPR[rt]._f[i] < -pow(2, 31))
-				CPU.GPR[rt]._u32[i] = 0x80000000;
-			else
-				CPU.GPR[rt]._s32[i] = (s32)CPU.GPR[rt]._f[i]; //trunc
-		}
+		CPU.GPR[rt].vi = simd::cflts(CPU.GPR[ra].vi, i8);
 	}
 	void CFLTU(u32 rt, u32 ra, s32 i8)
 	{
-		const u32 scale = 173 - (i8 & 0xff); //unsigned immediate
-		for (int i = 0; i < 4; i++)
-		{
-			u32 exp = ((CPU.GPR[ra]._u32[i] >> 23) & 0xff) + scale;
-
-			if (exp > 255) 
-				exp = 255;
-
-			if (CPU.GPR[ra]._u32[i] & 0x80000000) //if negative, result = 0
-				CPU.GPR[rt]._u32[i] = 0;
-			else
-			{
-				CPU.GPR[rt]._u32[i] = (CPU.GPR[ra]._u32[i] & 0x807fffff) | (exp << 23);
-
-				if (CPU.GPR[rt]._f[i] > 0xffffffff) //if big, result = max
-					CPU.GPR[rt]._u32[i] = 0xffffffff;
-				else
-					CPU.GPR[rt]._u32[i] = (u32)floor(CPU.GPR[rt]._f[i]);
-			}
-		}
+		CPU.GPR[rt].vi = simd::cfltu(CPU.GPR[ra].vi, i8);
 	}
 	void CSFLT(u32 rt, u32 ra, s32 i8)
 	{
-		const u32 scale = 155 - (i8 & 0xff); //unsigned immediate
-		for (int i = 0; i < 4; i++)
-		{
-			CPU.GPR[rt]._f[i] = (float)CPU.GPR[ra]._s32[i];
-
-			u32 exp = ((CPU.GPR[rt]._u32[i] >> 23) & 0xff) - scale;
-
-			if (exp > 255) //< 0
-				exp = 0;
-
-			CPU.GPR[rt]._u32[i] = (CPU.GPR[rt]._u32[i] & 0x807fffff) | (exp << 23);
-		}
+		CPU.GPR[rt].vf = simd::csflt(CPU.GPR[ra].vi, i8);
 	}
 	void CUFLT(u32 rt, u32 ra, s32 i8)
 	{
-		const u32 scale = 155 - (i8 & 0xff); //unsigned immediate
-		for (int i = 0; i < 4; i++)
-		{
-			CPU.GPR[rt]._f[i] = (float)CPU.GPR[ra]._u32[i];
-
-			u32 exp = ((CPU.GPR[rt]._u32[i] >> 23) & 0xff) - scale;
-
-			if (exp > 255) //< 0
-				exp = 0;
-
-			CPU.GPR[rt]._u32[i] = (CPU.GPR[rt]._u32[i] & 0x807fffff) | (exp << 23);
-		}
+		CPU.GPR[rt].vf = simd::cuflt(CPU.GPR[ra].vi, i8);
 	}
 
 	//0 - 8
@@ -1383,18 +1253,15 @@ private:
 	}
 	void CGTI(u32 rt, u32 ra, s32 i10)
 	{
-		for (int w = 0; w < 4; w++)
-			CPU.GPR[rt]._u32[w] = CPU.GPR[ra]._s32[w] > i10 ? 0xffffffff : 0;
+		CPU.GPR[rt].vi = _mm_cmpgt_epi32(CPU.GPR[ra].vi, _mm_set1_epi32(i10));
 	}
 	void CGTHI(u32 rt, u32 ra, s32 i10)
 	{
-		for (int h = 0; h < 8; h++)
-			CPU.GPR[rt]._u16[h] = CPU.GPR[ra]._s16[h] > i10 ? 0xffff : 0;
+		CPU.GPR[rt].vi = _mm_cmpgt_epi16(CPU.GPR[ra].vi, _mm_set1_epi16((s16)i10));
 	}
 	void CGTBI(u32 rt, u32 ra, s32 i10)
 	{
-		for (int b = 0; b < 16; b++)
-			CPU.GPR[rt]._u8[b] = CPU.GPR[ra]._s8[b] > (s8)(i10 & 0xff) ? 0xff : 0;
+		CPU.GPR[rt].vi = _mm_cmpgt_epi8(CPU.GPR[ra].vi, _mm_set1_epi8((s8)i10));
 	}
 	void HGTI(u32 rt, u32 ra, s32 i10)
 	{
@@ -1406,22 +1273,15 @@ private:
 	}
 	void CLGTI(u32 rt, u32 ra, s32 i10)
 	{
-		for(u32 i = 0; i < 4; ++i)
-		{
-			CPU.GPR[rt]._u32[i] = (CPU.GPR[ra]._u32[i] > (u32)i10) ? 0xffffffff : 0x00000000;
-		}
+		CPU.GPR[rt].vi = simd::cmpgt_u32(CPU.GPR[ra].vi, _mm_set1_epi32(i10));
 	}
 	void CLGTHI(u32 rt, u32 ra, s32 i10)
 	{
-		for(u32 i = 0; i < 8; ++i)
-		{
-			CPU.GPR[rt]._u16[i] = (CPU.GPR[ra]._u16[i] > (u16)i10) ? 0xffff : 0x0000;
-		}
+		CPU.GPR[rt].vi = simd::cmpgt_u16(CPU.GPR[ra].vi, _mm_set1_epi16((s16)i10));
 	}
 	void CLGTBI(u32 rt, u32 ra, s32 i10)
 	{
-		for (int b = 0; b < 16; b++)
-			CPU.GPR[rt]._u8[b] = CPU.GPR[ra]._u8[b] > (u8)(i10 & 0xff) ? 0xff : 0;
+		CPU.GPR[rt].vi = _mm_cmpgt_epu8(CPU.GPR[ra].vi, _mm_set1_epi8((s8)i10));
 	}
 	void HLGTI(u32 rt, u32 ra, s32 i10)
 	{
@@ -1433,28 +1293,23 @@ private:
 	}
 	void MPYI(u32 rt, u32 ra, s32 i10)
 	{
-		for (int w = 0; w < 4; w++)
-			CPU.GPR[rt]._s32[w] = CPU.GPR[ra]._s16[w*2] * i10;
+		CPU.GPR[rt].vi = simd::mul_lo_s16(CPU.GPR[ra].vi, _mm_set1_epi32(i10));
 	}
 	void MPYUI(u32 rt, u32 ra, s32 i10)
 	{
-		for (int w = 0; w < 4; w++)
-			CPU.GPR[rt]._u32[w] = CPU.GPR[ra]._u16[w*2] * (u16)(i10 & 0xffff);
+		CPU.GPR[rt].vi = simd::mul_lo_u16(CPU.GPR[ra].vi, _mm_set1_epi32(i10 & 0xffff));
 	}
 	void CEQI(u32 rt, u32 ra, s32 i10)
 	{
-		for(u32 i = 0; i < 4; ++i)
-			CPU.GPR[rt]._u32[i] = (CPU.GPR[ra]._s32[i] == i10) ? 0xffffffff : 0x00000000;
+		CPU.GPR[rt].vi = _mm_cmpeq_epi32(CPU.GPR[ra].vi, _mm_set1_epi32(i10));
 	}
 	void CEQHI(u32 rt, u32 ra, s32 i10)
 	{
-		for (int h = 0; h < 8; h++)
-			CPU.GPR[rt]._u16[h] = (CPU.GPR[ra]._s16[h] == (s16)i10) ? 0xffff : 0;
+		CPU.GPR[rt].vi = _mm_cmpeq_epi16(CPU.GPR[ra].vi, _mm_set1_epi16((s16)i10));
 	}
 	void CEQBI(u32 rt, u32 ra, s32 i10)
 	{
-		for (int b = 0; b < 16; b++)
-			CPU.GPR[rt]._s8[b] = (CPU.GPR[ra]._s8[b] == (s8)(i10 & 0xff)) ? 0xff : 0;
+		CPU.GPR[rt].vi = _mm_cmpeq_epi8(CPU.GPR[ra].vi, _mm_set1_epi8((s8)i10));
 	}
 	void HEQI(u32 rt, u32 ra, s32 i10)
 	{
@@ -1484,45 +1339,15 @@ private:
 	//0 - 3
 	void SELB(u32 rt, u32 ra, u32 rb, u32 rc)
 	{
-		for(u64 i = 0; i < 2; ++i)
-		{
-			CPU.GPR[rt]._u64[i] =
-				( CPU.GPR[rc]._u64[i] & CPU.GPR[rb]._u64[i]) |
-				(~CPU.GPR[rc]._u64[i] & CPU.GPR[ra]._u64[i]);
-		}
+		CPU.GPR[rt].vi = simd::sel(CPU.GPR[rc].vi, CPU.GPR[rb].vi, CPU.GPR[ra].vi);
 	}
 	void SHUFB(u32 rt, u32 ra, u32 rb, u32 rc)
 	{
-		const u128 _a = CPU.GPR[ra];
-		const u128 _b = CPU.GPR[rb];
-		for (int i = 0; i < 16; i++)
-		{
-			u8 b = CPU.GPR[rc]._u8[i];
-			if(b & 0x80)
-			{
-				if(b & 0x40)
-				{
-					if(b & 0x20)
-						CPU.GPR[rt]._u8[i] = 0x80;
-					else
-						CPU.GPR[rt]._u8[i] = 0xFF;
-				}
-				else
-					CPU.GPR[rt]._u8[i] = 0x00;
-			}
-			else
-			{
-				if(b & 0x10)
-					CPU.GPR[rt]._u8[i] = _b._u8[15 - (b & 0x0F)];
-				else
-					CPU.GPR[rt]._u8[i] = _a._u8[15 - (b & 0x0F)];
-			}
-		}
+		CPU.GPR[rt].vi = simd::shufb(CPU.GPR[ra].vi, CPU.GPR[rb].vi, CPU.GPR[rc].vi);
 	}
 	void MPYA(u32 rt, u32 ra, u32 rb, u32 rc)
 	{
-		for (int w = 0; w < 4; w++)
-			CPU.GPR[rt]._s32[w] = CPU.GPR[ra]._s16[w*2] * CPU.GPR[rb]._s16[w*2] + CPU.GPR[rc]._s32[w];
+		CPU.GPR[rt].vi = _mm_add_epi32(simd::mul_lo_s16(CPU.GPR[ra].vi, CPU.GPR[rb].vi), CPU.GPR[rc].vi);
 	}
 	void FNMS(u32 rt, u32 ra, u32 rb, u32 rc)
 	{
@@ -0,0 +1,1225 @@
+#include "stdafx.h"
+#include "rpcs3/Ini.h"
+#include "Utilities/Log.h"
+#include "Emu/Memory/Memory.h"
+#include "Emu/System.h"
+#include "Emu/PerfCounters.h"
+#include "Emu/Cell/SPUThread.h"
+#include "Emu/Cell/SPUInstrTable.h"
+#include "Emu/Cell/SPUInterpreter.h"
+#include "Emu/Cell/SPULLVMRecompiler.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/CodeGen/MachineCodeInfo.h"
+#include "llvm/IR/Intrinsics.h"
+#include "llvm/Analysis/Passes.h"
+#include "llvm/Analysis/TargetTransformInfo.h"
+#include "llvm/Analysis/MemoryDependenceAnalysis.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/Transforms/Scalar.h"
+
+using namespace llvm;
+
+/// Execute an instruction using the interpreter. Called by the executables.
+static void InterpreterFallback(SPUThread * spu_state, SPUInterpreter * interpreter, u32 pc, u32 instruction) {
+    spu_state->PC = pc;
+    (*SPU_instr::rrr_list)(interpreter, instruction);
+}
+
+SPULLVMRecompiler::SPULLVMRecompiler(SPUThread & spu)
+    : m_spu(spu)
+    , m_interpreter(new SPUInterpreter(spu))
+    , m_executables(0x10000)
+    , m_need_check(false)
+    , m_log_enabled(Ini.SPURecompilerLog.GetValue())
+    , m_num_compiled(0)
+    , m_compilation_time(0) {
+    InitializeNativeTarget();
+    InitializeNativeTargetAsmPrinter();
+
+    m_llvm_context = new LLVMContext();
+    m_ir_builder   = new IRBuilder<>(*m_llvm_context);
+    m_module       = new llvm::Module("Module", *m_llvm_context);
+    m_fpm          = new FunctionPassManager(m_module);
+
+    EngineBuilder engine_builder(m_module);
+    engine_builder.setMCPU(sys::getHostCPUName());
+    engine_builder.setEngineKind(EngineKind::JIT);
+    engine_builder.setOptLevel(CodeGenOpt::Default);
+    m_execution_engine = engine_builder.create();
+
+    // Registers are loaded and stored for every instruction. The passes below keep them in host registers
+    // between calls to the interpreter. The loop counter is promoted from its alloca.
+    m_fpm->add(new DataLayoutPass(m_module));
+    m_fpm->add(createNoAAPass());
+    m_fpm->add(createBasicAliasAnalysisPass());
+    m_fpm->add(createNoTargetTransformInfoPass());
+    m_fpm->add(createPromoteMemoryToRegisterPass());
+    m_fpm->add(createEarlyCSEPass());
+    m_fpm->add(createReassociatePass());
+    m_fpm->add(createInstructionCombiningPass());
+    m_fpm->add(new DominatorTreeWrapperPass());
+    m_fpm->add(new MemoryDependenceAnalysis());
+    m_fpm->add(createGVNPass());
+    m_fpm->add(createInstructionCombiningPass());
+    m_fpm->add(new MemoryDependenceAnalysis());
+    m_fpm->add(createDeadStoreEliminationPass());
+    m_fpm->add(createCFGSimplificationPass());
+    m_fpm->doInitialization();
+
+    m_interpreter_fallback = cast<Function>(m_module->getOrInsertFunction("InterpreterFallback", m_ir_builder->getVoidTy(),
+                                                                          m_ir_builder->getInt8PtrTy() /*spu_state*/,
+                                                                          m_ir_builder->getInt8PtrTy() /*interpreter*/,
+                                                                          m_ir_builder->getInt32Ty() /*pc*/,
+                                                                          m_ir_builder->getInt32Ty() /*instruction*/, nullptr));
+    m_interpreter_fallback->setCallingConv(CallingConv::C);
+    m_execution_engine->addGlobalMapping(m_interpreter_fallback, (void *)&InterpreterFallback);
+
+    // The tests need the LS of an SPU thread, so they are run by the first recompiler created in the process
+    static std::once_flag s_tests_run;
+    std::call_once(s_tests_run, [this]() { RunAllTests(); });
+}
+
+SPULLVMRecompiler::~SPULLVMRecompiler() {
+    if (m_log_enabled) {
+        std::string error;
+        raw_fd_ostream log_file(fmt::Format("SPULLVMRecompiler_%d.log", m_spu.GetId()).c_str(), error, sys::fs::F_Text);
+        log_file << "Functions compiled              = " << m_num_compiled << "\n";
+        log_file << "Time spent compiling            = " << m_compilation_time.count() / 1000000 << "ms\n";
+        log_file << "\nInterpreter fallback stats:\n";
+        for (auto i = m_interpreter_fallback_stats.begin(); i != m_interpreter_fallback_stats.end(); i++) {
+            log_file << i->first << " = " << i->second << "\n";
+        }
+    }
+
+    delete m_execution_engine;
+    delete m_fpm;
+    delete m_ir_builder;
+    delete m_llvm_context;
+    delete m_interpreter;
+}
+
+u8 SPULLVMRecompiler::DecodeMemory(const u32 address) {
+    const u32 start_pc = m_spu.PC;
+    u8 *      ls       = vm::get_ptr<u8>(m_spu.ls_offset);
+
+    if (m_need_check) {
+        CheckExecutables(ls);
+        m_need_check = false;
+    }
+
+    auto executable = m_executables[start_pc >> 2].executable;
+    if (!executable) {
+        executable = Compile(start_pc >> 2);
+    }
+
+    m_spu.SetProfState(CPU_EXEC_RECOMPILED, start_pc);
+    u32 next = executable(m_spu.GPR, ls, &m_spu, m_interpreter);
+
+    // Call the executables already compiled directly, without going back to CPUThread::Task.
+    // Breakpoints are checked by CPUThread::Task only, so executables are not chained if there are any.
+    if (Emu.GetBreakPoints().empty()) {
+        u32 num_chained = 0;
+
+        while (!(next & s_need_check_flag) && !m_spu.m_is_branch && m_spu.ThreadStatus() == CPUThread_Running) {
+            executable = m_executables[(next >> 2) & 0xffff].executable;
+            if (!executable) {
+                break;
+            }
+
+            m_spu.SetProfState(CPU_EXEC_RECOMPILED, next & 0x3fffc);
+            next = executable(m_spu.GPR, ls, &m_spu, m_interpreter);
+            num_chained++;
+        }
+
+        if (num_chained) {
+            perf::add(perf::CPU_STEPS, num_chained);
+        }
+    }
+
+    m_spu.SetProfState(CPU_EXEC_INTERPRETER, 0);
+
+    if (next & s_need_check_flag) {
+        m_need_check = true;
+        next &= ~s_need_check_flag;
+    }
+
+    // InterpreterFallback overwrites the PC
+    m_spu.PC = start_pc;
+
+    if (m_spu.m_is_branch) {
+        // The interpreter has branched. CPUThread::Task sets the PC.
+        return 0;
+    }
+
+    if (next == start_pc + 4) {
+        return 4;
+    }
+
+    m_spu.SetBranch(next);
+    return 0;
+}
+
+SPULLVMRecompiler::Executable SPULLVMRecompiler::Compile(u32 pos, u32 max_instructions) {
+    auto compilation_start = std::chrono::high_resolution_clock::now();
+
+    pos &= 0xffff;
+    if (m_executables[pos].executable) {
+        FreeExecutable(pos);
+    }
+
+    const u32 * ls     = vm::get_ptr<u32>(m_spu.ls_offset);
+    auto        gpr_ty = VectorType::get(m_ir_builder->getInt32Ty(), 4)->getPointerTo();
+
+    // Create a function for the code starting at pos
+    auto function_name = fmt::Format("fn_0x%X_%u", pos << 2, m_num_compiled);
+    m_current_function = (Function *)m_module->getOrInsertFunction(function_name, m_ir_builder->getInt32Ty(), gpr_ty /*gpr*/,
+                                                                   m_ir_builder->getInt8PtrTy() /*ls*/,
+                                                                   m_ir_builder->getInt8PtrTy() /*spu_state*/,
+                                                                   m_ir_builder->getInt8PtrTy() /*interpreter*/, nullptr);
+    m_current_function->setCallingConv(CallingConv::C);
+    auto arg_i = m_current_function->arg_begin();
+    arg_i->setName("gpr");
+    m_gpr = arg_i;
+    (++arg_i)->setName("ls");
+    m_ls = arg_i;
+    (++arg_i)->setName("spu_state");
+    m_spu_state = arg_i;
+    (++arg_i)->setName("interpreter");
+    m_interpreter_arg = arg_i;
+
+    m_current_function_blocks.clear();
+    m_current_function_exits.clear();
+    m_current_function_uncompiled_blocks_list.clear();
+    m_num_instructions = 0;
+    m_max_instructions = max_instructions;
+
+    // Add an entry block that sets up the loop counter and branches to the first instruction
+    m_ir_builder->SetInsertPoint(BasicBlock::Create(m_ir_builder->getContext(), "entry", m_current_function));
+    m_loop_count = m_ir_builder->CreateAlloca(m_ir_builder->getInt32Ty(), nullptr, "loop_count");
+    m_ir_builder->CreateStore(m_ir_builder->getInt32(s_max_loop_count), m_loop_count);
+    m_ir_builder->CreateBr(GetBlock(pos));
+
+    // Convert each block to LLVM IR. Fall-through and local branch targets are added to the function until
+    // the instruction limit is reached.
+    u32 first = pos;
+    u32 last  = pos;
+    while (!m_current_function_uncompiled_blocks_list.empty()) {
+        m_current_instruction_pos = m_current_function_uncompiled_blocks_list.front();
+        auto block                = GetBlock(m_current_instruction_pos);
+        m_hit_branch_instruction  = false;
+        m_ir_builder->SetInsertPoint(block);
+        m_current_function_uncompiled_blocks_list.pop_front();
+
+        while (!m_hit_branch_instruction) {
+            if (!block->getInstList().empty()) {
+                break;
+            }
+
+            first                 = std::min(first, m_current_instruction_pos);
+            last                  = std::max(last, m_current_instruction_pos);
+            m_current_instruction = re32(ls[m_current_instruction_pos]);
+            Decode(m_current_instruction);
+            m_num_instructions++;
+
+            if (!m_hit_branch_instruction) {
+                block = GetBlock(m_current_instruction_pos + 1);
+                m_ir_builder->CreateBr(block);
+                m_ir_builder->SetInsertPoint(block);
+                m_current_instruction_pos = (m_current_instruction_pos + 1) & 0xffff;
+            }
+        }
+    }
+
+    // Optimize and translate to machine code
+    m_fpm->run(*m_current_function);
+    MachineCodeInfo mci;
+    m_execution_engine->runJITOnFunction(m_current_function, &mci);
+
+    auto & executable_info        = m_executables[pos];
+    executable_info.executable    = (Executable)mci.address();
+    executable_info.first         = first;
+    executable_info.last          = last;
+    executable_info.code.assign(ls + first, ls + last + 1);
+    executable_info.llvm_function = m_current_function;
+    m_num_compiled++;
+
+    auto compilation_end  = std::chrono::high_resolution_clock::now();
+    m_compilation_time   += std::chrono::duration_cast<std::chrono::nanoseconds>(compilation_end - compilation_start);
+    perf::add(perf::JIT_COMPILE_US, std::chrono::duration_cast<std::chrono::microseconds>(compilation_end - compilation_start).count());
+    return executable_info.executable;
+}
+
+void SPULLVMRecompiler::CheckExecutables(const u8 * ls) {
+    for (u32 i = 0; i < 0x10000; i++) {
+        auto & executable_info = m_executables[i];
+        if (executable_info.executable &&
+            memcmp(ls + (executable_info.first << 2), executable_info.code.data(), executable_info.code.size() * sizeof(u32))) {
+            FreeExecutable(i);
+        }
+    }
+}
+
+void SPULLVMRecompiler::FreeExecutable(u32 pos) {
+    auto & executable_info = m_executables[pos];
+    m_execution_engine->freeMachineCodeForFunction(executable_info.llvm_function);
+    executable_info.llvm_function->eraseFromParent();
+    executable_info.executable    = nullptr;
+    executable_info.llvm_function = nullptr;
+    executable_info.code.clear();
+}
+
+void SPULLVMRecompiler::Decode(const u32 code) {
+    (*SPU_instr::rrr_list)(this, code);
+}
+
+BasicBlock * SPULLVMRecompiler::GetBlock(u32 pos) {
+    pos &= 0xffff;
+
+    auto i = m_current_function_blocks.find(pos);
+    if (i != m_current_function_blocks.end()) {
+        return i->second;
+    }
+
+    auto block = BasicBlock::Create(m_ir_builder->getContext(), fmt::Format("instr_0x%X", pos << 2), m_current_function);
+    m_current_function_blocks[pos] = block;
+
+    if (m_num_instructions < m_max_instructions) {
+        m_current_function_uncompiled_blocks_list.push_back(pos);
+    } else {
+        // The function is big enough. The code at pos is compiled into a function of its own.
+        auto ip = m_ir_builder->saveIP();
+        m_ir_builder->SetInsertPoint(block);
+        m_ir_builder->CreateRet(m_ir_builder->getInt32(pos << 2));
+        m_ir_builder->restoreIP(ip);
+        m_current_function_exits.insert(pos);
+    }
+
+    return block;
+}
+
+void SPULLVMRecompiler::ReturnToDispatcher(u32 next_pos, u32 flags) {
+    m_ir_builder->CreateRet(m_ir_builder->getInt32(((next_pos & 0xffff) << 2) | flags));
+    m_hit_branch_instruction = true;
+}
+
+void SPULLVMRecompiler::ReturnToDispatcher(Value * next_address) {
+    m_ir_builder->CreateRet(next_address);
+    m_hit_branch_instruction = true;
+}
+
+void SPULLVMRecompiler::BranchLocal(u32 target) {
+    target     = target & 0xffff;
+    auto block = GetBlock(target);
+
+    if (target <= m_current_instruction_pos && m_current_function_exits.find(target) == m_current_function_exits.end()) {
+        // Backward branch. Return to the dispatcher once the loop counter runs out, so that the thread can be paused.
+        auto count = m_ir_builder->CreateSub(m_ir_builder->CreateLoad(m_loop_count), m_ir_builder->getInt32(1));
+        m_ir_builder->CreateStore(count, m_loop_count);
+
+        auto exit_block = BasicBlock::Create(m_ir_builder->getContext(), "loop_exit", m_current_function);
+        m_ir_builder->CreateCondBr(m_ir_builder->CreateICmpEQ(count, m_ir_builder->getInt32(0)), exit_block, block);
+        m_ir_builder->SetInsertPoint(exit_block);
+        m_ir_builder->CreateRet(m_ir_builder->getInt32(target << 2));
+    } else {
+        m_ir_builder->CreateBr(block);
+    }
+
+    m_hit_branch_instruction = true;
+}
+
+void SPULLVMRecompiler::BranchLocalIf(Value * condition, u32 target) {
+    auto taken_block = BasicBlock::Create(m_ir_builder->getContext(), "taken", m_current_function);
+    m_ir_builder->CreateCondBr(condition, taken_block, GetBlock(m_current_instruction_pos + 1));
+    m_ir_builder->SetInsertPoint(taken_block);
+    BranchLocal(target);
+}
+
+void SPULLVMRecompiler::InterpreterCall(const char * name) {
+    auto i = m_interpreter_fallback_stats.find(name);
+    if (i == m_interpreter_fallback_stats.end()) {
+        i = m_interpreter_fallback_stats.insert(m_interpreter_fallback_stats.end(), std::make_pair<std::string, u64>(name, 0));
+    }
+
+    i->second++;
+
+    m_ir_builder->CreateCall4(m_interpreter_fallback, m_spu_state, m_interpreter_arg,
+                              m_ir_builder->getInt32(m_current_instruction_pos << 2), m_ir_builder->getInt32(m_current_instruction));
+}
+
+void SPULLVMRecompiler::InterpreterCallAndReturn(const char * name) {
+    InterpreterCall(name);
+    ReturnToDispatcher(m_current_instruction_pos + 1);
+}
+
+Value * SPULLVMRecompiler::GetGpr(u32 r) {
+    auto gpr_ptr = m_ir_builder->CreateConstGEP1_32(m_gpr, r);
+    return m_ir_builder->CreateAlignedLoad(gpr_ptr, 16);
+}
+
+Value * SPULLVMRecompiler::GetGprFloat(u32 r) {
+    return m_ir_builder->CreateBitCast(GetGpr(r), VectorType::get(m_ir_builder->getFloatTy(), 4));
+}
+
+Value * SPULLVMRecompiler::GetGprPreferredSlot(u32 r) {
+    // Words are stored in reverse order, word 0 is element 3
+    return m_ir_builder->CreateExtractElement(GetGpr(r), m_ir_builder->getInt32(3));
+}
+
+void SPULLVMRecompiler::SetGpr(u32 r, Value * value) {
+    auto gpr_ptr = m_ir_builder->CreateConstGEP1_32(m_gpr, r);
+    m_ir_builder->CreateAlignedStore(m_ir_builder->CreateBitCast(value, VectorType::get(m_ir_builder->getInt32Ty(), 4)), gpr_ptr, 16);
+}
+
+Value * SPULLVMRecompiler::GetSplat(u32 value) {
+    return ConstantVector::getSplat(4, m_ir_builder->getInt32(value));
+}
+
+Value * SPULLVMRecompiler::ReadLS128(Value * lsa) {
+    auto addr   = m_ir_builder->CreateGEP(m_ls, m_ir_builder->CreateZExt(lsa, m_ir_builder->getInt64Ty()));
+    auto ptr    = m_ir_builder->CreateBitCast(addr, m_ir_builder->getIntNTy(128)->getPointerTo());
+    auto bswap  = Intrinsic::getDeclaration(m_module, Intrinsic::bswap, m_ir_builder->getIntNTy(128));
+    auto val    = m_ir_builder->CreateCall(bswap, m_ir_builder->CreateAlignedLoad(ptr, 16));
+    return m_ir_builder->CreateBitCast(val, VectorType::get(m_ir_builder->getInt32Ty(), 4));
+}
+
+void SPULLVMRecompiler::WriteLS128(Value * lsa, Value * value) {
+    auto addr   = m_ir_builder->CreateGEP(m_ls, m_ir_builder->CreateZExt(lsa, m_ir_builder->getInt64Ty()));
+    auto ptr    = m_ir_builder->CreateBitCast(addr, m_ir_builder->getIntNTy(128)->getPointerTo());
+    auto bswap  = Intrinsic::getDeclaration(m_module, Intrinsic::bswap, m_ir_builder->getIntNTy(128));
+    auto val    = m_ir_builder->CreateCall(bswap, m_ir_builder->CreateBitCast(value, m_ir_builder->getIntNTy(128)));
+    m_ir_builder->CreateAlignedStore(val, ptr, 16);
+}
+
+void SPULLVMRecompiler::STOP(u32 code) {
+    InterpreterCallAndReturn("STOP");
+}
+
+void SPULLVMRecompiler::LNOP() {
+}
+
+void SPULLVMRecompiler::SYNC(u32 Cbit) {
+    // The instruction stream may have been modified. The executables are checked before continuing.
+    InterpreterCall("SYNC");
+    ReturnToDispatcher(m_current_instruction_pos + 1, s_need_check_flag);
+}
+
+void SPULLVMRecompiler::DSYNC() {
+    InterpreterCall("DSYNC");
+}
+
+void SPULLVMRecompiler::MFSPR(u32 rt, u32 sa) {
+    InterpreterCall("MFSPR");
+}
+
+void SPULLVMRecompiler::RDCH(u32 rt, u32 ra) {
+    InterpreterCallAndReturn("RDCH");
+}
+
+void SPULLVMRecompiler::RCHCNT(u32 rt, u32 ra) {
+    InterpreterCall("RCHCNT");
+}
+
+void SPULLVMRecompiler::SF(u32 rt, u32 ra, u32 rb) {
+    SetGpr(rt, m_ir_builder->CreateSub(GetGpr(rb), GetGpr(ra)));
+}
+
+void SPULLVMRecompiler::OR(u32 rt, u32 ra, u32 rb) {
+    SetGpr(rt, m_ir_builder->CreateOr(GetGpr(ra), GetGpr(rb)));
+}
+
+void SPULLVMRecompiler::BG(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("BG");
+}
+
+void SPULLVMRecompiler::SFH(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("SFH");
+}
+
+void SPULLVMRecompiler::NOR(u32 rt, u32 ra, u32 rb) {
+    SetGpr(rt, m_ir_builder->CreateNot(m_ir_builder->CreateOr(GetGpr(ra), GetGpr(rb))));
+}
+
+void SPULLVMRecompiler::ABSDB(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("ABSDB");
+}
+
+void SPULLVMRecompiler::ROT(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("ROT");
+}
+
+void SPULLVMRecompiler::ROTM(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("ROTM");
+}
+
+void SPULLVMRecompiler::ROTMA(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("ROTMA");
+}
+
+void SPULLVMRecompiler::SHL(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("SHL");
+}
+
+void SPULLVMRecompiler::ROTH(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("ROTH");
+}
+
+void SPULLVMRecompiler::ROTHM(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("ROTHM");
+}
+
+void SPULLVMRecompiler::ROTMAH(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("ROTMAH");
+}
+
+void SPULLVMRecompiler::SHLH(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("SHLH");
+}
+
+void SPULLVMRecompiler::ROTI(u32 rt, u32 ra, s32 i7) {
+    InterpreterCall("ROTI");
+}
+
+void SPULLVMRecompiler::ROTMI(u32 rt, u32 ra, s32 i7) {
+    const u32 n = (0 - i7) & 0x3f;
+    SetGpr(rt, n < 32 ? m_ir_builder->CreateLShr(GetGpr(ra), GetSplat(n)) : GetSplat(0));
+}
+
+void SPULLVMRecompiler::ROTMAI(u32 rt, u32 ra, s32 i7) {
+    const u32 n = (0 - i7) & 0x3f;
+    SetGpr(rt, m_ir_builder->CreateAShr(GetGpr(ra), GetSplat(n < 32 ? n : 31)));
+}
+
+void SPULLVMRecompiler::SHLI(u32 rt, u32 ra, s32 i7) {
+    const u32 s = i7 & 0x3f;
+    SetGpr(rt, s < 32 ? m_ir_builder->CreateShl(GetGpr(ra), GetSplat(s)) : GetSplat(0));
+}
+
+void SPULLVMRecompiler::ROTHI(u32 rt, u32 ra, s32 i7) {
+    InterpreterCall("ROTHI");
+}
+
+void SPULLVMRecompiler::ROTHMI(u32 rt, u32 ra, s32 i7) {
+    InterpreterCall("ROTHMI");
+}
+
+void SPULLVMRecompiler::ROTMAHI(u32 rt, u32 ra, s32 i7) {
+    InterpreterCall("ROTMAHI");
+}
+
+void SPULLVMRecompiler::SHLHI(u32 rt, u32 ra, s32 i7) {
+    InterpreterCall("SHLHI");
+}
+
+void SPULLVMRecompiler::A(u32 rt, u32 ra, u32 rb) {
+    SetGpr(rt, m_ir_builder->CreateAdd(GetGpr(ra), GetGpr(rb)));
+}
+
+void SPULLVMRecompiler::AND(u32 rt, u32 ra, u32 rb) {
+    SetGpr(rt, m_ir_builder->CreateAnd(GetGpr(ra), GetGpr(rb)));
+}
+
+void SPULLVMRecompiler::CG(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("CG");
+}
+
+void SPULLVMRecompiler::AH(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("AH");
+}
+
+void SPULLVMRecompiler::NAND(u32 rt, u32 ra, u32 rb) {
+    SetGpr(rt, m_ir_builder->CreateNot(m_ir_builder->CreateAnd(GetGpr(ra), GetGpr(rb))));
+}
+
+void SPULLVMRecompiler::AVGB(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("AVGB");
+}
+
+void SPULLVMRecompiler::MTSPR(u32 rt, u32 sa) {
+    InterpreterCall("MTSPR");
+}
+
+void SPULLVMRecompiler::WRCH(u32 ra, u32 rt) {
+    InterpreterCallAndReturn("WRCH");
+}
+
+void SPULLVMRecompiler::BIZ(u32 intr, u32 rt, u32 ra) {
+    InterpreterCallAndReturn("BIZ");
+}
+
+void SPULLVMRecompiler::BINZ(u32 intr, u32 rt, u32 ra) {
+    InterpreterCallAndReturn("BINZ");
+}
+
+void SPULLVMRecompiler::BIHZ(u32 intr, u32 rt, u32 ra) {
+    InterpreterCallAndReturn("BIHZ");
+}
+
+void SPULLVMRecompiler::BIHNZ(u32 intr, u32 rt, u32 ra) {
+    InterpreterCallAndReturn("BIHNZ");
+}
+
+void SPULLVMRecompiler::STOPD(u32 rc, u32 ra, u32 rb) {
+    InterpreterCallAndReturn("STOPD");
+}
+
+void SPULLVMRecompiler::STQX(u32 rt, u32 ra, u32 rb) {
+    auto lsa = m_ir_builder->CreateAdd(GetGprPreferredSlot(ra), GetGprPreferredSlot(rb));
+    WriteLS128(m_ir_builder->CreateAnd(lsa, 0x3fff0), GetGpr(rt));
+}
+
+void SPULLVMRecompiler::BI(u32 intr, u32 ra) {
+    switch (intr) {
+    case 0:
+    case 0x10:
+    case 0x20:
+        // Enabling or disabling interrupts is ignored, like the interpreter does
+        ReturnToDispatcher(m_ir_builder->CreateAnd(GetGprPreferredSlot(ra), 0x3fffc));
+        break;
+
+    default:
+        InterpreterCallAndReturn("BI");
+        break;
+    }
+}
+
+void SPULLVMRecompiler::BISL(u32 intr, u32 rt, u32 ra) {
+    InterpreterCallAndReturn("BISL");
+}
+
+void SPULLVMRecompiler::IRET(u32 ra) {
+    InterpreterCallAndReturn("IRET");
+}
+
+void SPULLVMRecompiler::BISLED(u32 intr, u32 rt, u32 ra) {
+    InterpreterCallAndReturn("BISLED");
+}
+
+void SPULLVMRecompiler::HBR(u32 p, u32 ro, u32 ra) {
+}
+
+void SPULLVMRecompiler::GB(u32 rt, u32 ra) {
+    InterpreterCall("GB");
+}
+
+void SPULLVMRecompiler::GBH(u32 rt, u32 ra) {
+    InterpreterCall("GBH");
+}
+
+void SPULLVMRecompiler::GBB(u32 rt, u32 ra) {
+    InterpreterCall("GBB");
+}
+
+void SPULLVMRecompiler::FSM(u32 rt, u32 ra) {
+    InterpreterCall("FSM");
+}
+
+void SPULLVMRecompiler::FSMH(u32 rt, u32 ra) {
+    InterpreterCall("FSMH");
+}
+
+void SPULLVMRecompiler::FSMB(u32 rt, u32 ra) {
+    InterpreterCall("FSMB");
+}
+
+void SPULLVMRecompiler::FREST(u32 rt, u32 ra) {
+    InterpreterCall("FREST");
+}
+
+void SPULLVMRecompiler::FRSQEST(u32 rt, u32 ra) {
+    InterpreterCall("FRSQEST");
+}
+
+void SPULLVMRecompiler::LQX(u32 rt, u32 ra, u32 rb) {
+    auto lsa = m_ir_builder->CreateAdd(GetGprPreferredSlot(ra), GetGprPreferredSlot(rb));
+    SetGpr(rt, ReadLS128(m_ir_builder->CreateAnd(lsa, 0x3fff0)));
+}
+
+void SPULLVMRecompiler::ROTQBYBI(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("ROTQBYBI");
+}
+
+void SPULLVMRecompiler::ROTQMBYBI(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("ROTQMBYBI");
+}
+
+void SPULLVMRecompiler::SHLQBYBI(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("SHLQBYBI");
+}
+
+void SPULLVMRecompiler::CBX(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("CBX");
+}
+
+void SPULLVMRecompiler::CHX(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("CHX");
+}
+
+void SPULLVMRecompiler::CWX(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("CWX");
+}
+
+void SPULLVMRecompiler::CDX(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("CDX");
+}
+
+void SPULLVMRecompiler::ROTQBI(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("ROTQBI");
+}
+
+void SPULLVMRecompiler::ROTQMBI(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("ROTQMBI");
+}
+
+void SPULLVMRecompiler::SHLQBI(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("SHLQBI");
+}
+
+void SPULLVMRecompiler::ROTQBY(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("ROTQBY");
+}
+
+void SPULLVMRecompiler::ROTQMBY(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("ROTQMBY");
+}
+
+void SPULLVMRecompiler::SHLQBY(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("SHLQBY");
+}
+
+void SPULLVMRecompiler::ORX(u32 rt, u32 ra) {
+    InterpreterCall("ORX");
+}
+
+void SPULLVMRecompiler::CBD(u32 rt, u32 ra, s32 i7) {
+    InterpreterCall("CBD");
+}
+
+void SPULLVMRecompiler::CHD(u32 rt, u32 ra, s32 i7) {
+    InterpreterCall("CHD");
+}
+
+void SPULLVMRecompiler::CWD(u32 rt, u32 ra, s32 i7) {
+    InterpreterCall("CWD");
+}
+
+void SPULLVMRecompiler::CDD(u32 rt, u32 ra, s32 i7) {
+    InterpreterCall("CDD");
+}
+
+void SPULLVMRecompiler::ROTQBII(u32 rt, u32 ra, s32 i7) {
+    InterpreterCall("ROTQBII");
+}
+
+void SPULLVMRecompiler::ROTQMBII(u32 rt, u32 ra, s32 i7) {
+    InterpreterCall("ROTQMBII");
+}
+
+void SPULLVMRecompiler::SHLQBII(u32 rt, u32 ra, s32 i7) {
+    InterpreterCall("SHLQBII");
+}
+
+void SPULLVMRecompiler::ROTQBYI(u32 rt, u32 ra, s32 i7) {
+    InterpreterCall("ROTQBYI");
+}
+
+void SPULLVMRecompiler::ROTQMBYI(u32 rt, u32 ra, s32 i7) {
+    InterpreterCall("ROTQMBYI");
+}
+
+void SPULLVMRecompiler::SHLQBYI(u32 rt, u32 ra, s32 i7) {
+    InterpreterCall("SHLQBYI");
+}
+
+void SPULLVMRecompiler::NOP(u32 rt) {
+}
+
+void SPULLVMRecompiler::CGT(u32 rt, u32 ra, u32 rb) {
+    SetGpr(rt, m_ir_builder->CreateSExt(m_ir_builder->CreateICmpSGT(GetGpr(ra), GetGpr(rb)), GetGpr(ra)->getType()));
+}
+
+void SPULLVMRecompiler::XOR(u32 rt, u32 ra, u32 rb) {
+    SetGpr(rt, m_ir_builder->CreateXor(GetGpr(ra), GetGpr(rb)));
+}
+
+void SPULLVMRecompiler::CGTH(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("CGTH");
+}
+
+void SPULLVMRecompiler::EQV(u32 rt, u32 ra, u32 rb) {
+    SetGpr(rt, m_ir_builder->CreateNot(m_ir_builder->CreateXor(GetGpr(ra), GetGpr(rb))));
+}
+
+void SPULLVMRecompiler::CGTB(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("CGTB");
+}
+
+void SPULLVMRecompiler::SUMB(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("SUMB");
+}
+
+void SPULLVMRecompiler::HGT(u32 rt, s32 ra, s32 rb) {
+    InterpreterCallAndReturn("HGT");
+}
+
+void SPULLVMRecompiler::CLZ(u32 rt, u32 ra) {
+    InterpreterCall("CLZ");
+}
+
+void SPULLVMRecompiler::XSWD(u32 rt, u32 ra) {
+    InterpreterCall("XSWD");
+}
+
+void SPULLVMRecompiler::XSHW(u32 rt, u32 ra) {
+    InterpreterCall("XSHW");
+}
+
+void SPULLVMRecompiler::CNTB(u32 rt, u32 ra) {
+    InterpreterCall("CNTB");
+}
+
+void SPULLVMRecompiler::XSBH(u32 rt, u32 ra) {
+    InterpreterCall("XSBH");
+}
+
+void SPULLVMRecompiler::CLGT(u32 rt, u32 ra, u32 rb) {
+    SetGpr(rt, m_ir_builder->CreateSExt(m_ir_builder->CreateICmpUGT(GetGpr(ra), GetGpr(rb)), GetGpr(ra)->getType()));
+}
+
+void SPULLVMRecompiler::ANDC(u32 rt, u32 ra, u32 rb) {
+    SetGpr(rt, m_ir_builder->CreateAnd(GetGpr(ra), m_ir_builder->CreateNot(GetGpr(rb))));
+}
+
+void SPULLVMRecompiler::FCGT(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("FCGT");
+}
+
+void SPULLVMRecompiler::DFCGT(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("DFCGT");
+}
+
+void SPULLVMRecompiler::FA(u32 rt, u32 ra, u32 rb) {
+    SetGpr(rt, m_ir_builder->CreateFAdd(GetGprFloat(ra), GetGprFloat(rb)));
+}
+
+void SPULLVMRecompiler::FS(u32 rt, u32 ra, u32 rb) {
+    SetGpr(rt, m_ir_builder->CreateFSub(GetGprFloat(ra), GetGprFloat(rb)));
+}
+
+void SPULLVMRecompiler::FM(u32 rt, u32 ra, u32 rb) {
+    SetGpr(rt, m_ir_builder->CreateFMul(GetGprFloat(ra), GetGprFloat(rb)));
+}
+
+void SPULLVMRecompiler::CLGTH(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("CLGTH");
+}
+
+void SPULLVMRecompiler::ORC(u32 rt, u32 ra, u32 rb) {
+    SetGpr(rt, m_ir_builder->CreateOr(GetGpr(ra), m_ir_builder->CreateNot(GetGpr(rb))));
+}
+
+void SPULLVMRecompiler::FCMGT(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("FCMGT");
+}
+
+void SPULLVMRecompiler::DFCMGT(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("DFCMGT");
+}
+
+void SPULLVMRecompiler::DFA(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("DFA");
+}
+
+void SPULLVMRecompiler::DFS(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("DFS");
+}
+
+void SPULLVMRecompiler::DFM(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("DFM");
+}
+
+void SPULLVMRecompiler::CLGTB(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("CLGTB");
+}
+
+void SPULLVMRecompiler::HLGT(u32 rt, u32 ra, u32 rb) {
+    InterpreterCallAndReturn("HLGT");
+}
+
+void SPULLVMRecompiler::DFMA(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("DFMA");
+}
+
+void SPULLVMRecompiler::DFMS(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("DFMS");
+}
+
+void SPULLVMRecompiler::DFNMS(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("DFNMS");
+}
+
+void SPULLVMRecompiler::DFNMA(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("DFNMA");
+}
+
+void SPULLVMRecompiler::CEQ(u32 rt, u32 ra, u32 rb) {
+    SetGpr(rt, m_ir_builder->CreateSExt(m_ir_builder->CreateICmpEQ(GetGpr(ra), GetGpr(rb)), GetGpr(ra)->getType()));
+}
+
+void SPULLVMRecompiler::MPYHHU(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("MPYHHU");
+}
+
+void SPULLVMRecompiler::ADDX(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("ADDX");
+}
+
+void SPULLVMRecompiler::SFX(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("SFX");
+}
+
+void SPULLVMRecompiler::CGX(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("CGX");
+}
+
+void SPULLVMRecompiler::BGX(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("BGX");
+}
+
+void SPULLVMRecompiler::MPYHHA(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("MPYHHA");
+}
+
+void SPULLVMRecompiler::MPYHHAU(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("MPYHHAU");
+}
+
+void SPULLVMRecompiler::FSCRRD(u32 rt) {
+    InterpreterCall("FSCRRD");
+}
+
+void SPULLVMRecompiler::FESD(u32 rt, u32 ra) {
+    InterpreterCall("FESD");
+}
+
+void SPULLVMRecompiler::FRDS(u32 rt, u32 ra) {
+    InterpreterCall("FRDS");
+}
+
+void SPULLVMRecompiler::FSCRWR(u32 rt, u32 ra) {
+    InterpreterCall("FSCRWR");
+}
+
+void SPULLVMRecompiler::DFTSV(u32 rt, u32 ra, s32 i7) {
+    InterpreterCall("DFTSV");
+}
+
+void SPULLVMRecompiler::FCEQ(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("FCEQ");
+}
+
+void SPULLVMRecompiler::DFCEQ(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("DFCEQ");
+}
+
+void SPULLVMRecompiler::MPY(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("MPY");
+}
+
+void SPULLVMRecompiler::MPYH(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("MPYH");
+}
+
+void SPULLVMRecompiler::MPYHH(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("MPYHH");
+}
+
+void SPULLVMRecompiler::MPYS(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("MPYS");
+}
+
+void SPULLVMRecompiler::CEQH(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("CEQH");
+}
+
+void SPULLVMRecompiler::FCMEQ(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("FCMEQ");
+}
+
+void SPULLVMRecompiler::DFCMEQ(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("DFCMEQ");
+}
+
+void SPULLVMRecompiler::MPYU(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("MPYU");
+}
+
+void SPULLVMRecompiler::CEQB(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("CEQB");
+}
+
+void SPULLVMRecompiler::FI(u32 rt, u32 ra, u32 rb) {
+    InterpreterCall("FI");
+}
+
+void SPULLVMRecompiler::HEQ(u32 rt, u32 ra, u32 rb) {
+    InterpreterCallAndReturn("HEQ");
+}
+
+void SPULLVMRecompiler::CFLTS(u32 rt, u32 ra, s32 i8) {
+    InterpreterCall("CFLTS");
+}
+
+void SPULLVMRecompiler::CFLTU(u32 rt, u32 ra, s32 i8) {
+    InterpreterCall("CFLTU");
+}
+
+void SPULLVMRecompiler::CSFLT(u32 rt, u32 ra, s32 i8) {
+    InterpreterCall("CSFLT");
+}
+
+void SPULLVMRecompiler::CUFLT(u32 rt, u32 ra, s32 i8) {
+    InterpreterCall("CUFLT");
+}
+
+void SPULLVMRecompiler::BRZ(u32 rt, s32 i16) {
+    BranchLocalIf(m_ir_builder->CreateICmpEQ(GetGprPreferredSlot(rt), m_ir_builder->getInt32(0)),
+                  branchTarget(m_current_instruction_pos << 2, i16) >> 2);
+}
+
+void SPULLVMRecompiler::STQA(u32 rt, s32 i16) {
+    WriteLS128(m_ir_builder->getInt32((i16 << 2) & 0x3fff0), GetGpr(rt));
+}
+
+void SPULLVMRecompiler::BRNZ(u32 rt, s32 i16) {
+    BranchLocalIf(m_ir_builder->CreateICmpNE(GetGprPreferredSlot(rt), m_ir_builder->getInt32(0)),
+                  branchTarget(m_current_instruction_pos << 2, i16) >> 2);
+}
+
+void SPULLVMRecompiler::BRHZ(u32 rt, s32 i16) {
+    auto halfword = m_ir_builder->CreateTrunc(GetGprPreferredSlot(rt), m_ir_builder->getInt16Ty());
+    BranchLocalIf(m_ir_builder->CreateICmpEQ(halfword, m_ir_builder->getInt16(0)),
+                  branchTarget(m_current_instruction_pos << 2, i16) >> 2);
+}
+
+void SPULLVMRecompiler::BRHNZ(u32 rt, s32 i16) {
+    auto halfword = m_ir_builder->CreateTrunc(GetGprPreferredSlot(rt), m_ir_builder->getInt16Ty());
+    BranchLocalIf(m_ir_builder->CreateICmpNE(halfword, m_ir_builder->getInt16(0)),
+                  branchTarget(m_current_instruction_pos << 2, i16) >> 2);
+}
+
+void SPULLVMRecompiler::STQR(u32 rt, s32 i16) {
+    const u32 lsa = branchTarget(m_current_instruction_pos << 2, i16) & 0x3fff0;
+    WriteLS128(m_ir_builder->getInt32(lsa), GetGpr(rt));
+}
+
+void SPULLVMRecompiler::BRA(s32 i16) {
+    BranchLocal(branchTarget(0, i16) >> 2);
+}
+
+void SPULLVMRecompiler::LQA(u32 rt, s32 i16) {
+    SetGpr(rt, ReadLS128(m_ir_builder->getInt32((i16 << 2) & 0x3fff0)));
+}
+
+void SPULLVMRecompiler::BRASL(u32 rt, s32 i16) {
+    // Calls return to the dispatcher, the callee is a function of its own
+    const u32 link = (m_current_instruction_pos + 1) << 2;
+    SetGpr(rt, ConstantVector::get(std::vector<Constant *>{m_ir_builder->getInt32(0), m_ir_builder->getInt32(0), m_ir_builder->getInt32(0), m_ir_builder->getInt32(link)}));
+    ReturnToDispatcher(branchTarget(0, i16) >> 2);
+}
+
+void SPULLVMRecompiler::BR(s32 i16) {
+    BranchLocal(branchTarget(m_current_instruction_pos << 2, i16) >> 2);
+}
+
+void SPULLVMRecompiler::FSMBI(u32 rt, s32 i16) {
+    InterpreterCall("FSMBI");
+}
+
+void SPULLVMRecompiler::BRSL(u32 rt, s32 i16) {
+    // Calls return to the dispatcher, the callee is a function of its own
+    const u32 link = (m_current_instruction_pos + 1) << 2;
+    SetGpr(rt, ConstantVector::get(std::vector<Constant *>{m_ir_builder->getInt32(0), m_ir_builder->getInt32(0), m_ir_builder->getInt32(0), m_ir_builder->getInt32(link)}));
+    ReturnToDispatcher(branchTarget(m_current_instruction_pos << 2, i16) >> 2);
+}
+
+void SPULLVMRecompiler::LQR(u32 rt, s32 i16) {
+    const u32 lsa = branchTarget(m_current_instruction_pos << 2, i16) & 0x3fff0;
+    SetGpr(rt, ReadLS128(m_ir_builder->getInt32(lsa)));
+}
+
+void SPULLVMRecompiler::IL(u32 rt, s32 i16) {
+    SetGpr(rt, GetSplat(i16));
+}
+
+void SPULLVMRecompiler::ILHU(u32 rt, s32 i16) {
+    SetGpr(rt, GetSplat(i16 << 16));
+}
+
+void SPULLVMRecompiler::ILH(u32 rt, s32 i16) {
+    SetGpr(rt, GetSplat((i16 & 0xffff) * 0x10001));
+}
+
+void SPULLVMRecompiler::IOHL(u32 rt, s32 i16) {
+    SetGpr(rt, m_ir_builder->CreateOr(GetGpr(rt), GetSplat(i16 & 0xffff)));
+}
+
+void SPULLVMRecompiler::ORI(u32 rt, u32 ra, s32 i10) {
+    SetGpr(rt, m_ir_builder->CreateOr(GetGpr(ra), GetSplat(i10)));
+}
+
+void SPULLVMRecompiler::ORHI(u32 rt, u32 ra, s32 i10) {
+    InterpreterCall("ORHI");
+}
+
+void SPULLVMRecompiler::ORBI(u32 rt, u32 ra, s32 i10) {
+    InterpreterCall("ORBI");
+}
+
+void SPULLVMRecompiler::SFI(u32 rt, u32 ra, s32 i10) {
+    SetGpr(rt, m_ir_builder->CreateSub(GetSplat(i10), GetGpr(ra)));
+}
+
+void SPULLVMRecompiler::SFHI(u32 rt, u32 ra, s32 i10) {
+    InterpreterCall("SFHI");
+}
+
+void SPULLVMRecompiler::ANDI(u32 rt, u32 ra, s32 i10) {
+    SetGpr(rt, m_ir_builder->CreateAnd(GetGpr(ra), GetSplat(i10)));
+}
+
+void SPULLVMRecompiler::ANDHI(u32 rt, u32 ra, s32 i10) {
+    InterpreterCall("ANDHI");
+}
+
+void SPULLVMRecompiler::ANDBI(u32 rt, u32 ra, s32 i10) {
+    InterpreterCall("ANDBI");
+}
+
+void SPULLVMRecompiler::AI(u32 rt, u32 ra, s32 i10) {
+    SetGpr(rt, m_ir_builder->CreateAdd(GetGpr(ra), GetSplat(i10)));
+}
+
+void SPULLVMRecompiler::AHI(u32 rt, u32 ra, s32 i10) {
+    InterpreterCall("AHI");
+}
+
+void SPULLVMRecompiler::STQD(u32 rt, s32 i10, u32 ra) {
+    auto lsa = m_ir_builder->CreateAdd(GetGprPreferredSlot(ra), m_ir_builder->getInt32(i10));
+    WriteLS128(m_ir_builder->CreateAnd(lsa, 0x3fff0), GetGpr(rt));
+}
+
+void SPULLVMRecompiler::LQD(u32 rt, s32 i10, u32 ra) {
+    auto lsa = m_ir_builder->CreateAdd(GetGprPreferredSlot(ra), m_ir_builder->getInt32(i10));
+    SetGpr(rt, ReadLS128(m_ir_builder->CreateAnd(lsa, 0x3fff0)));
+}
+
+void SPULLVMRecompiler::XORI(u32 rt, u32 ra, s32 i10) {
+    SetGpr(rt, m_ir_builder->CreateXor(GetGpr(ra), GetSplat(i10)));
+}
+
+void SPULLVMRecompiler::XORHI(u32 rt, u32 ra, s32 i10) {
+    InterpreterCall("XORHI");
+}
+
+void SPULLVMRecompiler::XORBI(u32 rt, u32 ra, s32 i10) {
+    InterpreterCall("XORBI");
+}
+
+void SPULLVMRecompiler::CGTI(u32 rt, u32 ra, s32 i10) {
+    SetGpr(rt, m_ir_builder->CreateSExt(m_ir_builder->CreateICmpSGT(GetGpr(ra), GetSplat(i10)), GetGpr(ra)->getType()));
+}
+
+void SPULLVMRecompiler::CGTHI(u32 rt, u32 ra, s32 i10) {
+    InterpreterCall("CGTHI");
+}
+
+void SPULLVMRecompiler::CGTBI(u32 rt, u32 ra, s32 i10) {
+    InterpreterCall("CGTBI");
+}
+
+void SPULLVMRecompiler::HGTI(u32 rt, u32 ra, s32 i10) {
+    InterpreterCallAndReturn("HGTI");
+}
+
+void SPULLVMRecompiler::CLGTI(u32 rt, u32 ra, s32 i10) {
+    SetGpr(rt, m_ir_builder->CreateSExt(m_ir_builder->CreateICmpUGT(GetGpr(ra), GetSplat(i10)), GetGpr(ra)->getType()));
+}
+
+void SPULLVMRecompiler::CLGTHI(u32 rt, u32 ra, s32 i10) {
+    InterpreterCall("CLGTHI");
+}
+
+void SPULLVMRecompiler::CLGTBI(u32 rt, u32 ra, s32 i10) {
+    InterpreterCall("CLGTBI");
+}
+
+void SPULLVMRecompiler::HLGTI(u32 rt, u32 ra, s32 i10) {
+    InterpreterCallAndReturn("HLGTI");
+}
+
+void SPULLVMRecompiler::MPYI(u32 rt, u32 ra, s32 i10) {
+    InterpreterCall("MPYI");
+}
+
+void SPULLVMRecompiler::MPYUI(u32 rt, u32 ra, s32 i10) {
+    InterpreterCall("MPYUI");
+}
+
+void SPULLVMRecompiler::CEQI(u32 rt, u32 ra, s32 i10) {
+    SetGpr(rt, m_ir_builder->CreateSExt(m_ir_builder->CreateICmpEQ(GetGpr(ra), GetSplat(i10)), GetGpr(ra)->getType()));
+}
+
+void SPULLVMRecompiler::CEQHI(u32 rt, u32 ra, s32 i10) {
+    InterpreterCall("CEQHI");
+}
+
+void SPULLVMRecompiler::CEQBI(u32 rt, u32 ra, s32 i10) {
+    InterpreterCall("CEQBI");
+}
+
+void SPULLVMRecompiler::HEQI(u32 rt, u32 ra, s32 i10) {
+    InterpreterCallAndReturn("HEQI");
+}
+
+void SPULLVMRecompiler::HBRA(s32 ro, s32 i16) {
+}
+
+void SPULLVMRecompiler::HBRR(s32 ro, s32 i16) {
+}
+
+void SPULLVMRecompiler::ILA(u32 rt, u32 i18) {
+    SetGpr(rt, GetSplat(i18 & 0x3ffff));
+}
+
+void SPULLVMRecompiler::SELB(u32 rt, u32 ra, u32 rb, u32 rc) {
+    auto mask = GetGpr(rc);
+    auto res  = m_ir_builder->CreateOr(m_ir_builder->CreateAnd(mask, GetGpr(rb)), m_ir_builder->CreateAnd(m_ir_builder->CreateNot(mask), GetGpr(ra)));
+    SetGpr(rt, res);
+}
+
+void SPULLVMRecompiler::SHUFB(u32 rt, u32 ra, u32 rb, u32 rc) {
+    InterpreterCall("SHUFB");
+}
+
+void SPULLVMRecompiler::MPYA(u32 rt, u32 ra, u32 rb, u32 rc) {
+    InterpreterCall("MPYA");
+}
+
+void SPULLVMRecompiler::FNMS(u32 rt, u32 ra, u32 rb, u32 rc) {
+    SetGpr(rt, m_ir_builder->CreateFSub(GetGprFloat(rc), m_ir_builder->CreateFMul(GetGprFloat(ra), GetGprFloat(rb))));
+}
+
+void SPULLVMRecompiler::FMA(u32 rt, u32 ra, u32 rb, u32 rc) {
+    SetGpr(rt, m_ir_builder->CreateFAdd(GetGprFloat(rc), m_ir_builder->CreateFMul(GetGprFloat(ra), GetGprFloat(rb))));
+}
+
+void SPULLVMRecompiler::FMS(u32 rt, u32 ra, u32 rb, u32 rc) {
+    SetGpr(rt, m_ir_builder->CreateFSub(m_ir_builder->CreateFMul(GetGprFloat(ra), GetGprFloat(rb)), GetGprFloat(rc)));
+}
+
+void SPULLVMRecompiler::UNK(u32 code, u32 opcode, u32 gcode) {
+    InterpreterCallAndReturn("UNK");
+}
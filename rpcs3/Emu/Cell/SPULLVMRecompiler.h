@@ -0,0 +1,415 @@
+#ifndef SPU_LLVM_RECOMPILER_H
+#define SPU_LLVM_RECOMPILER_H
+
+#ifdef LLVM_AVAILABLE
+#define SPU_LLVM_RECOMPILER 1
+
+#include "Emu/CPU/CPUDecoder.h"
+#include "Emu/Cell/SPUOpcodes.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Module.h"
+#include "llvm/ExecutionEngine/JIT.h"
+#include "llvm/PassManager.h"
+
+#include <map>
+#include <list>
+
+class SPUThread;
+class SPUInterpreter;
+
+/// SPU recompiler that uses LLVM for code generation and optimization. Each SPU thread has its own instance.
+/// Instructions that are not converted to LLVM IR are executed by calling the interpreter.
+class SPULLVMRecompiler : public CPUDecoder, protected SPUOpcodes {
+public:
+    /// Executes the function. Returns the LS address of the next instruction to execute, optionally ORed with s_need_check_flag.
+    typedef u32(*Executable)(u128 * gpr, u8 * ls, SPUThread * spu_state, SPUInterpreter * interpreter);
+
+    /// Set in the value returned by an executable after SYNC. The compiled code must be checked against LS.
+    static const u32 s_need_check_flag = 0x80000000;
+
+    /// Maximum number of instructions compiled into a function
+    static const u32 s_max_function_size = 0x1000;
+
+    /// Number of backward branches taken by a function before it returns
+    static const u32 s_max_loop_count = 0x400;
+
+    SPULLVMRecompiler(SPUThread & spu);
+    SPULLVMRecompiler() = delete;
+
+    SPULLVMRecompiler(const SPULLVMRecompiler & other) = delete;
+    SPULLVMRecompiler(SPULLVMRecompiler && other) = delete;
+
+    virtual ~SPULLVMRecompiler();
+
+    SPULLVMRecompiler & operator = (const SPULLVMRecompiler & other) = delete;
+    SPULLVMRecompiler & operator = (SPULLVMRecompiler && other) = delete;
+
+    u8 DecodeMemory(const u32 address) override;
+
+    /// Compile the function starting at the instruction index pos. At most max_instructions instructions are compiled.
+    Executable Compile(u32 pos, u32 max_instructions = s_max_function_size);
+
+    /// Execute all tests
+    void RunAllTests();
+
+protected:
+    void Decode(const u32 code);
+
+    //0 - 10
+    void STOP(u32 code) override;
+    void LNOP() override;
+    void SYNC(u32 Cbit) override;
+    void DSYNC() override;
+    void MFSPR(u32 rt, u32 sa) override;
+    void RDCH(u32 rt, u32 ra) override;
+    void RCHCNT(u32 rt, u32 ra) override;
+    void SF(u32 rt, u32 ra, u32 rb) override;
+    void OR(u32 rt, u32 ra, u32 rb) override;
+    void BG(u32 rt, u32 ra, u32 rb) override;
+    void SFH(u32 rt, u32 ra, u32 rb) override;
+    void NOR(u32 rt, u32 ra, u32 rb) override;
+    void ABSDB(u32 rt, u32 ra, u32 rb) override;
+    void ROT(u32 rt, u32 ra, u32 rb) override;
+    void ROTM(u32 rt, u32 ra, u32 rb) override;
+    void ROTMA(u32 rt, u32 ra, u32 rb) override;
+    void SHL(u32 rt, u32 ra, u32 rb) override;
+    void ROTH(u32 rt, u32 ra, u32 rb) override;
+    void ROTHM(u32 rt, u32 ra, u32 rb) override;
+    void ROTMAH(u32 rt, u32 ra, u32 rb) override;
+    void SHLH(u32 rt, u32 ra, u32 rb) override;
+    void ROTI(u32 rt, u32 ra, s32 i7) override;
+    void ROTMI(u32 rt, u32 ra, s32 i7) override;
+    void ROTMAI(u32 rt, u32 ra, s32 i7) override;
+    void SHLI(u32 rt, u32 ra, s32 i7) override;
+    void ROTHI(u32 rt, u32 ra, s32 i7) override;
+    void ROTHMI(u32 rt, u32 ra, s32 i7) override;
+    void ROTMAHI(u32 rt, u32 ra, s32 i7) override;
+    void SHLHI(u32 rt, u32 ra, s32 i7) override;
+    void A(u32 rt, u32 ra, u32 rb) override;
+    void AND(u32 rt, u32 ra, u32 rb) override;
+    void CG(u32 rt, u32 ra, u32 rb) override;
+    void AH(u32 rt, u32 ra, u32 rb) override;
+    void NAND(u32 rt, u32 ra, u32 rb) override;
+    void AVGB(u32 rt, u32 ra, u32 rb) override;
+    void MTSPR(u32 rt, u32 sa) override;
+    void WRCH(u32 ra, u32 rt) override;
+    void BIZ(u32 intr, u32 rt, u32 ra) override;
+    void BINZ(u32 intr, u32 rt, u32 ra) override;
+    void BIHZ(u32 intr, u32 rt, u32 ra) override;
+    void BIHNZ(u32 intr, u32 rt, u32 ra) override;
+    void STOPD(u32 rc, u32 ra, u32 rb) override;
+    void STQX(u32 rt, u32 ra, u32 rb) override;
+    void BI(u32 intr, u32 ra) override;
+    void BISL(u32 intr, u32 rt, u32 ra) override;
+    void IRET(u32 ra) override;
+    void BISLED(u32 intr, u32 rt, u32 ra) override;
+    void HBR(u32 p, u32 ro, u32 ra) override;
+    void GB(u32 rt, u32 ra) override;
+    void GBH(u32 rt, u32 ra) override;
+    void GBB(u32 rt, u32 ra) override;
+    void FSM(u32 rt, u32 ra) override;
+    void FSMH(u32 rt, u32 ra) override;
+    void FSMB(u32 rt, u32 ra) override;
+    void FREST(u32 rt, u32 ra) override;
+    void FRSQEST(u32 rt, u32 ra) override;
+    void LQX(u32 rt, u32 ra, u32 rb) override;
+    void ROTQBYBI(u32 rt, u32 ra, u32 rb) override;
+    void ROTQMBYBI(u32 rt, u32 ra, u32 rb) override;
+    void SHLQBYBI(u32 rt, u32 ra, u32 rb) override;
+    void CBX(u32 rt, u32 ra, u32 rb) override;
+    void CHX(u32 rt, u32 ra, u32 rb) override;
+    void CWX(u32 rt, u32 ra, u32 rb) override;
+    void CDX(u32 rt, u32 ra, u32 rb) override;
+    void ROTQBI(u32 rt, u32 ra, u32 rb) override;
+    void ROTQMBI(u32 rt, u32 ra, u32 rb) override;
+    void SHLQBI(u32 rt, u32 ra, u32 rb) override;
+    void ROTQBY(u32 rt, u32 ra, u32 rb) override;
+    void ROTQMBY(u32 rt, u32 ra, u32 rb) override;
+    void SHLQBY(u32 rt, u32 ra, u32 rb) override;
+    void ORX(u32 rt, u32 ra) override;
+    void CBD(u32 rt, u32 ra, s32 i7) override;
+    void CHD(u32 rt, u32 ra, s32 i7) override;
+    void CWD(u32 rt, u32 ra, s32 i7) override;
+    void CDD(u32 rt, u32 ra, s32 i7) override;
+    void ROTQBII(u32 rt, u32 ra, s32 i7) override;
+    void ROTQMBII(u32 rt, u32 ra, s32 i7) override;
+    void SHLQBII(u32 rt, u32 ra, s32 i7) override;
+    void ROTQBYI(u32 rt, u32 ra, s32 i7) override;
+    void ROTQMBYI(u32 rt, u32 ra, s32 i7) override;
+    void SHLQBYI(u32 rt, u32 ra, s32 i7) override;
+    void NOP(u32 rt) override;
+    void CGT(u32 rt, u32 ra, u32 rb) override;
+    void XOR(u32 rt, u32 ra, u32 rb) override;
+    void CGTH(u32 rt, u32 ra, u32 rb) override;
+    void EQV(u32 rt, u32 ra, u32 rb) override;
+    void CGTB(u32 rt, u32 ra, u32 rb) override;
+    void SUMB(u32 rt, u32 ra, u32 rb) override;
+    void HGT(u32 rt, s32 ra, s32 rb) override;
+    void CLZ(u32 rt, u32 ra) override;
+    void XSWD(u32 rt, u32 ra) override;
+    void XSHW(u32 rt, u32 ra) override;
+    void CNTB(u32 rt, u32 ra) override;
+    void XSBH(u32 rt, u32 ra) override;
+    void CLGT(u32 rt, u32 ra, u32 rb) override;
+    void ANDC(u32 rt, u32 ra, u32 rb) override;
+    void FCGT(u32 rt, u32 ra, u32 rb) override;
+    void DFCGT(u32 rt, u32 ra, u32 rb) override;
+    void FA(u32 rt, u32 ra, u32 rb) override;
+    void FS(u32 rt, u32 ra, u32 rb) override;
+    void FM(u32 rt, u32 ra, u32 rb) override;
+    void CLGTH(u32 rt, u32 ra, u32 rb) override;
+    void ORC(u32 rt, u32 ra, u32 rb) override;
+    void FCMGT(u32 rt, u32 ra, u32 rb) override;
+    void DFCMGT(u32 rt, u32 ra, u32 rb) override;
+    void DFA(u32 rt, u32 ra, u32 rb) override;
+    void DFS(u32 rt, u32 ra, u32 rb) override;
+    void DFM(u32 rt, u32 ra, u32 rb) override;
+    void CLGTB(u32 rt, u32 ra, u32 rb) override;
+    void HLGT(u32 rt, u32 ra, u32 rb) override;
+    void DFMA(u32 rt, u32 ra, u32 rb) override;
+    void DFMS(u32 rt, u32 ra, u32 rb) override;
+    void DFNMS(u32 rt, u32 ra, u32 rb) override;
+    void DFNMA(u32 rt, u32 ra, u32 rb) override;
+    void CEQ(u32 rt, u32 ra, u32 rb) override;
+    void MPYHHU(u32 rt, u32 ra, u32 rb) override;
+    void ADDX(u32 rt, u32 ra, u32 rb) override;
+    void SFX(u32 rt, u32 ra, u32 rb) override;
+    void CGX(u32 rt, u32 ra, u32 rb) override;
+    void BGX(u32 rt, u32 ra, u32 rb) override;
+    void MPYHHA(u32 rt, u32 ra, u32 rb) override;
+    void MPYHHAU(u32 rt, u32 ra, u32 rb) override;
+    void FSCRRD(u32 rt) override;
+    void FESD(u32 rt, u32 ra) override;
+    void FRDS(u32 rt, u32 ra) override;
+    void FSCRWR(u32 rt, u32 ra) override;
+    void DFTSV(u32 rt, u32 ra, s32 i7) override;
+    void FCEQ(u32 rt, u32 ra, u32 rb) override;
+    void DFCEQ(u32 rt, u32 ra, u32 rb) override;
+    void MPY(u32 rt, u32 ra, u32 rb) override;
+    void MPYH(u32 rt, u32 ra, u32 rb) override;
+    void MPYHH(u32 rt, u32 ra, u32 rb) override;
+    void MPYS(u32 rt, u32 ra, u32 rb) override;
+    void CEQH(u32 rt, u32 ra, u32 rb) override;
+    void FCMEQ(u32 rt, u32 ra, u32 rb) override;
+    void DFCMEQ(u32 rt, u32 ra, u32 rb) override;
+    void MPYU(u32 rt, u32 ra, u32 rb) override;
+    void CEQB(u32 rt, u32 ra, u32 rb) override;
+    void FI(u32 rt, u32 ra, u32 rb) override;
+    void HEQ(u32 rt, u32 ra, u32 rb) override;
+
+    //0 - 9
+    void CFLTS(u32 rt, u32 ra, s32 i8) override;
+    void CFLTU(u32 rt, u32 ra, s32 i8) override;
+    void CSFLT(u32 rt, u32 ra, s32 i8) override;
+    void CUFLT(u32 rt, u32 ra, s32 i8) override;
+
+    //0 - 8
+    void BRZ(u32 rt, s32 i16) override;
+    void STQA(u32 rt, s32 i16) override;
+    void BRNZ(u32 rt, s32 i16) override;
+    void BRHZ(u32 rt, s32 i16) override;
+    void BRHNZ(u32 rt, s32 i16) override;
+    void STQR(u32 rt, s32 i16) override;
+    void BRA(s32 i16) override;
+    void LQA(u32 rt, s32 i16) override;
+    void BRASL(u32 rt, s32 i16) override;
+    void BR(s32 i16) override;
+    void FSMBI(u32 rt, s32 i16) override;
+    void BRSL(u32 rt, s32 i16) override;
+    void LQR(u32 rt, s32 i16) override;
+    void IL(u32 rt, s32 i16) override;
+    void ILHU(u32 rt, s32 i16) override;
+    void ILH(u32 rt, s32 i16) override;
+    void IOHL(u32 rt, s32 i16) override;
+
+    //0 - 7
+    void ORI(u32 rt, u32 ra, s32 i10) override;
+    void ORHI(u32 rt, u32 ra, s32 i10) override;
+    void ORBI(u32 rt, u32 ra, s32 i10) override;
+    void SFI(u32 rt, u32 ra, s32 i10) override;
+    void SFHI(u32 rt, u32 ra, s32 i10) override;
+    void ANDI(u32 rt, u32 ra, s32 i10) override;
+    void ANDHI(u32 rt, u32 ra, s32 i10) override;
+    void ANDBI(u32 rt, u32 ra, s32 i10) override;
+    void AI(u32 rt, u32 ra, s32 i10) override;
+    void AHI(u32 rt, u32 ra, s32 i10) override;
+    void STQD(u32 rt, s32 i10, u32 ra) override;
+    void LQD(u32 rt, s32 i10, u32 ra) override;
+    void XORI(u32 rt, u32 ra, s32 i10) override;
+    void XORHI(u32 rt, u32 ra, s32 i10) override;
+    void XORBI(u32 rt, u32 ra, s32 i10) override;
+    void CGTI(u32 rt, u32 ra, s32 i10) override;
+    void CGTHI(u32 rt, u32 ra, s32 i10) override;
+    void CGTBI(u32 rt, u32 ra, s32 i10) override;
+    void HGTI(u32 rt, u32 ra, s32 i10) override;
+    void CLGTI(u32 rt, u32 ra, s32 i10) override;
+    void CLGTHI(u32 rt, u32 ra, s32 i10) override;
+    void CLGTBI(u32 rt, u32 ra, s32 i10) override;
+    void HLGTI(u32 rt, u32 ra, s32 i10) override;
+    void MPYI(u32 rt, u32 ra, s32 i10) override;
+    void MPYUI(u32 rt, u32 ra, s32 i10) override;
+    void CEQI(u32 rt, u32 ra, s32 i10) override;
+    void CEQHI(u32 rt, u32 ra, s32 i10) override;
+    void CEQBI(u32 rt, u32 ra, s32 i10) override;
+    void HEQI(u32 rt, u32 ra, s32 i10) override;
+
+    //0 - 6
+    void HBRA(s32 ro, s32 i16) override;
+    void HBRR(s32 ro, s32 i16) override;
+    void ILA(u32 rt, u32 i18) override;
+
+    //0 - 3
+    void SELB(u32 rt, u32 ra, u32 rb, u32 rc) override;
+    void SHUFB(u32 rt, u32 ra, u32 rb, u32 rc) override;
+    void MPYA(u32 rt, u32 ra, u32 rb, u32 rc) override;
+    void FNMS(u32 rt, u32 ra, u32 rb, u32 rc) override;
+    void FMA(u32 rt, u32 ra, u32 rb, u32 rc) override;
+    void FMS(u32 rt, u32 ra, u32 rb, u32 rc) override;
+    void UNK(u32 code, u32 opcode, u32 gcode) override;
+
+private:
+    struct ExecutableInfo {
+        /// Pointer to the executable
+        Executable executable;
+
+        /// Lowest and highest instruction index compiled into the executable
+        u32 first;
+        u32 last;
+
+        /// Copy of the instructions first..last at the time of compilation
+        std::vector<u32> code;
+
+        /// LLVM function corresponding to the executable
+        llvm::Function * llvm_function;
+    };
+
+    /// SPU processor context
+    SPUThread & m_spu;
+
+    /// SPU Interpreter used for the instructions that are not converted to LLVM IR
+    SPUInterpreter * m_interpreter;
+
+    /// Executables. Index is the instruction index (LS address / 4) of the first instruction.
+    std::vector<ExecutableInfo> m_executables;
+
+    /// Set after SYNC. The executables are checked against LS before the next one is executed.
+    bool m_need_check;
+
+    /// LLVM context
+    llvm::LLVMContext * m_llvm_context;
+
+    /// LLVM IR builder
+    llvm::IRBuilder<> * m_ir_builder;
+
+    /// Module to which all generated code is output to
+    llvm::Module * m_module;
+
+    /// JIT execution engine
+    llvm::ExecutionEngine * m_execution_engine;
+
+    /// Function pass manager
+    llvm::FunctionPassManager * m_fpm;
+
+    /// The function being compiled
+    llvm::Function * m_current_function;
+
+    /// Basic blocks of the function being compiled. Key is the instruction index.
+    std::map<u32, llvm::BasicBlock *> m_current_function_blocks;
+
+    /// Basic blocks of the function being compiled that only return to the dispatcher. Key is the instruction index.
+    std::set<u32> m_current_function_exits;
+
+    /// Instructions indexes whose blocks have not been converted to LLVM IR yet
+    std::list<u32> m_current_function_uncompiled_blocks_list;
+
+    /// Arguments of the function being compiled
+    llvm::Value * m_gpr;
+    llvm::Value * m_ls;
+    llvm::Value * m_spu_state;
+    llvm::Value * m_interpreter_arg;
+
+    /// Function that executes an instruction using the interpreter
+    llvm::Function * m_interpreter_fallback;
+
+    /// Number of backward branches the function being compiled may still take
+    llvm::Value * m_loop_count;
+
+    /// Instruction index and opcode of the instruction being compiled
+    u32 m_current_instruction_pos;
+    u32 m_current_instruction;
+
+    /// Number of instructions converted to LLVM IR and the limit for the function being compiled
+    u32 m_num_instructions;
+    u32 m_max_instructions;
+
+    /// Set to true when the current instruction ends its basic block
+    bool m_hit_branch_instruction;
+
+    /// Number of instructions executed by calling the interpreter. Key is the name of the instruction.
+    std::map<std::string, u64> m_interpreter_fallback_stats;
+
+    /// Write compilation statistics to SPULLVMRecompiler_<id>.log when the recompiler is destroyed
+    bool m_log_enabled;
+
+    /// Number of functions compiled and time spent compiling them
+    u32 m_num_compiled;
+    std::chrono::nanoseconds m_compilation_time;
+
+    /// Discard the executables whose instructions have changed in LS
+    void CheckExecutables(const u8 * ls);
+
+    /// Free the machine code of the executable at pos
+    void FreeExecutable(u32 pos);
+
+    /// Get the basic block for the instruction at pos. Creates and queues it if it does not exist yet.
+    /// Once the instruction limit has been reached, new blocks only return to the dispatcher.
+    llvm::BasicBlock * GetBlock(u32 pos);
+
+    /// Return from the function being compiled. next_pos is the instruction index to continue at.
+    void ReturnToDispatcher(u32 next_pos, u32 flags = 0);
+
+    /// Return from the function being compiled. next_address is the LS address to continue at.
+    void ReturnToDispatcher(llvm::Value * next_address);
+
+    /// Branch to the instruction at target inside of the function. Backward branches are counted.
+    void BranchLocal(u32 target);
+
+    /// Branch to target if condition is true, otherwise continue with the next instruction
+    void BranchLocalIf(llvm::Value * condition, u32 target);
+
+    /// Execute the current instruction using the interpreter
+    void InterpreterCall(const char * name);
+
+    /// Execute the current instruction using the interpreter and return to the dispatcher.
+    /// Used for instructions that branch or may stop the thread.
+    void InterpreterCallAndReturn(const char * name);
+
+    /// Load a GPR as a vector of 4 words
+    llvm::Value * GetGpr(u32 r);
+
+    /// Load a GPR as a vector of 4 floats
+    llvm::Value * GetGprFloat(u32 r);
+
+    /// Load the preferred slot (word 0 in big endian order) of a GPR
+    llvm::Value * GetGprPreferredSlot(u32 r);
+
+    /// Store a vector of 4 words or 4 floats to a GPR
+    void SetGpr(u32 r, llvm::Value * value);
+
+    /// Get a vector of 4 words set to value
+    llvm::Value * GetSplat(u32 value);
+
+    /// Load 16 bytes from LS. lsa must be 16 byte aligned.
+    llvm::Value * ReadLS128(llvm::Value * lsa);
+
+    /// Store 16 bytes to LS. lsa must be 16 byte aligned.
+    void WriteLS128(llvm::Value * lsa, llvm::Value * value);
+
+    /// Test the instructions in test_code (at the LS address 0x3f000) against the interpreter with the current register state
+    bool VerifyAgainstInterpreter(const char * name, const std::vector<u32> & test_code, u32 max_instructions);
+};
+
+#endif // LLVM_AVAILABLE
+
+#endif // SPU_LLVM_RECOMPILER_H
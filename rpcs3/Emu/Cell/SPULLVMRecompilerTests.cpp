@@ -0,0 +1,267 @@
+#include "stdafx.h"
+#include "Utilities/Log.h"
+#include "Emu/Memory/Memory.h"
+#include "Emu/System.h"
+#include "Emu/Cell/SPUThread.h"
+#include "Emu/Cell/SPUInstrTable.h"
+#include "Emu/Cell/SPUInterpreter.h"
+#include "Emu/Cell/SPULLVMRecompiler.h"
+
+//#define SPU_LLVM_RECOMPILER_UNIT_TESTS 1
+
+#ifdef SPU_LLVM_RECOMPILER_UNIT_TESTS
+/// LS address at which the tested code is placed
+static const u32 s_test_code_address = 0x3f000;
+
+/// Number of random instruction streams tested and the length of each stream
+static const u32 s_num_random_tests   = 1000;
+static const u32 s_random_test_length = 32;
+
+/// Instruction encoders
+static u32 EncodeRR(u32 op, u32 rt, u32 ra, u32 rb) {
+    return (op << 21) | ((rb & 0x7f) << 14) | ((ra & 0x7f) << 7) | (rt & 0x7f);
+}
+
+static u32 EncodeRRR(u32 op, u32 rt, u32 ra, u32 rb, u32 rc) {
+    return (op << 28) | ((rt & 0x7f) << 21) | ((rb & 0x7f) << 14) | ((ra & 0x7f) << 7) | (rc & 0x7f);
+}
+
+static u32 EncodeRI10(u32 op, u32 rt, u32 ra, s32 i10) {
+    return (op << 24) | ((i10 & 0x3ff) << 14) | ((ra & 0x7f) << 7) | (rt & 0x7f);
+}
+
+static u32 EncodeRI16(u32 op, u32 rt, s32 i16) {
+    return (op << 23) | ((i16 & 0xffff) << 7) | (rt & 0x7f);
+}
+
+static u32 EncodeRI18(u32 op, u32 rt, u32 i18) {
+    return (op << 25) | ((i18 & 0x3ffff) << 7) | (rt & 0x7f);
+}
+
+/// Generate a random instruction that is converted to LLVM IR (no branches).
+/// Only floating point instructions write r64..r127, so the NaNs they read are the default NaN and
+/// the result does not depend on the order of the operands.
+static u32 GetRandomInstruction(std::mt19937 & rng) {
+    using namespace SPU_opcodes;
+
+    auto r   = [&]() { return (u32)(rng() & 0x7f); };
+    auto ri  = [&]() { return (u32)(rng() & 0x3f); };
+    auto rf  = [&]() { return (u32)(rng() & 0x3f) + 64; };
+    auto imm = [&](u32 bits) { return (s32)(rng() & ((1 << bits) - 1)); };
+
+    // Loads and stores use a base of r0..r3, so that the addresses vary but are not always random
+    switch (rng() % 40) {
+    case 0:  return EncodeRR(A, ri(), r(), r());
+    case 1:  return EncodeRR(SF, ri(), r(), r());
+    case 2:  return EncodeRR(AND, ri(), r(), r());
+    case 3:  return EncodeRR(OR, ri(), r(), r());
+    case 4:  return EncodeRR(XOR, ri(), r(), r());
+    case 5:  return EncodeRR(NAND, ri(), r(), r());
+    case 6:  return EncodeRR(NOR, ri(), r(), r());
+    case 7:  return EncodeRR(ANDC, ri(), r(), r());
+    case 8:  return EncodeRR(ORC, ri(), r(), r());
+    case 9:  return EncodeRR(EQV, ri(), r(), r());
+    case 10: return EncodeRR(CEQ, ri(), r(), r());
+    case 11: return EncodeRR(CGT, ri(), r(), r());
+    case 12: return EncodeRR(CLGT, ri(), r(), r());
+    case 13: return EncodeRR(SHLI, ri(), r(), imm(7));
+    case 14: return EncodeRR(ROTMI, ri(), r(), imm(7));
+    case 15: return EncodeRR(ROTMAI, ri(), r(), imm(7));
+    case 16: return EncodeRR(FA, rf(), rf(), rf());
+    case 17: return EncodeRR(FS, rf(), rf(), rf());
+    case 18: return EncodeRR(FM, rf(), rf(), rf());
+    case 19: return EncodeRR(LQX, ri(), rng() & 3, rng() & 3);
+    case 20: return EncodeRR(STQX, ri(), rng() & 3, rng() & 3);
+    case 21: return EncodeRI10(AI, ri(), r(), imm(10));
+    case 22: return EncodeRI10(SFI, ri(), r(), imm(10));
+    case 23: return EncodeRI10(ANDI, ri(), r(), imm(10));
+    case 24: return EncodeRI10(ORI, ri(), r(), imm(10));
+    case 25: return EncodeRI10(XORI, ri(), r(), imm(10));
+    case 26: return EncodeRI10(CEQI, ri(), r(), imm(10));
+    case 27: return EncodeRI10(CGTI, ri(), r(), imm(10));
+    case 28: return EncodeRI10(CLGTI, ri(), r(), imm(10));
+    case 29: return EncodeRI10(LQD, ri(), rng() & 3, imm(10));
+    case 30: return EncodeRI10(STQD, ri(), rng() & 3, imm(10));
+    case 31: return EncodeRI16(IL, ri(), imm(16));
+    case 32: return EncodeRI16(ILH, ri(), imm(16));
+    case 33: return EncodeRI16(ILHU, ri(), imm(16));
+    case 34: return EncodeRI16(IOHL, ri(), imm(16));
+    case 35: return EncodeRI18(ILA, ri(), imm(18));
+    case 36: return EncodeRI16(rng() & 1 ? LQA : STQA, ri(), imm(16));
+    case 37: return EncodeRI16(rng() & 1 ? LQR : STQR, ri(), imm(16));
+    case 38: return EncodeRRR(SELB, ri(), r(), r(), r());
+    default:
+        switch (rng() % 3) {
+        case 0:  return EncodeRRR(FMA, rf(), rf(), rf(), rf());
+        case 1:  return EncodeRRR(FNMS, rf(), rf(), rf(), rf());
+        default: return EncodeRRR(FMS, rf(), rf(), rf(), rf());
+        }
+    }
+}
+
+/// Fill the registers with random values. r64..r127 hold finite floats.
+static void SetRandomRegisters(SPUThread & spu, std::mt19937 & rng) {
+    for (u32 i = 0; i < 128; i++) {
+        for (u32 w = 0; w < 4; w++) {
+            spu.GPR[i]._u32[w] = i < 64 ? rng() : rng() & 0xbfffffff;
+        }
+    }
+}
+#endif // SPU_LLVM_RECOMPILER_UNIT_TESTS
+
+bool SPULLVMRecompiler::VerifyAgainstInterpreter(const char * name, const std::vector<u32> & test_code, u32 max_instructions) {
+#ifdef SPU_LLVM_RECOMPILER_UNIT_TESTS
+    // The code is followed by HGT r0, r0, which never halts. It is executed by calling the interpreter and returns
+    // to the dispatcher, so the functions compiled from the code do not run into the rest of LS.
+    std::vector<u32> code = test_code;
+    code.push_back(EncodeRR(SPU_opcodes::HGT, 0, 0, 0));
+
+    u8 *      ls       = vm::get_ptr<u8>(m_spu.ls_offset);
+    const u32 end      = s_test_code_address + (u32)code.size() * 4;
+    const u32 saved_pc = m_spu.PC;
+
+    for (u32 i = 0; i < code.size(); i++) {
+        *(u32 *)(ls + s_test_code_address + i * 4) = re32(code[i]);
+    }
+
+    std::vector<u8> initial_ls(ls, ls + 0x40000);
+    u128            initial_gpr[128];
+    memcpy(initial_gpr, m_spu.GPR, sizeof(initial_gpr));
+
+    // Run the interpreter. The code is read from the vector, stores may overwrite it in LS.
+    m_spu.PC = s_test_code_address;
+    while (m_spu.PC >= s_test_code_address && m_spu.PC < end) {
+        (*SPU_instr::rrr_list)(m_interpreter, code[(m_spu.PC - s_test_code_address) / 4]);
+        if (m_spu.m_is_branch) {
+            m_spu.m_is_branch = false;
+            m_spu.PC          = m_spu.nPC;
+        } else {
+            m_spu.PC += 4;
+        }
+    }
+
+    std::vector<u8> interpreter_ls(ls, ls + 0x40000);
+    u128            interpreter_gpr[128];
+    memcpy(interpreter_gpr, m_spu.GPR, sizeof(interpreter_gpr));
+
+    // Run the recompiled code. Executables return when their loop counter runs out, they are called again until the end is reached.
+    memcpy(ls, initial_ls.data(), initial_ls.size());
+    memcpy(m_spu.GPR, initial_gpr, sizeof(initial_gpr));
+
+    for (u32 i = 0; i < code.size(); i++) {
+        Compile((s_test_code_address >> 2) + i, max_instructions);
+    }
+
+    u32 pc = s_test_code_address;
+    while (pc >= s_test_code_address && pc < end) {
+        pc = m_executables[pc >> 2].executable(m_spu.GPR, ls, &m_spu, m_interpreter) & ~s_need_check_flag;
+    }
+
+    m_spu.PC = saved_pc;
+
+    for (u32 i = 0; i < code.size(); i++) {
+        FreeExecutable((s_test_code_address >> 2) + i);
+    }
+
+    std::string msg;
+    for (u32 i = 0; i < 128; i++) {
+        if (m_spu.GPR[i] != interpreter_gpr[i]) {
+            msg += fmt::Format("\nr%d: %s (interpreter: %s)", i, m_spu.GPR[i].to_hex().c_str(), interpreter_gpr[i].to_hex().c_str());
+        }
+    }
+
+    if (memcmp(ls, interpreter_ls.data(), interpreter_ls.size())) {
+        msg += "\nLS differs";
+    }
+
+    if (pc != end) {
+        msg += fmt::Format("\nEnded at 0x%x (interpreter: 0x%x)", pc, end);
+    }
+
+    if (msg.empty()) {
+        LOG_NOTICE(SPU, "[UT %s] Test passed.", name);
+        return true;
+    }
+
+    std::string listing;
+    for (u32 i = 0; i < code.size(); i++) {
+        listing += fmt::Format(" %08x", code[i]);
+    }
+
+    LOG_ERROR(SPU, "[UT %s] Test failed. Code:%s%s", name, listing.c_str(), msg.c_str());
+#endif // SPU_LLVM_RECOMPILER_UNIT_TESTS
+    return false;
+}
+
+void SPULLVMRecompiler::RunAllTests() {
+#ifdef SPU_LLVM_RECOMPILER_UNIT_TESTS
+    LOG_NOTICE(SPU, "Running Unit Tests");
+
+    u8 *            ls = vm::get_ptr<u8>(m_spu.ls_offset);
+    std::vector<u8> saved_ls(ls, ls + 0x40000);
+    u128            saved_gpr[128];
+    memcpy(saved_gpr, m_spu.GPR, sizeof(saved_gpr));
+
+    std::mt19937 rng(0x5eed);
+    u32          num_failed = 0;
+
+    // Random straight-line code compiled into one function, and split into functions of 1 and 5 instructions
+    for (u32 i = 0; i < s_num_random_tests; i++) {
+        std::vector<u32> code;
+        for (u32 j = 0; j < s_random_test_length; j++) {
+            code.push_back(GetRandomInstruction(rng));
+        }
+
+        const u32 max_instructions = i % 3 == 0 ? 1 : i % 3 == 1 ? 5 : s_max_function_size;
+        SetRandomRegisters(m_spu, rng);
+        if (!VerifyAgainstInterpreter(fmt::Format("Random.%d", i).c_str(), code, max_instructions)) {
+            num_failed++;
+        }
+    }
+
+    // The opcodes are qualified below, the instruction members of the class hide them.
+    // Loop that ends before the loop counter runs out: r3 = 100; do { r4 += 3; } while (--r3);
+    SetRandomRegisters(m_spu, rng);
+    num_failed += !VerifyAgainstInterpreter("Loop.0", {
+        EncodeRI16(SPU_opcodes::IL, 3, 100),
+        EncodeRI16(SPU_opcodes::IL, 4, 0),
+        EncodeRI10(SPU_opcodes::AI, 4, 4, 3),
+        EncodeRI10(SPU_opcodes::AI, 3, 3, -1),
+        EncodeRI16(SPU_opcodes::BRNZ, 3, -2),
+    }, s_max_function_size);
+
+    // Loop that returns to the dispatcher several times, with a forward branch in its body
+    SetRandomRegisters(m_spu, rng);
+    num_failed += !VerifyAgainstInterpreter("Loop.1", {
+        EncodeRI16(SPU_opcodes::IL, 3, 0x1234),
+        EncodeRI16(SPU_opcodes::IL, 4, 0),
+        EncodeRI10(SPU_opcodes::ANDI, 5, 3, 1),
+        EncodeRI16(SPU_opcodes::BRZ, 5, 2),
+        EncodeRI10(SPU_opcodes::AI, 4, 4, 1),
+        EncodeRI10(SPU_opcodes::AI, 3, 3, -1),
+        EncodeRI16(SPU_opcodes::BRHNZ, 3, -4),
+        EncodeRI16(SPU_opcodes::BR, 0, 1),
+        EncodeRI16(SPU_opcodes::IL, 4, -1),
+    }, s_max_function_size);
+
+    // Branches to the end of the code and calls
+    SetRandomRegisters(m_spu, rng);
+    num_failed += !VerifyAgainstInterpreter("Branch.0", {
+        EncodeRI16(SPU_opcodes::IL, 3, 0),
+        EncodeRI16(SPU_opcodes::BRHZ, 3, 2),
+        EncodeRI16(SPU_opcodes::IL, 4, 1),
+        EncodeRI16(SPU_opcodes::BRSL, 5, 1),
+        EncodeRI16(SPU_opcodes::BRA, 0, ((s_test_code_address >> 2) + 6) & 0xffff),
+        EncodeRI16(SPU_opcodes::IL, 6, 1),
+    }, s_max_function_size);
+
+    memcpy(ls, saved_ls.data(), saved_ls.size());
+    memcpy(m_spu.GPR, saved_gpr, sizeof(saved_gpr));
+
+    if (num_failed) {
+        LOG_ERROR(SPU, "%d unit tests failed", num_failed);
+    } else {
+        LOG_NOTICE(SPU, "All unit tests passed");
+    }
+#endif // SPU_LLVM_RECOMPILER_UNIT_TESTS
+}
@@ -4,6 +4,8 @@
 
 #include "asmjit.h"
 
+#include <map>
+
 using namespace asmjit;
 using namespace asmjit::host;
 
@@ -21,11 +23,12 @@ public:
 	JitRuntime runtime;
 	bool first;
 	bool need_check;
+	bool log_enabled; // write the disassembly of compiled functions to SPUjit_<id>.log
 
 	struct SPURecEntry
 	{
-		//u16 host; // absolute position of first instruction of current block (not used now)
-		u16 count; // count of instructions compiled from current point (and to be checked)
+		u16 first; // lowest instruction of the function compiled at this position
+		u16 last; // highest instruction of the function (the range to be checked)
 		u32 valid; // copy of valid opcode for validation
 		void* pointer; // pointer to executable memory object
 #ifdef _WIN32
@@ -37,10 +40,16 @@ public:
 
 	std::vector<__m128i> imm_table;
 
+	// instructions of the function being compiled (sorted) and the positions branched to inside of it
+	std::vector<u16> func_body;
+	std::set<u16> func_targets;
+
 	SPURecompilerCore(SPUThread& cpu);
 
 	~SPURecompilerCore();
 
+	void Analyse(u16 start);
+
 	void Compile(u16 pos);
 
 	virtual void Decode(const u32 code);
@@ -107,6 +116,7 @@ private:
 public:
 	X86Compiler* compiler;
 	bool do_finalize;
+	bool do_jump; // unconditional jump inside of the function (no fall-through)
 	// input:
 	X86GpVar* cpu_var;
 	X86GpVar* ls_var;
@@ -119,6 +129,10 @@ public:
 	X86GpVar* qw0;
 	X86GpVar* qw1;
 	X86GpVar* qw2;
+	// control flow:
+	X86GpVar* loop_var; // backward branches left before returning
+	Label* exit_label;
+	std::map<u16, Label> labels; // branch targets inside of the function
 
 	struct XmmLink
 	{
@@ -371,6 +385,38 @@ public:
 		return XmmConst((__m128i&)data);
 	}
 
+	const Label* GetLocalLabel(u32 target) // get label of the target if it belongs to the current function
+	{
+		auto found = labels.find(target >> 2);
+		return found != labels.end() ? &found->second : nullptr;
+	}
+
+	void JumpLocal(const Label& label, u32 target)
+	{
+		if (target <= CPU.PC)
+		{
+			// return from time to time if the function loops, so that the thread can be paused or stopped
+			c.mov(*pos_var, target >> 2);
+			c.dec(*loop_var);
+			c.jz(*exit_label);
+		}
+		c.jmp(label);
+	}
+
+	void BranchLocal(const Label& label, u32 target, bool if_zero) // conditional jump (using the flags)
+	{
+		if (target > CPU.PC)
+		{
+			if (if_zero) c.jz(label); else c.jnz(label);
+			return;
+		}
+
+		Label skip = c.newLabel();
+		if (if_zero) c.jnz(skip); else c.jz(skip);
+		JumpLocal(label, target);
+		c.bind(skip);
+	}
+
 private:
 	//0 - 10
 	void STOP(u32 code)
@@ -2748,6 +2794,14 @@ private:
 	//0 - 8
 	void BRZ(u32 rt, s32 i16)
 	{
+		if (const Label* label = GetLocalLabel(branchTarget(CPU.PC, i16)))
+		{
+			c.cmp(cpu_dword(GPR[rt]._u32[3]), 0);
+			BranchLocal(*label, branchTarget(CPU.PC, i16), true);
+			LOG_OPCODE();
+			return;
+		}
+
 		c.mov(cpu_dword(PC), CPU.PC);
 		do_finalize = true;
 
@@ -2777,6 +2831,14 @@ private:
 	}
 	void BRNZ(u32 rt, s32 i16)
 	{
+		if (const Label* label = GetLocalLabel(branchTarget(CPU.PC, i16)))
+		{
+			c.cmp(cpu_dword(GPR[rt]._u32[3]), 0);
+			BranchLocal(*label, branchTarget(CPU.PC, i16), false);
+			LOG_OPCODE();
+			return;
+		}
+
 		c.mov(cpu_dword(PC), CPU.PC);
 		do_finalize = true;
 
@@ -2788,6 +2850,14 @@ private:
 	}
 	void BRHZ(u32 rt, s32 i16)
 	{
+		if (const Label* label = GetLocalLabel(branchTarget(CPU.PC, i16)))
+		{
+			c.cmp(cpu_word(GPR[rt]._u16[6]), 0);
+			BranchLocal(*label, branchTarget(CPU.PC, i16), true);
+			LOG_OPCODE();
+			return;
+		}
+
 		c.mov(cpu_dword(PC), CPU.PC);
 		do_finalize = true;
 
@@ -2799,6 +2869,14 @@ private:
 	}
 	void BRHNZ(u32 rt, s32 i16)
 	{
+		if (const Label* label = GetLocalLabel(branchTarget(CPU.PC, i16)))
+		{
+			c.cmp(cpu_word(GPR[rt]._u16[6]), 0);
+			BranchLocal(*label, branchTarget(CPU.PC, i16), false);
+			LOG_OPCODE();
+			return;
+		}
+
 		c.mov(cpu_dword(PC), CPU.PC);
 		do_finalize = true;
 
@@ -2828,6 +2906,14 @@ private:
 	}
 	void BRA(s32 i16)
 	{
+		if (const Label* label = GetLocalLabel(branchTarget(0, i16)))
+		{
+			JumpLocal(*label, branchTarget(0, i16));
+			do_jump = true;
+			LOG_OPCODE();
+			return;
+		}
+
 		c.mov(cpu_dword(PC), CPU.PC);
 		do_finalize = true;
 
@@ -2871,6 +2957,14 @@ private:
 	}
 	void BR(s32 i16)
 	{
+		if (const Label* label = GetLocalLabel(branchTarget(CPU.PC, i16)))
+		{
+			JumpLocal(*label, branchTarget(CPU.PC, i16));
+			do_jump = true;
+			LOG_OPCODE();
+			return;
+		}
+
 		c.mov(cpu_dword(PC), CPU.PC);
 		do_finalize = true;
 
@@ -1,4 +1,5 @@
 #include "stdafx.h"
+#include "rpcs3/Ini.h"
 #include "Utilities/Log.h"
 #include "Emu/Memory/Memory.h"
 #include "Emu/System.h"
@@ -12,15 +13,20 @@
 #include "SPUThread.h"
 #include "SPUInterpreter.h"
 #include "SPURecompiler.h"
+#include "Emu/PerfCounters.h"
 
 const g_imm_table_struct g_imm_table;
 
+const u32 g_max_function_size = 0x1000; // instructions
+const u32 g_max_loop_count = 0x400; // backward branches taken before the compiled function returns
+
 SPURecompilerCore::SPURecompilerCore(SPUThread& cpu)
 	: m_enc(new SPURecompiler(cpu, *this))
 	, inter(new SPUInterpreter(cpu))
 	, CPU(cpu)
 	, first(true)
 	, need_check(false)
+	, log_enabled(Ini.SPURecompilerLog.GetValue())
 {
 	memset(entry, 0, sizeof(entry));
 	X86CpuInfo inf;
@@ -43,11 +49,109 @@ void SPURecompilerCore::Decode(const u32 code) // decode instruction and run wit
 	(*SPU_instr::rrr_list)(inter, code);
 }
 
+void SPURecompilerCore::Analyse(u16 start)
+{
+	using namespace SPU_opcodes;
+
+	// find the instructions reachable from the start through fall-through and direct branches
+	// (calls, indirect branches and stops end the function)
+	std::vector<bool> visited(0x10000);
+	std::vector<u16> pending(1, start);
+
+	func_body.clear();
+	func_targets.clear();
+	func_targets.insert(start);
+
+	while (pending.size() && func_body.size() < g_max_function_size)
+	{
+		u32 pos = pending.back();
+		pending.pop_back();
+
+		while (pos < 0x10000 && !visited[pos] && func_body.size() < g_max_function_size)
+		{
+			visited[pos] = true;
+			func_body.push_back(pos);
+
+			const u32 opcode = vm::read32(CPU.ls_offset + pos * 4);
+			const s32 i16 = (s16)(opcode >> 7);
+			bool next = opcode != 0;
+
+			switch (opcode >> 23)
+			{
+			case BRZ:
+			case BRNZ:
+			case BRHZ:
+			case BRHNZ:
+				func_targets.insert(SPUOpcodes::branchTarget(pos * 4, i16) >> 2);
+				pending.push_back(SPUOpcodes::branchTarget(pos * 4, i16) >> 2);
+				break;
+
+			case BR:
+				func_targets.insert(SPUOpcodes::branchTarget(pos * 4, i16) >> 2);
+				pending.push_back(SPUOpcodes::branchTarget(pos * 4, i16) >> 2);
+				next = false;
+				break;
+
+			case BRA:
+				func_targets.insert(SPUOpcodes::branchTarget(0, i16) >> 2);
+				pending.push_back(SPUOpcodes::branchTarget(0, i16) >> 2);
+				next = false;
+				break;
+
+			case BRSL:
+			case BRASL:
+				next = false;
+				break;
+			}
+
+			switch (opcode >> 21)
+			{
+			case STOP:
+			case STOPD:
+			case SYNC:
+			case BIZ:
+			case BINZ:
+			case BIHZ:
+			case BIHNZ:
+			case BI:
+			case BISL:
+			case IRET:
+			case BISLED:
+			case HEQ:
+			case HGT:
+			case HLGT:
+				next = false;
+				break;
+			}
+
+			switch (opcode >> 24)
+			{
+			case HEQI:
+			case HGTI:
+			case HLGTI:
+				next = false;
+				break;
+			}
+
+			if (!next) break;
+			pos++;
+		}
+	}
+
+	std::sort(func_body.begin(), func_body.end());
+}
+
 void SPURecompilerCore::Compile(u16 pos)
 {
 	const u64 stamp0 = get_system_time();
 	u64 time0 = 0;
 
+	const u16 start = pos;
+	const u32 start_pc = CPU.PC;
+	u32 excess = 0;
+
+	Analyse(start);
+
 	SPUDisAsm dis_asm(CPUDisAsm_InterpreterMode);
 	dis_asm.offset = vm::get_ptr<u8>(CPU.ls_offset);
 
@@ -56,12 +160,12 @@ void SPURecompilerCore::Compile(u16 pos)
 
 	X86Compiler compiler(&runtime);
 	m_enc->compiler = &compiler;
-	compiler.setLogger(&stringLogger);
+	if (log_enabled)
+	{
+		compiler.setLogger(&stringLogger);
+	}
 
 	compiler.addFunc(kFuncConvHost, FuncBuilder4<u32, void*, void*, void*, u32>());
-	const u16 start = pos;
-	u32 excess = 0;
-	entry[start].count = 0;
 
 	X86GpVar cpu_var(compiler, kVarTypeIntPtr, "cpu");
 	compiler.setArg(0, cpu_var);
@@ -93,52 +197,91 @@ void SPURecompilerCore::Compile(u16 pos)
 	m_enc->qw1 = &qw1_var;
 	X86GpVar qw2_var(compiler, kVarTypeUInt64, "qw2");
 	m_enc->qw2 = &qw2_var;
+	X86GpVar loop_var(compiler, kVarTypeUInt32, "loop");
+	m_enc->loop_var = &loop_var;
 
 	for (u32 i = 0; i < 16; i++)
 	{
 		m_enc->xmm_var[i].data = new X86XmmVar(compiler, kX86VarTypeXmm, fmt::Format("reg_%d", i).c_str());
 	}
 
+	Label exit_label = compiler.newLabel();
+	m_enc->exit_label = &exit_label;
+
+	m_enc->labels.clear();
+	for (auto target : func_targets)
+	{
+		if (std::binary_search(func_body.begin(), func_body.end(), target))
+		{
+			m_enc->labels[target] = compiler.newLabel();
+		}
+	}
+
 	compiler.xor_(pos_var, pos_var);
+	compiler.mov(loop_var, g_max_loop_count);
 
-	while (true)
+	if (func_body[0] != start)
 	{
+		compiler.jmp(m_enc->labels[start]);
+	}
+
+	for (u32 i = 0; i < func_body.size(); i++)
+	{
+		pos = func_body[i];
+		CPU.PC = pos * 4;
+
+		auto label = m_enc->labels.find(pos);
+		if (label != m_enc->labels.end())
+		{
+			// cached registers are not known when the instruction is reached by a branch
+			m_enc->XmmRelease();
+			compiler.bind(label->second);
+		}
+
 		const u32 opcode = vm::read32(CPU.ls_offset + pos * 4);
 		m_enc->do_finalize = false;
+		m_enc->do_jump = false;
 		if (opcode)
 		{
-			const u64 stamp1 = get_system_time();
-			// disasm for logging:
-			dis_asm.dump_pc = pos * 4;
-			(*SPU_instr::rrr_list)(&dis_asm, opcode);
-			compiler.addComment(fmt::Format("SPU data: PC=0x%05x %s", pos * 4, dis_asm.last_opcode.c_str()).c_str());
+			if (log_enabled)
+			{
+				const u64 stamp1 = get_system_time();
+				// disasm for logging:
+				dis_asm.dump_pc = pos * 4;
+				(*SPU_instr::rrr_list)(&dis_asm, opcode);
+				compiler.addComment(fmt::Format("SPU data: PC=0x%05x %s", pos * 4, dis_asm.last_opcode.c_str()).c_str());
+				time0 += get_system_time() - stamp1;
+			}
 			// compile single opcode:
 			(*SPU_instr::rrr_list)(m_enc, opcode);
-			// force finalization between every slice using absolute alignment
-			/*if ((pos % 128 == 127) && !m_enc->do_finalize)
-			{
-				compiler.mov(pos_var, pos + 1);
-				m_enc->do_finalize = true;
-			}*/
-			entry[start].count++;
-			time0 += get_system_time() - stamp1;
 		}
 		else
 		{
+			// DecodeMemory reports it when it's entered
+			compiler.mov(pos_var, pos);
 			m_enc->do_finalize = true;
 		}
-		bool fin = m_enc->do_finalize;
+
 		if (entry[pos].valid == re32(opcode))
 		{
 			excess++;
 		}
 		entry[pos].valid = re32(opcode);
 
-		if (fin) break;
-		CPU.PC += 4;
-		pos++;
+		if (m_enc->do_finalize)
+		{
+			if (i + 1 < func_body.size()) compiler.jmp(exit_label);
+		}
+		else if (!m_enc->do_jump && (i + 1 == func_body.size() || func_body[i + 1] != pos + 1))
+		{
+			// the next instruction doesn't belong to the function
+			compiler.mov(pos_var, (pos + 1) & 0xffff);
+			compiler.jmp(exit_label);
+		}
 	}
 
+	CPU.PC = start_pc;
+
 	m_enc->XmmRelease();
 
 	for (u32 i = 0; i < 16; i++)
@@ -149,35 +292,49 @@ void SPURecompilerCore::Compile(u16 pos)
 	}
 
 	const u64 stamp1 = get_system_time();
+	compiler.bind(exit_label);
 	compiler.ret(pos_var);
 	compiler.endFunc();
 	entry[start].pointer = compiler.make();
+	entry[start].first = func_body.front();
+	entry[start].last = func_body.back();
 	compiler.setLogger(nullptr); // crashes without it
 
-	rFile log;
-	log.Open(fmt::Format("SPUjit_%d.log", GetCurrentSPUThread().GetId()), first ? rFile::write : rFile::write_append);
-	log.Write(fmt::Format("========== START POSITION 0x%x ==========\n\n", start * 4));
-	log.Write(std::string(stringLogger.getString()));
 	if (!entry[start].pointer)
 	{
 		LOG_ERROR(Log::SPU, "SPURecompilerCore::Compile(pos=0x%x) failed", start * sizeof(u32));
-		log.Write("========== FAILED ============\n\n");
 		Emu.Pause();
 	}
-	else
+
+	if (log_enabled)
 	{
-		log.Write(fmt::Format("========== COMPILED %d (excess %d), time: [start=%lld (decoding=%lld), finalize=%lld]\n\n",
-			entry[start].count, excess, stamp1 - stamp0, time0, get_system_time() - stamp1));
+		rFile log;
+		log.Open(fmt::Format("SPUjit_%d.log", GetCurrentSPUThread().GetId()), first ? rFile::write : rFile::write_append);
+		log.Write(fmt::Format("========== START POSITION 0x%x ==========\n\n", start * 4));
+		log.Write(std::string(stringLogger.getString()));
+		if (!entry[start].pointer)
+		{
+			log.Write("========== FAILED ============\n\n");
+		}
+		else
+		{
+			log.Write(fmt::Format("========== COMPILED %d (excess %d), time: [start=%lld (decoding=%lld), finalize=%lld]\n\n",
+				(u32)func_body.size(), excess, stamp1 - stamp0, time0, get_system_time() - stamp1));
 #ifdef _WIN32
-		//if (!RtlAddFunctionTable(&info, 1, (u64)entry[start].pointer))
-		//{
-		//	LOG_ERROR(Log::SPU, "RtlAddFunctionTable() failed");
-		//}
+			//if (!RtlAddFunctionTable(&info, 1, (u64)entry[start].pointer))
+			//{
+			//	LOG_ERROR(Log::SPU, "RtlAddFunctionTable() failed");
+			//}
 #endif
+		}
+		log.Close();
+		first = false;
 	}
-	log.Close();
+
+	m_enc->labels.clear();
 	m_enc->compiler = nullptr;
-	first = false;
+
+	perf::add(perf::JIT_COMPILE_US, get_system_time() - stamp0);
 }
 
 u8 SPURecompilerCore::DecodeMemory(const u32 address)
@@ -189,43 +346,38 @@ u8 SPURecompilerCore::DecodeMemory(const u32 address)
 	//ConLog.Write("DecodeMemory: pos=%d", pos);
 	u32* ls = vm::get_ptr<u32>(m_offset);
 
-	if (entry[pos].pointer)
+	if (entry[pos].pointer && need_check)
 	{
-		// check data (hard way)
-		bool is_valid = true;
-		if (need_check)
+		// check data (hard way): count the modified instructions, so that the functions covering them can be found
+		std::vector<u32> changed(0x10001);
+		for (u32 i = 0; i < 0x10000; i++)
 		{
-			for (u32 i = 0; i < 0x10000; i++)
-			{
-				if (entry[i].valid && entry[i].valid != ls[i])
-				{
-					is_valid = false;
-					break;
-				}
-			}
-			need_check = false;
+			changed[i + 1] = changed[i] + (entry[i].valid && entry[i].valid != ls[i] ? 1 : 0);
 		}
+		need_check = false;
+
 		// invalidate if necessary
-		if (!is_valid)
+		if (changed[0x10000])
 		{
 			for (u32 i = 0; i < 0x10000; i++)
 			{
 				if (!entry[i].pointer) continue;
 
-				if (!entry[i].valid || entry[i].valid != ls[i] ||
-					i + (u32)entry[i].count > (u32)pos &&
-					i < (u32)pos + (u32)entry[pos].count)
+				if (changed[entry[i].last + 1] != changed[entry[i].first])
 				{
 					runtime.release(entry[i].pointer);
 #ifdef _WIN32
 					//RtlDeleteFunctionTable(&entry[i].info);
 #endif
 					entry[i].pointer = nullptr;
-					for (u32 j = i; j < i + (u32)entry[i].count; j++)
-					{
-						entry[j].valid = 0;
-					}
-					//need_check = true;
+				}
+			}
+
+			for (u32 i = 0; i < 0x10000; i++)
+			{
+				if (changed[i + 1] != changed[i])
+				{
+					entry[i].valid = 0;
 				}
 			}
 			//LOG_ERROR(Log::SPU, "SPURecompilerCore::DecodeMemory(ls_addr=0x%x): code has changed", pos * sizeof(u32));
@@ -264,8 +416,31 @@ u8 SPURecompilerCore::DecodeMemory(const u32 address)
 	}
 
 	u32 res = pos;
+	CPU.SetProfState(CPU_EXEC_RECOMPILED, pos * sizeof(u32));
 	res = func(cpu, vm::get_ptr<void>(m_offset), imm_table.data(), &g_imm_table);
 
+	// call the functions already compiled directly, without going back to CPUThread::Task
+	// (breakpoints are checked by CPUThread::Task only, so functions are not chained if there are any)
+	if (Emu.GetBreakPoints().empty())
+	{
+		u32 num_chained = 0;
+
+		while (!(res & 0x3000000) && entry[res].pointer && CPU.ThreadStatus() == CPUThread_Running)
+		{
+			func = asmjit_cast<Func>(entry[res].pointer);
+			CPU.SetProfState(CPU_EXEC_RECOMPILED, res * sizeof(u32));
+			res = func(cpu, vm::get_ptr<void>(m_offset), imm_table.data(), &g_imm_table);
+			num_chained++;
+		}
+
+		if (num_chained)
+		{
+			perf::add(perf::CPU_STEPS, num_chained);
+		}
+	}
+
+	CPU.SetProfState(CPU_EXEC_INTERPRETER, 0);
+
 	if (res & 0x1000000)
 	{
 		CPU.SPU.Status.SetValue(SPU_STATUS_STOPPED_BY_HALT);
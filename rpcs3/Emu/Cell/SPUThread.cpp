@@ -5,6 +5,7 @@
 #include "Emu/System.h"
 
 #include "Emu/IdManager.h"
+#include "Emu/PerfCounters.h"
 #include "Emu/CPU/CPUThreadManager.h"
 #include "Emu/Cell/PPUThread.h"
 #include "Emu/SysCalls/ErrorCodes.h"
@@ -17,9 +18,12 @@
 #include "Emu/Cell/SPUDecoder.h"
 #include "Emu/Cell/SPUInterpreter.h"
 #include "Emu/Cell/SPURecompiler.h"
+#include "Emu/Cell/SPULLVMRecompiler.h"
 
 #include <cfenv>
 
+waiter_map_t g_spu_channel_wm("spu_channel_wm"); // signal_id = SPU thread id
+
 SPUThread& GetCurrentSPUThread()
 {
 	PPCThread* thread = GetCurrentPPCThread();
@@ -106,6 +110,14 @@ void SPUThread::DoRun()
 	case 2:
 		m_dec = new SPURecompilerCore(*this);
 	break;
+	case 3:
+#ifdef SPU_LLVM_RECOMPILER
+		m_dec = new SPULLVMRecompiler(*this);
+#else
+		LOG_ERROR(Log::SPU, "This image does not include SPU JIT (LLVM)");
+		Emu.Pause();
+#endif
+	break;
 
 	default:
 		LOG_ERROR(Log::SPU, "Invalid SPU decoder mode: %d", Ini.SPUDecoderMode.GetValue());
@@ -181,6 +193,13 @@ void SPUThread::WriteSNR(bool number, u32 value)
 	{
 		SPU.SNR[number ? 1 : 0].PushUncond(value); // overwrite
 	}
+
+	NotifyChannel();
+}
+
+void SPUThread::NotifyChannel()
+{
+	g_spu_channel_wm.notify(GetId());
 }
 
 #define LOG_DMAC(type, text) type(Log::SPU, "DMAC::ProcessCmd(cmd=0x%x, tag=0x%x, lsa=0x%x, ea=0x%llx, size=0x%x): " text, cmd, tag, lsa, ea, size)
@@ -189,6 +208,9 @@ void SPUThread::ProcessCmd(u32 cmd, u32 tag, u32 lsa, u64 ea, u32 size)
 {
 	if (cmd & (MFC_BARRIER_MASK | MFC_FENCE_MASK)) _mm_mfence();
 
+	perf::add(perf::DMA_COMMANDS);
+	perf::add(perf::DMA_BYTES, size);
+
 	if (ea >= SYS_SPU_THREAD_BASE_LOW)
 	{
 		if (ea >= 0x100000000)
@@ -585,14 +607,10 @@ void SPUThread::WriteChannel(u32 ch, const u128& r)
 		if (!group) // if RawSPU
 		{
 			if (Ini.HLELogging.GetValue()) LOG_NOTICE(Log::SPU, "SPU_WrOutIntrMbox: interrupt(v=0x%x)", v);
-			while (!SPU.Out_IntrMBox.Push(v))
+			if (!g_spu_channel_wm.wait_op(GetId(), [this, v]() { return SPU.Out_IntrMBox.Push(v); }))
 			{
-				std::this_thread::sleep_for(std::chrono::milliseconds(1));
-				if (Emu.IsStopped())
-				{
-					LOG_WARNING(Log::SPU, "%s(%s) aborted", __FUNCTION__, spu_ch_name[ch]);
-					return;
-				}
+				LOG_WARNING(Log::SPU, "%s(%s) aborted", __FUNCTION__, spu_ch_name[ch]);
+				return;
 			}
 			m_intrtag[2].stat |= 1;
 			if (CPUThread* t = Emu.GetCPU().GetThread(m_intrtag[2].thread))
@@ -643,7 +661,7 @@ void SPUThread::WriteChannel(u32 ch, const u128& r)
 					return;
 				}
 
-				if (!port.eq->events.push(SYS_SPU_THREAD_EVENT_USER_KEY, GetId(), ((u64)spup << 32) | (v & 0x00ffffff), data))
+				if (!port.eq->push(SYS_SPU_THREAD_EVENT_USER_KEY, GetId(), ((u64)spup << 32) | (v & 0x00ffffff), data))
 				{
 					SPU.In_MBox.PushUncond(CELL_EBUSY);
 					return;
@@ -681,7 +699,7 @@ void SPUThread::WriteChannel(u32 ch, const u128& r)
 				}
 
 				// TODO: check passing spup value
-				if (!port.eq->events.push(SYS_SPU_THREAD_EVENT_USER_KEY, GetId(), ((u64)spup << 32) | (v & 0x00ffffff), data))
+				if (!port.eq->push(SYS_SPU_THREAD_EVENT_USER_KEY, GetId(), ((u64)spup << 32) | (v & 0x00ffffff), data))
 				{
 					LOG_WARNING(Log::SPU, "sys_spu_thread_throw_event(spup=%d, data0=0x%x, data1=0x%x) failed (queue is full)", spup, (v & 0x00ffffff), data);
 					return;
@@ -805,7 +823,7 @@ void SPUThread::WriteChannel(u32 ch, const u128& r)
 
 	case SPU_WrOutMbox:
 	{
-		while (!SPU.Out_MBox.Push(v) && !Emu.IsStopped()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		g_spu_channel_wm.wait_op(GetId(), [this, v]() { return SPU.Out_MBox.Push(v); });
 		break;
 	}
 
@@ -916,13 +934,13 @@ void SPUThread::ReadChannel(u128& r, u32 ch)
 	{
 	case SPU_RdInMbox:
 	{
-		while (!SPU.In_MBox.Pop(v) && !Emu.IsStopped()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		g_spu_channel_wm.wait_op(GetId(), [this, &v]() { return SPU.In_MBox.Pop(v); });
 		break;
 	}
 
 	case MFC_RdTagStat:
 	{
-		while (!MFC1.TagStatus.Pop(v) && !Emu.IsStopped()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		g_spu_channel_wm.wait_op(GetId(), [this, &v]() { return MFC1.TagStatus.Pop(v); });
 		break;
 	}
 
@@ -936,11 +954,11 @@ void SPUThread::ReadChannel(u128& r, u32 ch)
 	{
 		if (cfg.value & 1)
 		{
-			while (!SPU.SNR[0].Pop_XCHG(v) && !Emu.IsStopped()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			g_spu_channel_wm.wait_op(GetId(), [this, &v]() { return SPU.SNR[0].Pop_XCHG(v); });
 		}
 		else
 		{
-			while (!SPU.SNR[0].Pop(v) && !Emu.IsStopped()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			g_spu_channel_wm.wait_op(GetId(), [this, &v]() { return SPU.SNR[0].Pop(v); });
 		}
 		break;
 	}
@@ -949,24 +967,24 @@ void SPUThread::ReadChannel(u128& r, u32 ch)
 	{
 		if (cfg.value & 2)
 		{
-			while (!SPU.SNR[1].Pop_XCHG(v) && !Emu.IsStopped()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			g_spu_channel_wm.wait_op(GetId(), [this, &v]() { return SPU.SNR[1].Pop_XCHG(v); });
 		}
 		else
 		{
-			while (!SPU.SNR[1].Pop(v) && !Emu.IsStopped()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			g_spu_channel_wm.wait_op(GetId(), [this, &v]() { return SPU.SNR[1].Pop(v); });
 		}
 		break;
 	}
 
 	case MFC_RdAtomicStat:
 	{
-		while (!MFC1.AtomicStat.Pop(v) && !Emu.IsStopped()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		g_spu_channel_wm.wait_op(GetId(), [this, &v]() { return MFC1.AtomicStat.Pop(v); });
 		break;
 	}
 
 	case MFC_RdListStallStat:
 	{
-		while (!StallStat.Pop(v) && !Emu.IsStopped()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		g_spu_channel_wm.wait_op(GetId(), [this, &v]() { return StallStat.Pop(v); });
 		break;
 	}
 
@@ -984,7 +1002,10 @@ void SPUThread::ReadChannel(u128& r, u32 ch)
 
 	case SPU_RdEventStat:
 	{
-		while (!CheckEvents() && !Emu.IsStopped()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		// a lost reservation isn't signaled by the writer, so it's still polled every 1 ms
+		while (!g_spu_channel_wm.wait_op(GetId(), [this]() { return CheckEvents(); }, 1000) && !Emu.IsStopped())
+		{
+		}
 		v = m_events & m_event_mask;
 		break;
 	}
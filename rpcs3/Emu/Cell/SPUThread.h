@@ -472,6 +472,9 @@ public:
 
 	void WriteSNR(bool number, u32 value);
 
+	// wake up the thread if it waits for a channel (must be called by other threads after they changed SPU channels)
+	void NotifyChannel();
+
 	u32 LSA;
 
 	union
@@ -573,6 +576,9 @@ public:
 	void FastCall(u32 ls_addr);
 	void FastStop();
 
+	// mailbox tests (empty unless enabled in SPUThreadTests.cpp)
+	static void RunAllTests();
+
 protected:
 	virtual void DoReset();
 	virtual void DoRun();
@@ -0,0 +1,137 @@
+#include "stdafx.h"
+#include "Utilities/Log.h"
+#include "Emu/Memory/Memory.h"
+#include "Emu/System.h"
+#include "Emu/CPU/CPUThreadManager.h"
+#include "Emu/Cell/RawSPUThread.h"
+
+//#define SPU_THREAD_UNIT_TESTS 1
+
+#ifdef SPU_THREAD_UNIT_TESTS
+
+// Round trip latency of the mailboxes between a PPU and an SPU thread: the PPU side (this thread) writes In_MBox and
+// polls the mailbox status through the RawSPU MMIO registers, the SPU side blocks in the channel read and write (on
+// g_spu_channel_wm) and answers with the value + 1. The sleep polling which the channels used before is measured for comparison.
+// Waits are aborted while the emulator is stopped, so this is called from Emulator::Run() (only the first time).
+
+namespace
+{
+	const u32 s_round_trips = 20000;
+	const u32 s_sleep_round_trips = 200;
+
+	typedef std::chrono::high_resolution_clock test_clock;
+
+	// returns the number of errors
+	u32 run_ping_pong(RawSPUThread& spu, const char* name, u32 count, bool sleep_polling)
+	{
+		const u32 in_mbox = GetRawSPURegAddrByNum(spu.GetIndex(), SPU_In_MBox_offs);
+		const u32 out_mbox = GetRawSPURegAddrByNum(spu.GetIndex(), SPU_Out_MBox_offs);
+		const u32 mbox_status = GetRawSPURegAddrByNum(spu.GetIndex(), SPU_MBox_Status_offs);
+		std::atomic<u32> errors(0);
+
+		thread spu_side("SPU mailbox test", [&spu, count, sleep_polling]()
+		{
+			for (u32 i = 0; i < count && !Emu.IsStopped(); i++)
+			{
+				if (sleep_polling)
+				{
+					u32 value;
+
+					while (!spu.SPU.In_MBox.Pop(value))
+					{
+						std::this_thread::sleep_for(std::chrono::milliseconds(1));
+					}
+
+					while (!spu.SPU.Out_MBox.Push(value + 1))
+					{
+						std::this_thread::sleep_for(std::chrono::milliseconds(1));
+					}
+				}
+				else
+				{
+					u128 r;
+					spu.ReadChannel(r, SPU_RdInMbox);
+					r._u32[3]++;
+					spu.WriteChannel(SPU_WrOutMbox, r);
+				}
+			}
+		});
+
+		std::vector<u64> latency;
+
+		for (u32 i = 0; i < count; i++)
+		{
+			const auto start = test_clock::now();
+
+			Memory.WriteMMIO32(in_mbox, i);
+
+			while (!(Memory.ReadMMIO32(mbox_status) & 0xff))
+			{
+				if (Emu.IsStopped())
+				{
+					LOG_ERROR(GENERAL, "%s: aborted after %d round trips", name, i);
+					spu_side.join();
+					return errors + 1;
+				}
+
+				std::this_thread::yield();
+			}
+
+			const u32 value = Memory.ReadMMIO32(out_mbox);
+			latency.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(test_clock::now() - start).count());
+
+			if (value != i + 1)
+			{
+				errors++;
+			}
+		}
+
+		spu_side.join();
+
+		std::sort(latency.begin(), latency.end());
+
+		LOG_NOTICE(GENERAL, "%s: round trip: median %.1f us, p99 %.1f us, max %.1f us", name,
+			latency[count / 2] / 1000.0, latency[count * 99 / 100] / 1000.0, latency.back() / 1000.0);
+
+		if (errors)
+		{
+			LOG_ERROR(GENERAL, "%s: %d wrong answers", name, errors.load());
+		}
+
+		return errors;
+	}
+}
+
+void SPUThread::RunAllTests()
+{
+	static bool s_done = false;
+
+	if (s_done)
+	{
+		return;
+	}
+
+	s_done = true;
+
+	LOG_NOTICE(GENERAL, "Running SPU mailbox tests");
+
+	u32 num_failed = 0;
+
+	// the RawSPU is not started, the SPU side of the test uses its channels from another thread
+	RawSPUThread& spu = (RawSPUThread&)Emu.GetCPU().AddThread(CPU_THREAD_RAW_SPU);
+
+	num_failed += run_ping_pong(spu, "Mailbox (channel waits)", s_round_trips, false) != 0;
+	num_failed += run_ping_pong(spu, "Mailbox (sleep polling)", s_sleep_round_trips, true) != 0;
+
+	Emu.GetCPU().RemoveThread(spu.GetId());
+
+	LOG_NOTICE(GENERAL, "Unit Tests done (%d failed)", num_failed);
+}
+
+#else
+
+void SPUThread::RunAllTests()
+{
+}
+
+#endif // SPU_THREAD_UNIT_TESTS
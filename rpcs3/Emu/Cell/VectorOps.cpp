@@ -0,0 +1,76 @@
+#include "stdafx.h"
+#include "VectorOps.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#define SSSE3_TARGET
+#else
+#include <cpuid.h>
+#define SSSE3_TARGET __attribute__((target("ssse3")))
+#endif
+#include <tmmintrin.h>
+
+namespace simd
+{
+	static bool ssse3_supported()
+	{
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 1);
+		return (info[2] & (1 << 9)) != 0;
+#else
+		unsigned int a, b, c, d;
+		return __get_cpuid(1, &a, &b, &c, &d) && (c & (1 << 9));
+#endif
+	}
+
+	const bool g_has_ssse3 = ssse3_supported();
+
+	SSSE3_TARGET __m128i shufb_ssse3(const __m128i a, const __m128i b, const __m128i c)
+	{
+		// guest byte n is host byte 15 - n
+		const __m128i index = _mm_and_si128(_mm_xor_si128(c, _mm_set1_epi8(0x0f)), _mm_set1_epi8(0x0f));
+		const __m128i from_b = _mm_cmpeq_epi8(_mm_and_si128(c, _mm_set1_epi8(0x10)), _mm_set1_epi8(0x10));
+		const __m128i res = sel(from_b, _mm_shuffle_epi8(b, index), _mm_shuffle_epi8(a, index));
+
+		// constants selected by the high nibble: 10xx -> 0x00, 110x -> 0xff, 111x -> 0x80
+		const __m128i consts = _mm_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, -1, -1, (char)0x80, (char)0x80);
+		const __m128i special = _mm_shuffle_epi8(consts, _mm_and_si128(_mm_srli_epi16(c, 4), _mm_set1_epi8(0x0f)));
+		return sel(_mm_cmplt_epi8(c, _mm_setzero_si128()), special, res);
+	}
+
+	__m128i shufb_sse2(const __m128i a, const __m128i b, const __m128i c)
+	{
+		const u128 _a = u128::fromV(a), _b = u128::fromV(b), _c = u128::fromV(c);
+		u128 res;
+
+		for (int i = 0; i < 16; i++)
+		{
+			const u8 x = _c._u8[i];
+			res._u8[i] = x & 0x80 ? (x & 0x40 ? (x & 0x20 ? 0x80 : 0xff) : 0x00) : (x & 0x10 ? _b : _a)._u8[15 - (x & 0x0f)];
+		}
+
+		return res.vi;
+	}
+
+	SSSE3_TARGET __m128i vperm_ssse3(const __m128i a, const __m128i b, const __m128i c)
+	{
+		const __m128i index = _mm_and_si128(_mm_xor_si128(c, _mm_set1_epi8(0x0f)), _mm_set1_epi8(0x0f));
+		const __m128i from_b = _mm_cmpeq_epi8(_mm_and_si128(c, _mm_set1_epi8(0x10)), _mm_set1_epi8(0x10));
+		return sel(from_b, _mm_shuffle_epi8(b, index), _mm_shuffle_epi8(a, index));
+	}
+
+	__m128i vperm_sse2(const __m128i a, const __m128i b, const __m128i c)
+	{
+		const u128 _a = u128::fromV(a), _b = u128::fromV(b), _c = u128::fromV(c);
+		u128 res;
+
+		for (int i = 0; i < 16; i++)
+		{
+			const u8 x = _c._u8[i];
+			res._u8[i] = (x & 0x10 ? _b : _a)._u8[15 - (x & 0x0f)];
+		}
+
+		return res.vi;
+	}
+}
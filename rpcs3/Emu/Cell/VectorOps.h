@@ -0,0 +1,422 @@
+#pragma once
+
+// 128-bit vector kernels shared by the PPU (AltiVec) and SPU interpreters (and the recompilers, which use the interpreters as fallback).
+// Vector registers are stored in u128 with reversed element order (element 0 of the guest vector is in the highest host lane),
+// so the element-wise kernels don't depend on it; kernels which combine or move elements mention the host lane order.
+// SSE2 is enough for everything, the byte shuffles use SSSE3 if the host supports it.
+
+namespace simd
+{
+	extern const bool g_has_ssse3;
+
+	// bitwise select: mask ? a : b
+	static __forceinline __m128i sel(const __m128i mask, const __m128i a, const __m128i b)
+	{
+		return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+	}
+
+	// unsigned compares (sign bit flipped for the signed compare, see _mm_cmpgt_epu8 in GNU.h for bytes)
+	static __forceinline __m128i cmpgt_u16(const __m128i a, const __m128i b)
+	{
+		const __m128i sign = _mm_set1_epi16((short)0x8000);
+		return _mm_cmpgt_epi16(_mm_xor_si128(a, sign), _mm_xor_si128(b, sign));
+	}
+
+	static __forceinline __m128i cmpgt_u32(const __m128i a, const __m128i b)
+	{
+		const __m128i sign = _mm_set1_epi32(0x80000000);
+		return _mm_cmpgt_epi32(_mm_xor_si128(a, sign), _mm_xor_si128(b, sign));
+	}
+
+	// min/max which aren't available in SSE2
+	static __forceinline __m128i max_s8(const __m128i a, const __m128i b)
+	{
+		return sel(_mm_cmpgt_epi8(a, b), a, b);
+	}
+
+	static __forceinline __m128i min_s8(const __m128i a, const __m128i b)
+	{
+		return sel(_mm_cmpgt_epi8(a, b), b, a);
+	}
+
+	static __forceinline __m128i max_u16(const __m128i a, const __m128i b)
+	{
+		return _mm_add_epi16(_mm_subs_epu16(a, b), b);
+	}
+
+	static __forceinline __m128i min_u16(const __m128i a, const __m128i b)
+	{
+		return _mm_sub_epi16(a, _mm_subs_epu16(a, b));
+	}
+
+	static __forceinline __m128i max_s32(const __m128i a, const __m128i b)
+	{
+		return sel(_mm_cmpgt_epi32(a, b), a, b);
+	}
+
+	static __forceinline __m128i min_s32(const __m128i a, const __m128i b)
+	{
+		return sel(_mm_cmpgt_epi32(a, b), b, a);
+	}
+
+	static __forceinline __m128i max_u32(const __m128i a, const __m128i b)
+	{
+		return sel(cmpgt_u32(a, b), a, b);
+	}
+
+	static __forceinline __m128i min_u32(const __m128i a, const __m128i b)
+	{
+		return sel(cmpgt_u32(a, b), b, a);
+	}
+
+	// Saturating arithmetic. sat is set if any element has been saturated (it's never cleared, like VSCR.SAT).
+	// A saturated result never equals the wrapped-around one, so comparing both is enough.
+	static __forceinline void check_sat(const __m128i res, const __m128i wrapped, bool& sat)
+	{
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(res, wrapped)) != 0xffff) sat = true;
+	}
+
+	static __forceinline __m128i adds_s8(const __m128i a, const __m128i b, bool& sat)
+	{
+		const __m128i res = _mm_adds_epi8(a, b);
+		check_sat(res, _mm_add_epi8(a, b), sat);
+		return res;
+	}
+
+	static __forceinline __m128i adds_u8(const __m128i a, const __m128i b, bool& sat)
+	{
+		const __m128i res = _mm_adds_epu8(a, b);
+		check_sat(res, _mm_add_epi8(a, b), sat);
+		return res;
+	}
+
+	static __forceinline __m128i adds_s16(const __m128i a, const __m128i b, bool& sat)
+	{
+		const __m128i res = _mm_adds_epi16(a, b);
+		check_sat(res, _mm_add_epi16(a, b), sat);
+		return res;
+	}
+
+	static __forceinline __m128i adds_u16(const __m128i a, const __m128i b, bool& sat)
+	{
+		const __m128i res = _mm_adds_epu16(a, b);
+		check_sat(res, _mm_add_epi16(a, b), sat);
+		return res;
+	}
+
+	static __forceinline __m128i subs_s8(const __m128i a, const __m128i b, bool& sat)
+	{
+		const __m128i res = _mm_subs_epi8(a, b);
+		check_sat(res, _mm_sub_epi8(a, b), sat);
+		return res;
+	}
+
+	static __forceinline __m128i subs_u8(const __m128i a, const __m128i b, bool& sat)
+	{
+		const __m128i res = _mm_subs_epu8(a, b);
+		check_sat(res, _mm_sub_epi8(a, b), sat);
+		return res;
+	}
+
+	static __forceinline __m128i subs_s16(const __m128i a, const __m128i b, bool& sat)
+	{
+		const __m128i res = _mm_subs_epi16(a, b);
+		check_sat(res, _mm_sub_epi16(a, b), sat);
+		return res;
+	}
+
+	static __forceinline __m128i subs_u16(const __m128i a, const __m128i b, bool& sat)
+	{
+		const __m128i res = _mm_subs_epu16(a, b);
+		check_sat(res, _mm_sub_epi16(a, b), sat);
+		return res;
+	}
+
+	static __forceinline __m128i adds_s32(const __m128i a, const __m128i b, bool& sat)
+	{
+		const __m128i sum = _mm_add_epi32(a, b);
+		// overflow if both operands have the same sign and the sign of the sum differs
+		const __m128i ovf = _mm_srai_epi32(_mm_andnot_si128(_mm_xor_si128(a, b), _mm_xor_si128(a, sum)), 31);
+		if (_mm_movemask_epi8(ovf)) sat = true;
+		return sel(ovf, _mm_xor_si128(_mm_srai_epi32(a, 31), _mm_set1_epi32(0x7fffffff)), sum);
+	}
+
+	static __forceinline __m128i subs_s32(const __m128i a, const __m128i b, bool& sat)
+	{
+		const __m128i diff = _mm_sub_epi32(a, b);
+		// overflow if the operands have different signs and the sign of the difference isn't the sign of a
+		const __m128i ovf = _mm_srai_epi32(_mm_and_si128(_mm_xor_si128(a, b), _mm_xor_si128(a, diff)), 31);
+		if (_mm_movemask_epi8(ovf)) sat = true;
+		return sel(ovf, _mm_xor_si128(_mm_srai_epi32(a, 31), _mm_set1_epi32(0x7fffffff)), diff);
+	}
+
+	static __forceinline __m128i adds_u32(const __m128i a, const __m128i b, bool& sat)
+	{
+		const __m128i sum = _mm_add_epi32(a, b);
+		const __m128i carry = cmpgt_u32(a, sum);
+		if (_mm_movemask_epi8(carry)) sat = true;
+		return _mm_or_si128(sum, carry);
+	}
+
+	static __forceinline __m128i subs_u32(const __m128i a, const __m128i b, bool& sat)
+	{
+		const __m128i borrow = cmpgt_u32(b, a);
+		if (_mm_movemask_epi8(borrow)) sat = true;
+		return _mm_andnot_si128(borrow, _mm_sub_epi32(a, b));
+	}
+
+	// carry out of a + b (0 or 1), SPU CG and VADDCUW
+	static __forceinline __m128i carry_u32(const __m128i a, const __m128i b)
+	{
+		return _mm_srli_epi32(cmpgt_u32(a, _mm_add_epi32(a, b)), 31);
+	}
+
+	// 1 if a - b doesn't borrow (a >= b), SPU BG (with swapped operands) and VSUBCUW
+	static __forceinline __m128i no_borrow_u32(const __m128i a, const __m128i b)
+	{
+		return _mm_andnot_si128(cmpgt_u32(b, a), _mm_set1_epi32(1));
+	}
+
+	// rounding average (a + b + 1) >> 1
+	static __forceinline __m128i avg_s8(const __m128i a, const __m128i b)
+	{
+		const __m128i sign = _mm_set1_epi8((char)0x80);
+		return _mm_xor_si128(_mm_avg_epu8(_mm_xor_si128(a, sign), _mm_xor_si128(b, sign)), sign);
+	}
+
+	static __forceinline __m128i avg_s16(const __m128i a, const __m128i b)
+	{
+		const __m128i sign = _mm_set1_epi16((short)0x8000);
+		return _mm_xor_si128(_mm_avg_epu16(_mm_xor_si128(a, sign), _mm_xor_si128(b, sign)), sign);
+	}
+
+	static __forceinline __m128i avg_u32(const __m128i a, const __m128i b)
+	{
+		const __m128i round = _mm_and_si128(_mm_or_si128(a, b), _mm_set1_epi32(1));
+		return _mm_add_epi32(_mm_add_epi32(_mm_srli_epi32(a, 1), _mm_srli_epi32(b, 1)), round);
+	}
+
+	static __forceinline __m128i avg_s32(const __m128i a, const __m128i b)
+	{
+		const __m128i round = _mm_and_si128(_mm_or_si128(a, b), _mm_set1_epi32(1));
+		return _mm_add_epi32(_mm_add_epi32(_mm_srai_epi32(a, 1), _mm_srai_epi32(b, 1)), round);
+	}
+
+	static __forceinline __m128i absdiff_u8(const __m128i a, const __m128i b)
+	{
+		return _mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a));
+	}
+
+	// 16 x 16 -> 32 bit products of the low (bits 0-15) or high (bits 16-31) halfwords of each word
+	static __forceinline __m128i mul_lo_s16(const __m128i a, const __m128i b)
+	{
+		return _mm_madd_epi16(_mm_and_si128(a, _mm_set1_epi32(0xffff)), b);
+	}
+
+	static __forceinline __m128i mul_hi_s16(const __m128i a, const __m128i b)
+	{
+		return _mm_madd_epi16(_mm_and_si128(a, _mm_set1_epi32(0xffff0000)), b);
+	}
+
+	static __forceinline __m128i mul_lo_u16(const __m128i a, const __m128i b)
+	{
+		const __m128i lo = _mm_and_si128(_mm_mullo_epi16(a, b), _mm_set1_epi32(0xffff));
+		return _mm_or_si128(lo, _mm_slli_epi32(_mm_mulhi_epu16(a, b), 16));
+	}
+
+	static __forceinline __m128i mul_hi_u16(const __m128i a, const __m128i b)
+	{
+		return mul_lo_u16(_mm_srli_epi32(a, 16), _mm_srli_epi32(b, 16));
+	}
+
+	// 8 x 8 -> 16 bit products of the low (bits 0-7) or high (bits 8-15) bytes of each halfword
+	static __forceinline __m128i mul_lo_s8(const __m128i a, const __m128i b)
+	{
+		return _mm_mullo_epi16(_mm_srai_epi16(_mm_slli_epi16(a, 8), 8), _mm_srai_epi16(_mm_slli_epi16(b, 8), 8));
+	}
+
+	static __forceinline __m128i mul_hi_s8(const __m128i a, const __m128i b)
+	{
+		return _mm_mullo_epi16(_mm_srai_epi16(a, 8), _mm_srai_epi16(b, 8));
+	}
+
+	static __forceinline __m128i mul_lo_u8(const __m128i a, const __m128i b)
+	{
+		const __m128i mask = _mm_set1_epi16(0xff);
+		return _mm_mullo_epi16(_mm_and_si128(a, mask), _mm_and_si128(b, mask));
+	}
+
+	static __forceinline __m128i mul_hi_u8(const __m128i a, const __m128i b)
+	{
+		return _mm_mullo_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8));
+	}
+
+	// Saturating packs, lo fills the low host lanes of the result (the second operand of AltiVec pack instructions).
+	// sat is set if an element doesn't fit into the destination type.
+	static __forceinline void check_pack_sat(const __m128i lo, const __m128i hi, const __m128i bias, const int shift, bool& sat)
+	{
+		// an element fits if nothing but zeros remains after the bias is added and the destination bits are shifted out
+		const __m128i lo_rest = shift == 8 ? _mm_srli_epi16(_mm_add_epi16(lo, bias), 8) : _mm_srli_epi32(_mm_add_epi32(lo, bias), 16);
+		const __m128i hi_rest = shift == 8 ? _mm_srli_epi16(_mm_add_epi16(hi, bias), 8) : _mm_srli_epi32(_mm_add_epi32(hi, bias), 16);
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_or_si128(lo_rest, hi_rest), _mm_setzero_si128())) != 0xffff) sat = true;
+	}
+
+	// s16 -> s8
+	static __forceinline __m128i packs_s16(const __m128i lo, const __m128i hi, bool& sat)
+	{
+		check_pack_sat(lo, hi, _mm_set1_epi16(0x80), 8, sat);
+		return _mm_packs_epi16(lo, hi);
+	}
+
+	// s16 -> u8
+	static __forceinline __m128i packus_s16(const __m128i lo, const __m128i hi, bool& sat)
+	{
+		check_pack_sat(lo, hi, _mm_setzero_si128(), 8, sat);
+		return _mm_packus_epi16(lo, hi);
+	}
+
+	// u16 -> u8
+	static __forceinline __m128i packus_u16(const __m128i lo, const __m128i hi, bool& sat)
+	{
+		check_pack_sat(lo, hi, _mm_setzero_si128(), 8, sat);
+		const __m128i max = _mm_set1_epi16(0xff);
+		return _mm_packus_epi16(min_u16(lo, max), min_u16(hi, max));
+	}
+
+	// s32 -> s16
+	static __forceinline __m128i packs_s32(const __m128i lo, const __m128i hi, bool& sat)
+	{
+		check_pack_sat(lo, hi, _mm_set1_epi32(0x8000), 16, sat);
+		return _mm_packs_epi32(lo, hi);
+	}
+
+	// u32 (already in the 0..0xffff range) -> u16 (SSE2 only has the signed pack)
+	static __forceinline __m128i pack_u32_in_range(const __m128i lo, const __m128i hi)
+	{
+		const __m128i bias32 = _mm_set1_epi32(0x8000);
+		const __m128i packed = _mm_packs_epi32(_mm_sub_epi32(lo, bias32), _mm_sub_epi32(hi, bias32));
+		return _mm_xor_si128(packed, _mm_set1_epi16((short)0x8000));
+	}
+
+	// s32 -> u16
+	static __forceinline __m128i packus_s32(const __m128i lo, const __m128i hi, bool& sat)
+	{
+		check_pack_sat(lo, hi, _mm_setzero_si128(), 16, sat);
+		const __m128i max = _mm_set1_epi32(0xffff);
+		const __m128i zero = _mm_setzero_si128();
+		return pack_u32_in_range(min_s32(max_s32(lo, zero), max), min_s32(max_s32(hi, zero), max));
+	}
+
+	// u32 -> u16
+	static __forceinline __m128i packus_u32(const __m128i lo, const __m128i hi, bool& sat)
+	{
+		check_pack_sat(lo, hi, _mm_setzero_si128(), 16, sat);
+		const __m128i max = _mm_set1_epi32(0xffff);
+		return pack_u32_in_range(min_u32(lo, max), min_u32(hi, max));
+	}
+
+	// u32 -> float, correctly rounded (both halves are exact, so the sum is rounded once)
+	static __forceinline __m128 cvt_u32_f(const __m128i a)
+	{
+		const __m128 hi = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(a, 16)), _mm_set1_ps(65536.0f));
+		return _mm_add_ps(hi, _mm_cvtepi32_ps(_mm_and_si128(a, _mm_set1_epi32(0xffff))));
+	}
+
+	// compares of absolute values
+	static __forceinline __m128 abs_f(const __m128 a)
+	{
+		return _mm_and_ps(a, _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff)));
+	}
+
+	// replace the exponent of every element by exp, computed by the SPU conversions (the exponent field must be masked out)
+	static __forceinline __m128 set_exp_f(const __m128i a, const __m128i exp)
+	{
+		return _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(a, _mm_set1_epi32(0x807fffff)), _mm_slli_epi32(exp, 23)));
+	}
+
+	static __forceinline __m128i get_exp_f(const __m128i a)
+	{
+		return _mm_and_si128(_mm_srli_epi32(a, 23), _mm_set1_epi32(0xff));
+	}
+
+	// SPU CFLTS: float scaled by 2^(173 - i8) -> s32 (truncated, positive overflow saturates)
+	static __forceinline __m128i cflts(const __m128i a, const u32 i8)
+	{
+		const __m128i max_exp = _mm_set1_epi32(255);
+		const __m128i exp = _mm_add_epi32(get_exp_f(a), _mm_set1_epi32(173 - (i8 & 0xff)));
+		const __m128 scaled = set_exp_f(a, sel(cmpgt_u32(exp, max_exp), max_exp, exp));
+		const __m128i res = _mm_cvttps_epi32(scaled); // 0x80000000 if too big, too small or NaN
+		return sel(_mm_castps_si128(_mm_cmpgt_ps(scaled, _mm_set1_ps(2147483648.0f))), _mm_set1_epi32(0x7fffffff), res);
+	}
+
+	// SPU CFLTU: float scaled by 2^(173 - i8) -> u32 (truncated, negative values and NaN give 0, overflow saturates)
+	static __forceinline __m128i cfltu(const __m128i a, const u32 i8)
+	{
+		const __m128i max_exp = _mm_set1_epi32(255);
+		const __m128i exp = _mm_add_epi32(get_exp_f(a), _mm_set1_epi32(173 - (i8 & 0xff)));
+		const __m128 scaled = set_exp_f(a, sel(cmpgt_u32(exp, max_exp), max_exp, exp));
+		const __m128 big = _mm_cmpge_ps(scaled, _mm_set1_ps(2147483648.0f));
+		const __m128 rebased = _mm_sub_ps(scaled, _mm_and_ps(big, _mm_set1_ps(2147483648.0f)));
+		__m128i res = _mm_xor_si128(_mm_cvttps_epi32(rebased), _mm_and_si128(_mm_castps_si128(big), _mm_set1_epi32(0x80000000)));
+		res = _mm_or_si128(res, _mm_castps_si128(_mm_cmpgt_ps(scaled, _mm_set1_ps(4294967296.0f))));
+		const __m128i valid = _mm_andnot_si128(_mm_srai_epi32(a, 31), _mm_castps_si128(_mm_cmpord_ps(scaled, scaled)));
+		return _mm_and_si128(res, valid);
+	}
+
+	// SPU CSFLT/CUFLT: the converted value is scaled by 2^(i8 - 155), an exponent underflow gives 0 (with the mantissa kept)
+	static __forceinline __m128 scale_exp_down(const __m128 f, const u32 i8)
+	{
+		const __m128i bits = _mm_castps_si128(f);
+		const __m128i exp = _mm_sub_epi32(get_exp_f(bits), _mm_set1_epi32(155 - (i8 & 0xff)));
+		return set_exp_f(bits, _mm_andnot_si128(cmpgt_u32(exp, _mm_set1_epi32(255)), exp));
+	}
+
+	static __forceinline __m128 csflt(const __m128i a, const u32 i8)
+	{
+		return scale_exp_down(_mm_cvtepi32_ps(a), i8);
+	}
+
+	static __forceinline __m128 cuflt(const __m128i a, const u32 i8)
+	{
+		return scale_exp_down(cvt_u32_f(a), i8);
+	}
+
+	// AltiVec VCTSXS/VCTUXS: float multiplied by scale -> integer (truncated, saturated)
+	static __forceinline __m128i cvt_f_s32_sat(const __m128 a, const float scale)
+	{
+		const __m128 scaled = _mm_mul_ps(a, _mm_set1_ps(scale));
+		const __m128i res = _mm_cvttps_epi32(scaled); // 0x80000000 if too big, too small or NaN
+		return sel(_mm_castps_si128(_mm_cmpgt_ps(scaled, _mm_set1_ps(2147483648.0f))), _mm_set1_epi32(0x7fffffff), res);
+	}
+
+	static __forceinline __m128i cvt_f_u32_sat(const __m128 a, const float scale)
+	{
+		const __m128 scaled = _mm_mul_ps(a, _mm_set1_ps(scale));
+		const __m128 big = _mm_cmpge_ps(scaled, _mm_set1_ps(2147483648.0f));
+		const __m128 rebased = _mm_sub_ps(scaled, _mm_and_ps(big, _mm_set1_ps(2147483648.0f)));
+		__m128i res = _mm_xor_si128(_mm_cvttps_epi32(rebased), _mm_and_si128(_mm_castps_si128(big), _mm_set1_epi32(0x80000000)));
+		res = _mm_or_si128(res, _mm_castps_si128(_mm_cmpge_ps(scaled, _mm_set1_ps(4294967296.0f))));
+		// negative values (including -0.x which is truncated to 0 anyway) and NaN give 0
+		return _mm_and_si128(res, _mm_castps_si128(_mm_cmpgt_ps(scaled, _mm_set1_ps(-1.0f))));
+	}
+
+	// byte shuffles (SSSE3 or byte loop)
+	__m128i shufb_ssse3(const __m128i a, const __m128i b, const __m128i c);
+	__m128i shufb_sse2(const __m128i a, const __m128i b, const __m128i c);
+	__m128i vperm_ssse3(const __m128i a, const __m128i b, const __m128i c);
+	__m128i vperm_sse2(const __m128i a, const __m128i b, const __m128i c);
+
+	// SPU SHUFB: bytes selected from a:b by c (bytes 0x80-0xff of c give the constants 0x00, 0xff or 0x80)
+	static __forceinline __m128i shufb(const __m128i a, const __m128i b, const __m128i c)
+	{
+		return g_has_ssse3 ? shufb_ssse3(a, b, c) : shufb_sse2(a, b, c);
+	}
+
+	// AltiVec VPERM: bytes selected from a:b by the low 5 bits of c
+	static __forceinline __m128i vperm(const __m128i a, const __m128i b, const __m128i c)
+	{
+		return g_has_ssse3 ? vperm_ssse3(a, b, c) : vperm_sse2(a, b, c);
+	}
+
+	void RunAllTests();
+}
@@ -0,0 +1,365 @@
+#include "stdafx.h"
+#include "Utilities/Log.h"
+#include "VectorOps.h"
+
+//#define VECTOR_OPS_UNIT_TESTS 1
+
+#ifdef VECTOR_OPS_UNIT_TESTS
+#include <random>
+
+// Every kernel is compared with the element loop which the interpreters used before (the references below).
+// Byte kernels get all 65536 pairs of operands, wider kernels all pairs of edge values and random input.
+// Every pair is also tested alone (in all elements) because the saturation flag is set if any element saturates.
+
+namespace simd
+{
+	struct test_input
+	{
+		u128 a, b, c;
+	};
+
+	enum test_data
+	{
+		TEST_U8,
+		TEST_U16,
+		TEST_U32,
+		TEST_F32,
+	};
+
+	typedef std::function<void(const u128& a, const u128& b, const u128& c, u32 imm, u128& r, bool& sat)> test_func;
+
+	static const u32 s_num_random = 10000;
+
+	static std::vector<test_input> make_inputs(test_data type)
+	{
+		std::mt19937 rng(0x5eed);
+		std::vector<test_input> res;
+		std::vector<u32> edge;
+
+		auto random = [&rng]()
+		{
+			test_input in;
+			for (auto& v : in.a._u32) v = rng();
+			for (auto& v : in.b._u32) v = rng();
+			for (auto& v : in.c._u32) v = rng();
+			return in;
+		};
+
+		switch (type)
+		{
+		case TEST_U8:
+		{
+			// all pairs of bytes, 16 per vector
+			for (u32 i = 0; i < 0x10000; i += 16)
+			{
+				test_input in = random();
+				for (u32 j = 0; j < 16; j++)
+				{
+					in.a._u8[j] = (i + j) >> 8;
+					in.b._u8[j] = (i + j) & 0xff;
+				}
+				res.push_back(in);
+			}
+
+			// and every pair in all elements (for the saturation flag)
+			for (u32 i = 0; i < 0x10000; i++)
+			{
+				test_input in = random();
+				in.a.vi = _mm_set1_epi8(i >> 8);
+				in.b.vi = _mm_set1_epi8(i & 0xff);
+				res.push_back(in);
+			}
+			return res;
+		}
+
+		case TEST_U16: edge = { 0, 1, 2, 0x7e, 0x7f, 0x80, 0x81, 0xfe, 0xff, 0x100, 0x101, 0x7ffe, 0x7fff, 0x8000, 0x8001, 0xff00, 0xff7f, 0xff80, 0xfffe, 0xffff }; break;
+		case TEST_U32: edge = { 0, 1, 2, 0x7fff, 0x8000, 0xffff, 0x10000, 0x10001, 0x7ffffffe, 0x7fffffff, 0x80000000, 0x80000001, 0xffff0000, 0xffff7fff, 0xffff8000, 0xfffffffe, 0xffffffff }; break;
+		case TEST_F32: edge =
+		{
+			0x00000000, 0x80000000, 0x00000001, 0x807fffff, 0x00800000, 0x3f000000, 0xbf000000, 0x3f800000, 0xbf800000, 0x3fc00000, 0xbfc00000,
+			0x4effffff, 0x4f000000, 0x4f000001, 0xceffffff, 0xcf000000, 0xcf000001, 0x4f7fffff, 0x4f800000, 0x4f800001, 0x5effffff,
+			0x7f7fffff, 0xff7fffff, 0x7f800000, 0xff800000, 0x7fc00000, 0xffc00000, 0x7f800001, 0x4b000000, 0x4b7fffff, 0x4b800001,
+		};
+		break;
+		}
+
+		// all pairs of edge values (with random data in the remaining elements)
+		const u32 count = type == TEST_U16 ? 8 : 4;
+		for (u32 i = 0; i < edge.size() * edge.size(); i += count)
+		{
+			test_input in = random();
+			for (u32 j = 0; j < count && i + j < edge.size() * edge.size(); j++)
+			{
+				const u32 x = edge[(i + j) / edge.size()], y = edge[(i + j) % edge.size()];
+				if (count == 8) in.a._u16[j] = x, in.b._u16[j] = y, in.c._u16[j] = y;
+				else in.a._u32[j] = x, in.b._u32[j] = y, in.c._u32[j] = y;
+			}
+			res.push_back(in);
+		}
+
+		// every pair in all elements (for the saturation flag)
+		for (auto x : edge)
+		{
+			for (auto y : edge)
+			{
+				test_input in;
+				in.a.vi = count == 8 ? _mm_set1_epi16(x) : _mm_set1_epi32(x);
+				in.b.vi = in.c.vi = count == 8 ? _mm_set1_epi16(y) : _mm_set1_epi32(y);
+				res.push_back(in);
+			}
+		}
+
+		for (u32 i = 0; i < s_num_random; i++)
+		{
+			res.push_back(random());
+		}
+
+		// random floats of moderate magnitude, which the conversions don't saturate
+		if (type == TEST_F32)
+		{
+			for (u32 i = 0; i < s_num_random; i++)
+			{
+				test_input in = random();
+				for (u32 j = 0; j < 4; j++)
+				{
+					in.a._u32[j] = (in.a._u32[j] & 0x807fffff) | ((in.a._u32[j] >> 23) % 48 + 110) << 23;
+				}
+				res.push_back(in);
+			}
+		}
+
+		return res;
+	}
+
+	// float results are compared bitwise, except that any NaN matches any NaN (the NaN propagated by x86 depends on the order of operands)
+	static bool same_result(const u128& res, const u128& expected, bool float_result)
+	{
+		if (res == expected) return true;
+		if (!float_result) return false;
+
+		for (u32 i = 0; i < 4; i++)
+		{
+			if (res._u32[i] != expected._u32[i] && !(res._f[i] != res._f[i] && expected._f[i] != expected._f[i])) return false;
+		}
+
+		return true;
+	}
+
+	static u32 run_test(const char* name, test_data type, u32 imm_count, bool float_result, const test_func& kernel, const test_func& reference)
+	{
+		static std::vector<test_input> inputs[4];
+		if (inputs[type].empty()) inputs[type] = make_inputs(type);
+
+		for (auto& in : inputs[type])
+		{
+			for (u32 imm = 0; imm < imm_count; imm++)
+			{
+				u128 res, expected;
+				bool sat = false, expected_sat = false;
+				kernel(in.a, in.b, in.c, imm, res, sat);
+				reference(in.a, in.b, in.c, imm, expected, expected_sat);
+
+				if (!same_result(res, expected, float_result) || sat != expected_sat)
+				{
+					LOG_ERROR(GENERAL, "[UT simd::%s] Test failed (imm=%d): a=%s b=%s c=%s -> %s (sat=%d), expected %s (sat=%d)", name, imm,
+						in.a.to_hex().c_str(), in.b.to_hex().c_str(), in.c.to_hex().c_str(), res.to_hex().c_str(), sat, expected.to_hex().c_str(), expected_sat);
+					return 1;
+				}
+			}
+		}
+
+		return 0;
+	}
+
+#define TEST_IMPL(name, type, imm_count, float_result, kernel, ...) \
+	num_failed += run_test(name, type, imm_count, float_result, [](const u128& a, const u128& b, const u128& c, u32 imm, u128& r, bool& sat) { kernel; }, \
+		[](const u128& a, const u128& b, const u128& c, u32 imm, u128& r, bool& sat) { __VA_ARGS__ })
+
+#define TEST(name, type, imm_count, kernel, ...) TEST_IMPL(name, type, imm_count, false, kernel, __VA_ARGS__)
+#define TEST_F(name, type, imm_count, kernel, ...) TEST_IMPL(name, type, imm_count, true, kernel, __VA_ARGS__)
+
+#define FOR_B for (int i = 0; i < 16; i++)
+#define FOR_H for (int i = 0; i < 8; i++)
+#define FOR_W for (int i = 0; i < 4; i++)
+
+	void RunAllTests()
+	{
+		LOG_NOTICE(GENERAL, "Running Unit Tests (SSSE3 %s)", g_has_ssse3 ? "enabled" : "disabled");
+
+		u32 num_failed = 0;
+
+		// compares, min/max
+		TEST("cmpgt_u16", TEST_U16, 1, r.vi = cmpgt_u16(a.vi, b.vi), FOR_H r._u16[i] = a._u16[i] > b._u16[i] ? 0xffff : 0;);
+		TEST("cmpgt_u32", TEST_U32, 1, r.vi = cmpgt_u32(a.vi, b.vi), FOR_W r._u32[i] = a._u32[i] > b._u32[i] ? 0xffffffff : 0;);
+		TEST("sel", TEST_U32, 1, r.vi = sel(c.vi, b.vi, a.vi), FOR_W r._u32[i] = (b._u32[i] & c._u32[i]) | (a._u32[i] & ~c._u32[i]););
+		TEST("max_s8", TEST_U8, 1, r.vi = max_s8(a.vi, b.vi), FOR_B r._s8[i] = std::max(a._s8[i], b._s8[i]););
+		TEST("min_s8", TEST_U8, 1, r.vi = min_s8(a.vi, b.vi), FOR_B r._s8[i] = std::min(a._s8[i], b._s8[i]););
+		TEST("max_u16", TEST_U16, 1, r.vi = max_u16(a.vi, b.vi), FOR_H r._u16[i] = std::max(a._u16[i], b._u16[i]););
+		TEST("min_u16", TEST_U16, 1, r.vi = min_u16(a.vi, b.vi), FOR_H r._u16[i] = std::min(a._u16[i], b._u16[i]););
+		TEST("max_s32", TEST_U32, 1, r.vi = max_s32(a.vi, b.vi), FOR_W r._s32[i] = std::max(a._s32[i], b._s32[i]););
+		TEST("min_s32", TEST_U32, 1, r.vi = min_s32(a.vi, b.vi), FOR_W r._s32[i] = std::min(a._s32[i], b._s32[i]););
+		TEST("max_u32", TEST_U32, 1, r.vi = max_u32(a.vi, b.vi), FOR_W r._u32[i] = std::max(a._u32[i], b._u32[i]););
+		TEST("min_u32", TEST_U32, 1, r.vi = min_u32(a.vi, b.vi), FOR_W r._u32[i] = std::min(a._u32[i], b._u32[i]););
+
+		// saturating arithmetic
+		TEST("adds_s8", TEST_U8, 1, r.vi = adds_s8(a.vi, b.vi, sat), FOR_B { s16 v = a._s8[i] + b._s8[i]; if (v > 0x7f) v = 0x7f, sat = true; else if (v < -0x80) v = -0x80, sat = true; r._s8[i] = (s8)v; });
+		TEST("adds_u8", TEST_U8, 1, r.vi = adds_u8(a.vi, b.vi, sat), FOR_B { u16 v = a._u8[i] + b._u8[i]; if (v > 0xff) v = 0xff, sat = true; r._u8[i] = (u8)v; });
+		TEST("subs_s8", TEST_U8, 1, r.vi = subs_s8(a.vi, b.vi, sat), FOR_B { s16 v = a._s8[i] - b._s8[i]; if (v > 0x7f) v = 0x7f, sat = true; else if (v < -0x80) v = -0x80, sat = true; r._s8[i] = (s8)v; });
+		TEST("subs_u8", TEST_U8, 1, r.vi = subs_u8(a.vi, b.vi, sat), FOR_B { s16 v = a._u8[i] - b._u8[i]; if (v < 0) v = 0, sat = true; r._u8[i] = (u8)v; });
+		TEST("adds_s16", TEST_U16, 1, r.vi = adds_s16(a.vi, b.vi, sat), FOR_H { s32 v = a._s16[i] + b._s16[i]; if (v > 0x7fff) v = 0x7fff, sat = true; else if (v < -0x8000) v = -0x8000, sat = true; r._s16[i] = (s16)v; });
+		TEST("adds_u16", TEST_U16, 1, r.vi = adds_u16(a.vi, b.vi, sat), FOR_H { u32 v = a._u16[i] + b._u16[i]; if (v > 0xffff) v = 0xffff, sat = true; r._u16[i] = (u16)v; });
+		TEST("subs_s16", TEST_U16, 1, r.vi = subs_s16(a.vi, b.vi, sat), FOR_H { s32 v = a._s16[i] - b._s16[i]; if (v > 0x7fff) v = 0x7fff, sat = true; else if (v < -0x8000) v = -0x8000, sat = true; r._s16[i] = (s16)v; });
+		TEST("subs_u16", TEST_U16, 1, r.vi = subs_u16(a.vi, b.vi, sat), FOR_H { s32 v = a._u16[i] - b._u16[i]; if (v < 0) v = 0, sat = true; r._u16[i] = (u16)v; });
+		TEST("adds_s32", TEST_U32, 1, r.vi = adds_s32(a.vi, b.vi, sat), FOR_W { s64 v = (s64)a._s32[i] + b._s32[i]; if (v > 0x7fffffff) v = 0x7fffffff, sat = true; else if (v < -0x80000000ll) v = -0x80000000ll, sat = true; r._s32[i] = (s32)v; });
+		TEST("adds_u32", TEST_U32, 1, r.vi = adds_u32(a.vi, b.vi, sat), FOR_W { u64 v = (u64)a._u32[i] + b._u32[i]; if (v > 0xffffffff) v = 0xffffffff, sat = true; r._u32[i] = (u32)v; });
+		TEST("subs_s32", TEST_U32, 1, r.vi = subs_s32(a.vi, b.vi, sat), FOR_W { s64 v = (s64)a._s32[i] - b._s32[i]; if (v > 0x7fffffff) v = 0x7fffffff, sat = true; else if (v < -0x80000000ll) v = -0x80000000ll, sat = true; r._s32[i] = (s32)v; });
+		TEST("subs_u32", TEST_U32, 1, r.vi = subs_u32(a.vi, b.vi, sat), FOR_W { s64 v = (s64)a._u32[i] - b._u32[i]; if (v < 0) v = 0, sat = true; r._u32[i] = (u32)v; });
+
+		// carry/borrow, averages, absolute difference
+		TEST("carry_u32", TEST_U32, 1, r.vi = carry_u32(a.vi, b.vi), FOR_W r._u32[i] = ~a._u32[i] < b._u32[i];);
+		TEST("no_borrow_u32", TEST_U32, 1, r.vi = no_borrow_u32(a.vi, b.vi), FOR_W r._u32[i] = a._u32[i] < b._u32[i] ? 0 : 1;);
+		TEST("avg_s8", TEST_U8, 1, r.vi = avg_s8(a.vi, b.vi), FOR_B r._s8[i] = (a._s8[i] + b._s8[i] + 1) >> 1;);
+		TEST("avg_s16", TEST_U16, 1, r.vi = avg_s16(a.vi, b.vi), FOR_H r._s16[i] = (a._s16[i] + b._s16[i] + 1) >> 1;);
+		TEST("avg_s32", TEST_U32, 1, r.vi = avg_s32(a.vi, b.vi), FOR_W r._s32[i] = (s32)(((s64)a._s32[i] + (s64)b._s32[i] + 1) >> 1););
+		TEST("avg_u32", TEST_U32, 1, r.vi = avg_u32(a.vi, b.vi), FOR_W r._u32[i] = (u32)(((u64)a._u32[i] + (u64)b._u32[i] + 1) >> 1););
+		TEST("absdiff_u8", TEST_U8, 1, r.vi = absdiff_u8(a.vi, b.vi), FOR_B r._u8[i] = b._u8[i] > a._u8[i] ? b._u8[i] - a._u8[i] : a._u8[i] - b._u8[i];);
+
+		// multiplication
+		TEST("mul_lo_s16", TEST_U16, 1, r.vi = mul_lo_s16(a.vi, b.vi), FOR_W r._s32[i] = a._s16[i * 2] * b._s16[i * 2];);
+		TEST("mul_hi_s16", TEST_U16, 1, r.vi = mul_hi_s16(a.vi, b.vi), FOR_W r._s32[i] = a._s16[i * 2 + 1] * b._s16[i * 2 + 1];);
+		TEST("mul_lo_u16", TEST_U16, 1, r.vi = mul_lo_u16(a.vi, b.vi), FOR_W r._u32[i] = (u32)a._u16[i * 2] * b._u16[i * 2];);
+		TEST("mul_hi_u16", TEST_U16, 1, r.vi = mul_hi_u16(a.vi, b.vi), FOR_W r._u32[i] = (u32)a._u16[i * 2 + 1] * b._u16[i * 2 + 1];);
+		TEST("mul_lo_s8", TEST_U8, 1, r.vi = mul_lo_s8(a.vi, b.vi), FOR_H r._s16[i] = (s16)a._s8[i * 2] * (s16)b._s8[i * 2];);
+		TEST("mul_hi_s8", TEST_U8, 1, r.vi = mul_hi_s8(a.vi, b.vi), FOR_H r._s16[i] = (s16)a._s8[i * 2 + 1] * (s16)b._s8[i * 2 + 1];);
+		TEST("mul_lo_u8", TEST_U8, 1, r.vi = mul_lo_u8(a.vi, b.vi), FOR_H r._u16[i] = (u16)a._u8[i * 2] * (u16)b._u8[i * 2];);
+		TEST("mul_hi_u8", TEST_U8, 1, r.vi = mul_hi_u8(a.vi, b.vi), FOR_H r._u16[i] = (u16)a._u8[i * 2 + 1] * (u16)b._u8[i * 2 + 1];);
+		TEST("spu_mpyh", TEST_U16, 1, r.vi = _mm_slli_epi32(_mm_mullo_epi16(_mm_srli_epi32(a.vi, 16), b.vi), 16), FOR_W r._s32[i] = (a._s16[i * 2 + 1] * b._s16[i * 2]) << 16;);
+		TEST("spu_mpys", TEST_U16, 1, r.vi = _mm_srai_epi32(mul_lo_s16(a.vi, b.vi), 16), FOR_W r._s32[i] = (a._s16[i * 2] * b._s16[i * 2]) >> 16;);
+
+		// packs (a is the high half like the first operand of AltiVec instructions)
+		TEST("packs_s16", TEST_U16, 1, r.vi = packs_s16(b.vi, a.vi, sat), FOR_H {
+			s16 v = a._s16[i]; if (v > 0x7f) v = 0x7f, sat = true; else if (v < -0x80) v = -0x80, sat = true; r._s8[i + 8] = (s8)v;
+			v = b._s16[i]; if (v > 0x7f) v = 0x7f, sat = true; else if (v < -0x80) v = -0x80, sat = true; r._s8[i] = (s8)v; });
+		TEST("packus_s16", TEST_U16, 1, r.vi = packus_s16(b.vi, a.vi, sat), FOR_H {
+			s16 v = a._s16[i]; if (v > 0xff) v = 0xff, sat = true; else if (v < 0) v = 0, sat = true; r._u8[i + 8] = (u8)v;
+			v = b._s16[i]; if (v > 0xff) v = 0xff, sat = true; else if (v < 0) v = 0, sat = true; r._u8[i] = (u8)v; });
+		TEST("packus_u16", TEST_U16, 1, r.vi = packus_u16(b.vi, a.vi, sat), FOR_H {
+			u16 v = a._u16[i]; if (v > 0xff) v = 0xff, sat = true; r._u8[i + 8] = (u8)v;
+			v = b._u16[i]; if (v > 0xff) v = 0xff, sat = true; r._u8[i] = (u8)v; });
+		TEST("packs_s32", TEST_U32, 1, r.vi = packs_s32(b.vi, a.vi, sat), FOR_W {
+			s32 v = a._s32[i]; if (v > 0x7fff) v = 0x7fff, sat = true; else if (v < -0x8000) v = -0x8000, sat = true; r._s16[i + 4] = (s16)v;
+			v = b._s32[i]; if (v > 0x7fff) v = 0x7fff, sat = true; else if (v < -0x8000) v = -0x8000, sat = true; r._s16[i] = (s16)v; });
+		TEST("packus_s32", TEST_U32, 1, r.vi = packus_s32(b.vi, a.vi, sat), FOR_W {
+			s32 v = a._s32[i]; if (v > 0xffff) v = 0xffff, sat = true; else if (v < 0) v = 0, sat = true; r._u16[i + 4] = (u16)v;
+			v = b._s32[i]; if (v > 0xffff) v = 0xffff, sat = true; else if (v < 0) v = 0, sat = true; r._u16[i] = (u16)v; });
+		TEST("packus_u32", TEST_U32, 1, r.vi = packus_u32(b.vi, a.vi, sat), FOR_W {
+			u32 v = a._u32[i]; if (v > 0xffff) v = 0xffff, sat = true; r._u16[i + 4] = (u16)v;
+			v = b._u32[i]; if (v > 0xffff) v = 0xffff, sat = true; r._u16[i] = (u16)v; });
+
+		// floating point
+		TEST("fcmgt", TEST_F32, 1, r.vf = _mm_cmpgt_ps(abs_f(a.vf), abs_f(b.vf)), FOR_W r._u32[i] = fabs(a._f[i]) > fabs(b._f[i]) ? 0xffffffff : 0;);
+		TEST("fcmeq", TEST_F32, 1, r.vf = _mm_cmpeq_ps(abs_f(a.vf), abs_f(b.vf)), FOR_W r._u32[i] = fabs(a._f[i]) == fabs(b._f[i]) ? 0xffffffff : 0;);
+		TEST_F("vmaxfp", TEST_F32, 1, r.vf = _mm_max_ps(b.vf, a.vf), FOR_W r._f[i] = std::max(a._f[i], b._f[i]););
+		TEST_F("vminfp", TEST_F32, 1, r.vf = _mm_min_ps(b.vf, a.vf), FOR_W r._f[i] = std::min(a._f[i], b._f[i]););
+		TEST_F("vnmsubfp", TEST_F32, 1, r.vf = _mm_xor_ps(_mm_sub_ps(_mm_mul_ps(a.vf, c.vf), b.vf), _mm_set1_ps(-0.0f)), FOR_W r._f[i] = -(a._f[i] * c._f[i] - b._f[i]););
+		TEST("cvt_u32_f", TEST_U32, 1, r.vf = cvt_u32_f(a.vi), FOR_W r._f[i] = (float)a._u32[i];);
+		TEST("vcfsx", TEST_U32, 32, r.vf = _mm_div_ps(_mm_cvtepi32_ps(a.vi), _mm_set1_ps((float)(1u << imm))), FOR_W r._f[i] = ((float)a._s32[i]) / (u32)(1u << imm););
+		TEST("vcfux", TEST_U32, 32, r.vf = _mm_div_ps(cvt_u32_f(a.vi), _mm_set1_ps((float)(1u << imm))), FOR_W r._f[i] = ((float)a._u32[i]) / (u32)(1u << imm););
+
+		TEST("cvt_f_s32_sat", TEST_F32, 32, r.vi = cvt_f_s32_sat(a.vf, (float)(s32)(1u << imm)), FOR_W {
+			const float v = a._f[i] * (s32)(1u << imm);
+			if (v > 0x7fffffff) r._s32[i] = 0x7fffffff;
+			else if (v < -pow(2, 31)) r._s32[i] = 0x80000000;
+			else r._s32[i] = _mm_cvttss_si32(_mm_set_ss(v)); // (int)v, without the UB for NaN and 2^31
+		});
+
+		TEST("cvt_f_u32_sat", TEST_F32, 32, r.vi = cvt_f_u32_sat(a.vf, (float)(s32)(1u << imm)), FOR_W {
+			const float v = a._f[i] * (s32)(1u << imm);
+			// the old loop truncated to s64 which overflows (to 0) at 2^63, the kernel saturates properly
+			const s64 t = v >= 9223372036854775808.0f ? 0x100000000ll : v != v ? 0 : (s64)v;
+			r._u32[i] = t > 0xffffffffll ? 0xffffffff : t < 0 ? 0 : (u32)t;
+		});
+
+		// SPU conversions
+		TEST("cflts", TEST_F32, 256, r.vi = cflts(a.vi, imm), FOR_W {
+			u32 exp = ((a._u32[i] >> 23) & 0xff) + (173 - imm);
+			if (exp > 255) exp = 255;
+			r._u32[i] = (a._u32[i] & 0x807fffff) | (exp << 23);
+			if (r._f[i] > 0x7fffffff) r._u32[i] = 0x7fffffff;
+			else if (r._f[i] < -pow(2, 31)) r._u32[i] = 0x80000000;
+			else r._s32[i] = _mm_cvttss_si32(_mm_set_ss(r._f[i]));
+		});
+
+		TEST("cfltu", TEST_F32, 256, r.vi = cfltu(a.vi, imm), FOR_W {
+			u32 exp = ((a._u32[i] >> 23) & 0xff) + (173 - imm);
+			if (exp > 255) exp = 255;
+			if (a._u32[i] & 0x80000000) r._u32[i] = 0;
+			else
+			{
+				r._u32[i] = (a._u32[i] & 0x807fffff) | (exp << 23);
+				if (r._f[i] > 0xffffffff) r._u32[i] = 0xffffffff;
+				else r._u32[i] = (u32)_mm_cvttsd_si64(_mm_set_sd(floor(r._f[i]))); // (u32)floor(v) on x64
+			}
+		});
+
+		TEST("csflt", TEST_U32, 256, r.vf = csflt(a.vi, imm), FOR_W {
+			r._f[i] = (float)a._s32[i];
+			u32 exp = ((r._u32[i] >> 23) & 0xff) - (155 - imm);
+			if (exp > 255) exp = 0;
+			r._u32[i] = (r._u32[i] & 0x807fffff) | (exp << 23);
+		});
+
+		TEST("cuflt", TEST_U32, 256, r.vf = cuflt(a.vi, imm), FOR_W {
+			r._f[i] = (float)a._u32[i];
+			u32 exp = ((r._u32[i] >> 23) & 0xff) - (155 - imm);
+			if (exp > 255) exp = 0;
+			r._u32[i] = (r._u32[i] & 0x807fffff) | (exp << 23);
+		});
+
+		// shuffles (all values of the selector bytes are covered by TEST_U8)
+		auto shufb_ref = [](const u128& a, const u128& b, const u128& c, u32 imm, u128& r, bool& sat)
+		{
+			FOR_B
+			{
+				const u8 x = c._u8[i];
+				if (x & 0x80) r._u8[i] = x & 0x40 ? (x & 0x20 ? 0x80 : 0xff) : 0x00;
+				else r._u8[i] = x & 0x10 ? b._u8[15 - (x & 0x0f)] : a._u8[15 - (x & 0x0f)];
+			}
+		};
+
+		auto vperm_ref = [](const u128& a, const u128& b, const u128& c, u32 imm, u128& r, bool& sat)
+		{
+			u8 src[32];
+			memcpy(src, b._u8, 16);
+			memcpy(src + 16, a._u8, 16);
+			FOR_B r._u8[i] = src[0x1f - (c._u8[i] & 0x1f)];
+		};
+
+		// the selector is taken from the exhaustive byte pairs
+		num_failed += run_test("shufb_sse2", TEST_U8, 1, false, [](const u128& a, const u128& b, const u128& c, u32, u128& r, bool&) { r.vi = shufb_sse2(c.vi, b.vi, a.vi); },
+			[shufb_ref](const u128& a, const u128& b, const u128& c, u32 imm, u128& r, bool& sat) { shufb_ref(c, b, a, imm, r, sat); });
+		num_failed += run_test("vperm_sse2", TEST_U8, 1, false, [](const u128& a, const u128& b, const u128& c, u32, u128& r, bool&) { r.vi = vperm_sse2(c.vi, b.vi, a.vi); },
+			[vperm_ref](const u128& a, const u128& b, const u128& c, u32 imm, u128& r, bool& sat) { vperm_ref(c, b, a, imm, r, sat); });
+
+		if (g_has_ssse3)
+		{
+			num_failed += run_test("shufb_ssse3", TEST_U8, 1, false, [](const u128& a, const u128& b, const u128& c, u32, u128& r, bool&) { r.vi = shufb_ssse3(c.vi, b.vi, a.vi); },
+				[shufb_ref](const u128& a, const u128& b, const u128& c, u32 imm, u128& r, bool& sat) { shufb_ref(c, b, a, imm, r, sat); });
+			num_failed += run_test("vperm_ssse3", TEST_U8, 1, false, [](const u128& a, const u128& b, const u128& c, u32, u128& r, bool&) { r.vi = vperm_ssse3(c.vi, b.vi, a.vi); },
+				[vperm_ref](const u128& a, const u128& b, const u128& c, u32 imm, u128& r, bool& sat) { vperm_ref(c, b, a, imm, r, sat); });
+		}
+
+		LOG_NOTICE(GENERAL, "Unit Tests done (%d failed)", num_failed);
+	}
+}
+
+#else
+
+namespace simd
+{
+	void RunAllTests()
+	{
+	}
+}
+
+#endif // VECTOR_OPS_UNIT_TESTS
@@ -0,0 +1,71 @@
+#include "stdafx.h"
+#include "vfsMemoryFile.h"
+
+vfsMemoryFile::vfsMemoryFile()
+	: vfsFileBase(nullptr)
+	, m_opened(false)
+{
+}
+
+bool vfsMemoryFile::Open(const std::string& path, vfsOpenMode mode)
+{
+	Close();
+
+	m_opened = true;
+
+	return vfsFileBase::Open(path, mode);
+}
+
+bool vfsMemoryFile::Close()
+{
+	m_data.clear();
+	m_data.shrink_to_fit();
+	m_opened = false;
+
+	return vfsFileBase::Close();
+}
+
+u64 vfsMemoryFile::GetSize()
+{
+	return m_data.size();
+}
+
+u64 vfsMemoryFile::Write(const void* src, u64 size)
+{
+	if (!m_opened)
+	{
+		return 0;
+	}
+
+	// writing past the end extends the file with zeros
+	if (Tell() + size > m_data.size())
+	{
+		m_data.resize(Tell() + size);
+	}
+
+	memcpy(m_data.data() + Tell(), src, size);
+
+	return vfsStream::Write(src, size);
+}
+
+u64 vfsMemoryFile::Read(void* dst, u64 size)
+{
+	if (Tell() >= m_data.size())
+	{
+		return 0;
+	}
+
+	if (Tell() + size > m_data.size())
+	{
+		size = m_data.size() - Tell();
+	}
+
+	memcpy(dst, m_data.data() + Tell(), size);
+
+	return vfsStream::Read(dst, size);
+}
+
+bool vfsMemoryFile::IsOpened() const
+{
+	return m_opened;
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include "vfsFileBase.h"
+
+// File stored in a host memory buffer (unlike vfsStreamMemory, which accesses guest memory).
+// Used for files which are produced by the emulator itself, e.g. ELF images decrypted from SELF files.
+class vfsMemoryFile : public vfsFileBase
+{
+private:
+	std::vector<u8> m_data;
+	bool m_opened;
+
+public:
+	vfsMemoryFile();
+
+	// create an empty file, path is only used as the name of the file
+	virtual bool Open(const std::string& path, vfsOpenMode mode = vfsReadWrite) override;
+	virtual bool Close() override;
+
+	virtual u64 GetSize() override;
+
+	virtual u64 Write(const void* src, u64 size) override;
+	virtual u64 Read(void* dst, u64 size) override;
+
+	virtual bool IsOpened() const override;
+
+	const std::vector<u8>& GetData() const { return m_data; }
+};
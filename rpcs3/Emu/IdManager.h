@@ -1,5 +1,6 @@
 #pragma once
 #include <unordered_map>
+#include <deque>
 
 #define rID_ANY -1 // was wxID_ANY
 
@@ -116,18 +117,66 @@ public:
 
 class IdManager
 {
+	// ID layout: the low bits select a slot in the table, the high bits hold the generation of that slot.
+	// Slots are recycled in FIFO order and bump their generation on every release, so a stale ID does not
+	// alias a newly created object until the slot has been reused s_gen_count times.
+	static const u32 s_slot_bits = 20;
+	static const u32 s_slot_mask = (1 << s_slot_bits) - 1;
+	static const u32 s_gen_count = 1 << (32 - s_slot_bits);
 	static const u32 s_first_id = 1;
-	static const u32 s_max_id = -1;
+	static const u32 s_max_slot = s_slot_mask - 1; // never hand out rID_ANY
+
+	static const u32 s_page_bits = 12;
+	static const u32 s_page_size = 1 << s_page_bits;
+	static const u32 s_page_count = (s_slot_mask + 1) >> s_page_bits;
+
+	struct IDSlot
+	{
+		std::atomic<u32> id; // currently stored ID, 0 if the slot is free
+		u32 gen;
+		ID data;
+
+		// copies of the data for lock-free readers (see FindIDData)
+		std::atomic<void*> ptr;
+		std::atomic<const std::string*> name;
+		std::atomic<u32> type;
+	};
+
+	// Pages are allocated on demand and only released by Clear(), so lookups never touch freed memory
+	std::atomic<IDSlot*> m_pages[s_page_count];
+	std::deque<u32> m_free_slots;
+	std::atomic<u32> m_count;
+	u32 m_next_slot;
+	std::mutex m_mtx_alloc;
 
-	std::unordered_map<u32, ID> m_id_map;
 	std::set<u32> m_types[TYPE_OTHER];
-	std::mutex m_mtx_main;
+	std::mutex m_mtx_types[TYPE_OTHER];
+
+	// names of the IDs (module names), never freed so that lock-free readers can compare them
+	std::set<std::string> m_names;
+
+	ID m_null_id;
 
-	u32 m_cur_id;
+	IDSlot* GetSlot(const u32 id) const
+	{
+		const u32 slot = id & s_slot_mask;
+		IDSlot* page = m_pages[slot >> s_page_bits].load(std::memory_order_acquire);
+
+		if (!page) {
+			return nullptr;
+		}
+
+		return &page[slot & (s_page_size - 1)];
+	}
 
 public:
-	IdManager() : m_cur_id(s_first_id)
+	IdManager()
+		: m_count(0)
+		, m_next_slot(s_first_id)
 	{
+		for (auto& page : m_pages) {
+			page.store(nullptr, std::memory_order_relaxed);
+		}
 	}
 	
 	~IdManager()
@@ -135,23 +184,103 @@ public:
 		Clear();
 	}
 
-	bool CheckID(const u32 id)
+	// Wait-free: safe to call concurrently with creation and removal of other IDs
+	ID* FindID(const u32 id) const
+	{
+		if (id == (u32)rID_ANY) {
+			return nullptr;
+		}
+
+		IDSlot* slot = GetSlot(id);
+
+		if (!slot || slot->id.load(std::memory_order_acquire) != id) {
+			return nullptr;
+		}
+
+		return &slot->data;
+	}
+
+	bool CheckID(const u32 id) const
+	{
+		return FindID(id) != nullptr;
+	}
+
+	// Wait-free: the data is read between two loads of the slot ID and the lookup fails if the slot was released
+	// (and possibly reused by another object) meanwhile, so the result always belongs to the requested ID
+	bool FindIDData(const u32 id, void*& ptr, IDType& type, const std::string*& name) const
+	{
+		if (id == (u32)rID_ANY) {
+			return false;
+		}
+
+		IDSlot* slot = GetSlot(id);
+
+		if (!slot || slot->id.load(std::memory_order_acquire) != id) {
+			return false;
+		}
+
+		void* const p = slot->ptr.load(std::memory_order_relaxed);
+		const std::string* const n = slot->name.load(std::memory_order_relaxed);
+		const u32 t = slot->type.load(std::memory_order_relaxed);
+
+		// pairs with the release fence in GetNewID: if the copies were overwritten by a new object, the ID is seen as changed
+		std::atomic_thread_fence(std::memory_order_acquire);
+
+		if (slot->id.load(std::memory_order_relaxed) != id) {
+			return false;
+		}
+
+		ptr = p;
+		type = (IDType)t;
+		name = n;
+		return true;
+	}
+
+	// the data of an ID created with the given name
+	template<typename T>
+	bool FindIDData(const u32 id, const std::string& name, T*& result) const
 	{
-		std::lock_guard<std::mutex> lock(m_mtx_main);
+		void* ptr;
+		IDType type;
+		const std::string* id_name;
 
-		return m_id_map.find(id) != m_id_map.end();
+		if (!FindIDData(id, ptr, type, id_name) || *id_name != name) {
+			return false;
+		}
+
+		result = (T*)ptr;
+		return true;
 	}
 
 	void Clear()
 	{
-		std::lock_guard<std::mutex> lock(m_mtx_main);
+		std::lock_guard<std::mutex> lock(m_mtx_alloc);
+
+		for (auto& p : m_pages) {
+			IDSlot* page = p.exchange(nullptr);
+
+			if (!page) {
+				continue;
+			}
+
+			for (u32 i = 0; i < s_page_size; i++) {
+				if (page[i].id.load()) {
+					page[i].data.Kill();
+				}
+			}
 
-		for(auto& i : m_id_map) {
-			i.second.Kill();
+			delete[] page;
 		}
 
-		m_id_map.clear();
-		m_cur_id = s_first_id;
+		for (u32 i = 0; i < TYPE_OTHER; i++) {
+			std::lock_guard<std::mutex> type_lock(m_mtx_types[i]);
+
+			m_types[i].clear();
+		}
+
+		m_free_slots.clear();
+		m_next_slot = s_first_id;
+		m_count = 0;
 	}
 	
 	template<typename T 
@@ -161,65 +290,119 @@ public:
 	>
 	u32 GetNewID(const std::string& name = "", T* data = nullptr, const IDType type = TYPE_OTHER)
 	{
-		std::lock_guard<std::mutex> lock(m_mtx_main);
+		IDSlot* slot;
+		u32 id;
+
+		{
+			std::lock_guard<std::mutex> lock(m_mtx_alloc);
+
+			u32 index;
+			if (!m_free_slots.empty()) {
+				index = m_free_slots.front();
+				m_free_slots.pop_front();
+			}
+			else if (m_next_slot <= s_max_slot) {
+				index = m_next_slot++;
+
+				auto& page = m_pages[index >> s_page_bits];
+				if (!page.load(std::memory_order_relaxed)) {
+					IDSlot* new_page = new IDSlot[s_page_size];
+
+					for (u32 i = 0; i < s_page_size; i++) {
+						new_page[i].id.store(0, std::memory_order_relaxed);
+						new_page[i].gen = 0;
+						new_page[i].ptr.store(nullptr, std::memory_order_relaxed);
+						new_page[i].name.store(nullptr, std::memory_order_relaxed);
+						new_page[i].type.store(TYPE_OTHER, std::memory_order_relaxed);
+					}
+
+					page.store(new_page, std::memory_order_release);
+				}
+			}
+			else {
+				throw std::string("IdManager::GetNewID(): out of IDs");
+			}
+
+			slot = GetSlot(index);
+			id = (slot->gen << s_slot_bits) | index;
+			slot->data = ID(name, data, type);
+
+			// the slot ID was set to 0 by RemoveID before the slot was freed, a reader which sees the new copies
+			// sees that too (see FindIDData)
+			std::atomic_thread_fence(std::memory_order_release);
+			slot->ptr.store(data, std::memory_order_relaxed);
+			slot->name.store(&*m_names.insert(name).first, std::memory_order_relaxed);
+			slot->type.store(type, std::memory_order_relaxed);
+
+			slot->id.store(id, std::memory_order_release);
+			m_count++;
+		}
 
-		m_id_map[m_cur_id] = ID(name, data, type);
 		if (type < TYPE_OTHER) {
-			m_types[type].insert(m_cur_id);
+			std::lock_guard<std::mutex> lock(m_mtx_types[type]);
+
+			m_types[type].insert(id);
 		}
 
-		return m_cur_id++;
+		return id;
 	}
 	
 	ID& GetID(const u32 id)
 	{
-		std::lock_guard<std::mutex> lock(m_mtx_main);
+		ID* result = FindID(id);
 
-		return m_id_map[id];
+		return result ? *result : m_null_id;
 	}
 
 	template<typename T>
 	bool GetIDData(const u32 id, T*& result)
 	{
-		std::lock_guard<std::mutex> lock(m_mtx_main);
+		void* ptr;
+		IDType type;
+		const std::string* name;
 
-		auto f = m_id_map.find(id);
-		if (f == m_id_map.end()) {
+		if (!FindIDData(id, ptr, type, name)) {
 			return false;
 		}
 
-		result = f->second.GetData()->get<T>();
+		result = (T*)ptr;
 
 		return true;
 	}
 
 	bool HasID(const u32 id)
 	{
-		{
-			std::lock_guard<std::mutex> lock(m_mtx_main);
-
-			if(id == rID_ANY) {
-				return m_id_map.begin() != m_id_map.end();
-			}
+		if(id == (u32)rID_ANY) {
+			return m_count.load() != 0;
 		}
+
 		return CheckID(id);
 	}
 
 	bool RemoveID(const u32 id)
 	{
-		std::lock_guard<std::mutex> lock(m_mtx_main);
-
-		auto item = m_id_map.find(id);
+		IDSlot* slot = GetSlot(id);
+		u32 expected = id;
 
-		if (item == m_id_map.end()) {
+		if (id == (u32)rID_ANY || !slot || !slot->id.compare_exchange_strong(expected, 0)) {
 			return false;
 		}
-		if (item->second.GetType() < TYPE_OTHER) {
-			m_types[item->second.GetType()].erase(id);
+
+		const IDType type = slot->data.GetType();
+
+		if (type < TYPE_OTHER) {
+			std::lock_guard<std::mutex> lock(m_mtx_types[type]);
+
+			m_types[type].erase(id);
 		}
 
-		item->second.Kill();
-		m_id_map.erase(item);
+		slot->data.Kill();
+
+		std::lock_guard<std::mutex> lock(m_mtx_alloc);
+
+		slot->gen = (slot->gen + 1) % s_gen_count;
+		m_free_slots.push_back(id & s_slot_mask);
+		m_count--;
 
 		return true;
 	}
@@ -227,14 +410,21 @@ public:
 	u32 GetTypeCount(IDType type)
 	{
 		if (type < TYPE_OTHER) {
+			std::lock_guard<std::mutex> lock(m_mtx_types[type]);
+
 			return (u32)m_types[type].size();
 		}
 		return 1;
 	}
 
-	const std::set<u32>& GetTypeIDs(IDType type)
+	// a copy, the set is modified by other threads
+	std::set<u32> GetTypeIDs(IDType type)
 	{
 		assert(type < TYPE_OTHER);
+		std::lock_guard<std::mutex> lock(m_mtx_types[type]);
+
 		return m_types[type];
 	}
+
+	static void RunAllTests();
 };
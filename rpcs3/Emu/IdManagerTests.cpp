@@ -0,0 +1,198 @@
+#include "stdafx.h"
+#include "Utilities/Log.h"
+#include "IdManager.h"
+
+//#define ID_MANAGER_UNIT_TESTS 1
+
+#ifdef ID_MANAGER_UNIT_TESTS
+#include <unordered_map>
+
+// Lookups from many threads while another thread creates and removes IDs. Every lookup which succeeds must return the
+// object of the requested ID, the benchmark compares the lookup rate with a map guarded by a mutex (the old design).
+
+namespace
+{
+	// objects are never freed during the test, so a reader can check an object it found after it was removed
+	struct test_object
+	{
+		std::atomic<u32> id;
+
+		static std::atomic<u32> s_next;
+		static test_object s_pool[];
+
+		static void* operator new(size_t size)
+		{
+			return &s_pool[s_next++];
+		}
+
+		static void operator delete(void* ptr)
+		{
+		}
+	};
+
+	const u32 s_pool_size = 1 << 20;
+	std::atomic<u32> test_object::s_next(0);
+	test_object test_object::s_pool[s_pool_size];
+
+	const u32 s_live_ids = 1024;
+	const u32 s_lookups = 1 << 22;
+	const u32 s_churn = 200000;
+
+	typedef std::function<bool(u32 id, test_object*& obj)> lookup_func;
+
+	// returns the number of wrong results, the time is the average of one lookup over all threads
+	u32 run_lookups(u32 threads, std::atomic<u32>* ids, const lookup_func& lookup, const std::function<void()>& writer, double& ns)
+	{
+		std::atomic<u32> errors(0);
+		std::atomic<bool> stop(false);
+
+		std::thread churn([&]()
+		{
+			while (!stop) writer();
+		});
+
+		const auto start = std::chrono::high_resolution_clock::now();
+		std::vector<std::thread> readers;
+
+		for (u32 t = 0; t < threads; t++)
+		{
+			readers.emplace_back([&, t]()
+			{
+				u32 x = 0x9e3779b9 * (t + 1);
+
+				for (u32 i = 0; i < s_lookups; i++)
+				{
+					x = x * 1664525 + 1013904223;
+					const u32 id = ids[(x >> 16) % s_live_ids].load(std::memory_order_relaxed);
+					test_object* obj;
+
+					if (id && lookup(id, obj))
+					{
+						const u32 obj_id = obj->id.load();
+						if (obj_id && obj_id != id) errors++;
+					}
+				}
+			});
+		}
+
+		for (auto& r : readers) r.join();
+
+		ns = std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count() / s_lookups;
+
+		stop = true;
+		churn.join();
+		return errors;
+	}
+}
+
+void IdManager::RunAllTests()
+{
+	LOG_NOTICE(GENERAL, "Running IdManager tests");
+
+	u32 num_failed = 0;
+	const u32 max_threads = std::max<u32>(std::thread::hardware_concurrency(), 2);
+
+	for (u32 threads = 1; threads <= max_threads; threads *= 2)
+	{
+		if (test_object::s_next + 2 * (s_churn + s_live_ids) > s_pool_size)
+		{
+			break;
+		}
+
+		// slot table
+		{
+			IdManager* manager = new IdManager();
+			std::atomic<u32> ids[s_live_ids];
+			u32 churn_count = 0;
+			u32 pos = 0;
+
+			for (auto& id : ids)
+			{
+				test_object* obj = new test_object;
+				id = manager->GetNewID<test_object>("test", obj, TYPE_SEMAPHORE);
+				obj->id = id.load();
+			}
+
+			double ns;
+			const u32 errors = run_lookups(threads, ids, [manager](u32 id, test_object*& obj)
+			{
+				return manager->FindIDData(id, "test", obj);
+			},
+			[&]()
+			{
+				if (churn_count++ >= s_churn) return;
+
+				// replace an ID, the readers may still look up the removed one
+				const u32 old_id = ids[pos];
+				manager->RemoveID(old_id);
+
+				test_object* obj = new test_object;
+				const u32 id = manager->GetNewID<test_object>("test", obj, TYPE_SEMAPHORE);
+				obj->id = id;
+				ids[pos] = id;
+				pos = (pos + 1) % s_live_ids;
+			}, ns);
+
+			if (errors || manager->GetTypeCount(TYPE_SEMAPHORE) != s_live_ids || manager->GetTypeIDs(TYPE_SEMAPHORE).size() != s_live_ids)
+			{
+				LOG_ERROR(GENERAL, "IdManager: %d wrong lookups with %d threads", errors, threads);
+				num_failed++;
+			}
+
+			delete manager;
+
+			LOG_NOTICE(GENERAL, "IdManager: %d threads: %.1f ns per lookup and thread (slot table)", threads, ns);
+		}
+
+		// global map and mutex
+		{
+			std::unordered_map<u32, test_object*> map;
+			std::mutex mutex;
+			std::atomic<u32> ids[s_live_ids];
+			u32 next_id = 1;
+			u32 churn_count = 0;
+			u32 pos = 0;
+
+			for (auto& id : ids)
+			{
+				test_object* obj = new test_object;
+				obj->id = id = next_id++;
+				map[id] = obj;
+			}
+
+			double ns;
+			run_lookups(threads, ids, [&map, &mutex](u32 id, test_object*& obj)
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				auto found = map.find(id);
+				if (found == map.end()) return false;
+				obj = found->second;
+				return true;
+			},
+			[&]()
+			{
+				if (churn_count++ >= s_churn) return;
+
+				test_object* obj = new test_object;
+				std::lock_guard<std::mutex> lock(mutex);
+				map.erase(ids[pos]);
+				obj->id = next_id;
+				map[next_id] = obj;
+				ids[pos] = next_id++;
+				pos = (pos + 1) % s_live_ids;
+			}, ns);
+
+			LOG_NOTICE(GENERAL, "IdManager: %d threads: %.1f ns per lookup and thread (map and mutex)", threads, ns);
+		}
+	}
+
+	LOG_NOTICE(GENERAL, "Unit Tests done (%d failed)", num_failed);
+}
+
+#else
+
+void IdManager::RunAllTests()
+{
+}
+
+#endif // ID_MANAGER_UNIT_TESTS
@@ -71,19 +71,32 @@ u32 MemoryBase::InitRawSPU(MemoryBlock* raw_spu)
 	u32 index;
 	for (index = 0; index < sizeof(RawSPUMem) / sizeof(RawSPUMem[0]); index++)
 	{
-		if (!RawSPUMem[index])
+		if (!RawSPUMem[index].block)
 		{
-			RawSPUMem[index] = raw_spu;
 			break;
 		}
 	}
 
 	MemoryBlocks.push_back(raw_spu->SetRange(RAW_SPU_BASE_ADDR + RAW_SPU_OFFSET * index, RAW_SPU_PROB_OFFSET));
+
+	// publish it after the range is set, MMIO accesses may see it immediately
+	if (index < sizeof(RawSPUMem) / sizeof(RawSPUMem[0])) RawSPUMem[index].block = raw_spu;
 	return index;
 }
 
 void MemoryBase::CloseRawSPU(MemoryBlock* raw_spu, const u32 num)
 {
+	if (num < sizeof(RawSPUMem) / sizeof(RawSPUMem[0]))
+	{
+		RawSPUMem[num].block = nullptr;
+
+		// wait for MMIO accesses which could still see the RawSPU (without holding the lv2 lock)
+		while (RawSPUMem[num].users)
+		{
+			std::this_thread::yield();
+		}
+	}
+
 	LV2_LOCK(0);
 
 	for (int i = 0; i < MemoryBlocks.size(); ++i)
@@ -94,7 +107,6 @@ void MemoryBase::CloseRawSPU(MemoryBlock* raw_spu, const u32 num)
 			break;
 		}
 	}
-	if (num < sizeof(RawSPUMem) / sizeof(RawSPUMem[0])) RawSPUMem[num] = nullptr;
 }
 
 void MemoryBase::Init(MemoryType type)
@@ -105,7 +117,11 @@ void MemoryBase::Init(MemoryType type)
 	m_inited = true;
 
 	memset(m_pages, 0, sizeof(m_pages));
-	memset(RawSPUMem, 0, sizeof(RawSPUMem));
+	for (auto& slot : RawSPUMem)
+	{
+		slot.block = nullptr;
+		slot.users = 0;
+	}
 
 #ifdef _WIN32
 	if (!g_base_addr)
@@ -168,13 +184,31 @@ void MemoryBase::Close()
 	MemoryBlocks.clear();
 }
 
+// registers an MMIO access, the RawSPU (if any) can't be destroyed until it's finished
+struct raw_spu_access_t
+{
+	MemoryBase::RawSPUSlot& slot;
+	RawSPUThread* thread;
+
+	raw_spu_access_t(MemoryBase::RawSPUSlot& slot)
+		: slot(slot)
+	{
+		slot.users++; // seq_cst: CloseRawSPU() either sees the counter or this access sees nullptr
+		thread = (RawSPUThread*)slot.block.load();
+	}
+
+	~raw_spu_access_t()
+	{
+		slot.users--;
+	}
+};
+
 void MemoryBase::WriteMMIO32(u32 addr, const u32 data)
 {
 	{
-		LV2_LOCK(0);
+		raw_spu_access_t access(RawSPUMem[(addr - RAW_SPU_BASE_ADDR) / RAW_SPU_OFFSET]);
 
-		if (RawSPUMem[(addr - RAW_SPU_BASE_ADDR) / RAW_SPU_OFFSET] &&
-			((RawSPUThread*)RawSPUMem[(addr - RAW_SPU_BASE_ADDR) / RAW_SPU_OFFSET])->Write32(addr, data))
+		if (access.thread && access.thread->Write32(addr, data))
 		{
 			return;
 		}
@@ -187,10 +221,9 @@ u32 MemoryBase::ReadMMIO32(u32 addr)
 {
 	u32 res;
 	{
-		LV2_LOCK(0);
+		raw_spu_access_t access(RawSPUMem[(addr - RAW_SPU_BASE_ADDR) / RAW_SPU_OFFSET]);
 
-		if (RawSPUMem[(addr - RAW_SPU_BASE_ADDR) / RAW_SPU_OFFSET] &&
-			((RawSPUThread*)RawSPUMem[(addr - RAW_SPU_BASE_ADDR) / RAW_SPU_OFFSET])->Read32(addr, &res))
+		if (access.thread && access.thread->Read32(addr, &res))
 		{
 			return res;
 		}
@@ -260,8 +293,8 @@ MemBlockInfo::MemBlockInfo(u64 _addr, u32 _size)
 	}
 	else
 	{
+		// pages are zero because they were never touched or were discarded by MemBlockInfo::Free()
 		Memory.RegisterPages(_addr, PAGE_4K(_size));
-		memset(mem, 0, size);
 	}
 }
 
@@ -273,7 +306,7 @@ void MemBlockInfo::Free()
 #ifdef _WIN32
 		if (!VirtualFree(mem, size, MEM_DECOMMIT))
 #else
-		if (::mprotect(mem, size, PROT_NONE))
+		if (::madvise(mem, size, MADV_DONTNEED) || ::mprotect(mem, size, PROT_NONE))
 #endif
 		{
 			LOG_ERROR(MEMORY, "Memory deallocation failed (addr=0x%llx, size=0x%x)", addr, size);
@@ -353,22 +386,21 @@ bool MemoryBlock::IsMyAddress(const u64 addr)
 
 DynamicMemoryBlockBase::DynamicMemoryBlockBase()
 	: MemoryBlock()
+	, m_used_size(0)
 	, m_max_size(0)
 {
 }
 
 const u32 DynamicMemoryBlockBase::GetUsedSize() const
 {
-	LV2_LOCK(0);
-
-	u32 size = 0;
+	return m_used_size.load();
+}
 
-	for (u32 i = 0; i<m_allocated.size(); ++i)
-	{
-		size += m_allocated[i].size;
-	}
+u32 DynamicMemoryBlockBase::GetMaxFreeSize()
+{
+	std::lock_guard<std::mutex> lock(m_lock);
 
-	return size;
+	return m_free_bins.empty() ? 0 : m_free_bins.rbegin()->first;
 }
 
 bool DynamicMemoryBlockBase::IsInMyRange(const u64 addr)
@@ -388,7 +420,7 @@ bool DynamicMemoryBlockBase::IsMyAddress(const u64 addr)
 
 MemoryBlock* DynamicMemoryBlockBase::SetRange(const u64 start, const u32 size)
 {
-	LV2_LOCK(0);
+	std::lock_guard<std::mutex> lock(m_lock);
 
 	m_max_size = PAGE_4K(size);
 	if (!MemoryBlock::SetRange(start, 0))
@@ -397,19 +429,122 @@ MemoryBlock* DynamicMemoryBlockBase::SetRange(const u64 start, const u32 size)
 		return nullptr;
 	}
 
+	m_free.clear();
+	m_free_bins.clear();
+
+	if (m_max_size)
+	{
+		AddFree(start, m_max_size);
+	}
+
 	return this;
 }
 
 void DynamicMemoryBlockBase::Delete()
 {
-	LV2_LOCK(0);
+	std::map<u64, MemBlockInfo> allocated;
 
-	m_allocated.clear();
-	m_max_size = 0;
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+
+		allocated.swap(m_allocated);
+		m_free.clear();
+		m_free_bins.clear();
+		m_used_size = 0;
+		m_max_size = 0;
+	}
+
+	// decommit pages
+	allocated.clear();
 
 	MemoryBlock::Delete();
 }
 
+void DynamicMemoryBlockBase::AddFree(u64 addr, u32 size) /* private */
+{
+	// merge with the following extent
+	auto next = m_free.find(addr + size);
+	if (next != m_free.end())
+	{
+		size += next->second;
+		RemoveFree(next);
+	}
+
+	// merge with the preceding extent
+	auto prev = m_free.lower_bound(addr);
+	if (prev != m_free.begin())
+	{
+		prev--;
+
+		if (prev->first + prev->second == addr)
+		{
+			addr = prev->first;
+			size += prev->second;
+			RemoveFree(prev);
+		}
+	}
+
+	m_free.emplace(addr, size);
+	m_free_bins.emplace(size, addr);
+}
+
+void DynamicMemoryBlockBase::RemoveFree(std::map<u64, u32>::iterator it) /* private */
+{
+	m_free_bins.erase(std::make_pair(it->second, it->first));
+	m_free.erase(it);
+}
+
+bool DynamicMemoryBlockBase::ReserveFixed(u64 addr, u32 size) /* private */
+{
+	// find the free extent containing addr
+	auto it = m_free.upper_bound(addr);
+	if (it == m_free.begin())
+	{
+		return false;
+	}
+
+	it--;
+
+	const u64 start = it->first;
+	const u64 end = start + it->second;
+
+	if (addr + size > end)
+	{
+		return false;
+	}
+
+	RemoveFree(it);
+
+	if (addr > start)
+	{
+		AddFree(start, (u32)(addr - start));
+	}
+
+	if (addr + size < end)
+	{
+		AddFree(addr + size, (u32)(end - addr - size));
+	}
+
+	return true;
+}
+
+u64 DynamicMemoryBlockBase::ReserveAlign(u32 size, u32 align) /* private */
+{
+	// the smallest free extent that can hold the block (the lowest address is taken among equal sizes)
+	for (auto it = m_free_bins.lower_bound(std::make_pair(size, (u64)0)); it != m_free_bins.end(); it++)
+	{
+		const u64 addr = align ? (it->second + (align - 1)) & ~(u64)(align - 1) : it->second;
+
+		if (addr + size <= it->second + it->first)
+		{
+			ReserveFixed(addr, size);
+			return addr;
+		}
+	}
+
+	return 0;
+}
+
 bool DynamicMemoryBlockBase::AllocFixed(u64 addr, u32 size)
 {
 	if (!MemoryBlock::GetStartAddr())
@@ -428,11 +563,10 @@ bool DynamicMemoryBlockBase::AllocFixed(u64 addr, u32 size)
 		return false;
 	}
 
-	LV2_LOCK(0);
-
-	for (u32 i = 0; i<m_allocated.size(); ++i)
 	{
-		if (addr >= m_allocated[i].addr && addr < m_allocated[i].addr + m_allocated[i].size) return false;
+		std::lock_guard<std::mutex> lock(m_lock);
+
+		if (!ReserveFixed(addr, size)) return false;
 	}
 
 	AppendMem(addr, size);
@@ -442,7 +576,13 @@ bool DynamicMemoryBlockBase::AllocFixed(u64 addr, u32 size)
 
 void DynamicMemoryBlockBase::AppendMem(u64 addr, u32 size) /* private */
 {
-	m_allocated.emplace_back(addr, size);
+	// the range is already reserved, so pages are committed without holding the lock
+	MemBlockInfo info(addr, size);
+
+	std::lock_guard<std::mutex> lock(m_lock);
+
+	m_allocated.emplace(addr, std::move(info));
+	m_used_size += size;
 }
 
 u64 DynamicMemoryBlockBase::AllocAlign(u32 size, u32 align)
@@ -454,51 +594,31 @@ u64 DynamicMemoryBlockBase::AllocAlign(u32 size, u32 align)
 	}
 
 	size = PAGE_4K(size);
-	u32 exsize;
 
 	if (align <= 4096)
 	{
 		align = 0;
-		exsize = size;
 	}
 	else
 	{
 		align &= ~4095;
-		exsize = size + align - 1;
 	}
 
-	LV2_LOCK(0);
+	u64 addr;
 
-	for (u64 addr = MemoryBlock::GetStartAddr(); addr <= MemoryBlock::GetEndAddr() - exsize;)
 	{
-		bool is_good_addr = true;
-
-		for (u32 i = 0; i<m_allocated.size(); ++i)
-		{
-			if ((addr >= m_allocated[i].addr && addr < m_allocated[i].addr + m_allocated[i].size) ||
-				(m_allocated[i].addr >= addr && m_allocated[i].addr < addr + exsize))
-			{
-				is_good_addr = false;
-				addr = m_allocated[i].addr + m_allocated[i].size;
-				break;
-			}
-		}
-
-		if (!is_good_addr) continue;
+		std::lock_guard<std::mutex> lock(m_lock);
 
-		if (align)
-		{
-			addr = (addr + (align - 1)) & ~(align - 1);
-		}
+		addr = ReserveAlign(size, align);
+	}
 
-		//LOG_NOTICE(MEMORY, "AllocAlign(size=0x%x) -> 0x%llx", size, addr);
+	if (!addr) return 0;
 
-		AppendMem(addr, size);
+	//LOG_NOTICE(MEMORY, "AllocAlign(size=0x%x) -> 0x%llx", size, addr);
 
-		return addr;
-	}
+	AppendMem(addr, size);
 
-	return 0;
+	return addr;
 }
 
 bool DynamicMemoryBlockBase::Alloc()
@@ -508,25 +628,38 @@ bool DynamicMemoryBlockBase::Alloc()
 
 bool DynamicMemoryBlockBase::Free(u64 addr)
 {
-	LV2_LOCK(0);
+	u32 size;
 
-	for (u32 num = 0; num < m_allocated.size(); num++)
 	{
-		if (addr == m_allocated[num].addr)
-		{
-			//LOG_NOTICE(MEMORY, "Free(0x%llx)", addr);
+		std::unique_lock<std::mutex> lock(m_lock);
 
-			m_allocated.erase(m_allocated.begin() + num);
-			return true;
+		auto it = m_allocated.find(addr);
+		if (it == m_allocated.end())
+		{
+			LOG_ERROR(MEMORY, "DynamicMemoryBlock::Free(addr=0x%llx): failed", addr);
+			for (auto& block : m_allocated)
+			{
+				LOG_NOTICE(MEMORY, "*** Memory Block: addr = 0x%llx, size = 0x%x", block.second.addr, block.second.size);
+			}
+			return false;
 		}
-	}
 
-	LOG_ERROR(MEMORY, "DynamicMemoryBlock::Free(addr=0x%llx): failed", addr);
-	for (u32 i = 0; i < m_allocated.size(); i++)
-	{
-		LOG_NOTICE(MEMORY, "*** Memory Block: addr = 0x%llx, size = 0x%x", m_allocated[i].addr, m_allocated[i].size);
+		//LOG_NOTICE(MEMORY, "Free(0x%llx)", addr);
+
+		MemBlockInfo info(std::move(it->second));
+		m_allocated.erase(it);
+		size = info.size;
+
+		// pages are decommitted when info is destroyed, after the lock is released
+		lock.unlock();
 	}
-	return false;
+
+	// the range can't be reused until the pages are decommitted
+	std::lock_guard<std::mutex> lock(m_lock);
+
+	AddFree(addr, size);
+	m_used_size -= size;
+	return true;
 }
 
 u8* DynamicMemoryBlockBase::GetMem(u64 addr) const
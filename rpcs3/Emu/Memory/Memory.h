@@ -37,7 +37,16 @@ public:
 	DynamicMemoryBlock RSXCMDMem;
 	DynamicMemoryBlock RSXFBMem;
 	DynamicMemoryBlock StackMem;
-	MemoryBlock* RawSPUMem[(0x100000000 - RAW_SPU_BASE_ADDR) / RAW_SPU_OFFSET];
+
+	// RawSPU problem state area, MMIO accesses use it without locking
+	struct RawSPUSlot
+	{
+		std::atomic<MemoryBlock*> block;
+		std::atomic<u32> users; // MMIO accesses in progress (CloseRawSPU() waits for them)
+	};
+
+	RawSPUSlot RawSPUMem[(0x100000000 - RAW_SPU_BASE_ADDR) / RAW_SPU_OFFSET];
+
 	VirtualMemoryBlock RSXIOMem;
 
 	struct
@@ -126,6 +135,9 @@ public:
 
 	__noinline u32 ReadMMIO32(u32 addr);
 
+	// MMIO polling benchmark (empty unless enabled in MemoryTests.cpp)
+	static void RunAllTests();
+
 	u32 GetUserMemTotalSize()
 	{
 		return UserMemory->GetSize();
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <map>
+
 #define PAGE_4K(x) (x + 4095) & ~(4095)
 
 //#include <emmintrin.h>
@@ -116,7 +118,11 @@ public:
 
 class DynamicMemoryBlockBase : public MemoryBlock
 {
-	std::vector<MemBlockInfo> m_allocated; // allocation info
+	std::mutex m_lock; // protects the maps below, pages are committed and decommitted without holding it
+	std::map<u64, MemBlockInfo> m_allocated; // allocation info (addr -> block)
+	std::map<u64, u32> m_free; // free extents ordered by address (addr -> size), adjacent extents are always merged
+	std::set<std::pair<u32, u64>> m_free_bins; // the same extents ordered by (size, addr) for the best fit search
+	std::atomic<u32> m_used_size;
 	u32 m_max_size;
 
 public:
@@ -124,6 +130,7 @@ public:
 
 	const u32 GetSize() const { return m_max_size; }
 	const u32 GetUsedSize() const;
+	u32 GetMaxFreeSize(); // size of the largest free extent
 
 	virtual bool IsInMyRange(const u64 addr);
 	virtual bool IsInMyRange(const u64 addr, const u32 size);
@@ -145,6 +152,10 @@ public:
 
 private:
 	void AppendMem(u64 addr, u32 size);
+	void AddFree(u64 addr, u32 size);
+	void RemoveFree(std::map<u64, u32>::iterator it);
+	bool ReserveFixed(u64 addr, u32 size);
+	u64 ReserveAlign(u32 size, u32 align);
 };
 
 class VirtualMemoryBlock : public MemoryBlock
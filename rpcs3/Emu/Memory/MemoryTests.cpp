@@ -0,0 +1,442 @@
+#include "stdafx.h"
+#include "Utilities/Log.h"
+#include "Memory.h"
+#include "Emu/System.h"
+#include "Emu/CPU/CPUThreadManager.h"
+#include "Emu/Cell/RawSPUThread.h"
+
+//#define MEMORY_UNIT_TESTS 1
+
+#ifdef MEMORY_UNIT_TESTS
+#include <random>
+
+// Throughput of RawSPU MMIO polling (a mailbox status register, read with ReadMMIO32()) while other threads make
+// "syscalls" (hold the lv2 lock for a short time), compared with the old dispatch which took the lv2 lock for every
+// access. Syscalls per second are reported as well, the read values are checked.
+// DynamicMemoryBlock tests (on a block in an unused part of the address space): adjacent free extents are merged,
+// AllocFixed() fails on overlaps, AllocAlign() returns aligned addresses, and random allocations and frees are checked
+// against a model. The churn benchmark reports operations per second and the fragmentation (the part of the free memory
+// which is not in the largest free extent), compared with a model of the old first-fit search (without page commits).
+// The memory is initialized when a game is loaded, so this is called from Emulator::Run() (only the first time).
+
+namespace
+{
+	const u32 s_run_ms = 500;
+	const u64 s_block_addr = 0x60000000; // unused by the PS3 memory map
+	const u32 s_block_size = 0x10000000;
+	const u32 s_random_ops = 5000;
+	const u32 s_churn_ops = 10000;
+	const u32 s_churn_live = 256;
+
+	// returns the number of errors
+	u32 run_mmio_polling(RawSPUThread& spu, bool lv2_lock, u32 pollers, u32 syscall_threads)
+	{
+		const u32 mbox_status = GetRawSPURegAddrByNum(spu.GetIndex(), SPU_MBox_Status_offs);
+		const u32 expected = (spu.SPU.Out_MBox.GetCount() & 0xff) | (spu.SPU.In_MBox.GetFreeCount() << 8);
+
+		std::atomic<bool> stop(false);
+		std::atomic<u64> reads(0), syscalls(0);
+		std::atomic<u32> errors(0);
+		std::vector<std::unique_ptr<thread>> threads;
+
+		for (u32 i = 0; i < syscall_threads; i++)
+		{
+			threads.emplace_back(new thread(fmt::Format("Syscall load %d", i), [&stop, &syscalls]()
+			{
+				u64 count = 0;
+				volatile u32 work = 0;
+
+				while (!stop)
+				{
+					LV2_LOCK(0);
+
+					for (u32 k = 0; k < 300; k++)
+					{
+						work += k;
+					}
+
+					count++;
+				}
+
+				syscalls += count;
+			}));
+		}
+
+		for (u32 i = 0; i < pollers; i++)
+		{
+			threads.emplace_back(new thread(fmt::Format("MMIO poller %d", i), [&stop, &reads, &errors, lv2_lock, mbox_status, expected]()
+			{
+				u64 count = 0;
+
+				while (!stop)
+				{
+					u32 value;
+
+					if (lv2_lock)
+					{
+						LV2_LOCK(0);
+						value = Memory.ReadMMIO32(mbox_status);
+					}
+					else
+					{
+						value = Memory.ReadMMIO32(mbox_status);
+					}
+
+					if (value != expected)
+					{
+						errors++;
+					}
+
+					count++;
+				}
+
+				reads += count;
+			}));
+		}
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(s_run_ms));
+		stop = true;
+
+		for (auto& t : threads)
+		{
+			t->join();
+		}
+
+		LOG_NOTICE(GENERAL, "MMIO polling (%s): %d pollers, %d syscall threads: %.2f M reads/s, %.2f M syscalls/s", lv2_lock ? "lv2 lock" : "lock-free",
+			pollers, syscall_threads, reads * 1000.0 / s_run_ms / 1000000, syscalls * 1000.0 / s_run_ms / 1000000);
+
+		if (errors)
+		{
+			LOG_ERROR(GENERAL, "MMIO polling (%s): %d wrong values", lv2_lock ? "lv2 lock" : "lock-free", errors.load());
+		}
+
+		return errors;
+	}
+
+	u32 check(bool cond, const char* what)
+	{
+		if (!cond)
+		{
+			LOG_ERROR(GENERAL, "[UT memory] %s", what);
+		}
+
+		return cond ? 0 : 1;
+	}
+
+	u32 test_coalescing(DynamicMemoryBlock& block)
+	{
+		u32 failed = 0;
+		const u64 a = block.AllocAlign(0x10000);
+		const u64 b = block.AllocAlign(0x10000);
+		const u64 c = block.AllocAlign(0x10000);
+
+		failed += check(a == s_block_addr && b == a + 0x10000 && c == b + 0x10000, "coalescing: the first blocks are not consecutive");
+
+		// a single free block is too small
+		block.Free(b);
+		const u64 d = block.AllocAlign(0x20000);
+		failed += check(d >= c + 0x10000, "coalescing: a block was allocated over a live block");
+		block.Free(d);
+
+		// merged with the preceding and the following extent
+		block.Free(a);
+		const u64 e = block.AllocAlign(0x20000);
+		failed += check(e == a, "coalescing: the free extents before a live block were not merged");
+		block.Free(e);
+
+		block.Free(c);
+		failed += check(block.GetUsedSize() == 0 && block.GetMaxFreeSize() == block.GetSize(), "coalescing: the free extents were not merged into one");
+		failed += check(!block.Free(c), "coalescing: a block was freed twice"); // logs an error
+
+		const u64 f = block.AllocAlign(block.GetSize());
+		failed += check(f == s_block_addr, "coalescing: the whole block could not be allocated");
+		block.Free(f);
+
+		return failed;
+	}
+
+	u32 test_alloc_fixed(DynamicMemoryBlock& block)
+	{
+		u32 failed = 0;
+		const u64 base = s_block_addr + 0x100000;
+
+		failed += check(block.AllocFixed(base, 0x3000), "AllocFixed: allocation failed");
+		failed += check(!block.AllocFixed(base + 0x2000, 0x1000), "AllocFixed: overlapping end was allocated");
+		failed += check(!block.AllocFixed(base - 0x1000, 0x2000), "AllocFixed: overlapping start was allocated");
+		failed += check(!block.AllocFixed(base - 0x1000, 0x5000), "AllocFixed: enclosing block was allocated");
+		failed += check(block.AllocFixed(base + 0x3000, 0x1000), "AllocFixed: adjacent allocation failed");
+
+		// unaligned addresses and sizes are extended to whole pages
+		failed += check(block.AllocFixed(base + 0x4800, 0x100), "AllocFixed: unaligned allocation failed");
+		failed += check(!block.AllocFixed(base + 0x4ff0, 0x20), "AllocFixed: overlapping unaligned block was allocated");
+		failed += check(block.GetUsedSize() == 0x5000, "AllocFixed: wrong used size");
+
+		// the free space before the fixed blocks is still used
+		const u64 a = block.AllocAlign(0x1000);
+		failed += check(a == s_block_addr, "AllocFixed: the space before the fixed blocks was not used");
+		block.Free(a);
+
+		failed += check(block.Free(base) && block.Free(base + 0x3000) && block.Free(base + 0x4000), "AllocFixed: free failed");
+		failed += check(block.GetUsedSize() == 0 && block.GetMaxFreeSize() == block.GetSize(), "AllocFixed: the free extents were not merged into one");
+
+		return failed;
+	}
+
+	// random allocations (alignment up to 1 MB) and frees, checked against a map of the live blocks
+	u32 test_random_alloc(DynamicMemoryBlock& block)
+	{
+		std::mt19937 rng(0xa110c);
+		std::map<u64, u32> live;
+		u32 used = 0;
+
+		for (u32 n = 0; n < s_random_ops; n++)
+		{
+			if (live.empty() || rng() % 3)
+			{
+				const u32 size = (rng() % 64 + 1) * 0x1000 - rng() % 0x1000;
+				const u32 align = 0x800 << (rng() % 10);
+				const u64 addr = block.AllocAlign(size, align);
+
+				if (!addr)
+				{
+					continue;
+				}
+
+				const u32 real_size = (size + 4095) & ~4095;
+				auto next = live.lower_bound(addr);
+				auto prev = next == live.begin() ? live.end() : std::prev(next);
+
+				if (addr % std::max<u32>(align, 4096) || addr < s_block_addr || addr + real_size > s_block_addr + s_block_size ||
+					(next != live.end() && next->first < addr + real_size) || (prev != live.end() && prev->first + prev->second > addr))
+				{
+					LOG_ERROR(GENERAL, "[UT memory] AllocAlign(0x%x, 0x%x): bad address 0x%llx", size, align, addr);
+					return 1;
+				}
+
+				live.emplace(addr, real_size);
+				used += real_size;
+			}
+			else
+			{
+				auto it = live.begin();
+				std::advance(it, rng() % live.size());
+
+				if (!block.Free(it->first))
+				{
+					LOG_ERROR(GENERAL, "[UT memory] Free(0x%llx) failed", it->first);
+					return 1;
+				}
+
+				used -= it->second;
+				live.erase(it);
+			}
+
+			if (block.GetUsedSize() != used)
+			{
+				LOG_ERROR(GENERAL, "[UT memory] wrong used size 0x%x (expected 0x%x)", block.GetUsedSize(), used);
+				return 1;
+			}
+		}
+
+		for (auto& b : live)
+		{
+			block.Free(b.first);
+		}
+
+		return check(block.GetUsedSize() == 0 && block.GetMaxFreeSize() == block.GetSize(), "random: the free extents were not merged into one");
+	}
+
+	// the first-fit search of the old allocator, which checked every address against all live blocks
+	class ref_first_fit
+	{
+		std::vector<std::pair<u64, u32>> m_allocated;
+
+	public:
+		u64 AllocAlign(u32 size, u32 align)
+		{
+			const u32 exsize = align ? size + align - 1 : size;
+
+			for (u64 addr = s_block_addr; addr <= s_block_addr + s_block_size - exsize;)
+			{
+				bool is_good_addr = true;
+
+				for (auto& b : m_allocated)
+				{
+					if ((addr >= b.first && addr < b.first + b.second) || (b.first >= addr && b.first < addr + exsize))
+					{
+						is_good_addr = false;
+						addr = b.first + b.second;
+						break;
+					}
+				}
+
+				if (!is_good_addr) continue;
+
+				if (align)
+				{
+					addr = (addr + (align - 1)) & ~(u64)(align - 1);
+				}
+
+				m_allocated.emplace_back(addr, size);
+				return addr;
+			}
+
+			return 0;
+		}
+
+		void Free(u64 addr)
+		{
+			for (auto it = m_allocated.begin(); it != m_allocated.end(); it++)
+			{
+				if (it->first == addr)
+				{
+					m_allocated.erase(it);
+					return;
+				}
+			}
+		}
+
+		u32 GetMaxFreeSize()
+		{
+			auto blocks = m_allocated;
+			std::sort(blocks.begin(), blocks.end());
+
+			u64 pos = s_block_addr, max_free = 0;
+
+			for (auto& b : blocks)
+			{
+				max_free = std::max(max_free, b.first - pos);
+				pos = b.first + b.second;
+			}
+
+			return (u32)std::max(max_free, s_block_addr + s_block_size - pos);
+		}
+	};
+
+	// the same sequence of allocations (4 KB - 128 KB, some aligned to 64 KB) and frees for both allocators
+	template<typename T> void run_churn(const char* name, T& block)
+	{
+		std::mt19937 rng(0xc4c4);
+		std::vector<std::pair<u64, u32>> live;
+		u32 failed_allocs = 0;
+
+		const auto start = std::chrono::high_resolution_clock::now();
+
+		for (u32 n = 0; n < s_churn_ops; n++)
+		{
+			if (live.size() < s_churn_live / 2 || (live.size() < s_churn_live && rng() % 2))
+			{
+				const u32 size = (rng() % 32 + 1) * 0x1000;
+				const u64 addr = block.AllocAlign(size, rng() % 8 ? 0 : 0x10000);
+
+				if (addr)
+				{
+					live.emplace_back(addr, size);
+				}
+				else
+				{
+					failed_allocs++;
+				}
+			}
+			else
+			{
+				const size_t i = rng() % live.size();
+				block.Free(live[i].first);
+				live[i] = live.back();
+				live.pop_back();
+			}
+		}
+
+		const double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+		u32 used = 0;
+
+		for (auto& b : live)
+		{
+			used += b.second;
+		}
+
+		const u32 max_free = block.GetMaxFreeSize();
+
+		LOG_NOTICE(GENERAL, "%s: %.0f K ops/s, %d blocks (%d KB) live, fragmentation %.2f%%", name, s_churn_ops / seconds / 1000, (u32)live.size(), used / 1024,
+			100.0 * (s_block_size - used - max_free) / (s_block_size - used));
+
+		if (failed_allocs)
+		{
+			LOG_WARNING(GENERAL, "%s: %d allocations failed", name, failed_allocs);
+		}
+
+		for (auto& b : live)
+		{
+			block.Free(b.first);
+		}
+	}
+}
+
+void MemoryBase::RunAllTests()
+{
+	static bool s_done = false;
+
+	if (s_done)
+	{
+		return;
+	}
+
+	s_done = true;
+
+	LOG_NOTICE(GENERAL, "Running memory tests");
+
+	u32 num_failed = 0;
+
+	// the RawSPU is not started, its registers keep their values
+	RawSPUThread& spu = (RawSPUThread&)Emu.GetCPU().AddThread(CPU_THREAD_RAW_SPU);
+
+	for (u32 pollers : { 1, 2 })
+	{
+		for (u32 syscall_threads : { 0, 2 })
+		{
+			num_failed += run_mmio_polling(spu, false, pollers, syscall_threads) != 0;
+			num_failed += run_mmio_polling(spu, true, pollers, syscall_threads) != 0;
+		}
+	}
+
+	Emu.GetCPU().RemoveThread(spu.GetId());
+
+	bool block_area_used = false;
+
+	for (u64 addr = s_block_addr; addr < s_block_addr + s_block_size; addr += 4096)
+	{
+		block_area_used = block_area_used || Memory.IsGoodAddr((u32)addr);
+	}
+
+	if (block_area_used)
+	{
+		LOG_ERROR(GENERAL, "[UT memory] DynamicMemoryBlock tests skipped (0x%llx is used)", s_block_addr);
+		num_failed++;
+	}
+	else
+	{
+		DynamicMemoryBlock block;
+		block.SetRange(s_block_addr, s_block_size);
+
+		num_failed += test_coalescing(block) != 0;
+		num_failed += test_alloc_fixed(block) != 0;
+		num_failed += test_random_alloc(block) != 0;
+
+		ref_first_fit ref;
+		run_churn("DynamicMemoryBlock churn", block);
+		run_churn("DynamicMemoryBlock churn (old first-fit search)", ref);
+
+		block.Delete();
+	}
+
+	LOG_NOTICE(GENERAL, "Unit Tests done (%d failed)", num_failed);
+}
+
+#else
+
+void MemoryBase::RunAllTests()
+{
+}
+
+#endif // MEMORY_UNIT_TESTS
@@ -1,4 +1,5 @@
 #include "stdafx.h"
+#include "Utilities/Log.h"
 #include "Memory.h"
 
 #ifdef _WIN32
@@ -7,6 +8,7 @@
 void* const g_base_addr = VirtualAlloc(nullptr, 0x100000000, MEM_RESERVE, PAGE_NOACCESS);
 #else
 #include <sys/mman.h>
+#include <signal.h>
 
 /* OS X uses MAP_ANON instead of MAP_ANONYMOUS */
 #ifndef MAP_ANONYMOUS
@@ -44,4 +46,108 @@ namespace vm
 	void unalloc(u32 addr)
 	{
 	}
+
+	// the handlers are only appended (the count is published after the entry), so they are read without locking
+	static fault_handler_t g_fault_handlers[4];
+	static std::atomic<u32> g_fault_handler_count(0);
+	static std::mutex g_fault_handler_lock;
+
+	static bool is_guest_address(u64 fault_address)
+	{
+		return fault_address >= (u64)g_base_addr && fault_address - (u64)g_base_addr < 0x100000000ull;
+	}
+
+	static bool call_fault_handlers(u32 addr, void* context)
+	{
+		const u32 count = g_fault_handler_count.load(std::memory_order_acquire);
+
+		for (u32 i = 0; i < count; i++)
+		{
+			if (g_fault_handlers[i](addr, context))
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+#ifdef _WIN32
+	static LONG CALLBACK exception_handler(PEXCEPTION_POINTERS exception)
+	{
+		const u64 fault_address = (u64)exception->ExceptionRecord->ExceptionInformation[1];
+
+		if (exception->ExceptionRecord->ExceptionCode == EXCEPTION_ACCESS_VIOLATION && is_guest_address(fault_address) &&
+			call_fault_handlers((u32)(fault_address - (u64)g_base_addr), exception->ContextRecord))
+		{
+			return EXCEPTION_CONTINUE_EXECUTION;
+		}
+
+		return EXCEPTION_CONTINUE_SEARCH;
+	}
+#else
+	static struct sigaction g_old_sigsegv_action;
+
+	static void signal_handler(int sig, siginfo_t* info, void* context)
+	{
+		const u64 fault_address = (u64)info->si_addr;
+
+		if (is_guest_address(fault_address) && call_fault_handlers((u32)(fault_address - (u64)g_base_addr), context))
+		{
+			return;
+		}
+
+		// pass the fault on to the previous handler, or restore the default action (the instruction faults again)
+		if (g_old_sigsegv_action.sa_flags & SA_SIGINFO)
+		{
+			g_old_sigsegv_action.sa_sigaction(sig, info, context);
+		}
+		else if (g_old_sigsegv_action.sa_handler != SIG_DFL && g_old_sigsegv_action.sa_handler != SIG_IGN)
+		{
+			g_old_sigsegv_action.sa_handler(sig);
+		}
+		else
+		{
+			sigaction(SIGSEGV, &g_old_sigsegv_action, nullptr);
+		}
+	}
+#endif
+
+	void add_fault_handler(fault_handler_t handler)
+	{
+		std::lock_guard<std::mutex> lock(g_fault_handler_lock);
+
+		const u32 count = g_fault_handler_count.load();
+
+		for (u32 i = 0; i < count; i++)
+		{
+			if (g_fault_handlers[i] == handler)
+			{
+				return;
+			}
+		}
+
+		if (count == sizeof(g_fault_handlers) / sizeof(*g_fault_handlers))
+		{
+			LOG_ERROR(MEMORY, "vm::add_fault_handler(): too many handlers");
+			return;
+		}
+
+		if (!count)
+		{
+#ifdef _WIN32
+			AddVectoredExceptionHandler(1, exception_handler);
+#else
+			struct sigaction action;
+			memset(&action, 0, sizeof(action));
+			action.sa_sigaction = signal_handler;
+			action.sa_flags = SA_SIGINFO;
+			sigemptyset(&action.sa_mask);
+			sigaction(SIGSEGV, &action, &g_old_sigsegv_action);
+#endif
+		}
+
+		g_fault_handlers[count] = handler;
+		g_fault_handler_count.store(count + 1, std::memory_order_release);
+	}
 }
\ No newline at end of file
@@ -6,6 +6,17 @@ namespace vm
 	bool unmap(u32 addr, u32 size = 0, u32 flags = 0);
 	u32 alloc(u32 size);
 	void unalloc(u32 addr);
+
+	// Handler of an access violation at a guest address, context is the host context of the faulting thread (PCONTEXT
+	// on Windows, ucontext_t* elsewhere). Returns true if the faulting instruction can be resumed. On Linux it runs in
+	// the SIGSEGV handler of the faulting thread. The fault is synchronous, so a handler may lock, allocate or log while
+	// it handles the faults of code that holds no locks and doesn't allocate (like recompiled guest code, identified by
+	// the faulting instruction). It must decline any other fault without doing so, because the faulting code may hold
+	// the same locks.
+	typedef bool(*fault_handler_t)(u32 addr, void* context);
+
+	// Add a handler of access violations in the guest memory (installs the signal or exception handler once)
+	void add_fault_handler(fault_handler_t handler);
 	
 	template<typename T>
 	T* const get_ptr(u32 addr)
@@ -0,0 +1,341 @@
+#include "stdafx.h"
+#include "Utilities/Log.h"
+#include "Utilities/rFile.h"
+#include "Utilities/Thread.h"
+#include "Emu/Memory/Memory.h"
+#include "Emu/SysCalls/lv2/sys_time.h"
+#include "PerfCounters.h"
+
+#include <map>
+
+namespace perf
+{
+	const char* const counter_names[COUNTER_COUNT] =
+	{
+		"cpu_steps",
+		"syscalls",
+		"hle_calls",
+		"dma_commands",
+		"dma_bytes",
+		"rsx_methods",
+		"rsx_draw_calls",
+		"rsx_flips",
+		"jit_compile_us",
+		"lock_waits",
+		"lock_wait_us",
+	};
+
+	thread_local thread_counters* g_tls_counters = nullptr;
+
+	std::mutex g_registry_lock;
+	std::vector<std::unique_ptr<thread_counters>> g_registry;
+
+	thread_counters::thread_counters(const std::string& name)
+		: name(name)
+		, finished(false)
+	{
+		for (auto& v : hle_nids) v.store(0, std::memory_order_relaxed);
+		clear();
+	}
+
+	void thread_counters::clear()
+	{
+		for (auto& v : values) v.store(0, std::memory_order_relaxed);
+		for (auto& v : syscalls) v.store(0, std::memory_order_relaxed);
+		for (auto& v : hle_calls) v.store(0, std::memory_order_relaxed);
+	}
+
+	thread_counters& register_thread()
+	{
+		NamedThreadBase* thr = GetCurrentNamedThread();
+		thread_counters* counters = new thread_counters(thr ? thr->GetThreadName() : "unnamed");
+
+		std::lock_guard<std::mutex> lock(g_registry_lock);
+		g_registry.emplace_back(counters);
+
+		return *(g_tls_counters = counters);
+	}
+
+	void release_thread()
+	{
+		if (thread_counters* counters = g_tls_counters)
+		{
+			g_tls_counters = nullptr;
+			counters->finished = true;
+		}
+	}
+
+	void add_syscall(u32 code)
+	{
+		thread_counters& c = get_counters();
+		inc(c.values[SYSCALLS], 1);
+		inc(c.syscalls[code % SYSCALL_COUNT], 1);
+	}
+
+	void add_hle_call(u32 nid)
+	{
+		thread_counters& c = get_counters();
+		inc(c.values[HLE_CALLS], 1);
+
+		for (u32 i = 0, pos = (nid * 0x9e3779b1) >> 22; i < HLE_SLOTS; i++, pos = (pos + 1) % HLE_SLOTS)
+		{
+			const u32 slot = c.hle_nids[pos].load(std::memory_order_relaxed);
+
+			if (slot == nid)
+			{
+				inc(c.hle_calls[pos], 1);
+				return;
+			}
+
+			if (!slot)
+			{
+				// the count is published before the id, so a reader never sees a stale count
+				c.hle_calls[pos].store(1, std::memory_order_relaxed);
+				c.hle_nids[pos].store(nid, std::memory_order_release);
+				return;
+			}
+		}
+
+		// the table is full, only the total is counted
+	}
+
+	std::mutex g_flip_lock;
+	std::atomic<u64> g_flip_count(0);
+	u64 g_last_flip = 0;
+	std::vector<u64> g_frame_times;
+
+	void add_flip()
+	{
+		add(RSX_FLIPS);
+
+		const u64 time = get_system_time();
+
+		std::lock_guard<std::mutex> lock(g_flip_lock);
+
+		if (g_last_flip)
+		{
+			g_frame_times.push_back(time - g_last_flip);
+		}
+
+		g_last_flip = time;
+		g_flip_count++;
+	}
+
+	u64 get_flip_count()
+	{
+		return g_flip_count;
+	}
+
+	std::vector<u64> get_frame_times()
+	{
+		std::lock_guard<std::mutex> lock(g_flip_lock);
+
+		return g_frame_times;
+	}
+
+	static void sort_calls(std::vector<std::pair<u32, u64>>& calls)
+	{
+		std::sort(calls.begin(), calls.end(), [](const std::pair<u32, u64>& a, const std::pair<u32, u64>& b)
+		{
+			return a.second > b.second;
+		});
+	}
+
+	snapshot collect()
+	{
+		snapshot s;
+		s.time = get_system_time();
+		memset(s.totals, 0, sizeof(s.totals));
+
+		std::vector<u64> syscalls(SYSCALL_COUNT);
+		std::map<u32, u64> hle_calls;
+
+		std::lock_guard<std::mutex> lock(g_registry_lock);
+
+		for (auto& c : g_registry)
+		{
+			snapshot::thread_info info;
+			info.name = c->name;
+			info.finished = c->finished;
+
+			for (u32 i = 0; i < COUNTER_COUNT; i++)
+			{
+				s.totals[i] += info.values[i] = c->values[i].load(std::memory_order_relaxed);
+			}
+
+			for (u32 i = 0; i < SYSCALL_COUNT; i++)
+			{
+				syscalls[i] += c->syscalls[i].load(std::memory_order_relaxed);
+			}
+
+			for (u32 i = 0; i < HLE_SLOTS; i++)
+			{
+				if (const u32 nid = c->hle_nids[i].load(std::memory_order_acquire))
+				{
+					hle_calls[nid] += c->hle_calls[i].load(std::memory_order_relaxed);
+				}
+			}
+
+			s.threads.push_back(info);
+		}
+
+		for (u32 i = 0; i < SYSCALL_COUNT; i++)
+		{
+			if (syscalls[i]) s.syscalls.emplace_back(i, syscalls[i]);
+		}
+
+		s.hle_calls.assign(hle_calls.begin(), hle_calls.end());
+
+		sort_calls(s.syscalls);
+		sort_calls(s.hle_calls);
+
+		return s;
+	}
+
+	void reset()
+	{
+		{
+			std::lock_guard<std::mutex> lock(g_flip_lock);
+			g_flip_count = 0;
+			g_last_flip = 0;
+			g_frame_times.clear();
+		}
+
+		std::lock_guard<std::mutex> lock(g_registry_lock);
+
+		for (auto it = g_registry.begin(); it != g_registry.end();)
+		{
+			if ((*it)->finished)
+			{
+				it = g_registry.erase(it);
+			}
+			else
+			{
+				(*it)->clear();
+				it++;
+			}
+		}
+	}
+
+	static std::string json_escape(const std::string& str)
+	{
+		std::string res;
+
+		for (char c : str)
+		{
+			if (c == '"' || c == '\\') res += '\\';
+			if ((u8)c < 0x20) { res += fmt::Format("\\u%04x", c); continue; }
+			res += c;
+		}
+
+		return res;
+	}
+
+	static std::string json_values(const u64 values[COUNTER_COUNT])
+	{
+		std::string res;
+
+		for (u32 i = 0; i < COUNTER_COUNT; i++)
+		{
+			res += fmt::Format("%s\"%s\": %llu", i ? ", " : "", counter_names[i], values[i]);
+		}
+
+		return res;
+	}
+
+	static std::string json_calls(const std::vector<std::pair<u32, u64>>& calls, const char* key_fmt)
+	{
+		std::string res;
+
+		for (auto& call : calls)
+		{
+			res += fmt::Format("%s\"", res.empty() ? "" : ", ") + fmt::Format(key_fmt, call.first) + fmt::Format("\": %llu", call.second);
+		}
+
+		return res;
+	}
+
+	std::string to_json(const snapshot& s)
+	{
+		std::string res = fmt::Format("{\n\t\"time_us\": %llu,\n\t\"totals\": { ", s.time) + json_values(s.totals) + " },\n\t\"threads\": [\n";
+
+		for (size_t i = 0; i < s.threads.size(); i++)
+		{
+			auto& t = s.threads[i];
+			res += fmt::Format("\t\t{ \"name\": \"%s\", \"finished\": %s, ", json_escape(t.name).c_str(), t.finished ? "true" : "false");
+			res += json_values(t.values) + (i + 1 < s.threads.size() ? " },\n" : " }\n");
+		}
+
+		res += "\t],\n\t\"syscalls\": { " + json_calls(s.syscalls, "%u") + " },\n";
+		res += "\t\"hle_calls\": { " + json_calls(s.hle_calls, "0x%08x") + " }\n}\n";
+		return res;
+	}
+
+	std::string to_csv(const snapshot& s, bool header)
+	{
+		std::string res;
+
+		if (header)
+		{
+			res += "time_us";
+			for (auto name : counter_names) res += std::string(",") + name;
+			res += "\n";
+		}
+
+		res += fmt::Format("%llu", s.time);
+		for (auto v : s.totals) res += fmt::Format(",%llu", v);
+		res += "\n";
+		return res;
+	}
+
+	std::mutex g_export_lock;
+	std::condition_variable g_export_cv;
+	std::thread g_export_thread;
+	bool g_export_stop = false;
+
+	void start_export(const std::string& path, u32 interval_ms)
+	{
+		stop_export();
+
+		const bool json = path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+
+		LOG_NOTICE(GENERAL, "Performance counters are written to '%s' every %d ms", path.c_str(), interval_ms);
+
+		g_export_stop = false;
+		g_export_thread = std::thread([path, interval_ms, json]()
+		{
+			bool first = true;
+			std::unique_lock<std::mutex> lock(g_export_lock);
+
+			while (!g_export_cv.wait_for(lock, std::chrono::milliseconds(interval_ms), []() { return g_export_stop; }))
+			{
+				const snapshot s = collect();
+
+				rFile f(path, json || first ? rFile::write : rFile::write_append);
+
+				if (!f.IsOpened())
+				{
+					LOG_ERROR(GENERAL, "perf::start_export(): failed to open '%s'", path.c_str());
+					return;
+				}
+
+				f.Write(json ? to_json(s) : to_csv(s, first));
+				first = false;
+			}
+		});
+	}
+
+	void stop_export()
+	{
+		if (g_export_thread.joinable())
+		{
+			{
+				std::lock_guard<std::mutex> lock(g_export_lock);
+				g_export_stop = true;
+				g_export_cv.notify_all();
+			}
+
+			g_export_thread.join();
+		}
+	}
+}
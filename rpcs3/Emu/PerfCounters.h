@@ -0,0 +1,109 @@
+#pragma once
+
+namespace perf
+{
+	enum counter_id : u32
+	{
+		CPU_STEPS, // instructions (interpreters) or blocks (recompilers) executed
+		SYSCALLS,
+		HLE_CALLS,
+		DMA_COMMANDS,
+		DMA_BYTES,
+		RSX_METHODS,
+		RSX_DRAW_CALLS,
+		RSX_FLIPS,
+		JIT_COMPILE_US,
+		LOCK_WAITS,
+		LOCK_WAIT_US,
+
+		COUNTER_COUNT
+	};
+
+	extern const char* const counter_names[COUNTER_COUNT];
+
+	const u32 SYSCALL_COUNT = 1024;
+	const u32 HLE_SLOTS = 1024; // power of 2
+
+	// Counters of one thread. Only the owner thread writes them (plain load/store, no lock prefix),
+	// other threads read them with relaxed loads when a snapshot is taken.
+	struct thread_counters
+	{
+		const std::string name;
+		std::atomic<bool> finished;
+		std::atomic<u64> values[COUNTER_COUNT];
+		std::atomic<u64> syscalls[SYSCALL_COUNT];
+		std::atomic<u32> hle_nids[HLE_SLOTS]; // open addressing table of function ids (0 = empty slot)
+		std::atomic<u64> hle_calls[HLE_SLOTS];
+
+		thread_counters(const std::string& name);
+
+		void clear();
+	};
+
+	extern thread_local thread_counters* g_tls_counters;
+
+	// creates the counters of the current thread
+	thread_counters& register_thread();
+
+	// called by a thread before it finishes, its counters are kept until reset()
+	void release_thread();
+
+	static __forceinline thread_counters& get_counters()
+	{
+		thread_counters* counters = g_tls_counters;
+		return counters ? *counters : register_thread();
+	}
+
+	static __forceinline void inc(std::atomic<u64>& counter, u64 value)
+	{
+		counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+	}
+
+	static __forceinline void add(counter_id id, u64 value = 1)
+	{
+		inc(get_counters().values[id], value);
+	}
+
+	void add_syscall(u32 code);
+	void add_hle_call(u32 nid);
+
+	// called by the RSX thread on every flip, the intervals between flips are kept until reset()
+	void add_flip();
+
+	// flips since reset()
+	u64 get_flip_count();
+
+	// intervals between the flips (us)
+	std::vector<u64> get_frame_times();
+
+	struct snapshot
+	{
+		struct thread_info
+		{
+			std::string name;
+			bool finished;
+			u64 values[COUNTER_COUNT];
+		};
+
+		u64 time; // us
+		u64 totals[COUNTER_COUNT];
+		std::vector<thread_info> threads;
+		std::vector<std::pair<u32, u64>> syscalls; // (code, count), sorted by count
+		std::vector<std::pair<u32, u64>> hle_calls; // (nid, count), sorted by count
+	};
+
+	// aggregate the counters of all threads
+	snapshot collect();
+
+	// clear all counters and forget finished threads (called when a new game is loaded)
+	void reset();
+
+	std::string to_json(const snapshot& s);
+
+	// a header line (optional) and one line with the time and the totals
+	std::string to_csv(const snapshot& s, bool header);
+
+	// write snapshots periodically (CSV rows are appended, a JSON file is rewritten with the latest snapshot)
+	void start_export(const std::string& path, u32 interval_ms);
+	void stop_export();
+}
@@ -0,0 +1,569 @@
+#include "stdafx.h"
+#include "Utilities/Log.h"
+#include "Utilities/rFile.h"
+#include "Emu/Memory/Memory.h"
+#include "Emu/System.h"
+#include "Emu/SysCalls/SysCalls.h"
+#include "Emu/SysCalls/lv2/sys_time.h"
+#include "Emu/CPU/CPUThreadManager.h"
+#include "Emu/Cell/PPUThread.h"
+#include "Emu/Cell/SPUThread.h"
+#include "Profiler.h"
+
+#include <map>
+#include <set>
+
+namespace prof
+{
+	const u32 max_depth = 32; // return addresses walked per sample
+	const u32 min_interval = 500; // us, shorter intervals are clamped
+	const u32 max_overhead = 2; // percent of one host thread, the next tick is delayed after a slow one
+	const size_t max_stacks = 0x40000; // distinct stacks kept, the samples of other new stacks are dropped
+
+	struct symbol
+	{
+		u32 size;
+		std::string name; // empty for the entries of called functions found by the sampler
+	};
+
+	std::mutex g_symbols_lock;
+	std::map<u32, symbol> g_ppu_symbols;
+	std::set<u32> g_spu_entries; // local storage addresses (the SPU programs aren't distinguished)
+
+	struct thread_samples
+	{
+		std::string name;
+		u64 modes[CPU_EXEC_MODE_COUNT];
+	};
+
+	// only accessed by the sampler thread while it runs
+	std::map<u32, thread_samples> g_threads; // by thread id
+	std::map<std::vector<u32>, u64> g_stacks; // (thread type and mode, address or function id, return addresses) -> samples
+	u64 g_samples = 0;
+	u64 g_dropped = 0;
+	u64 g_ticks = 0;
+	u64 g_tick_time = 0; // us
+	u64 g_max_tick_time = 0;
+	u64 g_delayed_ticks = 0;
+	u64 g_max_interval = 0; // us, the longest delay between two ticks
+	u64 g_start_time = 0;
+	u64 g_stop_time = 0;
+
+	std::mutex g_sampler_lock;
+	std::condition_variable g_sampler_cv;
+	std::thread g_sampler_thread;
+	bool g_sampler_stop = false;
+
+	void add_symbol(u32 addr, u32 size, const std::string& name)
+	{
+		std::lock_guard<std::mutex> lock(g_symbols_lock);
+
+		g_ppu_symbols[addr] = symbol{ size, name };
+	}
+
+	// the target of the call (bl or bla) before the return address, 0 for indirect calls
+	static u32 ppu_call_target(u32 ret)
+	{
+		if (!Memory.IsGoodAddr(ret - 4, 4)) return 0;
+
+		const u32 op = vm::read32(ret - 4);
+
+		if ((op & 0xfc000001) != 0x48000001) return 0;
+
+		const u32 disp = (u32)((s32)(op << 6) >> 6) & ~3;
+		return (op & 2 ? 0 : ret - 4) + disp;
+	}
+
+	// the target of the call (brsl or brasl) before the return address in the local storage, 0 for indirect calls
+	static u32 spu_call_target(u32 ls_offset, u32 ret)
+	{
+		const u32 op = vm::read32(ls_offset + ((ret - 4) & 0x3fffc));
+		const u32 disp = (u32)(s32)(s16)(op >> 7) << 2;
+
+		switch (op >> 23)
+		{
+		case 0x66: return (ret - 4 + disp) & 0x3fffc;
+		case 0x62: return disp & 0x3fffc;
+		}
+
+		return 0;
+	}
+
+	// the LR is stored in the frame of the caller, at back chain + 16
+	static u32 walk_ppu_stack(PPUThread& t, u32* frames)
+	{
+		u32 depth = 0;
+
+		if (Memory.IsGoodAddr((u32)t.LR - 4, 4))
+		{
+			frames[depth++] = (u32)t.LR;
+		}
+
+		const u32 stack_begin = t.GetStackAddr();
+		const u32 stack_end = stack_begin + t.GetStackSize();
+
+		for (u32 sp = (u32)t.GPR[1]; depth < max_depth && sp >= stack_begin && sp + 8 <= stack_end;)
+		{
+			const u32 next = (u32)vm::read64(sp);
+
+			if (next <= sp || next + 24 > stack_end) break;
+
+			const u32 ret = (u32)vm::read64(next + 16);
+
+			if (ret & 3 || !Memory.IsGoodAddr(ret - 4, 4)) break;
+
+			frames[depth++] = ret;
+			sp = next;
+		}
+
+		return depth;
+	}
+
+	static u32 walk_spu_stack(SPUThread& t, u32* frames)
+	{
+		u32 depth = 0;
+
+		if (const u32 lr = t.GPR[0]._u32[3] & 0x3fffc)
+		{
+			frames[depth++] = lr;
+		}
+
+		for (u32 sp = t.GPR[1]._u32[3]; depth < max_depth && sp < 0x40000 - 32;)
+		{
+			const u32 next = vm::read32(t.ls_offset + sp);
+
+			if (next <= sp || next >= 0x40000 - 32 || next & 0xf) break;
+
+			frames[depth++] = vm::read32(t.ls_offset + next + 16) & 0x3fffc;
+			sp = next;
+		}
+
+		return depth;
+	}
+
+	// a sample captured while the thread list is locked, aggregated after it is released
+	struct raw_sample
+	{
+		u32 id;
+		u32 type;
+		u32 depth;
+		u32 first_ret;
+		u32 frames[max_depth + 3];
+		u32 entries[max_depth + 3]; // call targets of the return addresses (0 for indirect calls)
+		std::string name; // only set for threads not sampled before
+	};
+
+	std::vector<raw_sample> g_raw_samples; // reused by every tick
+
+	// reads the registers and walks the stack, the symbols and the samples are only updated by aggregate()
+	static bool capture(CPUThread& t, raw_sample& s)
+	{
+		if (!t.IsRunning()) return false;
+
+		const u64 state = t.m_prof_state.load(std::memory_order_relaxed);
+		const u32 mode = (u32)(state >> 32);
+
+		if (mode >= CPU_EXEC_MODE_COUNT) return false;
+
+		s.id = t.GetId();
+		s.type = t.GetType();
+		s.name.clear();
+
+		if (!g_threads.count(s.id))
+		{
+			s.name = t.GetFName();
+		}
+
+		u32 depth = 0;
+
+		s.frames[depth++] = s.type << 8 | mode;
+		s.frames[depth++] = mode == CPU_EXEC_INTERPRETER ? t.PC : (u32)state;
+
+		if (mode == CPU_EXEC_SYSCALL)
+		{
+			s.frames[depth++] = t.PC; // sc
+		}
+
+		s.first_ret = depth;
+
+		switch (s.type)
+		{
+		case CPU_THREAD_PPU:
+			if (mode != CPU_EXEC_NATIVE) depth += walk_ppu_stack(static_cast<PPUThread&>(t), s.frames + depth);
+			break;
+
+		case CPU_THREAD_SPU:
+		case CPU_THREAD_RAW_SPU:
+			depth += walk_spu_stack(static_cast<SPUThread&>(t), s.frames + depth);
+			break;
+
+		default:
+			break;
+		}
+
+		s.depth = depth;
+
+		// the local storage of an SPU thread may be freed as soon as the thread list is unlocked
+		for (u32 i = s.first_ret; i < depth; i++)
+		{
+			switch (s.type)
+			{
+			case CPU_THREAD_PPU: s.entries[i] = ppu_call_target(s.frames[i]); break;
+			case CPU_THREAD_SPU:
+			case CPU_THREAD_RAW_SPU: s.entries[i] = spu_call_target(static_cast<SPUThread&>(t).ls_offset, s.frames[i]); break;
+			default: s.entries[i] = 0; break;
+			}
+		}
+
+		return true;
+	}
+
+	static void aggregate(const raw_sample& s)
+	{
+		thread_samples& info = g_threads[s.id];
+
+		if (!s.name.empty())
+		{
+			info.name = s.name;
+			memset(info.modes, 0, sizeof(info.modes));
+		}
+
+		info.modes[s.frames[0] & 0xff]++;
+		g_samples++;
+
+		const std::vector<u32> key(s.frames, s.frames + s.depth);
+		auto found = g_stacks.find(key);
+
+		if (found != g_stacks.end())
+		{
+			found->second++;
+			return;
+		}
+
+		if (g_stacks.size() >= max_stacks)
+		{
+			g_dropped++;
+			return;
+		}
+
+		g_stacks.emplace(key, 1);
+
+		// the entries of the called functions are kept once per stack
+		std::lock_guard<std::mutex> lock(g_symbols_lock);
+
+		for (u32 i = s.first_ret; i < s.depth; i++)
+		{
+			if (!s.entries[i]) continue;
+
+			if (s.type == CPU_THREAD_PPU)
+			{
+				g_ppu_symbols.emplace(s.entries[i], symbol{ 0, "" });
+			}
+			else
+			{
+				g_spu_entries.insert(s.entries[i]);
+			}
+		}
+	}
+
+	// returns the time spent (us)
+	static u64 tick()
+	{
+		const u64 start = get_system_time();
+		size_t count = 0;
+
+		// CPUThreadManager::m_mtx_thread is held while the threads are captured, threads can't be created or destroyed
+		Emu.GetCPU().ForEachThread([&count](CPUThread& t)
+		{
+			if (count == g_raw_samples.size()) g_raw_samples.emplace_back();
+			if (capture(t, g_raw_samples[count])) count++;
+		});
+
+		for (size_t i = 0; i < count; i++)
+		{
+			aggregate(g_raw_samples[i]);
+		}
+
+		const u64 time = get_system_time() - start;
+		g_ticks++;
+		g_tick_time += time;
+		g_max_tick_time = std::max(g_max_tick_time, time);
+		return time;
+	}
+
+	static bool stop_sampler()
+	{
+		if (!g_sampler_thread.joinable()) return false;
+
+		{
+			std::lock_guard<std::mutex> lock(g_sampler_lock);
+			g_sampler_stop = true;
+			g_sampler_cv.notify_all();
+		}
+
+		g_sampler_thread.join();
+		g_stop_time = get_system_time();
+		return true;
+	}
+
+	void reset()
+	{
+		stop_sampler();
+
+		std::lock_guard<std::mutex> lock(g_symbols_lock);
+
+		g_ppu_symbols.clear();
+		g_spu_entries.clear();
+		g_threads.clear();
+		g_stacks.clear();
+		g_raw_samples.clear();
+		g_samples = g_dropped = g_ticks = g_tick_time = g_max_tick_time = g_delayed_ticks = g_max_interval = 0;
+	}
+
+	void start(u32 interval_us)
+	{
+		stop_sampler();
+
+		if (interval_us < min_interval)
+		{
+			LOG_WARNING(GENERAL, "Profiler interval of %d us is too short, %d us is used", interval_us, min_interval);
+			interval_us = min_interval;
+		}
+
+		LOG_NOTICE(GENERAL, "Guest code is sampled every %d us", interval_us);
+
+		g_sampler_stop = false;
+		g_start_time = get_system_time();
+		g_max_interval = interval_us;
+		g_sampler_thread = std::thread([interval_us]()
+		{
+			std::unique_lock<std::mutex> lock(g_sampler_lock);
+			u64 interval = interval_us;
+
+			while (!g_sampler_cv.wait_for(lock, std::chrono::microseconds(interval), []() { return g_sampler_stop; }))
+			{
+				if (!Emu.IsRunning()) continue;
+
+				// a slow tick (many threads, deep stacks) is followed by a longer interval, so the sampler doesn't
+				// take more than max_overhead percent of a host thread or hold the thread list too often
+				interval = std::max<u64>(interval_us, tick() * 100 / max_overhead);
+
+				if (interval > interval_us)
+				{
+					g_delayed_ticks++;
+					g_max_interval = std::max(g_max_interval, interval);
+				}
+			}
+		});
+	}
+
+	static std::string function_name(u32 type, u32 addr)
+	{
+		switch (type)
+		{
+		case CPU_THREAD_PPU:
+		{
+			auto found = g_ppu_symbols.upper_bound(addr);
+
+			if (found != g_ppu_symbols.begin() && (!(--found)->second.size || addr - found->first < found->second.size))
+			{
+				return found->second.name.empty() ? fmt::Format("sub_%x", found->first) : found->second.name;
+			}
+
+			return fmt::Format("unknown_%x", addr);
+		}
+
+		case CPU_THREAD_SPU:
+		case CPU_THREAD_RAW_SPU:
+		{
+			auto found = g_spu_entries.upper_bound(addr);
+
+			return found != g_spu_entries.begin() ? fmt::Format("spu_sub_%x", *--found) : fmt::Format("spu_unknown_%x", addr);
+		}
+		}
+
+		return fmt::Format("unknown_%x", addr);
+	}
+
+	// function names of a stack from the leaf to the root. Consecutive frames of the same function are merged:
+	// the LR of a non-leaf function is stale or already saved in the frame, and recursion is collapsed.
+	static std::vector<std::string> resolve(const std::vector<u32>& key)
+	{
+		const u32 type = key[0] >> 8;
+		std::vector<std::string> names;
+
+		auto push = [&names](const std::string& name)
+		{
+			if (names.empty() || names.back() != name) names.push_back(name);
+		};
+
+		switch (key[0] & 0xff)
+		{
+		case CPU_EXEC_HLE: push(SysCalls::GetHLEFuncName(key[1])); break;
+		case CPU_EXEC_SYSCALL: push(fmt::Format("syscall_%d", key[1])); break;
+		case CPU_EXEC_NATIVE: push("native_task"); break;
+		default: push(function_name(type, key[1])); break;
+		}
+
+		for (size_t i = 2; i < key.size(); i++)
+		{
+			push(function_name(type, key[i]));
+		}
+
+		return names;
+	}
+
+	template<typename T> static std::vector<std::pair<T, u64>> sorted(const std::map<T, u64>& counts)
+	{
+		std::vector<std::pair<T, u64>> res(counts.begin(), counts.end());
+
+		std::stable_sort(res.begin(), res.end(), [](const std::pair<T, u64>& a, const std::pair<T, u64>& b)
+		{
+			return a.second > b.second;
+		});
+
+		return res;
+	}
+
+	static std::string report()
+	{
+		std::map<std::string, u64> self, total;
+		std::map<std::pair<std::string, std::string>, u64> calls; // (caller, callee)
+		u64 count = 0;
+
+		for (auto& stack : g_stacks)
+		{
+			const std::vector<std::string> names = resolve(stack.first);
+			const u64 n = stack.second;
+
+			count += n;
+			self[names[0]] += n;
+
+			// a function or a call is counted once per stack
+			std::set<std::string> functions;
+			std::set<std::pair<std::string, std::string>> edges;
+
+			for (size_t i = 0; i < names.size(); i++)
+			{
+				if (functions.insert(names[i]).second) total[names[i]] += n;
+				if (i + 1 < names.size() && edges.emplace(names[i + 1], names[i]).second) calls[std::make_pair(names[i + 1], names[i])] += n;
+			}
+		}
+
+		const double pct = count ? 100.0 / count : 0.0;
+		const u64 time = g_stop_time - g_start_time;
+
+		std::string res = fmt::Format("Guest code profile: %llu samples of %d threads in %.3f s\n", g_samples, (int)g_threads.size(), time / 1000000.0);
+		res += fmt::Format("Sampler: %llu ticks, %.1f us per tick on average, %llu us at most, %.3f%% of one host thread\n",
+			g_ticks, g_ticks ? (double)g_tick_time / g_ticks : 0.0, g_max_tick_time, time ? g_tick_time * 100.0 / time : 0.0);
+
+		if (g_delayed_ticks)
+		{
+			res += fmt::Format("%llu ticks delayed (more than %d%% overhead), up to %llu us between ticks\n", g_delayed_ticks, (int)max_overhead, g_max_interval);
+		}
+
+		if (g_dropped)
+		{
+			res += fmt::Format("%llu samples dropped (more than %d distinct stacks)\n", g_dropped, (int)max_stacks);
+		}
+
+		res += "\nThreads\n\n     samples interpreter  recompiled         hle     syscall      native  thread\n";
+
+		for (auto& t : g_threads)
+		{
+			u64 sum = 0;
+			for (auto v : t.second.modes) sum += v;
+
+			res += fmt::Format("%12llu", sum);
+			for (auto v : t.second.modes) res += fmt::Format("%12llu", v);
+			res += "  " + t.second.name + "\n";
+		}
+
+		res += "\nFlat profile\n\n  self %  total %        self       total  function\n";
+
+		for (auto& f : sorted(total))
+		{
+			const u64 s = self[f.first];
+			res += fmt::Format("%8.2f %8.2f %11llu %11llu  %s\n", s * pct, f.second * pct, s, f.second, f.first.c_str());
+		}
+
+		// callers are listed above and callees below the function, the numbers are the samples of the stacks containing the call
+		res += "\nCall graph\n\n";
+
+		std::map<std::string, std::vector<std::pair<std::string, u64>>> callers, callees;
+
+		for (auto& c : sorted(calls))
+		{
+			callers[c.first.second].emplace_back(c.first.first, c.second);
+			callees[c.first.first].emplace_back(c.first.second, c.second);
+		}
+
+		for (auto& f : sorted(total))
+		{
+			for (auto& c : callers[f.first]) res += fmt::Format("%30llu      %s\n", c.second, c.first.c_str());
+			res += fmt::Format("[%6.2f%%] %11llu %11llu  %s\n", f.second * pct, self[f.first], f.second, f.first.c_str());
+			for (auto& c : callees[f.first]) res += fmt::Format("%30llu      %s\n", c.second, c.first.c_str());
+			res += "\n";
+		}
+
+		return res;
+	}
+
+	// one line per stack: the thread type and the functions from the root to the leaf separated by ';' and the samples,
+	// the leaf is marked _[j] if it was recompiled and _[k] if it's host code (the annotations of flamegraph.pl)
+	static std::string collapsed_stacks()
+	{
+		std::map<std::string, u64> lines;
+
+		for (auto& stack : g_stacks)
+		{
+			const std::vector<std::string> names = resolve(stack.first);
+			std::string line = CPUThread::CPUThreadTypeToString((CPUThreadType)(stack.first[0] >> 8));
+
+			for (auto it = names.rbegin(); it != names.rend(); it++)
+			{
+				line += ";" + *it;
+			}
+
+			switch (stack.first[0] & 0xff)
+			{
+			case CPU_EXEC_RECOMPILED: line += "_[j]"; break;
+			case CPU_EXEC_HLE:
+			case CPU_EXEC_SYSCALL:
+			case CPU_EXEC_NATIVE: line += "_[k]"; break;
+			}
+
+			lines[line] += stack.second;
+		}
+
+		std::string res;
+
+		for (auto& line : lines)
+		{
+			res += fmt::Format("%s %llu\n", line.first.c_str(), line.second);
+		}
+
+		return res;
+	}
+
+	void stop(const std::string& path)
+	{
+		if (!stop_sampler()) return;
+
+		rFile f(path, rFile::write);
+
+		if (!f.IsOpened())
+		{
+			LOG_ERROR(GENERAL, "prof::stop(): failed to open '%s'", path.c_str());
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(g_symbols_lock);
+
+		const bool folded = path.size() >= 7 && path.compare(path.size() - 7, 7, ".folded") == 0;
+
+		f.Write(folded ? collapsed_stacks() : report());
+
+		LOG_NOTICE(GENERAL, "Profile of %llu samples written to '%s' (sampler time: %.3f ms)", g_samples, path.c_str(), g_tick_time / 1000.0);
+	}
+}
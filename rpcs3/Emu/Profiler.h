@@ -0,0 +1,20 @@
+#pragma once
+
+// Sampling profiler of the guest code.
+// The PC, the execution mode and the call stack of every running CPU thread are captured periodically by a separate
+// thread and aggregated by guest function when the report is written.
+namespace prof
+{
+	// names of guest functions (ELF symbols, HLE import stubs, hooked static functions), size 0 = unknown
+	void add_symbol(u32 addr, u32 size, const std::string& name);
+
+	// forget the symbols and the samples (called when a new game is loaded)
+	void reset();
+
+	// sample the threads every interval_us (at least 500 us, longer after a tick that took more than 2% of the interval)
+	void start(u32 interval_us);
+
+	// stop sampling (if started) and write the report: a flat profile and a call graph as text, or collapsed stacks
+	// for flamegraph tools if the path ends with .folded
+	void stop(const std::string& path);
+}
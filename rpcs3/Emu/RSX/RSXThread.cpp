@@ -5,6 +5,7 @@
 #include "Emu/System.h"
 #include "Emu/RSX/GSManager.h"
 #include "RSXThread.h"
+#include "Emu/PerfCounters.h"
 
 #include "Emu/SysCalls/Callback.h"
 #include "Emu/SysCalls/lv2/sys_time.h"
@@ -314,6 +315,7 @@ void RSXThread::DoCmd(const u32 fcmd, const u32 cmd, const u32 args_addr, const
 		{
 			Flip();
 			m_last_flip_time = get_system_time();
+			perf::add_flip();
 
 			m_gcm_current_buffer = ARGS(0);
 			m_read_buffer = true;
@@ -2132,6 +2134,8 @@ void RSXThread::Begin(u32 draw_mode)
 
 void RSXThread::End()
 {
+	perf::add(perf::RSX_DRAW_CALLS);
+
 	ExecCMD();
 
 	m_indexed_array.Reset();
@@ -2279,6 +2283,7 @@ void RSXThread::Task()
 			methodRegisters[(cmd & 0xffff) + (i*4*inc)] = ARGS(i);
 		}
 
+		perf::add(perf::RSX_METHODS);
 		DoCmd(cmd, cmd & 0x3ffff, args.addr(), count);
 
 		m_ctrl->get = get + (count + 1) * 4;
@@ -1,20 +1,43 @@
 #pragma once
+#include "Utilities/Log.h"
 
 class LogBase
 {
 	bool m_logging;
 	bool CheckLogging() const;
 
-	enum LogType
+	// formats "name info text" or "name[id] info text" (called by the log consumer thread)
+	template<bool with_id, typename... Targs> static std::string FormatOutput(const char* fmt, const u8* args)
 	{
-		LogNotice,
-		LogSuccess,
-		LogWarning,
-		LogError,
+		std::string res = ::Log::LogArg<const char*>::load(args);
+		if (with_id)
+		{
+			res += "[" + std::to_string(::Log::LogArg<u32>::load(args)) + "]";
+		}
+		res += ::Log::LogArg<const char*>::load(args);
+		return res + ::Log::LogArgs<Targs...>::format(fmt, args);
+	}
+
+	template<bool with_id, typename... Targs> struct OutputArgs
+	{
+		static const ::Log::LogArgsInfo info;
 	};
 
-	void LogOutput(LogType type, const char* info, const std::string& text) const;
-	void LogOutput(LogType type, const u32 id, const char* info, const std::string& text) const;
+	template<::Log::LogSeverity sev, typename... Targs> void LogOutput(const char* info, const char* fmt, Targs... args) const
+	{
+		if (::Log::is_enabled<sev>(::Log::HLE))
+		{
+			::Log::LogManager::getInstance().push(::Log::HLE, sev, OutputArgs<false, Targs...>::info, fmt, GetName().c_str(), info, args...);
+		}
+	}
+
+	template<::Log::LogSeverity sev, typename... Targs> void LogOutput(const u32 id, const char* info, const char* fmt, Targs... args) const
+	{
+		if (::Log::is_enabled<sev>(::Log::HLE))
+		{
+			::Log::LogManager::getInstance().push(::Log::HLE, sev, OutputArgs<true, Targs...>::info, fmt, GetName().c_str(), id, info, args...);
+		}
+	}
 
 public:
 	void SetLogging(bool value)
@@ -31,12 +54,12 @@ public:
 
 	template<typename... Targs> __noinline void Notice(const u32 id, const char* fmt, Targs... args) const
 	{
-		LogOutput(LogNotice, id, " : ", fmt::Format(fmt, args...));
+		LogOutput<::Log::Notice>(id, " : ", fmt, args...);
 	}
 
 	template<typename... Targs> __noinline void Notice(const char* fmt, Targs... args) const
 	{
-		LogOutput(LogNotice, " : ", fmt::Format(fmt, args...));
+		LogOutput<::Log::Notice>(" : ", fmt, args...);
 	}
 
 	template<typename... Targs> __forceinline void Log(const char* fmt, Targs... args) const
@@ -57,45 +80,53 @@ public:
 
 	template<typename... Targs> __noinline void Success(const u32 id, const char* fmt, Targs... args) const
 	{
-		LogOutput(LogSuccess, id, " : ", fmt::Format(fmt, args...));
+		LogOutput<::Log::Success>(id, " : ", fmt, args...);
 	}
 
 	template<typename... Targs> __noinline void Success(const char* fmt, Targs... args) const
 	{
-		LogOutput(LogSuccess, " : ", fmt::Format(fmt, args...));
+		LogOutput<::Log::Success>(" : ", fmt, args...);
 	}
 
 	template<typename... Targs> __noinline void Warning(const u32 id, const char* fmt, Targs... args) const
 	{
-		LogOutput(LogWarning, id, " warning: ", fmt::Format(fmt, args...));
+		LogOutput<::Log::Warning>(id, " warning: ", fmt, args...);
 	}
 
 	template<typename... Targs> __noinline void Warning(const char* fmt, Targs... args) const
 	{
-		LogOutput(LogWarning, " warning: ", fmt::Format(fmt, args...));
+		LogOutput<::Log::Warning>(" warning: ", fmt, args...);
 	}
 
 	template<typename... Targs> __noinline void Error(const u32 id, const char* fmt, Targs... args) const
 	{
-		LogOutput(LogError, id, " error: ", fmt::Format(fmt, args...));
+		LogOutput<::Log::Error>(id, " error: ", fmt, args...);
 	}
 
 	template<typename... Targs> __noinline void Error(const char* fmt, Targs... args) const
 	{
-		LogOutput(LogError, " error: ", fmt::Format(fmt, args...));
+		LogOutput<::Log::Error>(" error: ", fmt, args...);
 	}
 
 	template<typename... Targs> __noinline void Todo(const u32 id, const char* fmt, Targs... args) const
 	{
-		LogOutput(LogError, id, " TODO: ", fmt::Format(fmt, args...));
+		LogOutput<::Log::Error>(id, " TODO: ", fmt, args...);
 	}
 
 	template<typename... Targs> __noinline void Todo(const char* fmt, Targs... args) const
 	{
-		LogOutput(LogError, " TODO: ", fmt::Format(fmt, args...));
+		LogOutput<::Log::Error>(" TODO: ", fmt, args...);
 	}
 };
 
+// the module name, the id and the info text are stored before the arguments of the message
+template<bool with_id, typename... Targs> const ::Log::LogArgsInfo LogBase::OutputArgs<with_id, Targs...>::info =
+{
+	&LogBase::FormatOutput<with_id, Targs...>,
+	with_id ? "%s[%u]%s" : "%s%s",
+	with_id ? ::Log::LogArgTypes<const char*, u32, const char*, Targs...>::value : ::Log::LogArgTypes<const char*, const char*, Targs...>::value,
+};
+
 namespace hle
 {
 	struct error
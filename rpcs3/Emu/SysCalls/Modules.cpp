@@ -150,12 +150,14 @@ void Module::SetName(const std::string& name)
 
 bool Module::CheckID(u32 id) const
 {
-	return Emu.GetIdManager().CheckID(id) && Emu.GetIdManager().GetID(id).GetName() == GetName();
+	void* ptr;
+	return Emu.GetIdManager().FindIDData(id, GetName(), ptr);
 }
 
 bool Module::CheckID(u32 id, ID*& _id) const
 {
-	return Emu.GetIdManager().CheckID(id) && (_id = &Emu.GetIdManager().GetID(id))->GetName() == GetName();
+	ID* found = Emu.GetIdManager().FindID(id);
+	return found && (_id = found)->GetName() == GetName();
 }
 
 bool Module::RemoveId(u32 id)
@@ -85,23 +85,17 @@ public:
 	bool CheckID(u32 id) const;
 	template<typename T> bool CheckId(u32 id, T*& data)
 	{
-		ID* id_data;
-
-		if(!CheckID(id, id_data)) return false;
-
-		data = id_data->GetData()->get<T>();
-
-		return true;
+		return GetIdManager().FindIDData(id, GetName(), data);
 	}
 
 	template<typename T> bool CheckId(u32 id, T*& data, IDType& type)
 	{
-		ID* id_data;
+		void* ptr;
+		const std::string* name;
 
-		if(!CheckID(id, id_data)) return false;
+		if(!GetIdManager().FindIDData(id, ptr, type, name) || *name != GetName()) return false;
 
-		data = id_data->GetData()->get<T>();
-		type = id_data->GetType();
+		data = (T*)ptr;
 
 		return true;
 	}
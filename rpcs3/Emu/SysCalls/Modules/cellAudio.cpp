@@ -8,7 +8,9 @@
 #include "Emu/Event.h"
 #include "Emu/SysCalls/lv2/sys_time.h"
 #include "Emu/Audio/AudioManager.h"
+#include "Emu/Audio/AudioClock.h"
 #include "Emu/Audio/AudioDumper.h"
+#include "Emu/Audio/AudioMixer.h"
 #include "Emu/Audio/cellAudio.h"
 
 Module *cellAudio = nullptr;
@@ -74,10 +76,10 @@ int cellAudioInit()
 				oal_buffer_float[i] = std::unique_ptr<float[]>(new float[oal_buffer_size] {} );
 			}
 
-			SQueue<s16*, 31> queue;
+			SQueueSPSC<s16*, 31> queue;
 			queue.Clear();
 
-			SQueue<float*, 31> queue_float;
+			SQueueSPSC<float*, 31> queue_float;
 			queue_float.Clear();
 
 			std::vector<u64> keys;
@@ -93,7 +95,8 @@ int cellAudioInit()
 					m_audio_out->Open(oal_buffer_float[0].get(), oal_buffer_size * sizeof(float));
 			}
 
-			m_config.start_time = get_system_time();
+			g_audio_clock.Start(get_system_time());
+			m_config.start_time = g_audio_clock.GetStartTime();
 
 			volatile bool internal_finished = false;
 
@@ -139,14 +142,11 @@ int cellAudioInit()
 					goto abort;
 				}
 
-				const u64 stamp0 = get_system_time();
-
 				// TODO: send beforemix event (in ~2,6 ms before mixing)
 
-				// precise time of sleeping: 5,(3) ms (or 256/48000 sec)
-				if (m_config.counter * 256000000 / 48000 >= stamp0 - m_config.start_time)
+				// sleep until the deadline of the next block: 5,(3) ms (or 256/48000 sec) per block
+				if (!g_audio_clock.WaitDeadline(m_config.counter))
 				{
-					std::this_thread::sleep_for(std::chrono::milliseconds(1));
 					continue;
 				}
 
@@ -174,157 +174,11 @@ int cellAudioInit()
 
 					auto buf = vm::get_ptr<be_t<float>>(buf_addr);
 
-					static const float k = 1.0f; // may be 1.0f
-					const float m = port.level;
-
-					if (port.channel == 2)
+					if (port.channel == 2 || port.channel == 6 || port.channel == 8)
 					{
-						if (first_mix)
-						{
-							for (u32 i = 0; i < (sizeof(buf2ch) / sizeof(float)); i += 2)
-							{
-								// reverse byte order
-								const float left = buf[i + 0] * m;
-								const float right = buf[i + 1] * m;
-
-								buf2ch[i + 0] = left;
-								buf2ch[i + 1] = right;
-
-								buf8ch[i * 4 + 0] = left;
-								buf8ch[i * 4 + 1] = right;
-								buf8ch[i * 4 + 2] = 0.0f;
-								buf8ch[i * 4 + 3] = 0.0f;
-								buf8ch[i * 4 + 4] = 0.0f;
-								buf8ch[i * 4 + 5] = 0.0f;
-								buf8ch[i * 4 + 6] = 0.0f;
-								buf8ch[i * 4 + 7] = 0.0f;
-							}
-							first_mix = false;
-						}
-						else
-						{
-							for (u32 i = 0; i < (sizeof(buf2ch) / sizeof(float)); i += 2)
-							{
-								const float left = buf[i + 0] * m;
-								const float right = buf[i + 1] * m;
-
-								buf2ch[i + 0] += left;
-								buf2ch[i + 1] += right;
-
-								buf8ch[i * 4 + 0] += left;
-								buf8ch[i * 4 + 1] += right;
-							}
-						}
-					}
-					else if (port.channel == 6)
-					{
-						if (first_mix)
-						{
-							for (u32 i = 0; i < (sizeof(buf2ch) / sizeof(float)); i += 2)
-							{
-								const float left = buf[i * 3 + 0] * m;
-								const float right = buf[i * 3 + 1] * m;
-								const float center = buf[i * 3 + 2] * m;
-								const float low_freq = buf[i * 3 + 3] * m;
-								const float rear_left = buf[i * 3 + 4] * m;
-								const float rear_right = buf[i * 3 + 5] * m;
-
-								const float mid = (center + low_freq) * 0.708f;
-								buf2ch[i + 0] = (left + rear_left + mid) * k;
-								buf2ch[i + 1] = (right + rear_right + mid) * k;
-
-								buf8ch[i * 4 + 0] = left;
-								buf8ch[i * 4 + 1] = right;
-								buf8ch[i * 4 + 2] = center;
-								buf8ch[i * 4 + 3] = low_freq;
-								buf8ch[i * 4 + 4] = rear_left;
-								buf8ch[i * 4 + 5] = rear_right;
-								buf8ch[i * 4 + 6] = 0.0f;
-								buf8ch[i * 4 + 7] = 0.0f;
-							}
-							first_mix = false;
-						}
-						else
-						{
-							for (u32 i = 0; i < (sizeof(buf2ch) / sizeof(float)); i += 2)
-							{
-								const float left = buf[i * 3 + 0] * m;
-								const float right = buf[i * 3 + 1] * m;
-								const float center = buf[i * 3 + 2] * m;
-								const float low_freq = buf[i * 3 + 3] * m;
-								const float rear_left = buf[i * 3 + 4] * m;
-								const float rear_right = buf[i * 3 + 5] * m;
-
-								const float mid = (center + low_freq) * 0.708f;
-								buf2ch[i + 0] += (left + rear_left + mid) * k;
-								buf2ch[i + 1] += (right + rear_right + mid) * k;
-
-								buf8ch[i * 4 + 0] += left;
-								buf8ch[i * 4 + 1] += right;
-								buf8ch[i * 4 + 2] += center;
-								buf8ch[i * 4 + 3] += low_freq;
-								buf8ch[i * 4 + 4] += rear_left;
-								buf8ch[i * 4 + 5] += rear_right;
-							}
-						}
-					}
-					else if (port.channel == 8)
-					{
-						if (first_mix)
-						{
-							for (u32 i = 0; i < (sizeof(buf2ch) / sizeof(float)); i += 2)
-							{
-								const float left = buf[i * 4 + 0] * m;
-								const float right = buf[i * 4 + 1] * m;
-								const float center = buf[i * 4 + 2] * m;
-								const float low_freq = buf[i * 4 + 3] * m;
-								const float rear_left = buf[i * 4 + 4] * m;
-								const float rear_right = buf[i * 4 + 5] * m;
-								const float side_left = buf[i * 4 + 6] * m;
-								const float side_right = buf[i * 4 + 7] * m;
-
-								const float mid = (center + low_freq) * 0.708f;
-								buf2ch[i + 0] = (left + rear_left + side_left + mid) * k;
-								buf2ch[i + 1] = (right + rear_right + side_right + mid) * k;
-
-								buf8ch[i * 4 + 0] = left;
-								buf8ch[i * 4 + 1] = right;
-								buf8ch[i * 4 + 2] = center;
-								buf8ch[i * 4 + 3] = low_freq;
-								buf8ch[i * 4 + 4] = rear_left;
-								buf8ch[i * 4 + 5] = rear_right;
-								buf8ch[i * 4 + 6] = side_left;
-								buf8ch[i * 4 + 7] = side_right;
-							}
-							first_mix = false;
-						}
-						else
-						{
-							for (u32 i = 0; i < (sizeof(buf2ch) / sizeof(float)); i += 2)
-							{
-								const float left = buf[i * 4 + 0] * m;
-								const float right = buf[i * 4 + 1] * m;
-								const float center = buf[i * 4 + 2] * m;
-								const float low_freq = buf[i * 4 + 3] * m;
-								const float rear_left = buf[i * 4 + 4] * m;
-								const float rear_right = buf[i * 4 + 5] * m;
-								const float side_left = buf[i * 4 + 6] * m;
-								const float side_right = buf[i * 4 + 7] * m;
-
-								const float mid = (center + low_freq) * 0.708f;
-								buf2ch[i + 0] += (left + rear_left + side_left + mid) * k;
-								buf2ch[i + 1] += (right + rear_right + side_right + mid) * k;
-
-								buf8ch[i * 4 + 0] += left;
-								buf8ch[i * 4 + 1] += right;
-								buf8ch[i * 4 + 2] += center;
-								buf8ch[i * 4 + 3] += low_freq;
-								buf8ch[i * 4 + 4] += rear_left;
-								buf8ch[i * 4 + 5] += rear_right;
-								buf8ch[i * 4 + 6] += side_left;
-								buf8ch[i * 4 + 7] += side_right;
-							}
-						}
+						// reverse byte order, apply level and downmix to 2 channels (center and LFE are mixed at 0.708)
+						audio_mix_port(buf2ch, buf8ch, buf, port.channel, port.level, BUFFER_SIZE, first_mix);
+						first_mix = false;
 					}
 
 					memset(buf, 0, block_size * sizeof(float));
@@ -356,8 +210,6 @@ int cellAudioInit()
 					}
 				}
 
-				//const u64 stamp1 = get_system_time();
-
 				if (first_mix)
 				{
 					if (g_is_u16) memset(&oal_buffer[oal_pos][0], 0, oal_buffer_size * sizeof(s16));
@@ -371,15 +223,13 @@ int cellAudioInit()
 					{
 						if (g_is_u16)
 							queue.Push(&oal_buffer[oal_pos][0], nullptr);
-
-						queue_float.Push(&oal_buffer_float[oal_pos][0], nullptr);
+						else
+							queue_float.Push(&oal_buffer_float[oal_pos][0], nullptr);
 					}
 
 					oal_buffer_offset = 0;
 				}
 
-				//const u64 stamp2 = get_system_time();
-
 				// send aftermix event (normal audio event)
 				{
 					std::lock_guard<std::mutex> lock(audioMutex);
@@ -400,14 +250,14 @@ int cellAudioInit()
 					keys.resize(m_config.m_keys.size());
 					memcpy(keys.data(), m_config.m_keys.data(), sizeof(u64) * keys.size());
 				}
+				g_audio_clock.Tick();
+
 				for (u32 i = 0; i < keys.size(); i++)
 				{
 					// TODO: check event source
 					Emu.GetEventManager().SendEvent(keys[i], 0x10103000e010e07, 0, 0, 0);
 				}
 
-				//const u64 stamp3 = get_system_time();
-
 				if (do_dump && !first_mix)
 				{
 					if (m_dump.GetCh() == 8)
@@ -433,11 +283,17 @@ int cellAudioInit()
 					}
 				}
 
-				//LOG_NOTICE(HLE, "Audio perf: start=%d (access=%d, AddData=%d, events=%d, dump=%d)",
-					//stamp0 - m_config.start_time, stamp1 - stamp0, stamp2 - stamp1, stamp3 - stamp2, get_system_time() - stamp3);
 			}
 			cellAudio->Notice("Audio thread ended");
 abort:
+			g_audio_clock.Stop();
+
+			{
+				const AudioClockStats stats = g_audio_clock.GetStats();
+				cellAudio->Notice("Audio clock: %lld blocks, %lld late, %lld underruns, lateness avg=%lld us, max=%lld us",
+					stats.blocks, stats.late_blocks, stats.underruns, stats.blocks ? stats.total_lateness / stats.blocks : 0, stats.max_lateness);
+			}
+
 			queue.Push(nullptr, nullptr);
 			queue_float.Push(nullptr, nullptr);
 
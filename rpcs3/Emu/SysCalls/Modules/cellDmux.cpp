@@ -304,6 +304,45 @@ void dmuxQueryEsAttr(u32 info_addr /* may be 0 */, vm::ptr<const CellCodecEsFilt
 		(u32)esFilterId->supplementalInfo1, (u32)esFilterId->supplementalInfo2);
 }
 
+// returns the offset of the first 00 00 01 sequence (or size if not found)
+u32 dmuxFindStartCode(const u8* data, u32 size)
+{
+	u32 i = 0;
+
+	if (size >= 18)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i one = _mm_set1_epi8(1);
+
+		// test 16 positions per iteration
+		for (; i <= size - 18; i += 16)
+		{
+			const __m128i b0 = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(data + i + 0)), zero);
+			const __m128i b1 = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(data + i + 1)), zero);
+			const __m128i b2 = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(data + i + 2)), one);
+
+			const u32 mask = _mm_movemask_epi8(_mm_and_si128(_mm_and_si128(b0, b1), b2));
+			if (mask)
+			{
+				for (u32 j = 0;; j++)
+				{
+					if (mask & (1 << j)) return i + j;
+				}
+			}
+		}
+	}
+
+	for (; i + 3 <= size; i++)
+	{
+		if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1)
+		{
+			return i;
+		}
+	}
+
+	return size;
+}
+
 u32 dmuxOpen(Demuxer* data)
 {
 	Demuxer& dmux = *data;
@@ -523,8 +562,8 @@ u32 dmuxOpen(Demuxer* data)
 
 				default:
 				{
-					// search
-					stream.skip(1);
+					// search for the next start code
+					stream.skip(1 + dmuxFindStartCode(vm::get_ptr<u8>(stream.addr + 1), stream.size - 1));
 				}
 				}
 				continue;
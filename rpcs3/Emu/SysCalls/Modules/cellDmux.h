@@ -502,3 +502,12 @@ public:
 
 	void reset();
 };
+
+// returns the offset of the first 00 00 01 sequence (or size if not found)
+u32 dmuxFindStartCode(const u8* data, u32 size);
+
+namespace dmux_start_code
+{
+	// comparison of dmuxFindStartCode() with the scalar scan and a benchmark (empty unless enabled in cellDmuxTests.cpp)
+	void RunAllTests();
+}
@@ -0,0 +1,146 @@
+#include "stdafx.h"
+#include "Utilities/Log.h"
+#include "Emu/Memory/Memory.h"
+#include "Emu/System.h"
+#include "cellPamf.h"
+#include "cellDmux.h"
+
+//#define DMUX_START_CODE_UNIT_TESTS 1
+
+#ifdef DMUX_START_CODE_UNIT_TESTS
+#include <random>
+
+// dmuxFindStartCode() is compared with the scalar scan which cellDmux used before, on random buffers of any length at
+// unaligned addresses (bytes 0, 1 and 2 only, so start codes and their prefixes are dense and occur at every position
+// relative to the 16 byte blocks) and on longer random buffers with sparse start codes. The benchmark scans a synthetic
+// program stream (a start code at the beginning of every 2048 byte pack) like the demuxer thread and reports MB/s.
+
+namespace dmux_start_code
+{
+	static const u32 s_random_tests = 200000;
+	static const u32 s_bench_size = 64 * 1024 * 1024;
+
+	static u32 ref_find_start_code(const u8* data, u32 size)
+	{
+		for (u32 i = 0; i + 3 <= size; i++)
+		{
+			if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1)
+			{
+				return i;
+			}
+		}
+
+		return size;
+	}
+
+	static u32 test_random_buffers()
+	{
+		std::mt19937 rng(0xd3c0);
+		std::vector<u8> data(4096 + 16);
+
+		for (u32 n = 0; n < s_random_tests; n++)
+		{
+			const bool dense = n % 2 == 0;
+			const u32 size = dense ? rng() % 80 : rng() % 4096;
+			const u32 offset = rng() % 16;
+
+			for (u32 i = 0; i < size; i++)
+			{
+				data[offset + i] = (u8)(dense ? rng() % 3 : rng() % 255 + 1);
+			}
+
+			// a few start codes at random positions
+			const u32 codes = dense || size < 3 ? 0 : rng() % 3;
+
+			for (u32 i = 0; i < codes; i++)
+			{
+				const u32 pos = offset + rng() % (size - 2);
+				data[pos + 0] = 0;
+				data[pos + 1] = 0;
+				data[pos + 2] = 1;
+			}
+
+			const u32 res = dmuxFindStartCode(data.data() + offset, size);
+			const u32 ref = ref_find_start_code(data.data() + offset, size);
+
+			if (res != ref)
+			{
+				LOG_ERROR(GENERAL, "[UT dmux] dmuxFindStartCode(size %d, offset %d): %d, expected %d", size, offset, res, ref);
+				return 1;
+			}
+		}
+
+		return 0;
+	}
+
+	// scans like the demuxer thread (skipping the start code found), returns MB/s
+	template<typename F> static double scan_stream(const std::vector<u8>& stream, F func, u32& count)
+	{
+		const auto start = std::chrono::high_resolution_clock::now();
+		count = 0;
+
+		for (u32 pos = 0; pos < stream.size(); count++)
+		{
+			pos += 1 + func(stream.data() + pos + 1, (u32)stream.size() - pos - 1);
+		}
+
+		return stream.size() / std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count() / (1024 * 1024);
+	}
+
+	static u32 benchmark()
+	{
+		std::mt19937 rng(0xbe4c);
+		std::vector<u8> stream(s_bench_size);
+
+		// the payload contains no 00 00 01
+		for (auto& b : stream)
+		{
+			b = (u8)(rng() % 255 + 1);
+		}
+
+		for (u32 i = 0; i + 4 <= s_bench_size; i += 2048)
+		{
+			stream[i + 0] = 0;
+			stream[i + 1] = 0;
+			stream[i + 2] = 1;
+			stream[i + 3] = 0xba;
+		}
+
+		u32 count, ref_count;
+		const double sse = scan_stream(stream, dmuxFindStartCode, count);
+		const double ref = scan_stream(stream, ref_find_start_code, ref_count);
+
+		LOG_NOTICE(GENERAL, "dmuxFindStartCode: %.0f MB/s (scalar: %.0f MB/s)", sse, ref);
+
+		if (count != ref_count || count != s_bench_size / 2048)
+		{
+			LOG_ERROR(GENERAL, "[UT dmux] benchmark: %d start codes found (scalar: %d), expected %d", count, ref_count, s_bench_size / 2048);
+			return 1;
+		}
+
+		return 0;
+	}
+
+	void RunAllTests()
+	{
+		LOG_NOTICE(GENERAL, "Running dmux start code tests");
+
+		u32 num_failed = 0;
+
+		num_failed += test_random_buffers();
+		num_failed += benchmark();
+
+		LOG_NOTICE(GENERAL, "Unit Tests done (%d failed)", num_failed);
+	}
+}
+
+#else
+
+namespace dmux_start_code
+{
+	void RunAllTests()
+	{
+	}
+}
+
+#endif // DMUX_START_CODE_UNIT_TESTS
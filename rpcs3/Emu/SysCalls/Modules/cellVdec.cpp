@@ -3,6 +3,7 @@
 #include "Emu/System.h"
 #include "Emu/SysCalls/Modules.h"
 #include "Emu/SysCalls/Callback.h"
+#include "rpcs3/Ini.h"
 
 std::mutex g_mutex_avcodec_open2;
 
@@ -16,6 +17,7 @@ extern "C"
 #include "Emu/CPU/CPUThreadManager.h"
 #include "cellPamf.h"
 #include "cellVdec.h"
+#include "cellVdecConvert.h"
 
 Module *cellVdec = nullptr;
 
@@ -330,6 +332,11 @@ u32 vdecOpen(VideoDecoder* data)
 						break;
 					}
 					vdec.ctx = vdec.fmt->streams[0]->codec; // TODO: check data
+
+					// frame threading delays pictures by (thread_count - 1) frames,
+					// AUs are read continuously by vdecRead() and the delayed pictures are drained at the end of the sequence
+					vdec.ctx->thread_count = Ini.HLEVdecThreads.GetValue(); // 0 = auto
+					vdec.ctx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
 						
 					AVDictionary* opts = nullptr;
 					av_dict_set(&opts, "refcounted_frames", "1", 0);
@@ -578,6 +585,20 @@ int cellVdecDecodeAu(u32 handle, CellVdecDecodeMode mode, vm::ptr<const CellVdec
 	return CELL_OK;
 }
 
+// Convert a YUV420P frame to ARGB32 or RGBA32 (tightly packed, written directly to the output buffer)
+static void vdecConvertYUV420(u8* dst, const AVFrame& frame, bool argb, const VdecColorMatrix& m, u8 alpha)
+{
+	for (int i = 0; i < frame.height; i++)
+	{
+		const u8* y = frame.data[0] + i * frame.linesize[0];
+		const u8* u = frame.data[1] + (i / 2) * frame.linesize[1];
+		const u8* v = frame.data[2] + (i / 2) * frame.linesize[2];
+		u8* out = dst + i * frame.width * 4;
+
+		vdecConvertRow(out, y, u, v, frame.width, m, alpha, argb);
+	}
+}
+
 int cellVdecGetPicture(u32 handle, vm::ptr<const CellVdecPicFormat> format, vm::ptr<u8> outBuff)
 {
 	cellVdec->Log("cellVdecGetPicture(handle=%d, format_addr=0x%x, outBuff_addr=0x%x)", handle, format.addr(), outBuff.addr());
@@ -605,27 +626,55 @@ int cellVdecGetPicture(u32 handle, vm::ptr<const CellVdecPicFormat> format, vm::
 	{
 		u32 buf_size = a128(av_image_get_buffer_size(vdec->ctx->pix_fmt, vdec->ctx->width, vdec->ctx->height, 1));
 
-		if (format->formatType != CELL_VDEC_PICFMT_YUV420_PLANAR)
+		AVFrame& frame = *vf.data;
+
+		switch (format->formatType)
 		{
-			cellVdec->Todo("cellVdecGetPicture: unknown formatType(%d)", (u32)format->formatType);
-			return CELL_OK;
+		case CELL_VDEC_PICFMT_YUV420_PLANAR:
+		{
+			// TODO: zero padding bytes
+
+			int err = av_image_copy_to_buffer(outBuff.get_ptr(), buf_size, frame.data, frame.linesize, vdec->ctx->pix_fmt, frame.width, frame.height, 1);
+			if (err < 0)
+			{
+				cellVdec->Error("cellVdecGetPicture: av_image_copy_to_buffer failed(%d)", err);
+				Emu.Pause();
+			}
 		}
+		break;
 
-		if (format->colorMatrixType != CELL_VDEC_COLOR_MATRIX_TYPE_BT709)
+		case CELL_VDEC_PICFMT_ARGB32_ILV:
+		case CELL_VDEC_PICFMT_RGBA32_ILV:
 		{
-			cellVdec->Todo("cellVdecGetPicture: unknown colorMatrixType(%d)", (u32)format->colorMatrixType);
-			return CELL_OK;
-		}
+			if (frame.format != AV_PIX_FMT_YUV420P)
+			{
+				cellVdec->Todo("cellVdecGetPicture: unsupported pixel format(%d)", frame.format);
+				break;
+			}
 
-		AVFrame& frame = *vf.data;
+			const VdecColorMatrix* m;
+
+			switch (format->colorMatrixType)
+			{
+			case CELL_VDEC_COLOR_MATRIX_TYPE_BT601: m = &g_vdec_bt601; break;
+			case CELL_VDEC_COLOR_MATRIX_TYPE_BT709: m = &g_vdec_bt709; break;
+
+			default:
+			{
+				cellVdec->Error("cellVdecGetPicture: unknown colorMatrixType(%d)", (u32)format->colorMatrixType);
+				return CELL_VDEC_ERROR_ARG;
+			}
+			}
 
-		// TODO: zero padding bytes
+			vdecConvertYUV420(outBuff.get_ptr(), frame, format->formatType == CELL_VDEC_PICFMT_ARGB32_ILV, *m, format->alpha);
+		}
+		break;
 
-		int err = av_image_copy_to_buffer(outBuff.get_ptr(), buf_size, frame.data, frame.linesize, vdec->ctx->pix_fmt, frame.width, frame.height, 1);
-		if (err < 0)
+		default:
 		{
-			cellVdec->Error("cellVdecGetPicture: av_image_copy_to_buffer failed(%d)", err);
-			Emu.Pause();
+			cellVdec->Todo("cellVdecGetPicture: unknown formatType(%d)", (u32)format->formatType);
+			return CELL_OK;
+		}
 		}
 	}
 
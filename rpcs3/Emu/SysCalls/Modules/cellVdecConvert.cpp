@@ -0,0 +1,103 @@
+#include "stdafx.h"
+#include "cellVdecConvert.h"
+
+const VdecColorMatrix g_vdec_bt601 = { 2384, 3269, 803, 1665, 4131 }; // 1.164, 1.596, 0.392, 0.813, 2.017
+const VdecColorMatrix g_vdec_bt709 = { 2384, 3670, 436, 1091, 4324 }; // 1.164, 1.792, 0.213, 0.533, 2.112
+
+template<bool argb> static __forceinline void vdecStorePixels(u8* dst, __m128i r, __m128i g, __m128i b, __m128i a)
+{
+	// r, g, b: 8 pixels (s16, 2 fractional bits)
+	const __m128i r8 = _mm_packus_epi16(_mm_srai_epi16(_mm_add_epi16(r, _mm_set1_epi16(2)), 2), _mm_setzero_si128());
+	const __m128i g8 = _mm_packus_epi16(_mm_srai_epi16(_mm_add_epi16(g, _mm_set1_epi16(2)), 2), _mm_setzero_si128());
+	const __m128i b8 = _mm_packus_epi16(_mm_srai_epi16(_mm_add_epi16(b, _mm_set1_epi16(2)), 2), _mm_setzero_si128());
+
+	const __m128i lo = argb ? _mm_unpacklo_epi8(a, r8) : _mm_unpacklo_epi8(r8, g8);
+	const __m128i hi = argb ? _mm_unpacklo_epi8(g8, b8) : _mm_unpacklo_epi8(b8, a);
+
+	_mm_storeu_si128((__m128i*)dst + 0, _mm_unpacklo_epi16(lo, hi));
+	_mm_storeu_si128((__m128i*)dst + 1, _mm_unpackhi_epi16(lo, hi));
+}
+
+template<bool argb> static void vdecConvertPixels(u8* dst, const u8* y, const u8* u, const u8* v, u32 x, u32 width, const VdecColorMatrix& m, u8 alpha)
+{
+	for (; x < width; x++)
+	{
+		const s32 yy = ((y[x] - 16) * 128 * m.y) >> 16;
+		const s32 uu = (u[x / 2] - 128) * 128;
+		const s32 vv = (v[x / 2] - 128) * 128;
+		const s32 c[3] =
+		{
+			(yy + ((vv * m.rv) >> 16) + 2) >> 2,
+			(yy - ((uu * m.gu) >> 16) - ((vv * m.gv) >> 16) + 2) >> 2,
+			(yy + ((uu * m.bu) >> 16) + 2) >> 2,
+		};
+
+		u8* px = dst + x * 4;
+		px[argb ? 0 : 3] = alpha;
+
+		for (u32 i = 0; i < 3; i++)
+		{
+			px[i + (argb ? 1 : 0)] = (u8)std::min<s32>(std::max<s32>(c[i], 0), 255);
+		}
+	}
+}
+
+template<bool argb> static void vdecConvertRowSSE2(u8* dst, const u8* y, const u8* u, const u8* v, u32 width, const VdecColorMatrix& m, u8 alpha)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i a = _mm_set1_epi8(alpha);
+	const __m128i c_y = _mm_set1_epi16(m.y);
+	const __m128i c_rv = _mm_set1_epi16(m.rv);
+	const __m128i c_gu = _mm_set1_epi16(m.gu);
+	const __m128i c_gv = _mm_set1_epi16(m.gv);
+	const __m128i c_bu = _mm_set1_epi16(m.bu);
+
+	u32 x = 0;
+
+	for (; x + 8 <= width; x += 8)
+	{
+		u32 u4, v4;
+		memcpy(&u4, u + x / 2, 4);
+		memcpy(&v4, v + x / 2, 4);
+
+		// (value - bias) << 7, multiplied by Q11 coefficients with mulhi gives 2 fractional bits
+		const __m128i y16 = _mm_slli_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(y + x)), zero), _mm_set1_epi16(16)), 7);
+		__m128i u16 = _mm_slli_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(u4), zero), _mm_set1_epi16(128)), 7);
+		__m128i v16 = _mm_slli_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(v4), zero), _mm_set1_epi16(128)), 7);
+		u16 = _mm_unpacklo_epi16(u16, u16);
+		v16 = _mm_unpacklo_epi16(v16, v16);
+
+		const __m128i yy = _mm_mulhi_epi16(y16, c_y);
+		const __m128i r = _mm_add_epi16(yy, _mm_mulhi_epi16(v16, c_rv));
+		const __m128i g = _mm_sub_epi16(_mm_sub_epi16(yy, _mm_mulhi_epi16(u16, c_gu)), _mm_mulhi_epi16(v16, c_gv));
+		const __m128i b = _mm_add_epi16(yy, _mm_mulhi_epi16(u16, c_bu));
+
+		vdecStorePixels<argb>(dst + x * 4, r, g, b, a);
+	}
+
+	vdecConvertPixels<argb>(dst, y, u, v, x, width, m, alpha);
+}
+
+void vdecConvertRow(u8* dst, const u8* y, const u8* u, const u8* v, u32 width, const VdecColorMatrix& m, u8 alpha, bool argb)
+{
+	if (argb)
+	{
+		vdecConvertRowSSE2<true>(dst, y, u, v, width, m, alpha);
+	}
+	else
+	{
+		vdecConvertRowSSE2<false>(dst, y, u, v, width, m, alpha);
+	}
+}
+
+void vdecConvertRowScalar(u8* dst, const u8* y, const u8* u, const u8* v, u32 begin, u32 width, const VdecColorMatrix& m, u8 alpha, bool argb)
+{
+	if (argb)
+	{
+		vdecConvertPixels<true>(dst, y, u, v, begin, width, m, alpha);
+	}
+	else
+	{
+		vdecConvertPixels<false>(dst, y, u, v, begin, width, m, alpha);
+	}
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+// YUV420 (limited range) to 32-bit RGB conversion used by cellVdecGetPicture.
+// The SSE2 kernel converts 8 pixels at a time, the rest of a row is converted by the scalar code,
+// which gives the same results.
+
+// conversion coefficients, Q11 fixed point
+struct VdecColorMatrix
+{
+	s16 y, rv, gu, gv, bu;
+};
+
+extern const VdecColorMatrix g_vdec_bt601;
+extern const VdecColorMatrix g_vdec_bt709;
+
+// Convert a row (u and v are subsampled horizontally by 2) to ARGB32 or RGBA32
+void vdecConvertRow(u8* dst, const u8* y, const u8* u, const u8* v, u32 width, const VdecColorMatrix& m, u8 alpha, bool argb);
+
+// Convert the pixels [begin, width) of a row with the scalar code
+void vdecConvertRowScalar(u8* dst, const u8* y, const u8* u, const u8* v, u32 begin, u32 width, const VdecColorMatrix& m, u8 alpha, bool argb);
+
+namespace vdec_convert
+{
+	// comparison with the scalar code and a float reference, and a benchmark (empty unless enabled in cellVdecConvertTests.cpp)
+	void RunAllTests();
+}
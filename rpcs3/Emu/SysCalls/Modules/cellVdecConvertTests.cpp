@@ -0,0 +1,215 @@
+#include "stdafx.h"
+#include "Utilities/Log.h"
+#include "cellVdecConvert.h"
+
+//#define VDEC_CONVERT_UNIT_TESTS 1
+
+#ifdef VDEC_CONVERT_UNIT_TESTS
+#include <random>
+
+// The SSE2 kernel is compared bit for bit with the scalar code (for all Y, U and V values, and for random rows of any
+// width at unaligned addresses, which must not be written past their end). Both are compared with a float conversion
+// with the nominal BT.601 and BT.709 coefficients. The benchmark reports converted frames per second (the CPU side of
+// cellVdecGetPicture for ARGB32 and RGBA32 output) of the kernel and the scalar code.
+
+namespace vdec_convert
+{
+	static const u32 s_random_rows = 10000;
+	static const u32 s_bench_frames = 50;
+	static const int s_max_error = 1; // the fixed point result may differ from the rounded float result by 1
+
+	struct test_matrix
+	{
+		const char* name;
+		const VdecColorMatrix& m;
+		float rv, gu, gv, bu;
+	};
+
+	static const test_matrix s_matrices[] =
+	{
+		{ "BT.601", g_vdec_bt601, 1.596f, 0.392f, 0.813f, 2.017f },
+		{ "BT.709", g_vdec_bt709, 1.792f, 0.213f, 0.533f, 2.112f },
+	};
+
+	static void ref_convert_pixel(u8* px, int y, int u, int v, const test_matrix& t, u8 alpha, bool argb)
+	{
+		const float yy = 1.164f * (y - 16);
+		const float c[3] =
+		{
+			yy + t.rv * (v - 128),
+			yy - t.gu * (u - 128) - t.gv * (v - 128),
+			yy + t.bu * (u - 128),
+		};
+
+		px[argb ? 0 : 3] = alpha;
+
+		for (u32 i = 0; i < 3; i++)
+		{
+			px[i + (argb ? 1 : 0)] = (u8)std::min(std::max(std::floor(c[i] + 0.5f), 0.0f), 255.0f);
+		}
+	}
+
+	// every Y value with every U and V pair (one row per pair)
+	static u32 test_all_values(const test_matrix& t, bool argb)
+	{
+		const char* format = argb ? "ARGB" : "RGBA";
+		std::vector<u8> y(256), u(128), v(128), sse(256 * 4), scalar(256 * 4);
+		int max_error = 0;
+
+		for (u32 i = 0; i < 256; i++)
+		{
+			y[i] = (u8)i;
+		}
+
+		for (u32 uv = 0; uv < 0x10000; uv++)
+		{
+			memset(u.data(), uv & 0xff, u.size());
+			memset(v.data(), uv >> 8, v.size());
+
+			vdecConvertRow(sse.data(), y.data(), u.data(), v.data(), 256, t.m, 0x80, argb);
+			vdecConvertRowScalar(scalar.data(), y.data(), u.data(), v.data(), 0, 256, t.m, 0x80, argb);
+
+			if (sse != scalar)
+			{
+				LOG_ERROR(GENERAL, "[UT vdec] %s %s: the kernel differs from the scalar code (U=%d, V=%d)", t.name, format, uv & 0xff, uv >> 8);
+				return 1;
+			}
+
+			for (u32 x = 0; x < 256; x++)
+			{
+				u8 ref[4];
+				ref_convert_pixel(ref, x, uv & 0xff, uv >> 8, t, 0x80, argb);
+
+				for (u32 i = 0; i < 4; i++)
+				{
+					max_error = std::max(max_error, std::abs(ref[i] - sse[x * 4 + i]));
+				}
+			}
+		}
+
+		LOG_NOTICE(GENERAL, "%s %s: max difference from the float conversion: %d", t.name, format, max_error);
+
+		if (max_error > s_max_error)
+		{
+			LOG_ERROR(GENERAL, "[UT vdec] %s %s: the difference from the float conversion is %d", t.name, format, max_error);
+			return 1;
+		}
+
+		return 0;
+	}
+
+	// random rows of any width (the kernel converts 8 pixels at a time) at unaligned addresses
+	static u32 test_random_rows(const test_matrix& t, bool argb)
+	{
+		const char* format = argb ? "ARGB" : "RGBA";
+		std::mt19937 rng(0x1dec);
+		std::vector<u8> y(128 + 16), u(64 + 16), v(64 + 16), sse(128 * 4 + 32), scalar(128 * 4 + 32);
+
+		for (u32 n = 0; n < s_random_rows; n++)
+		{
+			const u32 width = rng() % 128 + 1;
+			const u32 offset = rng() % 16;
+			const u8 alpha = (u8)rng();
+
+			for (auto& b : y) b = (u8)rng();
+			for (auto& b : u) b = (u8)rng();
+			for (auto& b : v) b = (u8)rng();
+
+			// the bytes after the row must stay unchanged
+			std::fill(sse.begin(), sse.end(), 0xcd);
+			std::fill(scalar.begin(), scalar.end(), 0xcd);
+
+			vdecConvertRow(sse.data() + offset, y.data() + offset, u.data() + offset, v.data() + offset, width, t.m, alpha, argb);
+			vdecConvertRowScalar(scalar.data() + offset, y.data() + offset, u.data() + offset, v.data() + offset, 0, width, t.m, alpha, argb);
+
+			if (sse != scalar)
+			{
+				LOG_ERROR(GENERAL, "[UT vdec] %s %s: the kernel differs from the scalar code (width %d, offset %d)", t.name, format, width, offset);
+				return 1;
+			}
+		}
+
+		return 0;
+	}
+
+	template<typename F> static double frames_per_second(F func)
+	{
+		const auto start = std::chrono::high_resolution_clock::now();
+
+		for (u32 i = 0; i < s_bench_frames; i++)
+		{
+			func();
+		}
+
+		return s_bench_frames / std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	static void benchmark()
+	{
+		static const struct { u32 width, height; } sizes[] = { { 1280, 720 }, { 1920, 1080 } };
+
+		std::mt19937 rng(0xbe4c);
+
+		for (auto& s : sizes)
+		{
+			std::vector<u8> y(s.width * s.height), u(s.width * s.height / 4), v(s.width * s.height / 4), out(s.width * s.height * 4);
+
+			for (auto& b : y) b = (u8)rng();
+			for (auto& b : u) b = (u8)rng();
+			for (auto& b : v) b = (u8)rng();
+
+			for (bool argb : { true, false })
+			{
+				// like vdecConvertYUV420(), one chroma row for two rows
+				const double sse = frames_per_second([&]()
+				{
+					for (u32 i = 0; i < s.height; i++)
+					{
+						vdecConvertRow(&out[i * s.width * 4], &y[i * s.width], &u[i / 2 * s.width / 2], &v[i / 2 * s.width / 2], s.width, g_vdec_bt709, 0xff, argb);
+					}
+				});
+
+				const double scalar = frames_per_second([&]()
+				{
+					for (u32 i = 0; i < s.height; i++)
+					{
+						vdecConvertRowScalar(&out[i * s.width * 4], &y[i * s.width], &u[i / 2 * s.width / 2], &v[i / 2 * s.width / 2], 0, s.width, g_vdec_bt709, 0xff, argb);
+					}
+				});
+
+				LOG_NOTICE(GENERAL, "vdecConvertRow(%dx%d %s): %.0f frames/s (scalar: %.0f frames/s)", s.width, s.height, argb ? "ARGB" : "RGBA", sse, scalar);
+			}
+		}
+	}
+
+	void RunAllTests()
+	{
+		LOG_NOTICE(GENERAL, "Running vdec conversion tests");
+
+		u32 num_failed = 0;
+
+		for (auto& t : s_matrices)
+		{
+			for (bool argb : { true, false })
+			{
+				num_failed += test_all_values(t, argb);
+				num_failed += test_random_rows(t, argb);
+			}
+		}
+
+		benchmark();
+
+		LOG_NOTICE(GENERAL, "Unit Tests done (%d failed)", num_failed);
+	}
+}
+
+#else
+
+namespace vdec_convert
+{
+	void RunAllTests()
+	{
+	}
+}
+
+#endif // VDEC_CONVERT_UNIT_TESTS
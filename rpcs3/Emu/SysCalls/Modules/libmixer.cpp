@@ -6,6 +6,8 @@
 
 #include "Emu/CPU/CPUThreadManager.h"
 #include "Emu/Audio/cellAudio.h"
+#include "Emu/Audio/AudioClock.h"
+#include "Emu/Audio/AudioMixer.h"
 #include "libmixer.h"
 
 Module *libmixer = nullptr;
@@ -52,53 +54,12 @@ int cellAANAddData(u32 aan_handle, u32 aan_port, u32 offset, vm::ptr<float> addr
 
 	std::lock_guard<std::mutex> lock(mixer_mutex);
 
-	if (type == CELL_SURMIXER_CHSTRIP_TYPE1A)
-	{
-		// mono upmixing
-		for (u32 i = 0; i < samples; i++)
-		{
-			const float center = addr[i];
-			mixdata[i * 8 + 0] += center;
-			mixdata[i * 8 + 1] += center;
-		}		
-	}
-	else if (type == CELL_SURMIXER_CHSTRIP_TYPE2A)
-	{
-		// stereo upmixing
-		for (u32 i = 0; i < samples; i++)
-		{
-			const float left = addr[i * 2 + 0];
-			const float right = addr[i * 2 + 1];
-			mixdata[i * 8 + 0] += left;
-			mixdata[i * 8 + 1] += right;
-		}
-	}
-	else if (type == CELL_SURMIXER_CHSTRIP_TYPE6A)
+	switch (type)
 	{
-		// 5.1 upmixing
-		for (u32 i = 0; i < samples; i++)
-		{
-			const float left = addr[i * 6 + 0];
-			const float right = addr[i * 6 + 1];
-			const float center = addr[i * 6 + 2];
-			const float low_freq = addr[i * 6 + 3];
-			const float rear_left = addr[i * 6 + 4];
-			const float rear_right = addr[i * 6 + 5];
-			mixdata[i * 8 + 0] += left;
-			mixdata[i * 8 + 1] += right;
-			mixdata[i * 8 + 2] += center;
-			mixdata[i * 8 + 3] += low_freq;
-			mixdata[i * 8 + 4] += rear_left;
-			mixdata[i * 8 + 5] += rear_right;
-		}
-	}
-	else if (type == CELL_SURMIXER_CHSTRIP_TYPE8A)
-	{
-		// 7.1
-		for (u32 i = 0; i < samples * 8; i++)
-		{
-			mixdata[i] += addr[i];
-		}
+	case CELL_SURMIXER_CHSTRIP_TYPE1A: audio_upmix_be(mixdata, vm::get_ptr<const be_t<float>>(addr.addr()), 1, samples); break; // mono upmixing
+	case CELL_SURMIXER_CHSTRIP_TYPE2A: audio_upmix_be(mixdata, vm::get_ptr<const be_t<float>>(addr.addr()), 2, samples); break; // stereo upmixing
+	case CELL_SURMIXER_CHSTRIP_TYPE6A: audio_upmix_be(mixdata, vm::get_ptr<const be_t<float>>(addr.addr()), 6, samples); break; // 5.1 upmixing
+	case CELL_SURMIXER_CHSTRIP_TYPE8A: audio_upmix_be(mixdata, vm::get_ptr<const be_t<float>>(addr.addr()), 8, samples); break; // 7.1
 	}
 
 	return CELL_OK; 
@@ -345,9 +306,13 @@ int cellSurMixerCreate(vm::ptr<const CellSurMixerConfig> config)
 				break;
 			}
 
-			if (mixcount > (port.tag + 0)) // adding positive value (1-15): preemptive buffer filling (hack)
+			// wait until the audio thread has taken the block before the one to be filled
+			if (mixcount > port.tag)
 			{
-				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				g_audio_clock.WaitTick([&]()
+				{
+					return mixcount <= port.tag || !port.m_is_audio_port_opened || Emu.IsStopped();
+				});
 				continue;
 			}
 
@@ -373,6 +338,19 @@ int cellSurMixerCreate(vm::ptr<const CellSurMixerConfig> config)
 						float right = 0.0f;
 						float speed = fabs(p.m_speed);
 						float fpos = 0.0f;
+
+						if (p.m_speed == 1.0f && (p.m_channels == 1 || p.m_channels == 2) && (u64)p.m_position + 256 < p.m_samples)
+						{
+							// fast path: normal speed, no loop point or end of data within this block
+							if (p.m_connected)
+							{
+								audio_mix_s16_voice(mixdata, vm::get_ptr<const s16>(p.m_addr + p.m_position * p.m_channels * sizeof(s16)), p.m_channels, p.m_level, 256);
+							}
+
+							p.m_position += 256;
+							continue;
+						}
+
 						for (int i = 0; i < 256; i++) if (p.m_active)
 						{
 							u32 pos = p.m_position;
@@ -444,10 +422,12 @@ int cellSurMixerCreate(vm::ptr<const CellSurMixerConfig> config)
 
 				auto buf = vm::get_ptr<be_t<float>>(m_config.m_buffer + (128 * 1024 * SUR_PORT) + (mixcount % port.block) * port.channel * 256 * sizeof(float));
 
-				for (u32 i = 0; i < (sizeof(mixdata) / sizeof(float)); i++)
+				audio_store_be(buf, mixdata, sizeof(mixdata) / sizeof(float));
+
+				if (port.tag > mixcount)
 				{
-					// reverse byte order
-					buf[i] = mixdata[i];
+					// the audio thread has already taken this block
+					g_audio_clock.ReportUnderrun();
 				}
 
 				//u64 stamp3 = get_system_time();
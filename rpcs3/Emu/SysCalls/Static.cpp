@@ -2,6 +2,7 @@
 #include "rpcs3/Ini.h"
 #include "Utilities/Log.h"
 #include "Emu/SysCalls/Modules.h"
+#include "Emu/Profiler.h"
 #include "Static.h"
 
 void StaticFuncManager::StaticAnalyse(void* ptr, u32 size, u32 base)
@@ -11,9 +12,51 @@ void StaticFuncManager::StaticAnalyse(void* ptr, u32 size, u32 base)
 	if(!Ini.HLEHookStFunc.GetValue())
 		return;
 
-	// TODO: optimize search
+	std::lock_guard<std::mutex> lock(m_analyse_lock);
+
+	// Sorted first opcodes of all patterns, grouped by their mask.
+	// Most of the words can't start any pattern, they are rejected with a binary search per mask
+	// instead of comparing them with every pattern.
+	std::vector<std::pair<u32, std::vector<u32>>> first_ops;
+
+	for (u32 j = 0; j < m_static_funcs_list.size(); j++)
+	{
+		const SFuncOp& op = m_static_funcs_list[j]->ops[0];
+
+		auto group = std::find_if(first_ops.begin(), first_ops.end(), [&](const std::pair<u32, std::vector<u32>>& g) { return g.first == op.mask; });
+
+		if (group == first_ops.end())
+		{
+			first_ops.emplace_back(op.mask, std::vector<u32>());
+			group = first_ops.end() - 1;
+		}
+
+		group->second.push_back(op.crc);
+	}
+
+	for (auto& group : first_ops)
+	{
+		std::sort(group.second.begin(), group.second.end());
+	}
+
 	for (u32 i = 0; i < size; i++)
 	{
+		bool candidate = false;
+
+		for (auto& group : first_ops)
+		{
+			if (std::binary_search(group.second.begin(), group.second.end(), data[i] & group.first))
+			{
+				candidate = true;
+				break;
+			}
+		}
+
+		if (!candidate)
+		{
+			continue;
+		}
+
 		for (u32 j = 0; j < m_static_funcs_list.size(); j++)
 		{
 			if ((data[i] & m_static_funcs_list[j]->ops[0].mask) == m_static_funcs_list[j]->ops[0].crc)
@@ -84,6 +127,7 @@ void StaticFuncManager::StaticAnalyse(void* ptr, u32 size, u32 base)
 				{
 					LOG_NOTICE(LOADER, "Function '%s' hooked (addr=0x%x)", m_static_funcs_list[j]->name, i * 4 + base);
 					m_static_funcs_list[j]->found++;
+					prof::add_symbol(i * 4 + base, 12, m_static_funcs_list[j]->name);
 					data[i+0] = re32(0x39600000 | j); // li r11, j
 					data[i+1] = se32(0x44000003); // sc 3
 					data[i+2] = se32(0x4e800020); // blr
@@ -7,6 +7,7 @@ class PPUThread;
 class StaticFuncManager
 {
 	std::vector<SFunc *> m_static_funcs_list; 
+	std::mutex m_analyse_lock; // segments are analysed by the loader and by the segment prefetch thread
 public:
 	void StaticAnalyse(void* ptr, u32 size, u32 base);
 	void StaticExecute(PPUThread& CPU, u32 code);
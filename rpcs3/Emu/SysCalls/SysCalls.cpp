@@ -5,6 +5,7 @@
 #include "Emu/Memory/Memory.h"
 #include "Emu/System.h"
 #include "ModuleManager.h"
+#include "Emu/PerfCounters.h"
 
 #include "lv2/lv2Fs.h"
 #include "lv2/sys_cond.h"
@@ -31,7 +32,13 @@
 namespace detail{
 	template<> bool CheckId(u32 id, ID*& _id,const std::string &name)
 	{
-		return Emu.GetIdManager().CheckID(id) && (_id = &Emu.GetIdManager().GetID(id))->GetName() == name;
+		ID* found = Emu.GetIdManager().FindID(id);
+		return found && (_id = found)->GetName() == name;
+	}
+
+	bool CheckId(u32 id, void*& data, const std::string& name)
+	{
+		return Emu.GetIdManager().FindIDData(id, name, data);
 	}
 }
 
@@ -945,20 +952,28 @@ void SysCalls::DoSyscall(PPUThread& CPU, u32 code)
 	//Auto Pause using simple singleton.
 	Debug::AutoPause::getInstance().TryPause(code);
 
+	// the profiler attributes the time to the function, the state of the caller is restored after it
+	const u64 prof_state = CPU.m_prof_state.load(std::memory_order_relaxed);
+
 	if(code < 1024)
 	{
+		perf::add_syscall(code);
+		CPU.SetProfState(CPU_EXEC_SYSCALL, code);
 		(*sc_table[code])(CPU);
-		return;
 	}
-	
-	if(Emu.GetModuleManager().CallFunc(CPU, code))
+	else
 	{
-		return;
-	}
+		perf::add_hle_call(code);
+		CPU.SetProfState(CPU_EXEC_HLE, code);
 
+		if(!Emu.GetModuleManager().CallFunc(CPU, code))
+		{
+			LOG_ERROR(HLE, "TODO: %s", GetHLEFuncName(code).c_str());
+			CPU.GPR[3] = 0;
+		}
+	}
 
-	LOG_ERROR(HLE, "TODO: %s", GetHLEFuncName(code).c_str());
-	CPU.GPR[3] = 0;
+	CPU.m_prof_state.store(prof_state, std::memory_order_relaxed);
 }
 
 IdManager& SysCallBase::GetIdManager() const
@@ -8,11 +8,13 @@
 class SysCallBase;
 
 namespace detail{
+	bool CheckId(u32 id, void*& data, const std::string& name);
+
 	template<typename T> bool CheckId(u32 id, T*& data,const std::string &name)
 	{
-		ID* id_data;
-		if(!CheckId(id, id_data,name)) return false;
-		data = id_data->GetData()->get<T>();
+		void* ptr;
+		if(!CheckId(id, ptr, name)) return false;
+		data = (T*)ptr;
 		return true;
 	}
 
@@ -40,7 +42,8 @@ public:
 
 	bool CheckId(u32 id) const
 	{
-		return GetIdManager().CheckID(id) && GetIdManager().GetID(id).GetName() == GetName();
+		void* ptr;
+		return GetIdManager().FindIDData(id, GetName(), ptr);
 	}
 
 	template<typename T>
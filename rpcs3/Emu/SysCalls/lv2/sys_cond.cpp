@@ -5,6 +5,7 @@
 
 #include "Emu/CPU/CPUThreadManager.h"
 #include "Emu/Cell/PPUThread.h"
+#include "sys_time.h"
 #include "sys_cond.h"
 
 SysCallBase sys_cond("sys_cond");
@@ -182,8 +183,7 @@ s32 sys_cond_wait(u32 cond_id, u64 timeout)
 	mutex->recursive = 0;
 	mutex->m_mutex.unlock(tid, mutex->protocol == SYS_SYNC_PRIORITY ? mutex->m_queue.pop_prio() : mutex->m_queue.pop());
 
-	u64 counter = 0;
-	const u64 max_counter = timeout ? (timeout / 1000) : ~0ull;
+	const u64 start_time = get_system_time();
 
 	while (true)
 	{
@@ -212,9 +212,9 @@ s32 sys_cond_wait(u32 cond_id, u64 timeout)
 			return CELL_OK;
 		}
 
-		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		const u64 passed = get_system_time() - start_time;
 
-		if (counter++ > max_counter)
+		if (timeout && passed >= timeout)
 		{
 			cond->m_queue.invalidate(tid);
 			GetCurrentPPUThread().owned_mutexes--; // ???
@@ -224,6 +224,8 @@ s32 sys_cond_wait(u32 cond_id, u64 timeout)
 		{
 			goto abort;
 		}
+
+		cond->signal.wait_owner(tid, timeout ? timeout - passed : 0);
 	}
 
 abort:
@@ -6,6 +6,7 @@
 #include "Emu/Cell/PPUThread.h"
 #include "Emu/Event.h"
 #include "sys_process.h"
+#include "sys_time.h"
 #include "sys_event.h"
 
 SysCallBase sys_event("sys_event");
@@ -95,14 +96,9 @@ s32 sys_event_queue_destroy(u32 equeue_id, int mode)
 	}
 	eq->owner.unlock(tid, ~0);
 	eq->sq.m_mutex.unlock();
-	while (eq->sq.list.size())
+	if (!g_sm_wm.wait_op((u64)&eq->owner, [eq]() { return !eq->sq.count(); }))
 	{
-		std::this_thread::sleep_for(std::chrono::milliseconds(1));
-		if (Emu.IsStopped())
-		{
-			sys_event.Warning("sys_event_queue_destroy(equeue=%d) aborted", equeue_id);
-			break;
-		}
+		sys_event.Warning("sys_event_queue_destroy(equeue=%d) aborted", equeue_id);
 	}
 
 	Emu.GetEventManager().UnregisterKey(eq->key);
@@ -172,8 +168,8 @@ s32 sys_event_queue_receive(u32 equeue_id, vm::ptr<sys_event_data> dummy_event,
 
 	eq->sq.push(tid); // add thread to sleep queue
 
-	timeout = timeout ? (timeout / 1000) : ~0;
-	u64 counter = 0;
+	const u64 start_time = get_system_time();
+
 	while (true)
 	{
 		switch (eq->owner.trylock(tid))
@@ -209,16 +205,23 @@ s32 sys_event_queue_receive(u32 equeue_id, vm::ptr<sys_event_data> dummy_event,
 			return CELL_OK;
 		}
 		case SMR_FAILED: break;
-		default: eq->sq.invalidate(tid); return CELL_ECANCELED;
+		default: eq->sq.invalidate(tid); eq->owner.notify(); return CELL_ECANCELED;
 		}
 
-		std::this_thread::sleep_for(std::chrono::milliseconds(1));
-		if (counter++ > timeout || Emu.IsStopped())
+		const u64 passed = get_system_time() - start_time;
+
+		if ((timeout && passed >= timeout) || Emu.IsStopped())
 		{
 			if (Emu.IsStopped()) sys_event.Warning("sys_event_queue_receive(equeue=%d) aborted", equeue_id);
 			eq->sq.invalidate(tid);
 			return CELL_ETIMEDOUT;
 		}
+
+		// woken up by EventQueue::push() or by the ownership transfer
+		g_sm_wm.wait_op((u64)&eq->owner, [eq, tid]()
+		{
+			return (eq->events.count() && eq->owner.GetOwner() == eq->owner.GetFreeValue()) || eq->owner.GetOwner() == tid || eq->owner.GetOwner() == eq->owner.GetDeadValue();
+		}, timeout ? timeout - passed : 0);
 	}
 }
 
@@ -370,7 +373,7 @@ s32 sys_event_port_send(u32 eport_id, u64 data1, u64 data2, u64 data3)
 		return CELL_ENOTCONN;
 	}
 
-	if (!eq->events.push(eport->name, data1, data2, data3))
+	if (!eq->push(eport->name, data1, data2, data3))
 	{
 		return CELL_EBUSY;
 	}
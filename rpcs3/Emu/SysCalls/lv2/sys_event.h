@@ -214,6 +214,18 @@ struct EventQueue
 	{
 		owner.initialize();
 	}
+
+	bool push(u64 name, u64 d1, u64 d2, u64 d3)
+	{
+		if (!events.push(name, d1, d2, d3))
+		{
+			return false;
+		}
+
+		// wake up receivers
+		owner.notify();
+		return true;
+	}
 };
 
 // Aux
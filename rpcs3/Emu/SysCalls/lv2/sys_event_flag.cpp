@@ -4,6 +4,7 @@
 #include "Emu/SysCalls/SysCalls.h"
 
 #include "Emu/Cell/PPUThread.h"
+#include "sys_time.h"
 #include "sys_lwmutex.h"
 #include "sys_event_flag.h"
 
@@ -151,8 +152,7 @@ s32 sys_event_flag_wait(u32 eflag_id, u64 bitptn, u32 mode, vm::ptr<u64> result,
 		ef->m_mutex.unlock(tid);
 	}
 
-	u64 counter = 0;
-	const u64 max_counter = timeout ? (timeout / 1000) : ~0;
+	const u64 start_time = get_system_time();
 
 	while (true)
 	{
@@ -199,9 +199,9 @@ s32 sys_event_flag_wait(u32 eflag_id, u64 bitptn, u32 mode, vm::ptr<u64> result,
 			return CELL_ECANCELED;
 		}
 
-		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		const u64 passed = get_system_time() - start_time;
 
-		if (counter++ > max_counter)
+		if (timeout && passed >= timeout)
 		{
 			ef->m_mutex.lock(tid);
 
@@ -222,6 +222,8 @@ s32 sys_event_flag_wait(u32 eflag_id, u64 bitptn, u32 mode, vm::ptr<u64> result,
 			sys_event_flag.Warning("sys_event_flag_wait(id=%d) aborted", eflag_id);
 			return CELL_OK;
 		}
+
+		ef->signal.wait_owner(tid, timeout ? timeout - passed : 0);
 	}
 }
 
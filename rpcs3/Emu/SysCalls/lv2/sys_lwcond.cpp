@@ -4,6 +4,7 @@
 #include "Emu/SysCalls/SysCalls.h"
 
 #include "Emu/Cell/PPUThread.h"
+#include "sys_time.h"
 #include "sys_lwmutex.h"
 #include "sys_lwcond.h"
 
@@ -192,8 +193,7 @@ s32 sys_lwcond_wait(vm::ptr<sys_lwcond_t> lwcond, u64 timeout)
 			(u32)lwcond->lwcond_queue, (u32)mutex->sleep_queue);
 	}
 
-	u64 counter = 0;
-	const u64 max_counter = timeout ? (timeout / 1000) : ~0;
+	const u64 start_time = get_system_time();
 
 	while (true)
 	{
@@ -214,9 +214,9 @@ s32 sys_lwcond_wait(vm::ptr<sys_lwcond_t> lwcond, u64 timeout)
 			return CELL_OK;
 		}
 
-		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		const u64 passed = get_system_time() - start_time;
 
-		if (counter++ > max_counter)
+		if (timeout && passed >= timeout)
 		{
 			lw->m_queue.invalidate(tid_le);
 			return CELL_ETIMEDOUT;
@@ -225,6 +225,8 @@ s32 sys_lwcond_wait(vm::ptr<sys_lwcond_t> lwcond, u64 timeout)
 		{
 			goto abort;
 		}
+
+		lw->signal.wait_owner(tid_le, timeout ? timeout - passed : 0);
 	}
 
 abort:
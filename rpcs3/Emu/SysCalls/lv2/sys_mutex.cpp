@@ -155,7 +155,7 @@ s32 sys_mutex_lock(u32 mutex_id, u64 timeout)
 
 	mutex->m_queue.push(tid);
 
-	switch (mutex->m_mutex.lock(tid, timeout ? ((timeout < 1000) ? 1 : (timeout / 1000)) : 0))
+	switch (mutex->m_mutex.lock(tid, timeout))
 	{
 	case SMR_OK:
 		mutex->m_queue.invalidate(tid);
@@ -5,6 +5,7 @@
 
 #include "Emu/FS/VFS.h"
 #include "Emu/FS/vfsFile.h"
+#include "Emu/FS/vfsMemoryFile.h"
 #include "Crypto/unself.h"
 #include "sys_prx.h"
 
@@ -15,21 +16,25 @@ s32 sys_prx_load_module(vm::ptr<const char> path, u64 flags, vm::ptr<sys_prx_loa
 	sys_prx.Todo("sys_prx_load_module(path=\"%s\", flags=0x%llx, pOpt=0x%x)", path.get_ptr(), flags, pOpt.addr());
 
 	std::string _path = path.get_ptr();
-	// Check if the file is SPRX
+	// Check if the file is SPRX (decrypted in memory)
 	std::string local_path;
 	Emu.GetVFS().GetDevice(_path, local_path);
+	vfsMemoryFile prx_f;
+	vfsFile file_f;
+	vfsStream* stream = &file_f;
 	if (IsSelf(local_path)) {
-		if (!DecryptSelf(local_path+".prx", local_path)) {
+		prx_f.Open(_path);
+		if (!DecryptSelf(prx_f, local_path)) {
 			return CELL_PRX_ERROR_ILLEGAL_LIBRARY;
 		}
-		_path += ".prx";
+		stream = &prx_f;
 	}
-
-	vfsFile f(_path);
-	if (!f.IsOpened()) {
+	else if (!file_f.Open(_path)) {
 		return CELL_PRX_ERROR_UNKNOWN_MODULE;
 	}
 
+	vfsStream& f = *stream;
+
 	// Create the PRX object and return its id
 	sys_prx_t* prx = new sys_prx_t();
 	prx->size = (u32)f.GetSize();
@@ -9,6 +9,8 @@
 
 SysCallBase sys_rwlock("sys_rwlock");
 
+waiter_map_t g_rwlock_wm("rwlock_wm");
+
 s32 sys_rwlock_create(vm::ptr<u32> rw_lock_id, vm::ptr<sys_rwlock_attribute_t> attr)
 {
 	sys_rwlock.Warning("sys_rwlock_create(rw_lock_id_addr=0x%x, attr_addr=0x%x)", rw_lock_id.addr(), attr.addr());
@@ -66,31 +68,16 @@ s32 sys_rwlock_rlock(u32 rw_lock_id, u64 timeout)
 
 	if (rw->rlock_trylock(tid)) return CELL_OK;
 
-	u64 counter = 0;
-	const u64 max_counter = timeout ? (timeout / 1000) : 20000;
-	do
+	if (!g_rwlock_wm.wait_op(rw_lock_id, [rw, tid]() { return rw->rlock_trylock(tid); }, timeout))
 	{
 		if (Emu.IsStopped())
 		{
 			sys_rwlock.Warning("sys_rwlock_rlock(rw_lock_id=%d, ...) aborted", rw_lock_id);
-			return CELL_ETIMEDOUT;
 		}
-		std::this_thread::sleep_for(std::chrono::milliseconds(1));
-
-		if (rw->rlock_trylock(tid)) return CELL_OK;
+		return CELL_ETIMEDOUT;
+	}
 
-		if (counter++ > max_counter)
-		{
-			if (!timeout) 
-			{
-				counter = 0;
-			}
-			else
-			{
-				return CELL_ETIMEDOUT;
-			}
-		}		
-	} while (true);
+	return CELL_OK;
 }
 
 s32 sys_rwlock_tryrlock(u32 rw_lock_id)
@@ -114,6 +101,7 @@ s32 sys_rwlock_runlock(u32 rw_lock_id)
 
 	if (!rw->rlock_unlock(GetCurrentPPUThread().GetId())) return CELL_EPERM;
 
+	g_rwlock_wm.notify(rw_lock_id);
 	return CELL_OK;
 }
 
@@ -129,31 +117,16 @@ s32 sys_rwlock_wlock(u32 rw_lock_id, u64 timeout)
 
 	if (rw->wlock_trylock(tid, true)) return CELL_OK;
 
-	u64 counter = 0;
-	const u64 max_counter = timeout ? (timeout / 1000) : 20000;
-	do
+	if (!g_rwlock_wm.wait_op(rw_lock_id, [rw, tid]() { return rw->wlock_trylock(tid, true); }, timeout))
 	{
 		if (Emu.IsStopped())
 		{
 			sys_rwlock.Warning("sys_rwlock_wlock(rw_lock_id=%d, ...) aborted", rw_lock_id);
-			return CELL_ETIMEDOUT;
 		}
-		std::this_thread::sleep_for(std::chrono::milliseconds(1));
-
-		if (rw->wlock_trylock(tid, true)) return CELL_OK;
+		return CELL_ETIMEDOUT;
+	}
 
-		if (counter++ > max_counter)
-		{
-			if (!timeout) 
-			{
-				counter = 0;
-			}
-			else
-			{
-				return CELL_ETIMEDOUT;
-			}
-		}		
-	} while (true);
+	return CELL_OK;
 }
 
 s32 sys_rwlock_trywlock(u32 rw_lock_id)
@@ -180,5 +153,6 @@ s32 sys_rwlock_wunlock(u32 rw_lock_id)
 
 	if (!rw->wlock_unlock(GetCurrentPPUThread().GetId())) return CELL_EPERM;
 
+	g_rwlock_wm.notify(rw_lock_id);
 	return CELL_OK;
 }
@@ -10,6 +10,9 @@
 
 SysCallBase sys_semaphore("sys_semaphore");
 
+// waiters are registered with their thread id, posters waiting for the signal to be consumed with the semaphore id
+waiter_map_t g_sem_wm("sem_wm");
+
 u32 semaphore_create(s32 initial_count, s32 max_count, u32 protocol, u64 name_u64)
 {
 	LV2_LOCK(0);
@@ -104,8 +107,20 @@ s32 sys_semaphore_wait(u32 sem_id, u64 timeout)
 			return CELL_OK;
 		}
 
-		if (timeout && get_system_time() - start_time > timeout)
+		const u64 passed = get_system_time() - start_time;
+
+		if (timeout && passed > timeout)
 		{
+			std::lock_guard<std::mutex> lock(sem->m_mutex);
+
+			// the signal may have been handed to this thread after the last check, it would be lost
+			if (tid == sem->signal)
+			{
+				sem->signal = 0;
+				g_sem_wm.notify(sem_id);
+				return CELL_OK;
+			}
+
 			sem->m_queue.invalidate(tid);
 			return CELL_ETIMEDOUT;
 		}
@@ -119,10 +134,11 @@ s32 sys_semaphore_wait(u32 sem_id, u64 timeout)
 				continue;
 			}
 			sem->signal = 0;
+			g_sem_wm.notify(sem_id);
 			return CELL_OK;
 		}
 
-		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		g_sem_wm.wait_op(tid, [sem, tid]() { return tid == sem->signal; }, timeout ? timeout - passed + 1 : 0);
 	}
 }
 
@@ -177,11 +193,17 @@ s32 sys_semaphore_post(u32 sem_id, s32 count)
 			return CELL_OK;
 		}
 
+		if (sem->signal && sem->m_queue.count())
+		{
+			// wait until the previously signaled thread wakes up (same condition as above, the queue may become empty)
+			g_sem_wm.wait_op(sem_id, [sem]() { return !sem->signal || !sem->m_queue.count(); });
+			continue;
+		}
+
 		std::lock_guard<std::mutex> lock(sem->m_mutex);
 
 		if (sem->signal && sem->m_queue.count())
 		{
-			std::this_thread::sleep_for(std::chrono::milliseconds(1));
 			continue;
 		}
 
@@ -189,6 +211,7 @@ s32 sys_semaphore_post(u32 sem_id, s32 count)
 		{
 			count--;
 			sem->signal = target;
+			g_sem_wm.notify(target);
 		}
 		else
 		{
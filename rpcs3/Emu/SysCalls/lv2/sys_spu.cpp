@@ -613,6 +613,7 @@ s32 sys_spu_thread_write_spu_mb(u32 id, u32 value)
 	}
 
 	(*(SPUThread*)thr).SPU.In_MBox.PushUncond(value);
+	(*(SPUThread*)thr).NotifyChannel();
 
 	return CELL_OK;
 }
@@ -1062,6 +1063,7 @@ s32 sys_raw_spu_read_puint_mb(u32 id, vm::ptr<u32> value)
 
 	u32 v;
 	t->SPU.Out_IntrMBox.PopUncond(v);
+	t->NotifyChannel();
 	*value = v;
 	return CELL_OK;
 }
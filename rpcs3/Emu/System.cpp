@@ -1,18 +1,26 @@
 #include "stdafx.h"
 #include "Utilities/Log.h"
+#include "rpcs3/Ini.h"
 #include "Utilities/rFile.h"
+#include "Utilities/rPlatform.h"
 #include "Emu/Memory/Memory.h"
 #include "Emu/System.h"
+#include "Utilities/SQueue.h"
 
 #include "Emu/GameInfo.h"
 #include "Emu/SysCalls/Static.h"
 #include "Emu/SysCalls/ModuleManager.h"
+#include "Emu/SysCalls/lv2/sys_time.h"
 #include "Emu/Cell/PPUThread.h"
 #include "Emu/Cell/SPUThread.h"
 #include "Emu/Cell/PPUInstrTable.h"
+#include "Emu/Cell/VectorOps.h"
 #include "Emu/FS/vfsFile.h"
+#include "Emu/FS/vfsMemoryFile.h"
 #include "Emu/FS/vfsDeviceLocalFile.h"
 #include "Emu/DbgCommand.h"
+#include "Emu/PerfCounters.h"
+#include "Emu/Profiler.h"
 
 #include "Emu/CPU/CPUThreadManager.h"
 #include "Emu/IdManager.h"
@@ -21,11 +29,18 @@
 #include "Emu/Io/Mouse.h"
 #include "Emu/RSX/GSManager.h"
 #include "Emu/Audio/AudioManager.h"
+#include "Emu/Audio/AudioMixer.h"
+#include "Emu/SysCalls/Modules/cellVdecConvert.h"
+#include "Emu/SysCalls/Modules/cellPamf.h"
+#include "Emu/SysCalls/Modules/cellDmux.h"
 #include "Emu/FS/VFS.h"
 
 #include "Loader/PSF.h"
+#include "Loader/LazySegments.h"
 
 #include "../Crypto/unself.h"
+#include "../Crypto/aesni.h"
+#include "../Crypto/unpkg.h"
 #include <cstdlib>
 #include <fstream>
 using namespace PPU_instr;
@@ -83,6 +98,16 @@ void Emulator::Init()
 		m_modules_init[0]->Init();
 		m_modules_init.erase(m_modules_init.begin());
 	}
+
+	// unit tests of the core (empty unless enabled in their files), called once at startup
+	simd::RunAllTests();
+	IdManager::RunAllTests();
+	audio_mixer::RunAllTests();
+	vdec_convert::RunAllTests();
+	dmux_start_code::RunAllTests();
+	crypto::RunAllTests();
+	unpkg::RunAllTests();
+	Log::RunAllTests();
 	//if(m_memory_viewer) m_memory_viewer->Close();
 	//m_memory_viewer = new MemoryViewerPanel(wxGetApp().m_MainFrame);
 }
@@ -167,25 +192,40 @@ void Emulator::Load()
 {
 	GetModuleManager().init();
 
+	Log::LogManager::setSeverityMasks(Ini.HLELogMasks.GetValue());
+	Log::LogManager::getInstance().setBinaryLog(Ini.HLEBinaryLog.GetValue() ? rPlatform::getConfigDir() + _PRGNAME_ + ".blog" : "");
+
+	perf::reset();
+
+	if (Ini.HLEPerfStatsInterval.GetValue() > 0)
+	{
+		perf::start_export(Ini.HLEPerfStatsFile.GetValue(), Ini.HLEPerfStatsInterval.GetValue());
+	}
+
+	prof::reset();
+
+	if (Ini.HLEProfilerInterval.GetValue() > 0)
+	{
+		prof::start(Ini.HLEProfilerInterval.GetValue());
+	}
+
 	if(!rExists(m_path)) return;
 
-	if(IsSelf(m_path))
+	// SELF files are decrypted in memory and loaded from there
+	vfsMemoryFile elf_f;
+
+	const bool is_self = IsSelf(m_path);
+
+	if(is_self)
 	{
-		std::string elf_path = rFileName(m_path).GetPath();
+		const u64 stamp = get_system_time();
 
-		if (fmt::CmpNoCase(rFileName(m_path).GetFullName(),"EBOOT.BIN") == 0)
-		{
-			elf_path += "/BOOT.BIN";
-		}
-		else
-		{
-			elf_path += "/" + rFileName(m_path).GetName() + ".elf";
-		}
+		elf_f.Open(m_path);
 
-		if(!DecryptSelf(elf_path, m_path))
+		if(!DecryptSelf(elf_f, m_path))
 			return;
 
-		m_path = elf_path;
+		LOG_NOTICE(LOADER, "SELF decrypted in %.3f ms", (get_system_time() - stamp) / 1000.0);
 	}
 
 	LOG_NOTICE(LOADER, "Loading '%s'...", m_path.c_str());
@@ -227,16 +267,16 @@ void Emulator::Load()
 		GetVFS().GetDeviceLocal(m_path, m_elf_path);
 	}
 
-	vfsFile f(m_elf_path);
+	vfsFile f;
 
-	if(!f.IsOpened())
+	if(!is_self && !f.Open(m_elf_path))
 	{
 		LOG_ERROR(LOADER, "Elf not found! (%s - %s)", m_path.c_str(), m_elf_path.c_str());
 		return;
 	}
 
 	bool is_error;
-	Loader l(f);
+	Loader l(is_self ? (vfsFileBase&)elf_f : f);
 
 	try
 	{
@@ -433,6 +473,12 @@ void Emulator::Run()
 	//ConLog.Write("run...");
 	m_status = Running;
 
+	// unit tests which need a running emulator (empty unless enabled in their files)
+	waiter_map_t::RunAllTests();
+	squeue::RunAllTests();
+	SPUThread::RunAllTests();
+	MemoryBase::RunAllTests();
+
 	//if(m_memory_viewer && m_memory_viewer->exit) safe_delete(m_memory_viewer);
 
 	//m_memory_viewer->SetPC(loader.GetEntry());
@@ -476,6 +522,9 @@ void Emulator::Stop()
 	SendDbgCommand(DID_STOP_EMU);
 	m_status = Stopped;
 
+	perf::stop_export();
+	prof::stop(Ini.HLEProfilerFile.GetValue());
+
 	u32 uncounted = 0;
 	u32 counter = 0;
 	while (true)
@@ -502,6 +551,7 @@ void Emulator::Stop()
 	GetAudioManager().Close();
 	GetEventManager().Clear();
 	GetCPU().Close();
+	lazy_segments::stop();
 	GetIdManager().Clear();
 	GetPadManager().Close();
 	GetKeyboardManager().Close();
@@ -18,6 +18,7 @@
 #include "Gui/AutoPauseManager.h"
 #include "Gui/SaveDataUtility.h"
 #include "Gui/KernelExplorer.h"
+#include "Gui/PerfStatsFrame.h"
 #include "Gui/MemoryViewer.h"
 #include "Gui/RSXDebugger.h"
 
@@ -48,6 +49,7 @@ enum IDs
 	id_tools_kernel_explorer,
 	id_tools_memory_viewer,
 	id_tools_rsx_debugger,
+	id_tools_perf_stats,
 	id_help_about,
 	id_update_dbg,
 };
@@ -105,6 +107,7 @@ MainFrame::MainFrame()
 	menu_tools->Append(id_tools_kernel_explorer, "Kernel Explorer")->Enable(false);
 	menu_tools->Append(id_tools_memory_viewer, "Memory Viewer")->Enable(false);
 	menu_tools->Append(id_tools_rsx_debugger, "RSX Debugger")->Enable(false);
+	menu_tools->Append(id_tools_perf_stats, "Performance Counters");
 
 	wxMenu* menu_help = new wxMenu();
 	menubar->Append(menu_help, "Help");
@@ -142,6 +145,7 @@ MainFrame::MainFrame()
 	Bind(wxEVT_MENU, &MainFrame::OpenKernelExplorer, this, id_tools_kernel_explorer);
 	Bind(wxEVT_MENU, &MainFrame::OpenMemoryViewer, this, id_tools_memory_viewer);
 	Bind(wxEVT_MENU, &MainFrame::OpenRSXDebugger, this, id_tools_rsx_debugger);
+	Bind(wxEVT_MENU, &MainFrame::OpenPerfStats, this, id_tools_perf_stats);
 
 	Bind(wxEVT_MENU, &MainFrame::AboutDialogHandler, this, id_help_about);
 
@@ -424,6 +428,7 @@ void MainFrame::Config(wxCommandEvent& WXUNUSED(event))
 
 	cbox_spu_decoder->Append("SPU Interpreter");
 	cbox_spu_decoder->Append("SPU JIT (ASMJIT)");
+	cbox_spu_decoder->Append("SPU JIT (LLVM)");
 
 	cbox_gs_render->Append("Null");
 	cbox_gs_render->Append("OpenGL");
@@ -688,6 +693,11 @@ void MainFrame::OpenRSXDebugger(wxCommandEvent& WXUNUSED(event))
 	(new RSXDebugger(this)) -> Show();
 }
 
+void MainFrame::OpenPerfStats(wxCommandEvent& WXUNUSED(event))
+{
+	(new PerfStatsFrame(this)) -> Show();
+}
+
 
 void MainFrame::AboutDialogHandler(wxCommandEvent& WXUNUSED(event))
 {
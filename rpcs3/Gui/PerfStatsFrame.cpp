@@ -0,0 +1,128 @@
+#include "stdafx_gui.h"
+#include "Utilities/Log.h"
+#include "Utilities/rFile.h"
+#include "Emu/SysCalls/SysCalls.h"
+#include "Emu/PerfCounters.h"
+#include "PerfStatsFrame.h"
+
+PerfStatsFrame::PerfStatsFrame(wxWindow* parent)
+	: wxFrame(parent, wxID_ANY, "Performance Counters", wxDefaultPosition, wxSize(900, 600))
+	, m_timer(this)
+{
+	this->SetBackgroundColour(wxColour(240,240,240)); //This fix the ugly background color under Windows
+	wxBoxSizer* s_panel = new wxBoxSizer(wxVERTICAL);
+
+	// Buttons
+	wxBoxSizer* box_buttons = new wxBoxSizer(wxHORIZONTAL);
+	wxButton* b_reset = new wxButton(this, wxID_ANY, "Reset");
+	wxButton* b_save = new wxButton(this, wxID_ANY, "Save JSON...");
+	box_buttons->AddSpacer(10);
+	box_buttons->Add(b_reset);
+	box_buttons->AddSpacer(10);
+	box_buttons->Add(b_save);
+	box_buttons->AddSpacer(10);
+
+	wxStaticBoxSizer* box_threads = new wxStaticBoxSizer(wxVERTICAL, this, "Threads");
+	m_threads = new wxListView(this, wxID_ANY, wxDefaultPosition, wxSize(880, 250));
+	m_threads->InsertColumn(0, "Thread", wxLIST_FORMAT_LEFT, 160);
+	for (u32 i = 0; i < perf::COUNTER_COUNT; i++)
+	{
+		m_threads->InsertColumn(i + 1, perf::counter_names[i], wxLIST_FORMAT_RIGHT, 70);
+	}
+	box_threads->Add(m_threads, 1, wxEXPAND);
+
+	wxStaticBoxSizer* box_calls = new wxStaticBoxSizer(wxVERTICAL, this, "Syscalls and HLE functions");
+	m_calls = new wxListView(this, wxID_ANY, wxDefaultPosition, wxSize(880, 250));
+	m_calls->InsertColumn(0, "ID", wxLIST_FORMAT_LEFT, 90);
+	m_calls->InsertColumn(1, "Name", wxLIST_FORMAT_LEFT, 300);
+	m_calls->InsertColumn(2, "Calls", wxLIST_FORMAT_RIGHT, 120);
+	box_calls->Add(m_calls, 1, wxEXPAND);
+
+	// Merge and display everything
+	s_panel->AddSpacer(10);
+	s_panel->Add(box_buttons);
+	s_panel->AddSpacer(10);
+	s_panel->Add(box_threads, 1, wxEXPAND);
+	s_panel->AddSpacer(10);
+	s_panel->Add(box_calls, 1, wxEXPAND);
+	s_panel->AddSpacer(10);
+	SetSizerAndFit(s_panel);
+
+	// Events
+	b_reset->Bind(wxEVT_BUTTON, &PerfStatsFrame::OnReset, this);
+	b_save->Bind(wxEVT_BUTTON, &PerfStatsFrame::OnSave, this);
+	Bind(wxEVT_TIMER, &PerfStatsFrame::OnTimer, this);
+
+	Update();
+	m_timer.Start(1000);
+}
+
+void PerfStatsFrame::Update()
+{
+	const perf::snapshot s = perf::collect();
+
+	m_threads->Freeze();
+	m_threads->DeleteAllItems();
+
+	for (auto& t : s.threads)
+	{
+		const long item = m_threads->InsertItem(m_threads->GetItemCount(), t.finished ? t.name + " (finished)" : t.name);
+
+		for (u32 i = 0; i < perf::COUNTER_COUNT; i++)
+		{
+			m_threads->SetItem(item, i + 1, fmt::Format("%llu", t.values[i]));
+		}
+	}
+
+	m_threads->Thaw();
+
+	m_calls->Freeze();
+	m_calls->DeleteAllItems();
+
+	// the most frequent calls only
+	const size_t max_calls = 100;
+
+	for (size_t i = 0; i < s.syscalls.size() && i < max_calls; i++)
+	{
+		const long item = m_calls->InsertItem(m_calls->GetItemCount(), fmt::Format("%d", s.syscalls[i].first));
+		m_calls->SetItem(item, 1, "syscall");
+		m_calls->SetItem(item, 2, fmt::Format("%llu", s.syscalls[i].second));
+	}
+
+	for (size_t i = 0; i < s.hle_calls.size() && i < max_calls; i++)
+	{
+		const long item = m_calls->InsertItem(m_calls->GetItemCount(), fmt::Format("0x%08x", s.hle_calls[i].first));
+		m_calls->SetItem(item, 1, SysCalls::GetHLEFuncName(s.hle_calls[i].first));
+		m_calls->SetItem(item, 2, fmt::Format("%llu", s.hle_calls[i].second));
+	}
+
+	m_calls->Thaw();
+}
+
+void PerfStatsFrame::OnTimer(wxTimerEvent& WXUNUSED(event))
+{
+	if (IsShown()) Update();
+}
+
+void PerfStatsFrame::OnReset(wxCommandEvent& WXUNUSED(event))
+{
+	perf::reset();
+	Update();
+}
+
+void PerfStatsFrame::OnSave(wxCommandEvent& WXUNUSED(event))
+{
+	wxFileDialog dialog(this, "Save performance counters", wxEmptyString, "perf_stats.json", "JSON files (*.json)|*.json", wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+
+	if (dialog.ShowModal() != wxID_OK) return;
+
+	rFile f(fmt::ToUTF8(dialog.GetPath()), rFile::write);
+
+	if (!f.IsOpened())
+	{
+		LOG_ERROR(GENERAL, "PerfStatsFrame: failed to open '%s'", fmt::ToUTF8(dialog.GetPath()).c_str());
+		return;
+	}
+
+	f.Write(perf::to_json(perf::collect()));
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+class PerfStatsFrame : public wxFrame
+{
+	wxListView* m_threads;
+	wxListView* m_calls;
+	wxTimer m_timer;
+
+public:
+	PerfStatsFrame(wxWindow* parent);
+	void Update();
+
+	void OnTimer(wxTimerEvent& WXUNUSED(event));
+	void OnReset(wxCommandEvent& WXUNUSED(event));
+	void OnSave(wxCommandEvent& WXUNUSED(event));
+};
@@ -98,7 +98,9 @@ private:
 public:
 	// Core
 	IniEntry<u8> CPUDecoderMode;
+	IniEntry<bool> CPUFastmem;
 	IniEntry<u8> SPUDecoderMode;
+	IniEntry<bool> SPURecompilerLog;
 
 	// Graphics
 	IniEntry<u8> GSRenderMode;
@@ -151,10 +153,18 @@ public:
 	// HLE/Miscs
 	IniEntry<bool> HLELogging;
 	IniEntry<bool> HLEHookStFunc;
+	IniEntry<bool> HLELazySegments;
 	IniEntry<bool> HLESaveTTY;
 	IniEntry<bool> HLEExitOnStop;
 	IniEntry<u8>   HLELogLvl;
+	IniEntry<std::string> HLELogMasks;
+	IniEntry<bool> HLEBinaryLog;
 	IniEntry<bool> HLEAlwaysStart;
+	IniEntry<u8>   HLEVdecThreads;
+	IniEntry<int>  HLEPerfStatsInterval;
+	IniEntry<std::string> HLEPerfStatsFile;
+	IniEntry<int>  HLEProfilerInterval;
+	IniEntry<std::string> HLEProfilerFile;
 
 	//Auto Pause
 	IniEntry<bool> DBGAutoPauseSystemCall;
@@ -172,7 +182,9 @@ public:
 
 		// Core
 		CPUDecoderMode.Init("CPU_DecoderMode", path);
+		CPUFastmem.Init("CPU_Fastmem", path);
 		SPUDecoderMode.Init("CPU_SPUDecoderMode", path);
+		SPURecompilerLog.Init("CPU_SPURecompilerLog", path);
 
 		// Graphics
 		GSRenderMode.Init("GS_RenderMode", path);
@@ -225,10 +237,18 @@ public:
 		// HLE/Misc
 		HLELogging.Init("HLE_HLELogging", path);
 		HLEHookStFunc.Init("HLE_HLEHookStFunc", path);
+		HLELazySegments.Init("HLE_HLELazySegments", path);
 		HLESaveTTY.Init("HLE_HLESaveTTY", path);
 		HLEExitOnStop.Init("HLE_HLEExitOnStop", path);
 		HLELogLvl.Init("HLE_HLELogLvl", path);
+		HLELogMasks.Init("HLE_HLELogMasks", path);
+		HLEBinaryLog.Init("HLE_HLEBinaryLog", path);
 		HLEAlwaysStart.Init("HLE_HLEAlwaysStart", path);
+		HLEVdecThreads.Init("HLE_HLEVdecThreads", path);
+		HLEPerfStatsInterval.Init("HLE_HLEPerfStatsInterval", path);
+		HLEPerfStatsFile.Init("HLE_HLEPerfStatsFile", path);
+		HLEProfilerInterval.Init("HLE_HLEProfilerInterval", path);
+		HLEProfilerFile.Init("HLE_HLEProfilerFile", path);
 
 		// Auto Pause
 		DBGAutoPauseFunctionCall.Init("DBG_AutoPauseFunctionCall", path);
@@ -242,7 +262,9 @@ public:
 	{
 		// Core
 		CPUDecoderMode.Load(1);
+		CPUFastmem.Load(false); // PPU LLVM recompiler only
 		SPUDecoderMode.Load(1);
+		SPURecompilerLog.Load(false); // disassembly of SPU recompiler functions in SPUjit_<id>.log
 
 		// Graphics
 		GSRenderMode.Load(1);
@@ -295,10 +317,18 @@ public:
 		// HLE/Miscs
 		HLELogging.Load(false);
 		HLEHookStFunc.Load(false);
+		HLELazySegments.Load(false); // Linux only, ELF segments are analysed and mapped by a prefetch thread or on first access
 		HLESaveTTY.Load(false);
 		HLEExitOnStop.Load(false);
 		HLELogLvl.Load(3);
+		HLELogMasks.Load(""); // e.g. "HLE=0xc,RSX=0x8" (bit 0 = success, 1 = notice, 2 = warning, 3 = error)
+		HLEBinaryLog.Load(false); // RPCS3.blog instead of RPCS3.log, decoded with "rpcs3-headless --decode-log"
 		HLEAlwaysStart.Load(true);
+		HLEVdecThreads.Load(0); // 0 = one per core
+		HLEPerfStatsInterval.Load(0); // ms, 0 = performance counters are not exported
+		HLEPerfStatsFile.Load("perf_stats.csv"); // CSV rows are appended, a .json file holds the latest snapshot
+		HLEProfilerInterval.Load(0); // us (at least 500), 0 = guest code is not sampled
+		HLEProfilerFile.Load("profile.txt"); // written when the emulation stops, a .folded file holds collapsed stacks
 
 		//Auto Pause
 		DBGAutoPauseFunctionCall.Load(false);
@@ -313,7 +343,9 @@ public:
 	{
 		// CPU/SPU
 		CPUDecoderMode.Save();
+		CPUFastmem.Save();
 		SPUDecoderMode.Save();
+		SPURecompilerLog.Save();
 
 		// Graphics
 		GSRenderMode.Save();
@@ -366,10 +398,18 @@ public:
 		// HLE/Miscs
 		HLELogging.Save();
 		HLEHookStFunc.Save();
+		HLELazySegments.Save();
 		HLESaveTTY.Save();
 		HLEExitOnStop.Save();
 		HLELogLvl.Save();
+		HLELogMasks.Save();
+		HLEBinaryLog.Save();
 		HLEAlwaysStart.Save();
+		HLEVdecThreads.Save();
+		HLEPerfStatsInterval.Save();
+		HLEPerfStatsFile.Save();
+		HLEProfilerInterval.Save();
+		HLEProfilerFile.Save();
 
 		//Auto Pause
 		DBGAutoPauseFunctionCall.Save();
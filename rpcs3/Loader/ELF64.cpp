@@ -6,8 +6,11 @@
 #include "Emu/System.h"
 #include "Emu/SysCalls/SysCalls.h"
 #include "Emu/SysCalls/Static.h"
+#include "Emu/SysCalls/lv2/sys_time.h"
 #include "Emu/Cell/PPUInstrTable.h"
 #include "Emu/SysCalls/ModuleManager.h"
+#include "Emu/Profiler.h"
+#include "LazySegments.h"
 #include "ELF64.h"
 
 using namespace PPU_instr;
@@ -116,55 +119,6 @@ void Elf64_Phdr::Show()
 #endif
 }
 
-void WriteEhdr(rFile& f, Elf64_Ehdr& ehdr)
-{
-	Write32(f, ehdr.e_magic);
-	Write8(f, ehdr.e_class);
-	Write8(f, ehdr.e_data);
-	Write8(f, ehdr.e_curver);
-	Write8(f, ehdr.e_os_abi);
-	Write64(f, ehdr.e_abi_ver);
-	Write16(f, ehdr.e_type);
-	Write16(f, ehdr.e_machine);
-	Write32(f, ehdr.e_version);
-	Write64(f, ehdr.e_entry);
-	Write64(f, ehdr.e_phoff);
-	Write64(f, ehdr.e_shoff);
-	Write32(f, ehdr.e_flags);
-	Write16(f, ehdr.e_ehsize);
-	Write16(f, ehdr.e_phentsize);
-	Write16(f, ehdr.e_phnum);
-	Write16(f, ehdr.e_shentsize);
-	Write16(f, ehdr.e_shnum);
-	Write16(f, ehdr.e_shstrndx);
-}
-
-void WritePhdr(rFile& f, Elf64_Phdr& phdr)
-{
-	Write32(f, phdr.p_type);
-	Write32(f, phdr.p_flags);
-	Write64(f, phdr.p_offset);
-	Write64(f, phdr.p_vaddr);
-	Write64(f, phdr.p_paddr);
-	Write64(f, phdr.p_filesz);
-	Write64(f, phdr.p_memsz);
-	Write64(f, phdr.p_align);
-}
-
-void WriteShdr(rFile& f, Elf64_Shdr& shdr)
-{
-	Write32(f, shdr.sh_name);
-	Write32(f, shdr.sh_type);
-	Write64(f, shdr.sh_flags);
-	Write64(f, shdr.sh_addr);
-	Write64(f, shdr.sh_offset);
-	Write64(f, shdr.sh_size);
-	Write32(f, shdr.sh_link);
-	Write32(f, shdr.sh_info);
-	Write64(f, shdr.sh_addralign);
-	Write64(f, shdr.sh_entsize);
-}
-
 ELF64Loader::ELF64Loader(vfsStream& f)
 	: elf64_f(f)
 	, LoaderBase()
@@ -187,10 +141,19 @@ bool ELF64Loader::LoadData(u64 offset)
 {
 	if(!elf64_f.IsOpened()) return false;
 
+	segments_time = 0;
+	analysis_time = 0;
+	imports_time = 0;
+
+	const u64 start_time = get_system_time();
+
 	if(!LoadEhdrData(offset)) return false;
 	if(!LoadPhdrData(offset)) return false;
 	if(!LoadShdrData(offset)) return false;
 
+	LOG_NOTICE(LOADER, "elf64: loaded in %.3f ms (segments: %.3f ms, static analysis: %.3f ms, imports: %.3f ms)",
+		(get_system_time() - start_time) / 1000.0, segments_time / 1000.0, analysis_time / 1000.0, imports_time / 1000.0);
+
 	return true;
 }
 
@@ -348,15 +311,40 @@ bool ELF64Loader::LoadPhdrData(u64 offset)
 			case 0x00000001: //LOAD
 				if(phdr.p_memsz)
 				{
+					const u64 stamp0 = get_system_time();
+
 					if (!Memory.MainMem.AllocFixed(offset + phdr.p_vaddr, (u32)phdr.p_memsz))
 					{
 						LOG_ERROR(LOADER, "%s(): AllocFixed(0x%llx, 0x%x) failed", __FUNCTION__, offset + phdr.p_vaddr, (u32)phdr.p_memsz);
+						break;
 					}
-					else if (phdr.p_filesz)
+
+					// a lazily mapped segment is loaded to staging memory, analysed and mapped by the prefetch thread
+					void* data = offset ? nullptr : lazy_segments::reserve((u32)phdr.p_vaddr, (u32)phdr.p_memsz);
+					const bool lazy = data != nullptr;
+
+					if (!lazy)
+					{
+						data = vm::get_ptr<void>(offset + phdr.p_vaddr);
+					}
+
+					if (phdr.p_filesz)
 					{
 						elf64_f.Seek(phdr.p_offset);
-						elf64_f.Read(vm::get_ptr<void>(offset + phdr.p_vaddr), phdr.p_filesz);
-						Emu.GetSFuncManager().StaticAnalyse(vm::get_ptr<void>(offset + phdr.p_vaddr), (u32)phdr.p_filesz, (u32)phdr.p_vaddr);
+						elf64_f.Read(data, phdr.p_filesz);
+					}
+
+					const u64 stamp1 = get_system_time();
+					segments_time += stamp1 - stamp0;
+
+					if (lazy)
+					{
+						lazy_segments::queue((u32)phdr.p_vaddr, (u32)phdr.p_filesz);
+					}
+					else if (phdr.p_filesz)
+					{
+						Emu.GetSFuncManager().StaticAnalyse(data, (u32)phdr.p_filesz, (u32)phdr.p_vaddr);
+						analysis_time += get_system_time() - stamp1;
 					}
 				}
 			break;
@@ -420,6 +408,8 @@ bool ELF64Loader::LoadPhdrData(u64 offset)
 					break;
 				}
 
+				const u64 stamp0 = get_system_time();
+
 				for (u32 s = proc_prx_param.libstubstart; s < proc_prx_param.libstubend; s += sizeof(Elf64_StubHeader))
 				{
 					const Elf64_StubHeader& stub = vm::get_ref<Elf64_StubHeader>(offset + s);
@@ -478,8 +468,12 @@ bool ELF64Loader::LoadPhdrData(u64 offset)
 						out_dst[0] = OR(11, 2, 2, 0);
 						out_dst[1] = SC(2);
 						out_dst[2] = BLR();
+
+						prof::add_symbol((u32)dst + i * section, section, SysCalls::GetHLEFuncName(nid));
 					}
 				}
+
+				imports_time += get_system_time() - stamp0;
 #ifdef LOADER_DEBUG
 				LOG_NOTICE(LOADER, "");
 #endif
@@ -552,5 +546,62 @@ bool ELF64Loader::LoadShdrData(u64 offset)
 		}
 	}
 
+	LoadSymbols(offset);
+
 	return true;
 }
+
+void ELF64Loader::LoadSymbols(u64 offset)
+{
+	// function names of unstripped executables, used by the profiler
+	for (auto& symtab : shdr_arr)
+	{
+		if (symtab.sh_type != SHT_SYMTAB || symtab.sh_entsize != sizeof(Elf64_Sym) || symtab.sh_link >= shdr_arr.size())
+		{
+			continue;
+		}
+
+		const Elf64_Shdr& strtab = shdr_arr[symtab.sh_link];
+
+		std::vector<Elf64_Sym> syms((size_t)(symtab.sh_size / sizeof(Elf64_Sym)));
+		std::vector<char> names((size_t)strtab.sh_size + 1);
+
+		elf64_f.Seek(symtab.sh_offset);
+		elf64_f.Read(syms.data(), syms.size() * sizeof(Elf64_Sym));
+		elf64_f.Seek(strtab.sh_offset);
+		elf64_f.Read(names.data(), (size_t)strtab.sh_size);
+		names.back() = 0;
+
+		u32 count = 0;
+
+		for (auto& sym : syms)
+		{
+			if ((sym.st_info & 0xf) != 2 || !sym.st_value || sym.st_shndx >= shdr_arr.size() || sym.st_name >= strtab.sh_size)
+			{
+				continue;
+			}
+
+			u32 addr = (u32)(offset + sym.st_value);
+			u32 size = (u32)sym.st_size;
+
+			if (sym.st_shndx < shdr_name_arr.size() && shdr_name_arr[sym.st_shndx] == ".opd")
+			{
+				// the symbol is the descriptor (code address and TOC), the size of the code isn't known
+				if (!Memory.IsGoodAddr(addr, 4)) continue;
+
+				addr = (u32)offset + vm::read32(addr);
+				size = 0;
+			}
+			else if (!(shdr_arr[sym.st_shndx].sh_flags & SHF_EXECINSTR))
+			{
+				continue;
+			}
+
+			const char* name = names.data() + sym.st_name;
+			prof::add_symbol(addr, size, name[0] == '.' ? name + 1 : name);
+			count++;
+		}
+
+		LOG_NOTICE(LOADER, "elf64: %d function symbols", count);
+	}
+}
@@ -90,13 +90,64 @@ public:
 	bool LoadShdrInfo(s64 offset=-1);
 
 private:
+	// time spent in the loading phases (us)
+	u64 segments_time;
+	u64 analysis_time;
+	u64 imports_time;
+
 	bool LoadEhdrData(u64 offset);
 	bool LoadPhdrData(u64 offset);
 	bool LoadShdrData(u64 offset);
+	void LoadSymbols(u64 offset);
 
 	//bool LoadImports();
 };
 
-void WriteEhdr(rFile& f, Elf64_Ehdr& ehdr);
-void WritePhdr(rFile& f, Elf64_Phdr& phdr);
-void WriteShdr(rFile& f, Elf64_Shdr& shdr);
+template<typename T> void WriteEhdr(T& f, Elf64_Ehdr& ehdr)
+{
+	Write32(f, ehdr.e_magic);
+	Write8(f, ehdr.e_class);
+	Write8(f, ehdr.e_data);
+	Write8(f, ehdr.e_curver);
+	Write8(f, ehdr.e_os_abi);
+	Write64(f, ehdr.e_abi_ver);
+	Write16(f, ehdr.e_type);
+	Write16(f, ehdr.e_machine);
+	Write32(f, ehdr.e_version);
+	Write64(f, ehdr.e_entry);
+	Write64(f, ehdr.e_phoff);
+	Write64(f, ehdr.e_shoff);
+	Write32(f, ehdr.e_flags);
+	Write16(f, ehdr.e_ehsize);
+	Write16(f, ehdr.e_phentsize);
+	Write16(f, ehdr.e_phnum);
+	Write16(f, ehdr.e_shentsize);
+	Write16(f, ehdr.e_shnum);
+	Write16(f, ehdr.e_shstrndx);
+}
+
+template<typename T> void WritePhdr(T& f, Elf64_Phdr& phdr)
+{
+	Write32(f, phdr.p_type);
+	Write32(f, phdr.p_flags);
+	Write64(f, phdr.p_offset);
+	Write64(f, phdr.p_vaddr);
+	Write64(f, phdr.p_paddr);
+	Write64(f, phdr.p_filesz);
+	Write64(f, phdr.p_memsz);
+	Write64(f, phdr.p_align);
+}
+
+template<typename T> void WriteShdr(T& f, Elf64_Shdr& shdr)
+{
+	Write32(f, shdr.sh_name);
+	Write32(f, shdr.sh_type);
+	Write64(f, shdr.sh_flags);
+	Write64(f, shdr.sh_addr);
+	Write64(f, shdr.sh_offset);
+	Write64(f, shdr.sh_size);
+	Write32(f, shdr.sh_link);
+	Write32(f, shdr.sh_info);
+	Write64(f, shdr.sh_addralign);
+	Write64(f, shdr.sh_entsize);
+}
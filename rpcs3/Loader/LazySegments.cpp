@@ -0,0 +1,299 @@
+#include "stdafx.h"
+#include "rpcs3/Ini.h"
+#include "Utilities/Log.h"
+#include "Utilities/Thread.h"
+#include "Emu/Memory/Memory.h"
+#include "Emu/System.h"
+#include "Emu/SysCalls/Static.h"
+#include "Emu/SysCalls/lv2/sys_time.h"
+#include "LazySegments.h"
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <time.h>
+
+namespace lazy_segments
+{
+	enum : u32
+	{
+		SEG_LOADING, // the loader fills the staging pages
+		SEG_QUEUED, // waiting for the prefetch thread
+		SEG_MAPPED,
+		SEG_DROPPED, // not mapped (the emulation was stopped or the guest pages couldn't be protected)
+	};
+
+	struct segment
+	{
+		u32 start; // page aligned guest range
+		u32 end;
+		u32 addr;
+		u32 filesz;
+		u8* staging; // the contents of [start, end), moved to the guest memory when the segment is mapped
+		std::atomic<u32> state;
+		std::atomic<bool> requested; // touched before it was mapped
+	};
+
+	const u32 max_segments = 64;
+
+	// an entry is published by incrementing g_count and only reused after stop(), so the fault handler reads them
+	// without locking
+	segment g_segments[max_segments];
+	std::atomic<u32> g_count(0);
+
+	std::mutex g_lock; // g_running, queueing and the statistics
+	thread g_thread("Segment prefetch");
+	bool g_running = false; // set until the prefetch thread runs out of queued segments
+	std::atomic<bool> g_stop(false);
+
+	u32 g_mapped = 0;
+	u32 g_mapped_on_access = 0;
+	u64 g_analysis_time = 0;
+
+	// runs in signal context: the thread waits until the segment is mapped and then retries the access
+	bool fault_handler(u32 addr, void* context)
+	{
+		const u32 count = g_count.load(std::memory_order_acquire);
+
+		for (u32 i = 0; i < count; i++)
+		{
+			segment& seg = g_segments[i];
+
+			if (addr < seg.start || addr >= seg.end)
+			{
+				continue;
+			}
+
+			seg.requested = true;
+
+			for (u32 state; (state = seg.state.load()) != SEG_MAPPED;)
+			{
+				if (state == SEG_DROPPED)
+				{
+					return false;
+				}
+
+				const timespec ts = { 0, 20000 };
+				nanosleep(&ts, nullptr);
+			}
+
+			return true;
+		}
+
+		return false;
+	}
+
+	void map(segment& seg)
+	{
+		const u64 stamp = get_system_time();
+
+		if (seg.filesz)
+		{
+			Emu.GetSFuncManager().StaticAnalyse(seg.staging + (seg.addr - seg.start), seg.filesz, seg.addr);
+		}
+
+		const u32 size = seg.end - seg.start;
+		void* const dst = vm::get_ptr<void>(seg.start);
+
+		// the inaccessible guest pages are replaced in one step, other threads either fault or see the final contents
+		if (::mremap(seg.staging, size, size, MREMAP_MAYMOVE | MREMAP_FIXED, dst) == MAP_FAILED)
+		{
+			LOG_WARNING(LOADER, "lazy_segments: mremap(addr=0x%x, size=0x%x) failed (errno=%d), the segment is copied", seg.start, size, errno);
+
+			if (::mprotect(dst, size, PROT_READ | PROT_WRITE))
+			{
+				LOG_ERROR(LOADER, "lazy_segments: the segment at 0x%x can't be mapped (errno=%d)", seg.start, errno);
+				Emu.Pause();
+				seg.state = SEG_DROPPED;
+				return;
+			}
+
+			memcpy(dst, seg.staging, size);
+			::munmap(seg.staging, size);
+		}
+
+		seg.staging = nullptr;
+
+		std::lock_guard<std::mutex> lock(g_lock);
+
+		g_mapped++;
+		g_mapped_on_access += seg.requested ? 1 : 0;
+		g_analysis_time += get_system_time() - stamp;
+		seg.state = SEG_MAPPED;
+	}
+
+	void prefetch()
+	{
+		while (!g_stop)
+		{
+			segment* next = nullptr;
+
+			{
+				std::lock_guard<std::mutex> lock(g_lock);
+
+				// the segments are mapped in the order of the program headers, the ones being waited for first
+				for (u32 i = 0; i < g_count; i++)
+				{
+					segment& seg = g_segments[i];
+
+					if (seg.state == SEG_QUEUED && (!next || (seg.requested && !next->requested)))
+					{
+						next = &seg;
+					}
+				}
+
+				if (!next)
+				{
+					g_running = false;
+
+					LOG_NOTICE(LOADER, "lazy_segments: %d segments mapped (%d on first access), static analysis: %.3f ms",
+						g_mapped, g_mapped_on_access, g_analysis_time / 1000.0);
+					return;
+				}
+			}
+
+			map(*next);
+		}
+	}
+
+	void* reserve(u32 addr, u32 size)
+	{
+		if (!Ini.HLELazySegments.GetValue())
+		{
+			return nullptr;
+		}
+
+		vm::add_fault_handler(fault_handler);
+
+		std::lock_guard<std::mutex> lock(g_lock);
+
+		const u32 count = g_count;
+
+		if (count == max_segments)
+		{
+			LOG_WARNING(LOADER, "lazy_segments: too many segments, the segment at 0x%x is loaded directly", addr);
+			return nullptr;
+		}
+
+		segment& seg = g_segments[count];
+		seg.start = addr & ~4095;
+		seg.end = (addr + size + 4095) & ~4095;
+		seg.addr = addr;
+		seg.filesz = 0;
+		seg.staging = (u8*)::mmap(nullptr, seg.end - seg.start, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		seg.requested = false;
+		seg.state = SEG_LOADING;
+
+		if (seg.staging == MAP_FAILED)
+		{
+			LOG_WARNING(LOADER, "lazy_segments: no staging memory for the segment at 0x%x (errno=%d), it is loaded directly", addr, errno);
+			return nullptr;
+		}
+
+		// published before the guest pages are protected, so a fault on them always finds the segment
+		g_count.store(count + 1, std::memory_order_release);
+
+		if (::mprotect(vm::get_ptr<void>(seg.start), seg.end - seg.start, PROT_NONE))
+		{
+			LOG_WARNING(LOADER, "lazy_segments: the segment at 0x%x can't be protected (errno=%d), it is loaded directly", addr, errno);
+			::munmap(seg.staging, seg.end - seg.start);
+			seg.staging = nullptr;
+			seg.state = SEG_DROPPED;
+			return nullptr;
+		}
+
+		return seg.staging + (addr - seg.start);
+	}
+
+	void queue(u32 addr, u32 filesz)
+	{
+		std::lock_guard<std::mutex> lock(g_lock);
+
+		for (u32 i = 0; i < g_count; i++)
+		{
+			segment& seg = g_segments[i];
+
+			if (seg.addr == addr && seg.state == SEG_LOADING)
+			{
+				seg.filesz = filesz;
+				seg.state = SEG_QUEUED;
+
+				if (!g_running)
+				{
+					// the previous prefetch thread has run out of segments and is finishing
+					if (g_thread.joinable())
+					{
+						g_thread.join();
+					}
+
+					g_running = true;
+					g_stop = false;
+					g_thread.start(prefetch);
+				}
+
+				return;
+			}
+		}
+
+		LOG_ERROR(LOADER, "lazy_segments::queue(addr=0x%x): segment not reserved", addr);
+	}
+
+	void stop()
+	{
+		g_stop = true;
+
+		if (g_thread.joinable())
+		{
+			g_thread.join();
+		}
+
+		std::lock_guard<std::mutex> lock(g_lock);
+
+		for (u32 i = 0; i < g_count; i++)
+		{
+			segment& seg = g_segments[i];
+
+			if (seg.state != SEG_MAPPED)
+			{
+				seg.state = SEG_DROPPED;
+			}
+
+			if (seg.staging)
+			{
+				::munmap(seg.staging, seg.end - seg.start);
+				seg.staging = nullptr;
+			}
+		}
+
+		g_count = 0;
+		g_running = false;
+		g_mapped = 0;
+		g_mapped_on_access = 0;
+		g_analysis_time = 0;
+	}
+}
+
+#else
+
+// mremap() is needed to move the staging pages to the guest memory, the segments are loaded directly elsewhere
+namespace lazy_segments
+{
+	void* reserve(u32 addr, u32 size)
+	{
+		if (Ini.HLELazySegments.GetValue())
+		{
+			LOG_WARNING(LOADER, "lazy_segments: not supported on this platform, the segment at 0x%x is loaded directly", addr);
+		}
+
+		return nullptr;
+	}
+
+	void queue(u32 addr, u32 filesz)
+	{
+	}
+
+	void stop()
+	{
+	}
+}
+
+#endif
@@ -0,0 +1,18 @@
+#pragma once
+
+// Lazy mapping of the LOAD segments of an executable (Ini.HLELazySegments).
+// The guest pages of a segment stay inaccessible while its data waits in staging pages. A prefetch thread statically
+// analyses the segments in the background and moves the staging pages to the guest addresses in one step. A thread
+// that touches a segment before that faults, moves the segment to the front of the queue and waits for it.
+namespace lazy_segments
+{
+	// make the guest pages of an allocated segment inaccessible and return the staging memory its data must be loaded
+	// to (the host address of addr), nullptr if the segment must be loaded directly
+	void* reserve(u32 addr, u32 size);
+
+	// let the prefetch thread map a reserved segment, the first filesz bytes are statically analysed before
+	void queue(u32 addr, u32 filesz);
+
+	// stop the prefetch thread and drop the segments which are not mapped yet (called when the emulation stops)
+	void stop();
+}
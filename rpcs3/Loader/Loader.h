@@ -40,6 +40,13 @@ enum ShdrFlag
 	SHF_MASKPROC  = 0xf0000000,
 };
 
+enum PhdrFlag
+{
+	PF_X = 0x1,
+	PF_W = 0x2,
+	PF_R = 0x4,
+};
+
 const std::string Ehdr_DataToString(const u8 data);
 const std::string Ehdr_TypeToString(const u16 type);
 const std::string Ehdr_OS_ABIToString(const u8 os_abi);
@@ -98,6 +105,16 @@ struct Elf64_StubHeader
 	be_t<u32> s_unk7; // = 0x0
 };
 
+struct Elf64_Sym
+{
+	be_t<u32> st_name;
+	u8 st_info; // type in the low nibble (2 = function)
+	u8 st_other;
+	be_t<u16> st_shndx;
+	be_t<u64> st_value;
+	be_t<u64> st_size;
+};
+
 class LoaderBase
 {
 protected:
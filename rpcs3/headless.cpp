@@ -0,0 +1,405 @@
+#include "stdafx.h"
+#include "Utilities/Log.h"
+#include "Utilities/rFile.h"
+#include "Emu/Memory/Memory.h"
+#include "Emu/System.h"
+#include "Emu/DbgCommand.h"
+#include "Emu/GameInfo.h"
+#include "Emu/PerfCounters.h"
+#include "Emu/Audio/AudioClock.h"
+#include "Ini.h"
+
+#include "Emu/Io/Keyboard.h"
+#include "Emu/Io/Null/NullKeyboardHandler.h"
+
+#include "Emu/Io/Mouse.h"
+#include "Emu/Io/Null/NullMouseHandler.h"
+
+#include "Emu/Io/Pad.h"
+#include "Emu/Io/Null/NullPadHandler.h"
+
+#include "Emu/SysCalls/Modules/cellMsgDialog.h"
+#include "Emu/SysCalls/lv2/sys_time.h"
+
+#include <wx/init.h>
+
+// Runner without GUI for benchmarks and CI: the game is booted with the Null renderer, the Null input handlers and no
+// audio output (or a dump file), runs for a number of frames or seconds and the frame times, the audio clock statistics
+// and the performance counters are written as JSON.
+//
+// Timing test of the audio clock (the exit code is 3 if a limit is exceeded, the report is written anyway):
+//   rpcs3-headless --seconds 60 --audio-dump --max-late-blocks 1 --max-underruns 0 <game>
+// The audio thread runs without an output device (it only sleeps until the deadline of every block), so late blocks
+// and surmixer underruns are caused by the emulator. --audio-dump adds the work of writing audio.wav to every block.
+
+GameInfo CurGameInfo;
+
+// functions passed to CallAfter() are executed by the main thread (like the GUI does), not by the caller
+std::mutex g_main_lock;
+std::vector<std::function<void()>> g_main_queue;
+
+void RunMainQueue()
+{
+	std::vector<std::function<void()>> queue;
+
+	{
+		std::lock_guard<std::mutex> lock(g_main_lock);
+		queue.swap(g_main_queue);
+	}
+
+	for (auto& func : queue)
+	{
+		func();
+	}
+}
+
+// warnings, errors and the TTY output are printed to stderr (everything is still written to the log files)
+struct StderrWriter : Log::LogListener
+{
+	std::atomic<u32> errors;
+
+	StderrWriter() : errors(0)
+	{
+	}
+
+	virtual void log(Log::LogMessage msg)
+	{
+		if (msg.mType == Log::TTY)
+		{
+			fputs(msg.mText.c_str(), stderr);
+		}
+		else if (msg.mServerity >= Log::Warning)
+		{
+			if (msg.mServerity == Log::Error) errors++;
+
+			fprintf(stderr, "%s%s\n", Log::gTypeNameTable[msg.mType].mName.c_str(), msg.mText.c_str());
+		}
+	}
+};
+
+void PrintUsage()
+{
+	fputs(
+		"Usage: rpcs3-headless [options] <game directory or (S)ELF file>\n"
+		"  --frames N     stop after N frames\n"
+		"  --seconds S    stop after S seconds (default: 60 if --frames is not set)\n"
+		"  --warmup N     exclude the first N frames from the frame times\n"
+		"  --report FILE  write the report to FILE instead of stdout\n"
+		"  --audio-dump   write the audio output to a file\n"
+		"  --max-late-blocks P  fail (exit code 3) if more than P percent of the audio blocks were late\n"
+		"  --max-underruns N    fail (exit code 3) if the surmixer missed more than N audio blocks\n"
+		"  --decode-log FILE    write the text of a binary log (HLE_HLEBinaryLog) to stdout and exit\n"
+		"The settings are read from rpcs3.ini in the current directory (the renderer, the audio output and the input\n"
+		"handlers are replaced), run it from the directory of rpcs3 like the GUI.\n", stderr);
+}
+
+struct FrameStats
+{
+	u64 count;
+	double fps;
+	u64 min, mean, p50, p90, p99, max; // us
+};
+
+FrameStats GetFrameStats(std::vector<u64> times, u64 warmup)
+{
+	FrameStats res = {};
+
+	times.erase(times.begin(), times.begin() + std::min<u64>(warmup, times.size()));
+
+	if (times.empty())
+	{
+		return res;
+	}
+
+	std::sort(times.begin(), times.end());
+
+	u64 total = 0;
+	for (auto t : times) total += t;
+
+	// nearest rank
+	auto percentile = [&times](u32 p) -> u64
+	{
+		return times[std::max<size_t>((times.size() * p + 99) / 100, 1) - 1];
+	};
+
+	res.count = times.size();
+	res.fps = total ? 1000000.0 * times.size() / total : 0.0;
+	res.min = times.front();
+	res.mean = total / times.size();
+	res.p50 = percentile(50);
+	res.p90 = percentile(90);
+	res.p99 = percentile(99);
+	res.max = times.back();
+	return res;
+}
+
+int main(int argc, char** argv)
+{
+	u64 max_frames = 0;
+	double max_seconds = 0.0;
+	u64 warmup = 0;
+	std::string report_path;
+	std::string game_path;
+	bool audio_dump = false;
+	double max_late_blocks = -1.0;
+	s64 max_underruns = -1;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string arg = argv[i];
+		const bool has_value = i + 1 < argc;
+
+		if (arg == "--frames" && has_value)
+		{
+			max_frames = strtoull(argv[++i], nullptr, 10);
+		}
+		else if (arg == "--seconds" && has_value)
+		{
+			max_seconds = strtod(argv[++i], nullptr);
+		}
+		else if (arg == "--warmup" && has_value)
+		{
+			warmup = strtoull(argv[++i], nullptr, 10);
+		}
+		else if (arg == "--report" && has_value)
+		{
+			report_path = argv[++i];
+		}
+		else if (arg == "--audio-dump")
+		{
+			audio_dump = true;
+		}
+		else if (arg == "--max-late-blocks" && has_value)
+		{
+			max_late_blocks = strtod(argv[++i], nullptr);
+		}
+		else if (arg == "--max-underruns" && has_value)
+		{
+			max_underruns = strtoll(argv[++i], nullptr, 10);
+		}
+		else if (arg == "--decode-log" && has_value)
+		{
+			std::string text;
+			if (Log::LogManager::decodeBinaryLog(argv[++i], text) < 0)
+			{
+				fprintf(stderr, "'%s' is not a binary log\n", argv[i]);
+				return 1;
+			}
+
+			fwrite(text.data(), 1, text.size(), stdout);
+			return 0;
+		}
+		else if (arg.compare(0, 2, "--") != 0 && game_path.empty())
+		{
+			game_path = arg;
+		}
+		else
+		{
+			PrintUsage();
+			return 2;
+		}
+	}
+
+	if (game_path.empty())
+	{
+		PrintUsage();
+		return 2;
+	}
+
+	if (!max_frames && max_seconds <= 0.0)
+	{
+		max_seconds = 60.0;
+	}
+
+	// the core uses wxBase for files and strings
+	wxInitializer wx_init;
+
+	if (!wx_init.IsOk())
+	{
+		fputs("Failed to initialize wxWidgets\n", stderr);
+		return 1;
+	}
+
+	SetSendDbgCommandCallback([](DbgCommand id, CPUThread* t)
+	{
+	});
+	SetCallAfterCallback([](std::function<void()> func)
+	{
+		std::lock_guard<std::mutex> lock(g_main_lock);
+		g_main_queue.push_back(func);
+	});
+	SetGetKeyboardHandlerCountCallback([]()
+	{
+		return 1;
+	});
+	SetGetKeyboardHandlerCallback([](int i) -> KeyboardHandlerBase*
+	{
+		return new NullKeyboardHandler();
+	});
+	SetGetMouseHandlerCountCallback([]()
+	{
+		return 1;
+	});
+	SetGetMouseHandlerCallback([](int i) -> MouseHandlerBase*
+	{
+		return new NullMouseHandler();
+	});
+	SetGetPadHandlerCountCallback([]()
+	{
+		return 1;
+	});
+	SetGetPadHandlerCallback([](int i) -> PadHandlerBase*
+	{
+		return new NullPadHandler();
+	});
+
+	// nobody can press a button, so dialogs are answered with the default one (yes or ok) immediately
+	SetMsgDialogCreateCallback([](u32 type, const char* msg, u64& status)
+	{
+		if (type & CELL_MSGDIALOG_TYPE_BUTTON_TYPE)
+		{
+			status = CELL_MSGDIALOG_BUTTON_YES;
+			MsgDialogClose();
+		}
+	});
+	SetMsgDialogDestroyCallback([]()
+	{
+	});
+	SetMsgDialogProgressBarSetMsgCallback([](u32 index, const char* msg)
+	{
+	});
+	SetMsgDialogProgressBarResetCallback([](u32 index)
+	{
+	});
+	SetMsgDialogProgressBarIncCallback([](u32 index, u32 delta)
+	{
+	});
+
+	auto writer = std::make_shared<StderrWriter>();
+	Log::LogManager::getInstance().addListener(writer);
+
+	// the settings are not saved back
+	Ini.Load();
+	Ini.GSRenderMode.SetValue(0);
+	Ini.AudioOutMode.SetValue(0);
+	Ini.AudioDumpToFile.SetValue(audio_dump);
+	Ini.PadHandlerMode.SetValue(0);
+	Ini.KeyboardHandlerMode.SetValue(0);
+	Ini.MouseHandlerMode.SetValue(0);
+
+	Emu.Init();
+
+	if (rIsDir(game_path))
+	{
+		if (!Emu.BootGame(game_path))
+		{
+			LOG_ERROR(GENERAL, "No BOOT.BIN or EBOOT.BIN found in '%s'", game_path.c_str());
+		}
+	}
+	else
+	{
+		Emu.SetPath(game_path);
+		Emu.Load();
+	}
+
+	if (!Emu.IsReady())
+	{
+		LOG_ERROR(GENERAL, "Failed to load '%s'", game_path.c_str());
+		Emu.Stop();
+		RunMainQueue();
+		return 1;
+	}
+
+	const u64 start = get_system_time();
+	const char* stop_reason = "exit";
+
+	Emu.Run();
+
+	while (true)
+	{
+		RunMainQueue();
+
+		if (Emu.IsStopped())
+		{
+			break;
+		}
+
+		if (max_frames && perf::get_flip_count() >= max_frames)
+		{
+			stop_reason = "frames";
+			break;
+		}
+
+		if (max_seconds > 0.0 && get_system_time() - start >= (u64)(max_seconds * 1000000.0))
+		{
+			stop_reason = "time";
+			break;
+		}
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	const u64 elapsed = get_system_time() - start;
+	const FrameStats frames = GetFrameStats(perf::get_frame_times(), warmup);
+	const u64 flips = perf::get_flip_count();
+
+	Emu.Stop();
+	RunMainQueue();
+
+	// the messages still queued by the emulator threads are counted too
+	Log::LogManager::getInstance().flush();
+	Log::LogManager::getInstance().removeListener(writer);
+
+	// the counters of the finished threads are kept, so they are complete after the emulation stopped
+	std::string counters = perf::to_json(perf::collect());
+	while (!counters.empty() && counters.back() == '\n') counters.pop_back();
+
+	// the statistics are kept until the audio thread starts again
+	const AudioClockStats audio = g_audio_clock.GetStats();
+	const double late_percent = audio.blocks ? 100.0 * audio.late_blocks / audio.blocks : 0.0;
+	bool audio_ok = true;
+
+	if (max_late_blocks >= 0.0 && late_percent > max_late_blocks)
+	{
+		fprintf(stderr, "Audio timing: %.2f%% of the blocks were late (limit: %.2f%%)\n", late_percent, max_late_blocks);
+		audio_ok = false;
+	}
+
+	if (max_underruns >= 0 && audio.underruns > (u64)max_underruns)
+	{
+		fprintf(stderr, "Audio timing: %llu underruns (limit: %lld)\n", audio.underruns, max_underruns);
+		audio_ok = false;
+	}
+
+	std::string report = "{\n";
+	report += fmt::Format("\t\"path\": \"%s\",\n", fmt::replace_all(fmt::replace_all(game_path, "\\", "\\\\"), "\"", "\\\"").c_str());
+	report += fmt::Format("\t\"stop_reason\": \"%s\",\n", stop_reason);
+	report += fmt::Format("\t\"elapsed_us\": %llu,\n", elapsed);
+	report += fmt::Format("\t\"frames\": %llu,\n", flips);
+	report += fmt::Format("\t\"log_errors\": %u,\n", writer->errors.load());
+	report += fmt::Format("\t\"frame_times\": { \"count\": %llu, \"fps\": %.3f, \"min_us\": %llu, \"mean_us\": %llu, "
+		"\"p50_us\": %llu, \"p90_us\": %llu, \"p99_us\": %llu, \"max_us\": %llu },\n",
+		frames.count, frames.fps, frames.min, frames.mean, frames.p50, frames.p90, frames.p99, frames.max);
+	report += fmt::Format("\t\"audio\": { \"blocks\": %llu, \"audio_time_us\": %llu, \"late_blocks\": %llu, \"late_percent\": %.3f, "
+		"\"underruns\": %llu, \"mean_lateness_us\": %llu, \"max_lateness_us\": %llu, \"ok\": %s },\n",
+		audio.blocks, audio.blocks * AudioClock::block_samples * 1000000 / AudioClock::sample_rate, audio.late_blocks, late_percent,
+		audio.underruns, audio.blocks ? audio.total_lateness / audio.blocks : 0, audio.max_lateness, audio_ok ? "true" : "false");
+	report += "\t\"counters\": " + counters + "\n}\n";
+
+	if (report_path.empty())
+	{
+		fputs(report.c_str(), stdout);
+	}
+	else
+	{
+		rFile f(report_path, rFile::write);
+
+		if (!f.IsOpened() || !f.Write(report))
+		{
+			fprintf(stderr, "Failed to write the report to '%s'\n", report_path.c_str());
+			return 1;
+		}
+	}
+
+	return audio_ok ? 0 : 3;
+}